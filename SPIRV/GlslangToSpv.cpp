@@ -126,6 +126,7 @@ public:
 
     void finishSpv();
     void dumpSpv(std::vector<unsigned int>& out);
+    void dumpSpv(const spv::WordWriter::Sink& sink);
 
 protected:
     spv::Decoration TranslateInterpolationDecoration(const glslang::TQualifier& qualifier);
@@ -190,6 +191,8 @@ protected:
     bool isTrivialLeaf(const glslang::TIntermTyped* node);
     bool isTrivial(const glslang::TIntermTyped* node);
     spv::Id createShortCircuit(glslang::TOperator, glslang::TIntermTyped& left, glslang::TIntermTyped& right);
+    bool isBinaryOperation(const glslang::TIntermBinary&);
+    void translateBinaryOperations(glslang::TIntermBinary*);
     spv::Id getExtBuiltins(const char* name);
 
     glslang::SpvOptions& options;
@@ -216,6 +219,15 @@ protected:
     std::unordered_map<const glslang::TTypeList*, spv::Id> structMap[glslang::ElpCount][glslang::ElmCount];
     std::unordered_map<const glslang::TTypeList*, std::vector<int> > memberRemapper;  // for mapping glslang block indices to spv indices (e.g., due to hidden members)
     std::stack<bool> breakForLoop;  // false means break for switch
+
+    // The operations translateBinaryOperations() is in the middle of, innermost last.
+    struct TBinaryFrame {
+        glslang::TIntermBinary* node;
+        bool specConstantOpMode;  // the builder's mode before the operation
+        int step;                 // how many operands are done
+        spv::Id left;
+    };
+    std::vector<TBinaryFrame> binaryFrames;
 };
 
 //
@@ -895,6 +907,8 @@ TGlslangToSpvTraverser::TGlslangToSpvTraverser(const glslang::TIntermediate* gls
     builder.setSource(TranslateSourceLanguage(glslangIntermediate->getSource(), glslangIntermediate->getProfile()),
                       glslangIntermediate->getVersion());
 
+    if (options.forwardLoads)
+        builder.setForwardLoads();
     if (options.generateDebugInfo) {
         builder.setEmitOpLines();
         builder.setSourceFile(glslangIntermediate->getSourceFile());
@@ -1073,6 +1087,15 @@ void TGlslangToSpvTraverser::dumpSpv(std::vector<unsigned int>& out)
     builder.dump(out);
 }
 
+// Hand the SPV to 'sink', a buffer full at a time.
+void TGlslangToSpvTraverser::dumpSpv(const spv::WordWriter::Sink& sink)
+{
+    const size_t maxBufferSize = 16 * 1024;
+    std::vector<unsigned int> buffer(std::min(builder.getWordCount(), maxBufferSize));
+    spv::WordWriter out(buffer.data(), buffer.size(), sink);
+    builder.dump(out);
+}
+
 //
 // Implement the traversal functions.
 //
@@ -1279,7 +1302,7 @@ bool TGlslangToSpvTraverser::visitBinary(glslang::TVisit /* visit */, glslang::T
             // These may require short circuiting, but can sometimes be done as straight
             // binary operations.  The right operand must be short circuited if it has
             // side effects, and should probably be if it is complex.
-            if (isTrivial(node->getRight()->getAsTyped()))
+            if (isBinaryOperation(*node))
                 break; // handle below as a normal binary operation
             // otherwise, we need to do dynamic short circuiting on the right operand
             spv::Id result = createShortCircuit(node->getOp(), *node->getLeft()->getAsTyped(), *node->getRight()->getAsTyped());
@@ -1292,30 +1315,111 @@ bool TGlslangToSpvTraverser::visitBinary(glslang::TVisit /* visit */, glslang::T
     }
 
     // Assume generic binary op...
+    translateBinaryOperations(node);
 
-    // get right operand
-    builder.clearAccessChain();
-    node->getLeft()->traverse(this);
-    spv::Id left = accessChainLoad(node->getLeft()->getType());
+    return false;
+}
 
-    // get left operand
-    builder.clearAccessChain();
-    node->getRight()->traverse(this);
-    spv::Id right = accessChainLoad(node->getRight()->getType());
+// Whether 'node' is a generic binary operation, done by
+// translateBinaryOperations(), rather than a special case of visitBinary().
+bool TGlslangToSpvTraverser::isBinaryOperation(const glslang::TIntermBinary& node)
+{
+    switch (node.getOp()) {
+    case glslang::EOpAssign:
+    case glslang::EOpAddAssign:
+    case glslang::EOpSubAssign:
+    case glslang::EOpMulAssign:
+    case glslang::EOpVectorTimesMatrixAssign:
+    case glslang::EOpVectorTimesScalarAssign:
+    case glslang::EOpMatrixTimesScalarAssign:
+    case glslang::EOpMatrixTimesMatrixAssign:
+    case glslang::EOpDivAssign:
+    case glslang::EOpModAssign:
+    case glslang::EOpAndAssign:
+    case glslang::EOpInclusiveOrAssign:
+    case glslang::EOpExclusiveOrAssign:
+    case glslang::EOpLeftShiftAssign:
+    case glslang::EOpRightShiftAssign:
+    case glslang::EOpIndexDirect:
+    case glslang::EOpIndexDirectStruct:
+    case glslang::EOpIndexIndirect:
+    case glslang::EOpVectorSwizzle:
+    case glslang::EOpMatrixSwizzle:
+        return false;
+    case glslang::EOpLogicalOr:
+    case glslang::EOpLogicalAnd:
+        return isTrivial(node.getRight()->getAsTyped());
+    default:
+        return true;
+    }
+}
 
-    // get result
-    spv::Id result = createBinaryOperation(node->getOp(), TranslatePrecisionDecoration(node->getOperationPrecision()),
-                                           TranslateNoContractionDecoration(node->getType().getQualifier()),
-                                           convertGlslangToSpvType(node->getType()), left, right,
-                                           node->getLeft()->getType().getBasicType());
+//
+// Translate the generic binary operation 'node': load the left operand, then
+// the right, and combine them.  Chains of these, like "a + b + c + ...", can
+// be much deeper than the stack, so operands that are generic binary
+// operations themselves are done here, from binaryFrames, rather than by
+// traversing them.  Leaves the result in the access chain, as an r-value.
+//
+void TGlslangToSpvTraverser::translateBinaryOperations(glslang::TIntermBinary* node)
+{
+    // frames below 'base' belong to operations whose operands are being traversed
+    const size_t base = binaryFrames.size();
+    glslang::TIntermTyped* operand = nullptr;
 
-    builder.clearAccessChain();
-    if (! result) {
-        logger->missingFunctionality("unknown glslang binary operation");
-        return true;  // pick up a child as the place-holder result
-    } else {
-        builder.setAccessChainRValue(result);
-        return false;
+    TBinaryFrame entered = { node, false, 0, spv::NoResult };
+    binaryFrames.push_back(entered);
+    while (binaryFrames.size() > base) {
+        // the frame is looked up again after each operand, which may have added frames
+        node = binaryFrames.back().node;
+
+        switch (binaryFrames.back().step++) {
+        case 0:
+            builder.setLine(node->getLoc().line);
+            binaryFrames.back().specConstantOpMode = builder.isInSpecConstCodeGenMode();
+            if (node->getType().getQualifier().isSpecConstant())
+                builder.setToSpecConstCodeGenMode();
+
+            // get left operand
+            operand = node->getLeft();
+            break;
+        case 1:
+            binaryFrames.back().left = accessChainLoad(node->getLeft()->getType());
+
+            // get right operand
+            operand = node->getRight();
+            break;
+        default:
+            {
+                spv::Id right = accessChainLoad(node->getRight()->getType());
+
+                // get result
+                spv::Id result = createBinaryOperation(node->getOp(), TranslatePrecisionDecoration(node->getOperationPrecision()),
+                                                       TranslateNoContractionDecoration(node->getType().getQualifier()),
+                                                       convertGlslangToSpvType(node->getType()), binaryFrames.back().left, right,
+                                                       node->getLeft()->getType().getBasicType());
+                if (! result) {
+                    logger->missingFunctionality("unknown glslang binary operation");
+                    result = right;  // pick up a child as the place-holder result
+                }
+
+                builder.clearAccessChain();
+                builder.setAccessChainRValue(result);
+
+                binaryFrames.back().specConstantOpMode ? builder.setToSpecConstCodeGenMode()
+                                                       : builder.setToNormalCodeGenMode();
+                binaryFrames.pop_back();
+            }
+            continue;
+        }
+
+        builder.clearAccessChain();
+        glslang::TIntermBinary* binaryOperand = operand->getAsBinaryNode();
+        if (binaryOperand != nullptr && isBinaryOperation(*binaryOperand)) {
+            TBinaryFrame operandFrame = { binaryOperand, false, 0, spv::NoResult };
+            binaryFrames.push_back(operandFrame);
+        } else
+            operand->traverse(this);
     }
 }
 
@@ -5953,10 +6057,7 @@ void OutputSpvBin(const std::vector<unsigned int>& spirv, const char* baseName)
     out.open(baseName, std::ios::binary | std::ios::out);
     if (out.fail())
         printf("ERROR: Failed to open file: %s\n", baseName);
-    for (int i = 0; i < (int)spirv.size(); ++i) {
-        unsigned int word = spirv[i];
-        out.write((const char*)&word, 4);
-    }
+    out.write((const char*)spirv.data(), spirv.size() * sizeof(unsigned int));
     out.close();
 }
 
@@ -5994,11 +6095,82 @@ void OutputSpvHex(const std::vector<unsigned int>& spirv, const char* baseName,
 void errHandler(const std::string& str) {
     std::cerr << str << std::endl;
 }
+
+// Whether the SPIR-V is to go through spirv-opt, which needs the whole module at once.
+static bool NeedsOptimizer(const glslang::TIntermediate& intermediate, const SpvOptions& options)
+{
+    // If from HLSL, run spirv-opt to "legalize" the SPIR-V for Vulkan
+    // eg. forward and remove memory writes of opaque types.
+    return (intermediate.getSource() == EShSourceHlsl ||
+                options.optimizeSize) &&
+            !options.disableOptimizer;
+}
+
+static void Optimize(std::vector<unsigned int>& spirv)
+{
+    spv_target_env target_env = SPV_ENV_UNIVERSAL_1_2;
+
+    spvtools::Optimizer optimizer(target_env);
+    optimizer.SetMessageConsumer([](spv_message_level_t level,
+                                     const char* source,
+                                     const spv_position_t& position,
+                                     const char* message) {
+        std::cerr << StringifyMessage(level, source, position, message)
+                  << std::endl;
+    });
+
+    optimizer.RegisterPass(CreateInlineExhaustivePass());
+    optimizer.RegisterPass(CreateLocalAccessChainConvertPass());
+    optimizer.RegisterPass(CreateLocalSingleBlockLoadStoreElimPass());
+    optimizer.RegisterPass(CreateLocalSingleStoreElimPass());
+    optimizer.RegisterPass(CreateInsertExtractElimPass());
+    optimizer.RegisterPass(CreateAggressiveDCEPass());
+    optimizer.RegisterPass(CreateDeadBranchElimPass());
+    optimizer.RegisterPass(CreateBlockMergePass());
+    optimizer.RegisterPass(CreateLocalMultiStoreElimPass());
+    optimizer.RegisterPass(CreateInsertExtractElimPass());
+    optimizer.RegisterPass(CreateAggressiveDCEPass());
+    // TODO(greg-lunarg): Add this when AMD driver issues are resolved
+    // if (options->optimizeSize)
+    //     optimizer.RegisterPass(CreateCommonUniformElimPass());
+
+    if (!optimizer.Run(spirv.data(), spirv.size(), &spirv))
+        return;
+
+    // Remove dead module-level objects: functions, types, vars
+    // TODO(greg-lunarg): Switch to spirv-opt versions when available
+    spv::spirvbin_t Remapper(0);
+    Remapper.registerErrorHandler(errHandler);
+    Remapper.remap(spirv, spv::spirvbin_t::DCE_ALL);
+}
 #endif
 
 //
-// Set up the glslang traversal
+// Set up the glslang traversal, and dump what it makes to 'out', which is
+// anything TGlslangToSpvTraverser::dumpSpv() takes.  Returns false if there
+// is no tree to traverse.
 //
+template<class Out>
+static bool TraverseToSpv(const glslang::TIntermediate& intermediate, Out& out,
+                          spv::SpvBuildLogger* logger, SpvOptions& options)
+{
+    TIntermNode* root = intermediate.getTreeRoot();
+
+    if (root == 0)
+        return false;
+
+    glslang::GetThreadPoolAllocator().push();
+
+    TGlslangToSpvTraverser it(&intermediate, logger, options);
+    root->traverse(&it);
+    it.finishSpv();
+    it.dumpSpv(out);
+
+    glslang::GetThreadPoolAllocator().pop();
+
+    return true;
+}
+
 void GlslangToSpv(const glslang::TIntermediate& intermediate, std::vector<unsigned int>& spirv, SpvOptions* options)
 {
     spv::SpvBuildLogger logger;
@@ -6008,66 +6180,38 @@ void GlslangToSpv(const glslang::TIntermediate& intermediate, std::vector<unsign
 void GlslangToSpv(const glslang::TIntermediate& intermediate, std::vector<unsigned int>& spirv,
                   spv::SpvBuildLogger* logger, SpvOptions* options)
 {
-    TIntermNode* root = intermediate.getTreeRoot();
+    glslang::SpvOptions defaultOptions;
+    if (options == nullptr)
+        options = &defaultOptions;
 
-    if (root == 0)
+    if (! TraverseToSpv(intermediate, spirv, logger, *options))
         return;
 
+#ifdef ENABLE_OPT
+    if (NeedsOptimizer(intermediate, *options))
+        Optimize(spirv);
+#endif
+}
+
+void GlslangToSpv(const glslang::TIntermediate& intermediate,
+                  const std::function<void(const unsigned int* words, size_t count)>& sink,
+                  spv::SpvBuildLogger* logger, SpvOptions* options)
+{
     glslang::SpvOptions defaultOptions;
     if (options == nullptr)
         options = &defaultOptions;
 
-    glslang::GetThreadPoolAllocator().push();
-
-    TGlslangToSpvTraverser it(&intermediate, logger, *options);
-    root->traverse(&it);
-    it.finishSpv();
-    it.dumpSpv(spirv);
-
 #ifdef ENABLE_OPT
-    // If from HLSL, run spirv-opt to "legalize" the SPIR-V for Vulkan
-    // eg. forward and remove memory writes of opaque types.
-    if ((intermediate.getSource() == EShSourceHlsl ||
-                options->optimizeSize) &&
-            !options->disableOptimizer) {
-        spv_target_env target_env = SPV_ENV_UNIVERSAL_1_2;
-
-        spvtools::Optimizer optimizer(target_env);
-        optimizer.SetMessageConsumer([](spv_message_level_t level,
-                                         const char* source,
-                                         const spv_position_t& position,
-                                         const char* message) {
-            std::cerr << StringifyMessage(level, source, position, message)
-                      << std::endl;
-        });
-
-        optimizer.RegisterPass(CreateInlineExhaustivePass());
-        optimizer.RegisterPass(CreateLocalAccessChainConvertPass());
-        optimizer.RegisterPass(CreateLocalSingleBlockLoadStoreElimPass());
-        optimizer.RegisterPass(CreateLocalSingleStoreElimPass());
-        optimizer.RegisterPass(CreateInsertExtractElimPass());
-        optimizer.RegisterPass(CreateAggressiveDCEPass());
-        optimizer.RegisterPass(CreateDeadBranchElimPass());
-        optimizer.RegisterPass(CreateBlockMergePass());
-        optimizer.RegisterPass(CreateLocalMultiStoreElimPass());
-        optimizer.RegisterPass(CreateInsertExtractElimPass());
-        optimizer.RegisterPass(CreateAggressiveDCEPass());
-        // TODO(greg-lunarg): Add this when AMD driver issues are resolved
-        // if (options->optimizeSize)
-        //     optimizer.RegisterPass(CreateCommonUniformElimPass());
-
-        if (!optimizer.Run(spirv.data(), spirv.size(), &spirv))
-            return;
-
-        // Remove dead module-level objects: functions, types, vars
-        // TODO(greg-lunarg): Switch to spirv-opt versions when available
-        spv::spirvbin_t Remapper(0);
-        Remapper.registerErrorHandler(errHandler);
-        Remapper.remap(spirv, spv::spirvbin_t::DCE_ALL);
+    if (NeedsOptimizer(intermediate, *options)) {
+        std::vector<unsigned int> spirv;
+        GlslangToSpv(intermediate, spirv, logger, options);
+        if (! spirv.empty())
+            sink(spirv.data(), spirv.size());
+        return;
     }
 #endif
 
-    glslang::GetThreadPoolAllocator().pop();
+    TraverseToSpv(intermediate, sink, logger, *options);
 }
 
 }; // end namespace glslang
@@ -40,6 +40,7 @@
 
 #include "../glslang/Include/intermediate.h"
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -49,10 +50,11 @@ namespace glslang {
 
 struct SpvOptions {
     SpvOptions() : generateDebugInfo(false), disableOptimizer(true),
-        optimizeSize(false) { }
+        optimizeSize(false), forwardLoads(false) { }
     bool generateDebugInfo;
     bool disableOptimizer;
     bool optimizeSize;
+    bool forwardLoads;  // reuse values already loaded or stored in a block, see spv::Builder::setForwardLoads()
 };
 
 void GetSpirvVersion(std::string&);
@@ -60,6 +62,10 @@ void GlslangToSpv(const glslang::TIntermediate& intermediate, std::vector<unsign
                   SpvOptions* options = nullptr);
 void GlslangToSpv(const glslang::TIntermediate& intermediate, std::vector<unsigned int>& spirv,
                   spv::SpvBuildLogger* logger, SpvOptions* options = nullptr);
+// Hand the SPIR-V to 'sink' a buffer full at a time, rather than gathering it all.
+void GlslangToSpv(const glslang::TIntermediate& intermediate,
+                  const std::function<void(const unsigned int* words, size_t count)>& sink,
+                  spv::SpvBuildLogger* logger, SpvOptions* options = nullptr);
 void OutputSpvBin(const std::vector<unsigned int>& spirv, const char* baseName);
 void OutputSpvHex(const std::vector<unsigned int>& spirv, const char* baseName, const char* varName);
 
@@ -56,12 +56,54 @@
 
 namespace spv {
 
+namespace {
+
+// The hash by which types and constants are found in Builder::hashedTypes and
+// Builder::hashedConstants.
+size_t HashOperands(unsigned opcode, Id typeId, const Id* operands, int numOperands)
+{
+    size_t hash = opcode * 0x9E3779B9u + typeId;
+    for (int op = 0; op < numOperands; ++op)
+        hash = (hash ^ operands[op]) * 16777619u;
+
+    return hash;
+}
+
+bool SameOperands(const Instruction& instr, const Id* operands, int numOperands)
+{
+    if (instr.getNumOperands() != numOperands)
+        return false;
+    for (int op = 0; op < numOperands; ++op) {
+        if (instr.getIdOperand(op) != operands[op])
+            return false;
+    }
+
+    return true;
+}
+
+std::vector<Id> GetOperands(const Instruction& instr)
+{
+    std::vector<Id> operands(instr.getNumOperands());
+    for (int op = 0; op < instr.getNumOperands(); ++op)
+        operands[op] = instr.getIdOperand(op);
+
+    return operands;
+}
+
+bool IsCompositeConstant(Op opcode)
+{
+    return opcode == OpConstantComposite || opcode == OpSpecConstantComposite;
+}
+
+} // end anonymous namespace
+
 Builder::Builder(unsigned int magicNumber, SpvBuildLogger* buildLogger) :
     source(SourceLanguageUnknown),
     sourceVersion(0),
     sourceFileStringId(NoResult),
     currentLine(0),
     emitOpLines(false),
+    forwardLoads(false),
     addressModel(AddressingModelLogical),
     memoryModel(MemoryModelGLSL450),
     builderNumber(magicNumber),
@@ -69,6 +111,8 @@ Builder::Builder(unsigned int magicNumber, SpvBuildLogger* buildLogger) :
     uniqueId(0),
     entryPointFunction(0),
     generatingOpCodeForSpecConst(false),
+    forwardingBlock(NoResult),
+    forwardingScanned(0),
     logger(buildLogger)
 {
     clearAccessChain();
@@ -80,7 +124,7 @@ Builder::~Builder()
 
 Id Builder::import(const char* name)
 {
-    Instruction* import = new Instruction(getUniqueId(), NoType, OpExtInstImport);
+    Instruction* import = new (module) Instruction(getUniqueId(), NoType, OpExtInstImport);
     import->addStringOperand(name);
 
     imports.push_back(std::unique_ptr<Instruction>(import));
@@ -100,7 +144,7 @@ void Builder::setLine(int lineNum)
 
 void Builder::addLine(Id fileName, int lineNum, int column)
 {
-    Instruction* line = new Instruction(OpLine);
+    Instruction* line = new (module) Instruction(OpLine);
     line->addIdOperand(fileName);
     line->addImmediateOperand(lineNum);
     line->addImmediateOperand(column);
@@ -112,8 +156,8 @@ Id Builder::makeVoidType()
 {
     Instruction* type;
     if (groupedTypes[OpTypeVoid].size() == 0) {
-        type = new Instruction(getUniqueId(), NoType, OpTypeVoid);
-        groupedTypes[OpTypeVoid].push_back(type);
+        type = new (module) Instruction(getUniqueId(), NoType, OpTypeVoid);
+        groupType(type);
         constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
         module.mapInstruction(type);
     } else
@@ -126,8 +170,8 @@ Id Builder::makeBoolType()
 {
     Instruction* type;
     if (groupedTypes[OpTypeBool].size() == 0) {
-        type = new Instruction(getUniqueId(), NoType, OpTypeBool);
-        groupedTypes[OpTypeBool].push_back(type);
+        type = new (module) Instruction(getUniqueId(), NoType, OpTypeBool);
+        groupType(type);
         constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
         module.mapInstruction(type);
     } else
@@ -140,8 +184,8 @@ Id Builder::makeSamplerType()
 {
     Instruction* type;
     if (groupedTypes[OpTypeSampler].size() == 0) {
-        type = new Instruction(getUniqueId(), NoType, OpTypeSampler);
-        groupedTypes[OpTypeSampler].push_back(type);
+        type = new (module) Instruction(getUniqueId(), NoType, OpTypeSampler);
+        groupType(type);
         constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
         module.mapInstruction(type);
     } else
@@ -153,19 +197,16 @@ Id Builder::makeSamplerType()
 Id Builder::makePointer(StorageClass storageClass, Id pointee)
 {
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypePointer].size(); ++t) {
-        type = groupedTypes[OpTypePointer][t];
-        if (type->getImmediateOperand(0) == (unsigned)storageClass &&
-            type->getIdOperand(1) == pointee)
-            return type->getResultId();
-    }
+    const Id operands[] = { (Id)storageClass, pointee };
+    Instruction* type = findType(OpTypePointer, operands, 2);
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypePointer);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypePointer);
     type->addImmediateOperand(storageClass);
     type->addIdOperand(pointee);
-    groupedTypes[OpTypePointer].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
@@ -175,19 +216,16 @@ Id Builder::makePointer(StorageClass storageClass, Id pointee)
 Id Builder::makeIntegerType(int width, bool hasSign)
 {
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeInt].size(); ++t) {
-        type = groupedTypes[OpTypeInt][t];
-        if (type->getImmediateOperand(0) == (unsigned)width &&
-            type->getImmediateOperand(1) == (hasSign ? 1u : 0u))
-            return type->getResultId();
-    }
+    const Id operands[] = { (Id)width, hasSign ? 1u : 0u };
+    Instruction* type = findType(OpTypeInt, operands, 2);
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeInt);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeInt);
     type->addImmediateOperand(width);
     type->addImmediateOperand(hasSign ? 1 : 0);
-    groupedTypes[OpTypeInt].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
@@ -209,17 +247,15 @@ Id Builder::makeIntegerType(int width, bool hasSign)
 Id Builder::makeFloatType(int width)
 {
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeFloat].size(); ++t) {
-        type = groupedTypes[OpTypeFloat][t];
-        if (type->getImmediateOperand(0) == (unsigned)width)
-            return type->getResultId();
-    }
+    const Id operands[] = { (Id)width };
+    Instruction* type = findType(OpTypeFloat, operands, 1);
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeFloat);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeFloat);
     type->addImmediateOperand(width);
-    groupedTypes[OpTypeFloat].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
@@ -248,10 +284,10 @@ Id Builder::makeStructType(const std::vector<Id>& members, const char* name)
     // structs can be duplicated except for decorations.
 
     // not found, make it
-    Instruction* type = new Instruction(getUniqueId(), NoType, OpTypeStruct);
+    Instruction* type = new (module) Instruction(getUniqueId(), NoType, OpTypeStruct);
     for (int op = 0; op < (int)members.size(); ++op)
         type->addIdOperand(members[op]);
-    groupedTypes[OpTypeStruct].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
     addName(type->getResultId(), name);
@@ -264,16 +300,10 @@ Id Builder::makeStructType(const std::vector<Id>& members, const char* name)
 Id Builder::makeStructResultType(Id type0, Id type1)
 {
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeStruct].size(); ++t) {
-        type = groupedTypes[OpTypeStruct][t];
-        if (type->getNumOperands() != 2)
-            continue;
-        if (type->getIdOperand(0) != type0 ||
-            type->getIdOperand(1) != type1)
-            continue;
+    const Id operands[] = { type0, type1 };
+    Instruction* type = findType(OpTypeStruct, operands, 2);
+    if (type != nullptr)
         return type->getResultId();
-    }
 
     // not found, make it
     std::vector<spv::Id> members;
@@ -286,19 +316,16 @@ Id Builder::makeStructResultType(Id type0, Id type1)
 Id Builder::makeVectorType(Id component, int size)
 {
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeVector].size(); ++t) {
-        type = groupedTypes[OpTypeVector][t];
-        if (type->getIdOperand(0) == component &&
-            type->getImmediateOperand(1) == (unsigned)size)
-            return type->getResultId();
-    }
+    const Id operands[] = { component, (Id)size };
+    Instruction* type = findType(OpTypeVector, operands, 2);
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeVector);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeVector);
     type->addIdOperand(component);
     type->addImmediateOperand(size);
-    groupedTypes[OpTypeVector].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
@@ -312,26 +339,22 @@ Id Builder::makeMatrixType(Id component, int cols, int rows)
     Id column = makeVectorType(component, rows);
 
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeMatrix].size(); ++t) {
-        type = groupedTypes[OpTypeMatrix][t];
-        if (type->getIdOperand(0) == column &&
-            type->getImmediateOperand(1) == (unsigned)cols)
-            return type->getResultId();
-    }
+    const Id operands[] = { column, (Id)cols };
+    Instruction* type = findType(OpTypeMatrix, operands, 2);
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeMatrix);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeMatrix);
     type->addIdOperand(column);
     type->addImmediateOperand(cols);
-    groupedTypes[OpTypeMatrix].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
     return type->getResultId();
 }
 
-// TODO: performance: track arrays per stride
 // If a stride is supplied (non-zero) make an array.
 // If no stride (0), reuse previous array types.
 // 'size' is an Id of a constant or specialization constant of the array size
@@ -340,19 +363,17 @@ Id Builder::makeArrayType(Id element, Id sizeId, int stride)
     Instruction* type;
     if (stride == 0) {
         // try to find existing type
-        for (int t = 0; t < (int)groupedTypes[OpTypeArray].size(); ++t) {
-            type = groupedTypes[OpTypeArray][t];
-            if (type->getIdOperand(0) == element &&
-                type->getIdOperand(1) == sizeId)
-                return type->getResultId();
-        }
+        const Id operands[] = { element, sizeId };
+        type = findType(OpTypeArray, operands, 2);
+        if (type != nullptr)
+            return type->getResultId();
     }
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeArray);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeArray);
     type->addIdOperand(element);
     type->addIdOperand(sizeId);
-    groupedTypes[OpTypeArray].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
@@ -361,7 +382,7 @@ Id Builder::makeArrayType(Id element, Id sizeId, int stride)
 
 Id Builder::makeRuntimeArray(Id element)
 {
-    Instruction* type = new Instruction(getUniqueId(), NoType, OpTypeRuntimeArray);
+    Instruction* type = new (module) Instruction(getUniqueId(), NoType, OpTypeRuntimeArray);
     type->addIdOperand(element);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
@@ -372,28 +393,18 @@ Id Builder::makeRuntimeArray(Id element)
 Id Builder::makeFunctionType(Id returnType, const std::vector<Id>& paramTypes)
 {
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeFunction].size(); ++t) {
-        type = groupedTypes[OpTypeFunction][t];
-        if (type->getIdOperand(0) != returnType || (int)paramTypes.size() != type->getNumOperands() - 1)
-            continue;
-        bool mismatch = false;
-        for (int p = 0; p < (int)paramTypes.size(); ++p) {
-            if (paramTypes[p] != type->getIdOperand(p + 1)) {
-                mismatch = true;
-                break;
-            }
-        }
-        if (! mismatch)
-            return type->getResultId();
-    }
+    std::vector<Id> operands(1, returnType);
+    operands.insert(operands.end(), paramTypes.begin(), paramTypes.end());
+    Instruction* type = findType(OpTypeFunction, operands.data(), (int)operands.size());
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeFunction);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeFunction);
     type->addIdOperand(returnType);
     for (int p = 0; p < (int)paramTypes.size(); ++p)
         type->addIdOperand(paramTypes[p]);
-    groupedTypes[OpTypeFunction].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
@@ -405,21 +416,14 @@ Id Builder::makeImageType(Id sampledType, Dim dim, bool depth, bool arrayed, boo
     assert(sampled == 1 || sampled == 2);
 
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeImage].size(); ++t) {
-        type = groupedTypes[OpTypeImage][t];
-        if (type->getIdOperand(0) == sampledType &&
-            type->getImmediateOperand(1) == (unsigned int)dim &&
-            type->getImmediateOperand(2) == (  depth ? 1u : 0u) &&
-            type->getImmediateOperand(3) == (arrayed ? 1u : 0u) &&
-            type->getImmediateOperand(4) == (     ms ? 1u : 0u) &&
-            type->getImmediateOperand(5) == sampled &&
-            type->getImmediateOperand(6) == (unsigned int)format)
-            return type->getResultId();
-    }
+    const Id operands[] = { sampledType, (Id)dim, depth ? 1u : 0u, arrayed ? 1u : 0u, ms ? 1u : 0u, sampled,
+                            (Id)format };
+    Instruction* type = findType(OpTypeImage, operands, 7);
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeImage);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeImage);
     type->addIdOperand(sampledType);
     type->addImmediateOperand(   dim);
     type->addImmediateOperand(  depth ? 1 : 0);
@@ -428,7 +432,7 @@ Id Builder::makeImageType(Id sampledType, Dim dim, bool depth, bool arrayed, boo
     type->addImmediateOperand(sampled);
     type->addImmediateOperand((unsigned int)format);
 
-    groupedTypes[OpTypeImage].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
@@ -481,24 +485,66 @@ Id Builder::makeImageType(Id sampledType, Dim dim, bool depth, bool arrayed, boo
 Id Builder::makeSampledImageType(Id imageType)
 {
     // try to find it
-    Instruction* type;
-    for (int t = 0; t < (int)groupedTypes[OpTypeSampledImage].size(); ++t) {
-        type = groupedTypes[OpTypeSampledImage][t];
-        if (type->getIdOperand(0) == imageType)
-            return type->getResultId();
-    }
+    Instruction* type = findType(OpTypeSampledImage, &imageType, 1);
+    if (type != nullptr)
+        return type->getResultId();
 
     // not found, make it
-    type = new Instruction(getUniqueId(), NoType, OpTypeSampledImage);
+    type = new (module) Instruction(getUniqueId(), NoType, OpTypeSampledImage);
     type->addIdOperand(imageType);
 
-    groupedTypes[OpTypeSampledImage].push_back(type);
+    groupType(type);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(type));
     module.mapInstruction(type);
 
     return type->getResultId();
 }
 
+// Find a type that was already made, other than by makeStructType(), which
+// doesn't look for one.
+Instruction* Builder::findType(Op opcode, const Id* operands, int numOperands) const
+{
+    const auto candidates = hashedTypes.equal_range(HashOperands(opcode, NoType, operands, numOperands));
+    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+        if (candidate->second->getOpCode() == opcode && SameOperands(*candidate->second, operands, numOperands))
+            return candidate->second;
+    }
+
+    return nullptr;
+}
+
+// Record a new type, for the lookups of later ones.
+void Builder::groupType(Instruction* type)
+{
+    groupedTypes[type->getOpCode()].push_back(type);
+
+    const std::vector<Id> operands = GetOperands(*type);
+    if (findType(type->getOpCode(), operands.data(), (int)operands.size()) == nullptr) {
+        hashedTypes.insert(std::make_pair(HashOperands(type->getOpCode(), NoType, operands.data(), (int)operands.size()),
+                                          type));
+    }
+}
+
+// Record a new constant, for the lookups of later ones.  Composite ones are
+// found by their type class rather than their type.
+void Builder::groupConstant(Op typeClass, Instruction* constant)
+{
+    groupedConstants[typeClass].push_back(constant);
+
+    const std::vector<Id> operands = GetOperands(*constant);
+    size_t hash;
+    if (IsCompositeConstant(constant->getOpCode())) {
+        if (findCompositeConstant(typeClass, operands) != NoResult)
+            return;
+        hash = HashOperands(typeClass, NoType, operands.data(), (int)operands.size());
+    } else {
+        if (findConstant(constant->getOpCode(), constant->getTypeId(), operands.data(), (int)operands.size()) != 0)
+            return;
+        hash = HashOperands(constant->getOpCode(), constant->getTypeId(), operands.data(), (int)operands.size());
+    }
+    hashedConstants.insert(std::make_pair(hash, constant));
+}
+
 Id Builder::getDerefTypeId(Id resultId) const
 {
     Id typeId = getTypeId(resultId);
@@ -618,30 +664,26 @@ Id Builder::getContainedTypeId(Id typeId) const
 
 // See if a scalar constant of this type has already been created, so it
 // can be reused rather than duplicated.  (Required by the specification).
-Id Builder::findScalarConstant(Op typeClass, Op opcode, Id typeId, unsigned value) const
-{
-    Instruction* constant;
-    for (int i = 0; i < (int)groupedConstants[typeClass].size(); ++i) {
-        constant = groupedConstants[typeClass][i];
-        if (constant->getOpCode() == opcode &&
-            constant->getTypeId() == typeId &&
-            constant->getImmediateOperand(0) == value)
-            return constant->getResultId();
-    }
-
-    return 0;
+Id Builder::findScalarConstant(Op /*typeClass*/, Op opcode, Id typeId, unsigned value) const
+{
+    return findConstant(opcode, typeId, &value, 1);
 }
 
 // Version of findScalarConstant (see above) for scalars that take two operands (e.g. a 'double' or 'int64').
-Id Builder::findScalarConstant(Op typeClass, Op opcode, Id typeId, unsigned v1, unsigned v2) const
-{
-    Instruction* constant;
-    for (int i = 0; i < (int)groupedConstants[typeClass].size(); ++i) {
-        constant = groupedConstants[typeClass][i];
-        if (constant->getOpCode() == opcode &&
-            constant->getTypeId() == typeId &&
-            constant->getImmediateOperand(0) == v1 &&
-            constant->getImmediateOperand(1) == v2)
+Id Builder::findScalarConstant(Op /*typeClass*/, Op opcode, Id typeId, unsigned v1, unsigned v2) const
+{
+    const Id operands[] = { v1, v2 };
+    return findConstant(opcode, typeId, operands, 2);
+}
+
+// Find a constant, other than a composite one, that was already made.
+Id Builder::findConstant(Op opcode, Id typeId, const Id* operands, int numOperands) const
+{
+    const auto candidates = hashedConstants.equal_range(HashOperands(opcode, typeId, operands, numOperands));
+    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+        const Instruction* constant = candidate->second;
+        if (constant->getOpCode() == opcode && constant->getTypeId() == typeId &&
+            SameOperands(*constant, operands, numOperands))
             return constant->getResultId();
     }
 
@@ -690,27 +732,20 @@ bool Builder::isSpecConstantOpCode(Op opcode) const
 Id Builder::makeBoolConstant(bool b, bool specConstant)
 {
     Id typeId = makeBoolType();
-    Instruction* constant;
     Op opcode = specConstant ? (b ? OpSpecConstantTrue : OpSpecConstantFalse) : (b ? OpConstantTrue : OpConstantFalse);
 
     // See if we already made it. Applies only to regular constants, because specialization constants
     // must remain distinct for the purpose of applying a SpecId decoration.
     if (! specConstant) {
-        Id existing = 0;
-        for (int i = 0; i < (int)groupedConstants[OpTypeBool].size(); ++i) {
-            constant = groupedConstants[OpTypeBool][i];
-            if (constant->getTypeId() == typeId && constant->getOpCode() == opcode)
-                existing = constant->getResultId();
-        }
-
+        Id existing = findConstant(opcode, typeId, nullptr, 0);
         if (existing)
             return existing;
     }
 
     // Make it
-    Instruction* c = new Instruction(getUniqueId(), typeId, opcode);
+    Instruction* c = new (module) Instruction(getUniqueId(), typeId, opcode);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(c));
-    groupedConstants[OpTypeBool].push_back(c);
+    groupConstant(OpTypeBool, c);
     module.mapInstruction(c);
 
     return c->getResultId();
@@ -728,10 +763,10 @@ Id Builder::makeIntConstant(Id typeId, unsigned value, bool specConstant)
             return existing;
     }
 
-    Instruction* c = new Instruction(getUniqueId(), typeId, opcode);
+    Instruction* c = new (module) Instruction(getUniqueId(), typeId, opcode);
     c->addImmediateOperand(value);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(c));
-    groupedConstants[OpTypeInt].push_back(c);
+    groupConstant(OpTypeInt, c);
     module.mapInstruction(c);
 
     return c->getResultId();
@@ -752,11 +787,11 @@ Id Builder::makeInt64Constant(Id typeId, unsigned long long value, bool specCons
             return existing;
     }
 
-    Instruction* c = new Instruction(getUniqueId(), typeId, opcode);
+    Instruction* c = new (module) Instruction(getUniqueId(), typeId, opcode);
     c->addImmediateOperand(op1);
     c->addImmediateOperand(op2);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(c));
-    groupedConstants[OpTypeInt].push_back(c);
+    groupConstant(OpTypeInt, c);
     module.mapInstruction(c);
 
     return c->getResultId();
@@ -778,10 +813,10 @@ Id Builder::makeFloatConstant(float f, bool specConstant)
             return existing;
     }
 
-    Instruction* c = new Instruction(getUniqueId(), typeId, opcode);
+    Instruction* c = new (module) Instruction(getUniqueId(), typeId, opcode);
     c->addImmediateOperand(value);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(c));
-    groupedConstants[OpTypeFloat].push_back(c);
+    groupConstant(OpTypeFloat, c);
     module.mapInstruction(c);
 
     return c->getResultId();
@@ -805,11 +840,11 @@ Id Builder::makeDoubleConstant(double d, bool specConstant)
             return existing;
     }
 
-    Instruction* c = new Instruction(getUniqueId(), typeId, opcode);
+    Instruction* c = new (module) Instruction(getUniqueId(), typeId, opcode);
     c->addImmediateOperand(op1);
     c->addImmediateOperand(op2);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(c));
-    groupedConstants[OpTypeFloat].push_back(c);
+    groupConstant(OpTypeFloat, c);
     module.mapInstruction(c);
 
     return c->getResultId();
@@ -835,42 +870,30 @@ Id Builder::makeFloat16Constant(float f16, bool specConstant)
             return existing;
     }
 
-    Instruction* c = new Instruction(getUniqueId(), typeId, opcode);
+    Instruction* c = new (module) Instruction(getUniqueId(), typeId, opcode);
     c->addImmediateOperand(value);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(c));
-    groupedConstants[OpTypeFloat].push_back(c);
+    groupConstant(OpTypeFloat, c);
     module.mapInstruction(c);
 
     return c->getResultId();
 }
 #endif
 
+// Find a composite constant of the type class 'typeClass' that was already
+// made of 'comps'.
 Id Builder::findCompositeConstant(Op typeClass, const std::vector<Id>& comps) const
 {
-    Instruction* constant = 0;
-    bool found = false;
-    for (int i = 0; i < (int)groupedConstants[typeClass].size(); ++i) {
-        constant = groupedConstants[typeClass][i];
-
-        // same shape?
-        if (constant->getNumOperands() != (int)comps.size())
-            continue;
-
-        // same contents?
-        bool mismatch = false;
-        for (int op = 0; op < constant->getNumOperands(); ++op) {
-            if (constant->getIdOperand(op) != comps[op]) {
-                mismatch = true;
-                break;
-            }
-        }
-        if (! mismatch) {
-            found = true;
-            break;
-        }
+    const auto candidates = hashedConstants.equal_range(HashOperands(typeClass, NoType, comps.data(),
+                                                                     (int)comps.size()));
+    for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+        const Instruction* constant = candidate->second;
+        if (IsCompositeConstant(constant->getOpCode()) && getTypeClass(constant->getTypeId()) == typeClass &&
+            SameOperands(*constant, comps.data(), (int)comps.size()))
+            return constant->getResultId();
     }
 
-    return found ? constant->getResultId() : NoResult;
+    return NoResult;
 }
 
 // Comments in header
@@ -897,11 +920,11 @@ Id Builder::makeCompositeConstant(Id typeId, const std::vector<Id>& members, boo
             return existing;
     }
 
-    Instruction* c = new Instruction(getUniqueId(), typeId, opcode);
+    Instruction* c = new (module) Instruction(getUniqueId(), typeId, opcode);
     for (int op = 0; op < (int)members.size(); ++op)
         c->addIdOperand(members[op]);
     constantsTypesGlobals.push_back(std::unique_ptr<Instruction>(c));
-    groupedConstants[typeClass].push_back(c);
+    groupConstant(typeClass, c);
     module.mapInstruction(c);
 
     return c->getResultId();
@@ -909,7 +932,7 @@ Id Builder::makeCompositeConstant(Id typeId, const std::vector<Id>& members, boo
 
 Instruction* Builder::addEntryPoint(ExecutionModel model, Function* function, const char* name)
 {
-    Instruction* entryPoint = new Instruction(OpEntryPoint);
+    Instruction* entryPoint = new (module) Instruction(OpEntryPoint);
     entryPoint->addImmediateOperand(model);
     entryPoint->addIdOperand(function->getId());
     entryPoint->addStringOperand(name);
@@ -922,7 +945,7 @@ Instruction* Builder::addEntryPoint(ExecutionModel model, Function* function, co
 // Currently relying on the fact that all 'value' of interest are small non-negative values.
 void Builder::addExecutionMode(Function* entryPoint, ExecutionMode mode, int value1, int value2, int value3)
 {
-    Instruction* instr = new Instruction(OpExecutionMode);
+    Instruction* instr = new (module) Instruction(OpExecutionMode);
     instr->addIdOperand(entryPoint->getId());
     instr->addImmediateOperand(mode);
     if (value1 >= 0)
@@ -937,7 +960,7 @@ void Builder::addExecutionMode(Function* entryPoint, ExecutionMode mode, int val
 
 void Builder::addName(Id id, const char* string)
 {
-    Instruction* name = new Instruction(OpName);
+    Instruction* name = new (module) Instruction(OpName);
     name->addIdOperand(id);
     name->addStringOperand(string);
 
@@ -946,7 +969,7 @@ void Builder::addName(Id id, const char* string)
 
 void Builder::addMemberName(Id id, int memberNumber, const char* string)
 {
-    Instruction* name = new Instruction(OpMemberName);
+    Instruction* name = new (module) Instruction(OpMemberName);
     name->addIdOperand(id);
     name->addImmediateOperand(memberNumber);
     name->addStringOperand(string);
@@ -958,7 +981,7 @@ void Builder::addDecoration(Id id, Decoration decoration, int num)
 {
     if (decoration == spv::DecorationMax)
         return;
-    Instruction* dec = new Instruction(OpDecorate);
+    Instruction* dec = new (module) Instruction(OpDecorate);
     dec->addIdOperand(id);
     dec->addImmediateOperand(decoration);
     if (num >= 0)
@@ -969,7 +992,7 @@ void Builder::addDecoration(Id id, Decoration decoration, int num)
 
 void Builder::addMemberDecoration(Id id, unsigned int member, Decoration decoration, int num)
 {
-    Instruction* dec = new Instruction(OpMemberDecorate);
+    Instruction* dec = new (module) Instruction(OpMemberDecorate);
     dec->addIdOperand(id);
     dec->addImmediateOperand(member);
     dec->addImmediateOperand(decoration);
@@ -1028,11 +1051,11 @@ Function* Builder::makeFunctionEntry(Decoration precision, Id returnType, const
 void Builder::makeReturn(bool implicit, Id retVal)
 {
     if (retVal) {
-        Instruction* inst = new Instruction(NoResult, NoType, OpReturnValue);
+        Instruction* inst = new (module) Instruction(NoResult, NoType, OpReturnValue);
         inst->addIdOperand(retVal);
         buildPoint->addInstruction(std::unique_ptr<Instruction>(inst));
     } else
-        buildPoint->addInstruction(std::unique_ptr<Instruction>(new Instruction(NoResult, NoType, OpReturn)));
+        buildPoint->addInstruction(std::unique_ptr<Instruction>(new (module) Instruction(NoResult, NoType, OpReturn)));
 
     if (! implicit)
         createAndSetNoPredecessorBlock("post-return");
@@ -1058,7 +1081,7 @@ void Builder::leaveFunction()
 // Comments in header
 void Builder::makeDiscard()
 {
-    buildPoint->addInstruction(std::unique_ptr<Instruction>(new Instruction(OpKill)));
+    buildPoint->addInstruction(std::unique_ptr<Instruction>(new (module) Instruction(OpKill)));
     createAndSetNoPredecessorBlock("post-discard");
 }
 
@@ -1066,7 +1089,7 @@ void Builder::makeDiscard()
 Id Builder::createVariable(StorageClass storageClass, Id type, const char* name)
 {
     Id pointerType = makePointer(storageClass, type);
-    Instruction* inst = new Instruction(getUniqueId(), pointerType, OpVariable);
+    Instruction* inst = new (module) Instruction(getUniqueId(), pointerType, OpVariable);
     inst->addImmediateOperand(storageClass);
 
     switch (storageClass) {
@@ -1090,7 +1113,7 @@ Id Builder::createVariable(StorageClass storageClass, Id type, const char* name)
 // Comments in header
 Id Builder::createUndefined(Id type)
 {
-  Instruction* inst = new Instruction(getUniqueId(), type, OpUndef);
+  Instruction* inst = new (module) Instruction(getUniqueId(), type, OpUndef);
   buildPoint->addInstruction(std::unique_ptr<Instruction>(inst));
   return inst->getResultId();
 }
@@ -1098,7 +1121,7 @@ Id Builder::createUndefined(Id type)
 // Comments in header
 void Builder::createStore(Id rValue, Id lValue)
 {
-    Instruction* store = new Instruction(OpStore);
+    Instruction* store = new (module) Instruction(OpStore);
     store->addIdOperand(lValue);
     store->addIdOperand(rValue);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(store));
@@ -1107,13 +1130,130 @@ void Builder::createStore(Id rValue, Id lValue)
 // Comments in header
 Id Builder::createLoad(Id lValue)
 {
-    Instruction* load = new Instruction(getUniqueId(), getDerefTypeId(lValue), OpLoad);
+    const Id forwarded = findForwardedValue(lValue);
+    if (forwarded != NoResult)
+        return forwarded;
+
+    Instruction* load = new (module) Instruction(getUniqueId(), getDerefTypeId(lValue), OpLoad);
     load->addIdOperand(lValue);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(load));
 
     return load->getResultId();
 }
 
+// The value the variable 'pointer' is known to hold, from a load or store
+// earlier in the current block, or NoResult if it isn't known.
+Id Builder::findForwardedValue(Id pointer)
+{
+    if (! forwardLoads || buildPoint == nullptr)
+        return NoResult;
+
+    updateForwardedValues();
+    const auto value = forwardedValues.find(pointer);
+
+    return value != forwardedValues.end() ? value->second : NoResult;
+}
+
+// Bring forwardedValues up to date with the instructions added to the
+// current block since it was last updated.  Anything that could write a
+// variable in ways not followed here forgets all values.
+void Builder::updateForwardedValues()
+{
+    const std::vector<std::unique_ptr<Instruction> >& instructions = buildPoint->getInstructions();
+    if (buildPoint->getId() != forwardingBlock) {
+        forwardedValues.clear();
+        forwardingBlock = buildPoint->getId();
+        forwardingScanned = instructions.size();
+        return;
+    }
+
+    for (; forwardingScanned < instructions.size(); ++forwardingScanned) {
+        const Instruction& instruction = *instructions[forwardingScanned];
+        switch (instruction.getOpCode()) {
+        case OpLoad:
+            if (isForwardedVariable(instruction.getIdOperand(0)))
+                forwardedValues[instruction.getIdOperand(0)] = instruction.getResultId();
+            break;
+
+        case OpStore:
+        {
+            if (isForwardedVariable(instruction.getIdOperand(0))) {
+                forwardedValues[instruction.getIdOperand(0)] = instruction.getIdOperand(1);
+                break;
+            }
+
+            // a store into part of a variable only changes that variable
+            Id base = instruction.getIdOperand(0);
+            const Instruction* chain = module.findInstruction(base);
+            while (chain != nullptr &&
+                   (chain->getOpCode() == OpAccessChain || chain->getOpCode() == OpInBoundsAccessChain)) {
+                base = chain->getIdOperand(0);
+                chain = module.findInstruction(base);
+            }
+            if (isForwardedVariable(base))
+                forwardedValues.erase(base);
+            else
+                forwardedValues.clear();
+            break;
+        }
+
+        default:
+            if (mayWriteMemory(instruction))
+                forwardedValues.clear();
+            break;
+        }
+    }
+}
+
+// Whether the values held by 'pointer' are followed for forwarding: it must
+// be a variable that only this invocation writes, or that isn't written.
+bool Builder::isForwardedVariable(Id pointer) const
+{
+    const Instruction* variable = module.findInstruction(pointer);
+    if (variable == nullptr || variable->getOpCode() != OpVariable)
+        return false;
+
+    switch (variable->getImmediateOperand(0)) {
+    case StorageClassFunction:
+    case StorageClassPrivate:
+    case StorageClassInput:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Whether 'instruction', other than a load or store, could write a variable:
+// calls and barriers might, as might anything taking a pointer that doesn't
+// just compute another pointer.  An operand that is a literal rather than an
+// id can only make this more cautious.
+bool Builder::mayWriteMemory(const Instruction& instruction) const
+{
+    switch (instruction.getOpCode()) {
+    case OpFunctionCall:
+    case OpControlBarrier:
+    case OpMemoryBarrier:
+        return true;
+    case OpAccessChain:
+    case OpInBoundsAccessChain:
+    case OpArrayLength:
+        return false;
+    default:
+        break;
+    }
+
+    for (int op = 0; op < instruction.getNumOperands(); ++op) {
+        const Instruction* operand = module.findInstruction(instruction.getIdOperand(op));
+        if (operand == nullptr || operand->getTypeId() == NoType)
+            continue;
+        const Instruction* type = module.findInstruction(operand->getTypeId());
+        if (type != nullptr && type->getOpCode() == OpTypePointer)
+            return true;
+    }
+
+    return false;
+}
+
 // Comments in header
 Id Builder::createAccessChain(StorageClass storageClass, Id base, const std::vector<Id>& offsets)
 {
@@ -1131,7 +1271,7 @@ Id Builder::createAccessChain(StorageClass storageClass, Id base, const std::vec
     typeId = makePointer(storageClass, typeId);
 
     // Make the instruction
-    Instruction* chain = new Instruction(getUniqueId(), typeId, OpAccessChain);
+    Instruction* chain = new (module) Instruction(getUniqueId(), typeId, OpAccessChain);
     chain->addIdOperand(base);
     for (int i = 0; i < (int)offsets.size(); ++i)
         chain->addIdOperand(offsets[i]);
@@ -1143,7 +1283,7 @@ Id Builder::createAccessChain(StorageClass storageClass, Id base, const std::vec
 Id Builder::createArrayLength(Id base, unsigned int member)
 {
     spv::Id intType = makeIntType(32);
-    Instruction* length = new Instruction(getUniqueId(), intType, OpArrayLength);
+    Instruction* length = new (module) Instruction(getUniqueId(), intType, OpArrayLength);
     length->addIdOperand(base);
     length->addImmediateOperand(member);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(length));
@@ -1158,7 +1298,7 @@ Id Builder::createCompositeExtract(Id composite, Id typeId, unsigned index)
     if (generatingOpCodeForSpecConst) {
         return createSpecConstantOp(OpCompositeExtract, typeId, std::vector<Id>(1, composite), std::vector<Id>(1, index));
     }
-    Instruction* extract = new Instruction(getUniqueId(), typeId, OpCompositeExtract);
+    Instruction* extract = new (module) Instruction(getUniqueId(), typeId, OpCompositeExtract);
     extract->addIdOperand(composite);
     extract->addImmediateOperand(index);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(extract));
@@ -1173,7 +1313,7 @@ Id Builder::createCompositeExtract(Id composite, Id typeId, const std::vector<un
     if (generatingOpCodeForSpecConst) {
         return createSpecConstantOp(OpCompositeExtract, typeId, std::vector<Id>(1, composite), indexes);
     }
-    Instruction* extract = new Instruction(getUniqueId(), typeId, OpCompositeExtract);
+    Instruction* extract = new (module) Instruction(getUniqueId(), typeId, OpCompositeExtract);
     extract->addIdOperand(composite);
     for (int i = 0; i < (int)indexes.size(); ++i)
         extract->addImmediateOperand(indexes[i]);
@@ -1184,7 +1324,7 @@ Id Builder::createCompositeExtract(Id composite, Id typeId, const std::vector<un
 
 Id Builder::createCompositeInsert(Id object, Id composite, Id typeId, unsigned index)
 {
-    Instruction* insert = new Instruction(getUniqueId(), typeId, OpCompositeInsert);
+    Instruction* insert = new (module) Instruction(getUniqueId(), typeId, OpCompositeInsert);
     insert->addIdOperand(object);
     insert->addIdOperand(composite);
     insert->addImmediateOperand(index);
@@ -1195,7 +1335,7 @@ Id Builder::createCompositeInsert(Id object, Id composite, Id typeId, unsigned i
 
 Id Builder::createCompositeInsert(Id object, Id composite, Id typeId, const std::vector<unsigned>& indexes)
 {
-    Instruction* insert = new Instruction(getUniqueId(), typeId, OpCompositeInsert);
+    Instruction* insert = new (module) Instruction(getUniqueId(), typeId, OpCompositeInsert);
     insert->addIdOperand(object);
     insert->addIdOperand(composite);
     for (int i = 0; i < (int)indexes.size(); ++i)
@@ -1207,7 +1347,7 @@ Id Builder::createCompositeInsert(Id object, Id composite, Id typeId, const std:
 
 Id Builder::createVectorExtractDynamic(Id vector, Id typeId, Id componentIndex)
 {
-    Instruction* extract = new Instruction(getUniqueId(), typeId, OpVectorExtractDynamic);
+    Instruction* extract = new (module) Instruction(getUniqueId(), typeId, OpVectorExtractDynamic);
     extract->addIdOperand(vector);
     extract->addIdOperand(componentIndex);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(extract));
@@ -1217,7 +1357,7 @@ Id Builder::createVectorExtractDynamic(Id vector, Id typeId, Id componentIndex)
 
 Id Builder::createVectorInsertDynamic(Id vector, Id typeId, Id component, Id componentIndex)
 {
-    Instruction* insert = new Instruction(getUniqueId(), typeId, OpVectorInsertDynamic);
+    Instruction* insert = new (module) Instruction(getUniqueId(), typeId, OpVectorInsertDynamic);
     insert->addIdOperand(vector);
     insert->addIdOperand(component);
     insert->addIdOperand(componentIndex);
@@ -1229,14 +1369,14 @@ Id Builder::createVectorInsertDynamic(Id vector, Id typeId, Id component, Id com
 // An opcode that has no operands, no result id, and no type
 void Builder::createNoResultOp(Op opCode)
 {
-    Instruction* op = new Instruction(opCode);
+    Instruction* op = new (module) Instruction(opCode);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
 }
 
 // An opcode that has one operand, no result id, and no type
 void Builder::createNoResultOp(Op opCode, Id operand)
 {
-    Instruction* op = new Instruction(opCode);
+    Instruction* op = new (module) Instruction(opCode);
     op->addIdOperand(operand);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
 }
@@ -1244,7 +1384,7 @@ void Builder::createNoResultOp(Op opCode, Id operand)
 // An opcode that has one operand, no result id, and no type
 void Builder::createNoResultOp(Op opCode, const std::vector<Id>& operands)
 {
-    Instruction* op = new Instruction(opCode);
+    Instruction* op = new (module) Instruction(opCode);
     for (auto it = operands.cbegin(); it != operands.cend(); ++it)
         op->addIdOperand(*it);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
@@ -1252,7 +1392,7 @@ void Builder::createNoResultOp(Op opCode, const std::vector<Id>& operands)
 
 void Builder::createControlBarrier(Scope execution, Scope memory, MemorySemanticsMask semantics)
 {
-    Instruction* op = new Instruction(OpControlBarrier);
+    Instruction* op = new (module) Instruction(OpControlBarrier);
     op->addImmediateOperand(makeUintConstant(execution));
     op->addImmediateOperand(makeUintConstant(memory));
     op->addImmediateOperand(makeUintConstant(semantics));
@@ -1261,7 +1401,7 @@ void Builder::createControlBarrier(Scope execution, Scope memory, MemorySemantic
 
 void Builder::createMemoryBarrier(unsigned executionScope, unsigned memorySemantics)
 {
-    Instruction* op = new Instruction(OpMemoryBarrier);
+    Instruction* op = new (module) Instruction(OpMemoryBarrier);
     op->addImmediateOperand(makeUintConstant(executionScope));
     op->addImmediateOperand(makeUintConstant(memorySemantics));
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
@@ -1275,7 +1415,7 @@ Id Builder::createUnaryOp(Op opCode, Id typeId, Id operand)
     if (generatingOpCodeForSpecConst) {
         return createSpecConstantOp(opCode, typeId, std::vector<Id>(1, operand), std::vector<Id>());
     }
-    Instruction* op = new Instruction(getUniqueId(), typeId, opCode);
+    Instruction* op = new (module) Instruction(getUniqueId(), typeId, opCode);
     op->addIdOperand(operand);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
 
@@ -1291,7 +1431,7 @@ Id Builder::createBinOp(Op opCode, Id typeId, Id left, Id right)
         operands[0] = left; operands[1] = right;
         return createSpecConstantOp(opCode, typeId, operands, std::vector<Id>());
     }
-    Instruction* op = new Instruction(getUniqueId(), typeId, opCode);
+    Instruction* op = new (module) Instruction(getUniqueId(), typeId, opCode);
     op->addIdOperand(left);
     op->addIdOperand(right);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
@@ -1311,7 +1451,7 @@ Id Builder::createTriOp(Op opCode, Id typeId, Id op1, Id op2, Id op3)
         return createSpecConstantOp(
             opCode, typeId, operands, std::vector<Id>());
     }
-    Instruction* op = new Instruction(getUniqueId(), typeId, opCode);
+    Instruction* op = new (module) Instruction(getUniqueId(), typeId, opCode);
     op->addIdOperand(op1);
     op->addIdOperand(op2);
     op->addIdOperand(op3);
@@ -1322,7 +1462,7 @@ Id Builder::createTriOp(Op opCode, Id typeId, Id op1, Id op2, Id op3)
 
 Id Builder::createOp(Op opCode, Id typeId, const std::vector<Id>& operands)
 {
-    Instruction* op = new Instruction(getUniqueId(), typeId, opCode);
+    Instruction* op = new (module) Instruction(getUniqueId(), typeId, opCode);
     for (auto it = operands.cbegin(); it != operands.cend(); ++it)
         op->addIdOperand(*it);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
@@ -1332,7 +1472,7 @@ Id Builder::createOp(Op opCode, Id typeId, const std::vector<Id>& operands)
 
 Id Builder::createSpecConstantOp(Op opCode, Id typeId, const std::vector<Id>& operands, const std::vector<unsigned>& literals)
 {
-    Instruction* op = new Instruction(getUniqueId(), typeId, OpSpecConstantOp);
+    Instruction* op = new (module) Instruction(getUniqueId(), typeId, OpSpecConstantOp);
     op->addImmediateOperand((unsigned) opCode);
     for (auto it = operands.cbegin(); it != operands.cend(); ++it)
         op->addIdOperand(*it);
@@ -1346,7 +1486,7 @@ Id Builder::createSpecConstantOp(Op opCode, Id typeId, const std::vector<Id>& op
 
 Id Builder::createFunctionCall(spv::Function* function, const std::vector<spv::Id>& args)
 {
-    Instruction* op = new Instruction(getUniqueId(), function->getReturnType(), OpFunctionCall);
+    Instruction* op = new (module) Instruction(getUniqueId(), function->getReturnType(), OpFunctionCall);
     op->addIdOperand(function->getId());
     for (int a = 0; a < (int)args.size(); ++a)
         op->addIdOperand(args[a]);
@@ -1366,7 +1506,7 @@ Id Builder::createRvalueSwizzle(Decoration precision, Id typeId, Id source, cons
         operands[0] = operands[1] = source;
         return setPrecision(createSpecConstantOp(OpVectorShuffle, typeId, operands, channels), precision);
     }
-    Instruction* swizzle = new Instruction(getUniqueId(), typeId, OpVectorShuffle);
+    Instruction* swizzle = new (module) Instruction(getUniqueId(), typeId, OpVectorShuffle);
     assert(isVector(source));
     swizzle->addIdOperand(source);
     swizzle->addIdOperand(source);
@@ -1383,7 +1523,7 @@ Id Builder::createLvalueSwizzle(Id typeId, Id target, Id source, const std::vect
     if (channels.size() == 1 && getNumComponents(source) == 1)
         return createCompositeInsert(source, target, typeId, channels.front());
 
-    Instruction* swizzle = new Instruction(getUniqueId(), typeId, OpVectorShuffle);
+    Instruction* swizzle = new (module) Instruction(getUniqueId(), typeId, OpVectorShuffle);
     assert(isVector(target));
     swizzle->addIdOperand(target);
     if (accessChain.component != NoResult)
@@ -1454,7 +1594,7 @@ Id Builder::smearScalar(Decoration precision, Id scalar, Id vectorType)
         auto result_id = makeCompositeConstant(vectorType, members, isSpecConstant(scalar));
         smear = module.getInstruction(result_id);
     } else {
-        smear = new Instruction(getUniqueId(), vectorType, OpCompositeConstruct);
+        smear = new (module) Instruction(getUniqueId(), vectorType, OpCompositeConstruct);
         for (int c = 0; c < numComponents; ++c)
             smear->addIdOperand(scalar);
         buildPoint->addInstruction(std::unique_ptr<Instruction>(smear));
@@ -1466,7 +1606,7 @@ Id Builder::smearScalar(Decoration precision, Id scalar, Id vectorType)
 // Comments in header
 Id Builder::createBuiltinCall(Id resultType, Id builtins, int entryPoint, const std::vector<Id>& args)
 {
-    Instruction* inst = new Instruction(getUniqueId(), resultType, OpExtInst);
+    Instruction* inst = new (module) Instruction(getUniqueId(), resultType, OpExtInst);
     inst->addIdOperand(builtins);
     inst->addImmediateOperand(entryPoint);
     for (int arg = 0; arg < (int)args.size(); ++arg)
@@ -1648,7 +1788,7 @@ Id Builder::createTextureCall(Decoration precision, Id resultType, bool sparse,
     }
 
     // Build the SPIR-V instruction
-    Instruction* textureInst = new Instruction(getUniqueId(), resultType, opCode);
+    Instruction* textureInst = new (module) Instruction(getUniqueId(), resultType, opCode);
     for (int op = 0; op < optArgNum; ++op)
         textureInst->addIdOperand(texArgs[op]);
     if (optArgNum < numArgs)
@@ -1733,7 +1873,7 @@ Id Builder::createTextureQueryCall(Op opCode, const TextureParameters& parameter
         break;
     }
 
-    Instruction* query = new Instruction(getUniqueId(), resultType, opCode);
+    Instruction* query = new (module) Instruction(getUniqueId(), resultType, opCode);
     query->addIdOperand(parameters.sampler);
     if (parameters.coords)
         query->addIdOperand(parameters.coords);
@@ -1832,7 +1972,7 @@ Id Builder::createCompositeConstruct(Id typeId, const std::vector<Id>& constitue
                                                  [&](spv::Id id) { return isSpecConstant(id); }));
     }
 
-    Instruction* op = new Instruction(getUniqueId(), typeId, OpCompositeConstruct);
+    Instruction* op = new (module) Instruction(getUniqueId(), typeId, OpCompositeConstruct);
     for (int c = 0; c < (int)constituents.size(); ++c)
         op->addIdOperand(constituents[c]);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(op));
@@ -2086,7 +2226,7 @@ void Builder::makeSwitch(Id selector, unsigned int control, int numSegments, con
     createSelectionMerge(mergeBlock, control);
 
     // make the switch instruction
-    Instruction* switchInst = new Instruction(NoResult, NoType, OpSwitch);
+    Instruction* switchInst = new (module) Instruction(NoResult, NoType, OpSwitch);
     switchInst->addIdOperand(selector);
     auto defaultOrMerge = (defaultSegment >= 0) ? segmentBlocks[defaultSegment] : mergeBlock;
     switchInst->addIdOperand(defaultOrMerge->getId());
@@ -2285,9 +2425,14 @@ Id Builder::accessChainLoad(Decoration precision, Id resultType)
             id = accessChain.base;  // no precision, it was set when this was defined
     } else {
         transferAccessChainSwizzle(true);
-        // load through the access chain
-        id = createLoad(collapseAccessChain());
-        setPrecision(id, precision);
+        // load through the access chain, unless the value is known, and has
+        // its own precision
+        Id lValue = collapseAccessChain();
+        id = findForwardedValue(lValue);
+        if (id == NoResult) {
+            id = createLoad(lValue);
+            setPrecision(id, precision);
+        }
     }
 
     // Done, unless there are swizzles to do
@@ -2397,13 +2542,29 @@ void Builder::eliminateDeadDecorations() {
 }
 
 void Builder::dump(std::vector<unsigned int>& out) const
+{
+    const size_t start = out.size();
+    out.resize(start + getWordCount());
+    WordWriter writer(out.data() + start, out.size() - start);
+    dump(writer);
+}
+
+size_t Builder::getWordCount() const
+{
+    WordWriter counter;
+    dump(counter);
+
+    return counter.getCount();
+}
+
+void Builder::dump(WordWriter& out) const
 {
     // Header, before first instructions:
-    out.push_back(MagicNumber);
-    out.push_back(Version);
-    out.push_back(builderNumber);
-    out.push_back(uniqueId + 1);
-    out.push_back(0);
+    out.write(MagicNumber);
+    out.write(Version);
+    out.write(builderNumber);
+    out.write(uniqueId + 1);
+    out.write(0);
 
     // Capabilities
     for (auto it = capabilities.cbegin(); it != capabilities.cend(); ++it) {
@@ -2448,6 +2609,8 @@ void Builder::dump(std::vector<unsigned int>& out) const
 
     // The functions
     module.dump(out);
+
+    out.flush();
 }
 
 //
@@ -2555,7 +2718,7 @@ void Builder::createAndSetNoPredecessorBlock(const char* /*name*/)
 // Comments in header
 void Builder::createBranch(Block* block)
 {
-    Instruction* branch = new Instruction(OpBranch);
+    Instruction* branch = new (module) Instruction(OpBranch);
     branch->addIdOperand(block->getId());
     buildPoint->addInstruction(std::unique_ptr<Instruction>(branch));
     block->addPredecessor(buildPoint);
@@ -2563,7 +2726,7 @@ void Builder::createBranch(Block* block)
 
 void Builder::createSelectionMerge(Block* mergeBlock, unsigned int control)
 {
-    Instruction* merge = new Instruction(OpSelectionMerge);
+    Instruction* merge = new (module) Instruction(OpSelectionMerge);
     merge->addIdOperand(mergeBlock->getId());
     merge->addImmediateOperand(control);
     buildPoint->addInstruction(std::unique_ptr<Instruction>(merge));
@@ -2571,7 +2734,7 @@ void Builder::createSelectionMerge(Block* mergeBlock, unsigned int control)
 
 void Builder::createLoopMerge(Block* mergeBlock, Block* continueBlock, unsigned int control)
 {
-    Instruction* merge = new Instruction(OpLoopMerge);
+    Instruction* merge = new (module) Instruction(OpLoopMerge);
     merge->addIdOperand(mergeBlock->getId());
     merge->addIdOperand(continueBlock->getId());
     merge->addImmediateOperand(control);
@@ -2580,7 +2743,7 @@ void Builder::createLoopMerge(Block* mergeBlock, Block* continueBlock, unsigned
 
 void Builder::createConditionalBranch(Id condition, Block* thenBlock, Block* elseBlock)
 {
-    Instruction* branch = new Instruction(OpBranchConditional);
+    Instruction* branch = new (module) Instruction(OpBranchConditional);
     branch->addIdOperand(condition);
     branch->addIdOperand(thenBlock->getId());
     branch->addIdOperand(elseBlock->getId());
@@ -2592,7 +2755,7 @@ void Builder::createConditionalBranch(Id condition, Block* thenBlock, Block* els
 // OpSource
 // [OpSourceContinued]
 // ...
-void Builder::dumpSourceInstructions(std::vector<unsigned int>& out) const
+void Builder::dumpSourceInstructions(WordWriter& out) const
 {
     const int maxWordCount = 0xFFFF;
     const int opSourceWordCount = 4;
@@ -2631,14 +2794,14 @@ void Builder::dumpSourceInstructions(std::vector<unsigned int>& out) const
     }
 }
 
-void Builder::dumpInstructions(std::vector<unsigned int>& out, const std::vector<std::unique_ptr<Instruction> >& instructions) const
+void Builder::dumpInstructions(WordWriter& out, const std::vector<std::unique_ptr<Instruction> >& instructions) const
 {
     for (int i = 0; i < (int)instructions.size(); ++i) {
         instructions[i]->dump(out);
     }
 }
 
-void Builder::dumpModuleProcesses(std::vector<unsigned int>& out) const
+void Builder::dumpModuleProcesses(WordWriter& out) const
 {
     for (int i = 0; i < (int)moduleProcesses.size(); ++i) {
         // TODO: switch this out for the 1.1 headers
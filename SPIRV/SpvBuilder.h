@@ -55,6 +55,7 @@
 #include <set>
 #include <sstream>
 #include <stack>
+#include <unordered_map>
 
 namespace spv {
 
@@ -72,7 +73,7 @@ public:
     }
     void setSourceFile(const std::string& file)
     {
-        Instruction* fileString = new Instruction(getUniqueId(), NoType, OpString);
+        Instruction* fileString = new (module) Instruction(getUniqueId(), NoType, OpString);
         fileString->addStringOperand(file.c_str());
         sourceFileStringId = fileString->getResultId();
         strings.push_back(std::unique_ptr<Instruction>(fileString));
@@ -81,6 +82,10 @@ public:
     void addSourceExtension(const char* ext) { sourceExtensions.push_back(ext); }
     void addModuleProcessed(const std::string& p) { moduleProcesses.push_back(p.c_str()); }
     void setEmitOpLines() { emitOpLines = true; }
+    // Have createLoad() and accessChainLoad() reuse the value a variable is
+    // known to hold, from a load or store earlier in the same block, rather
+    // than load it again.
+    void setForwardLoads() { forwardLoads = true; }
     void addExtension(const char* ext) { extensions.insert(ext); }
     Id import(const char*);
     void setMemoryModel(spv::AddressingModel addr, spv::MemoryModel mem)
@@ -269,7 +274,7 @@ public:
     // Store into an Id and return the l-value
     void createStore(Id rValue, Id lValue);
 
-    // Load from an Id and return it
+    // Load from an Id and return it (or the value it is known to hold, see setForwardLoads())
     Id createLoad(Id lValue);
 
     // Create an OpAccessChain instruction
@@ -557,7 +562,12 @@ public:
     // Remove OpDecorate instructions whose operands are defined in unreachable
     // blocks.
     void eliminateDeadDecorations();
+    // Dump the module in binary form: appended to a vector, which is sized
+    // first, or written to 'out', which is flushed at the end.
     void dump(std::vector<unsigned int>&) const;
+    void dump(WordWriter& out) const;
+    // The number of words dump() writes.
+    size_t getWordCount() const;
 
     void createBranch(Block* block);
     void createConditionalBranch(Id condition, Block* thenBlock, Block* elseBlock);
@@ -576,14 +586,22 @@ public:
     Id findScalarConstant(Op typeClass, Op opcode, Id typeId, unsigned value) const;
     Id findScalarConstant(Op typeClass, Op opcode, Id typeId, unsigned v1, unsigned v2) const;
     Id findCompositeConstant(Op typeClass, const std::vector<Id>& comps) const;
+    Id findConstant(Op opcode, Id typeId, const Id* operands, int numOperands) const;
+    Instruction* findType(Op opcode, const Id* operands, int numOperands) const;
+    void groupType(Instruction*);
+    void groupConstant(Op typeClass, Instruction*);
+    Id findForwardedValue(Id pointer);
+    void updateForwardedValues();
+    bool isForwardedVariable(Id pointer) const;
+    bool mayWriteMemory(const Instruction&) const;
     Id collapseAccessChain();
     void transferAccessChainSwizzle(bool dynamic);
     void simplifyAccessChainSwizzle();
     void createAndSetNoPredecessorBlock(const char*);
     void createSelectionMerge(Block* mergeBlock, unsigned int control);
-    void dumpSourceInstructions(std::vector<unsigned int>&) const;
-    void dumpInstructions(std::vector<unsigned int>&, const std::vector<std::unique_ptr<Instruction> >&) const;
-    void dumpModuleProcesses(std::vector<unsigned int>&) const;
+    void dumpSourceInstructions(WordWriter&) const;
+    void dumpInstructions(WordWriter&, const std::vector<std::unique_ptr<Instruction> >&) const;
+    void dumpModuleProcesses(WordWriter&) const;
 
     SourceLanguage source;
     int sourceVersion;
@@ -591,6 +609,7 @@ public:
     std::string sourceText;
     int currentLine;
     bool emitOpLines;
+    bool forwardLoads;
     std::set<std::string> extensions;
     std::vector<const char*> sourceExtensions;
     std::vector<const char*> moduleProcesses;
@@ -598,7 +617,7 @@ public:
     MemoryModel memoryModel;
     std::set<spv::Capability> capabilities;
     int builderNumber;
-    Module module;
+    Module module;  // declared ahead of the instructions below, to outlive them
     Block* buildPoint;
     Id uniqueId;
     Function* entryPointFunction;
@@ -620,6 +639,16 @@ public:
      // not output, internally used for quick & dirty canonical (unique) creation
     std::vector<Instruction*> groupedConstants[OpConstant];  // all types appear before OpConstant
     std::vector<Instruction*> groupedTypes[OpConstant];
+    // the same, by a hash of their opcode (type class for composite constants),
+    // type and operands, to find one without a scan; holds the first made of equal ones
+    std::unordered_multimap<size_t, Instruction*> hashedConstants;
+    std::unordered_multimap<size_t, Instruction*> hashedTypes;
+
+    // For setForwardLoads(): the values variables are known to hold, as of
+    // the first 'forwardingScanned' instructions of the block 'forwardingBlock'.
+    std::unordered_map<Id, Id> forwardedValues;
+    Id forwardingBlock;
+    size_t forwardingScanned;
 
     // stack of switches
     std::stack<Block*> switchMerges;
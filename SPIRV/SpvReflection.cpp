@@ -0,0 +1,904 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+//
+// Reflection of a SPIR-V module, from its words alone.
+//
+// Everything reflected is declared before the first function, and SPIR-V
+// puts names and decorations before the types and variables they apply to,
+// so a single pass over that part of the module finds all of it: each
+// variable is reflected when it is reached, and the rest of the module is
+// never looked at.
+//
+// The records follow the rules of the front end's reflection (see
+// reflection.cpp): blocks are named by their type, with one entry per
+// element of an array of blocks; members are named "Block.member", or just
+// "member" for an anonymous block; structs and arrays of structs are
+// expanded down to their leaves; and an array leaf has its outer array size
+// as its size.
+//
+
+#include "SpvReflection.h"
+#include "spirv.hpp"
+
+#include "../glslang/MachineIndependent/gl_types.h"
+
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <unordered_map>
+
+namespace {
+
+using namespace spv;
+
+// What is known of a struct member.
+struct Member {
+    Member() : offset(0), matrixStride(0), rowMajor(false) { }
+
+    std::string name;
+    int offset;
+    int matrixStride;
+    bool rowMajor;
+};
+
+// What is known of an id: its name and decorations, and the instruction
+// declaring it, if that is one of interest.
+struct IdInfo {
+    IdInfo() : instruction(nullptr), binding(-1), set(-1), arrayStride(0), depth(0), block(false), bufferBlock(false) { }
+
+    const unsigned int* instruction;
+    std::string name;
+    int binding;
+    int set;
+    int arrayStride;
+    int depth;                                     // of the arrays and structs nested in a type
+    bool block;
+    bool bufferBlock;
+    std::vector<Member> members;                   // one per member, once the struct is declared
+    std::map<unsigned int, Member> earlyMembers;   // those named or decorated before that
+};
+
+// As the SPIR-V spec's limit on the nesting of structs, and what keeps the
+// recursion over a type shallow.
+const int MaxTypeDepth = 255;
+
+// Sizes and offsets are ints, as in the front end's reflection; -1 is one
+// that is out of range, because it is, or it comes from one that is.
+int SizeSum(long long a, long long b)
+{
+    return a < 0 || b < 0 || a + b > INT_MAX ? -1 : (int)(a + b);
+}
+
+int SizeProduct(long long a, long long b)
+{
+    return a < 0 || b < 0 || (b != 0 && a > INT_MAX / b) ? -1 : (int)(a * b);
+}
+
+class Reflector {
+public:
+    Reflector(const unsigned int* spirv, size_t size, glslang::TReflectionRecords& records, std::string& error) :
+        spirv(spirv), size(size), records(records), error(error), vertex(false) { }
+
+    bool reflect();
+
+protected:
+    bool fail(const char* message)
+    {
+        error = message;
+        return false;
+    }
+
+    IdInfo& info(Id id) { return id < ids.size() ? ids[id] : none; }
+    bool declared(Id id) { return info(id).instruction != nullptr; }
+
+    Op op(Id id)
+    {
+        const unsigned int* instruction = info(id).instruction;
+        return instruction != nullptr ? (Op)(instruction[0] & OpCodeMask) : OpNop;
+    }
+
+    // Word 'w' of the instruction declaring 'id', or 0 if it has no such word.
+    unsigned int word(Id id, unsigned int w)
+    {
+        const unsigned int* instruction = info(id).instruction;
+        return instruction != nullptr && w < (instruction[0] >> WordCountShift) ? instruction[w] : 0;
+    }
+
+    bool madeOfDeclared(Op opCode, const unsigned int* operands, unsigned int operandCount);
+    bool declareType(const unsigned int* instruction);
+    Member* member(Id structure, unsigned int m);
+    static std::string literalString(const unsigned int* words, unsigned int count);
+
+    bool addVariable(Id variable);
+    bool addObject(Id type, const std::string& name, int offset, const Member* member, int blockIndex,
+                   int binding, int set, bool atomic);
+    int addBlock(const std::string& name, Id type, int binding, int set, bool std140);
+
+    Id stripArrays(Id type);
+    unsigned int arrayLength(Id type);
+    int glType(Id type, bool atomic);
+    int samplerGlType(Id image);
+    int sizeOf(Id type, const Member* member, bool std140);
+    int alignmentOf(Id type, const Member* member, bool std140);
+
+    const unsigned int* spirv;
+    size_t size;
+    glslang::TReflectionRecords& records;
+    std::string& error;
+
+    std::vector<IdInfo> ids;
+    IdInfo none;
+    std::unordered_map<std::string, int> uniformIndices;
+    std::unordered_map<std::string, int> blockIndices;
+    std::vector<Id> computeEntryPoints;
+    bool vertex;  // a vertex shader entry point was declared
+};
+
+std::string Reflector::literalString(const unsigned int* words, unsigned int count)
+{
+    std::string string;
+    for (unsigned int w = 0; w < count; ++w) {
+        for (int byte = 0; byte < 4; ++byte) {
+            const char c = (char)((words[w] >> (8 * byte)) & 0xff);
+            if (c == 0)
+                return string;
+            string += c;
+        }
+    }
+
+    return string;
+}
+
+// Whether the types a type declaration with 'operands' refers to are declared already;
+// operands[0] is the type's own id.
+bool Reflector::madeOfDeclared(Op opCode, const unsigned int* operands, unsigned int operandCount)
+{
+    unsigned int parts;
+    switch (opCode) {
+    case OpTypeVector:
+    case OpTypeMatrix:
+    case OpTypeSampledImage:
+    case OpTypeArray:
+    case OpTypeRuntimeArray: parts = 1;                break;
+    case OpTypeStruct:       parts = operandCount - 1; break;
+    default:                 parts = 0;                break;
+    }
+    if (operandCount < parts + 1)
+        return false;
+    for (unsigned int p = 1; p <= parts; ++p) {
+        if (! declared(operands[p]))
+            return false;
+    }
+
+    return true;
+}
+
+// Declare the type 'instruction' declares, and figure its depth.
+bool Reflector::declareType(const unsigned int* instruction)
+{
+    const Op opCode = (Op)(instruction[0] & OpCodeMask);
+    const unsigned int* operands = instruction + 1;
+    const unsigned int operandCount = (instruction[0] >> WordCountShift) - 1;
+    if (operandCount < 1 || operands[0] >= ids.size())
+        return fail("type has a bad result id");
+    // Other than the pointee of a pointer, which can be forward declared, what a type is
+    // made of is declared before it, and no id is declared twice, so no type can contain
+    // itself.
+    if (declared(operands[0]))
+        return fail("result id is declared twice");
+    if (! madeOfDeclared(opCode, operands, operandCount))
+        return fail("type is made of something not yet declared");
+
+    IdInfo& type = ids[operands[0]];
+    switch (opCode) {
+    case OpTypeArray:
+    case OpTypeRuntimeArray:
+        type.depth = info(operands[1]).depth + 1;
+        break;
+    case OpTypeStruct:
+    {
+        const unsigned int memberCount = operandCount - 1;
+        for (unsigned int m = 0; m < memberCount; ++m)
+            type.depth = std::max(type.depth, info(operands[1 + m]).depth);
+        ++type.depth;
+
+        // what was named or decorated before the struct was declared
+        if (! type.earlyMembers.empty() && type.earlyMembers.rbegin()->first >= memberCount)
+            return fail("member index is out of range");
+        type.members.resize(memberCount);
+        for (const auto& early : type.earlyMembers)
+            type.members[early.first] = early.second;
+        type.earlyMembers.clear();
+        break;
+    }
+    default:
+        break;
+    }
+    if (type.depth > MaxTypeDepth)
+        return fail("types are nested too deeply");
+
+    type.instruction = instruction;
+
+    return true;
+}
+
+// Member 'm' of struct 'structure', to name or decorate, or nullptr if there is no such member.
+Member* Reflector::member(Id structure, unsigned int m)
+{
+    if (structure >= ids.size())
+        return nullptr;
+
+    IdInfo& declaration = ids[structure];
+    if (! declared(structure))
+        return &declaration.earlyMembers[m];
+    if (op(structure) != OpTypeStruct || m >= declaration.members.size())
+        return nullptr;
+
+    return &declaration.members[m];
+}
+
+bool Reflector::reflect()
+{
+    if (size < 5 || spirv[0] != MagicNumber)
+        return fail("not a SPIR-V module");
+
+    const unsigned int bound = spirv[3];
+    if (bound > size)
+        return fail("id bound is larger than the module");
+    ids.resize(bound);
+
+    records.localSize[0] = records.localSize[1] = records.localSize[2] = 0;
+    records.uniforms.clear();
+    records.uniformBlocks.clear();
+    records.attributes.clear();
+
+    unsigned int wordCount;
+    for (size_t w = 5; w < size; w += wordCount) {
+        const unsigned int* instruction = spirv + w;
+        wordCount = instruction[0] >> WordCountShift;
+        const Op opCode = (Op)(instruction[0] & OpCodeMask);
+        if (wordCount == 0 || wordCount > size - w)
+            return fail("instruction runs past the end of the module");
+
+        // the words after the opcode, which all instructions below need some of
+        const unsigned int* operands = instruction + 1;
+        const unsigned int operandCount = wordCount - 1;
+
+        switch (opCode) {
+        case OpEntryPoint:
+            if (operandCount < 2)
+                return fail("truncated OpEntryPoint");
+            if (operands[0] == ExecutionModelVertex)
+                vertex = true;
+            else if (operands[0] == ExecutionModelGLCompute)
+                computeEntryPoints.push_back(operands[1]);
+            break;
+
+        case OpExecutionMode:
+            if (operandCount >= 5 && operands[1] == ExecutionModeLocalSize &&
+                std::find(computeEntryPoints.begin(), computeEntryPoints.end(), operands[0]) !=
+                    computeEntryPoints.end()) {
+                for (int dim = 0; dim < 3; ++dim)
+                    records.localSize[dim] = operands[2 + dim];
+            }
+            break;
+
+        case OpName:
+            if (operandCount >= 1)
+                info(operands[0]).name = literalString(operands + 1, operandCount - 1);
+            break;
+
+        case OpMemberName:
+            if (operandCount >= 2) {
+                Member* named = member(operands[0], operands[1]);
+                if (named == nullptr)
+                    return fail("member index is out of range");
+                named->name = literalString(operands + 2, operandCount - 2);
+            }
+            break;
+
+        case OpDecorate:
+            if (operandCount >= 2) {
+                IdInfo& decorated = info(operands[0]);
+                const unsigned int literal = operandCount >= 3 ? operands[2] : 0;
+                switch (operands[1]) {
+                case DecorationBinding:       decorated.binding = (int)literal;     break;
+                case DecorationDescriptorSet: decorated.set = (int)literal;         break;
+                case DecorationArrayStride:   decorated.arrayStride = (int)literal; break;
+                case DecorationBlock:         decorated.block = true;               break;
+                case DecorationBufferBlock:   decorated.bufferBlock = true;         break;
+                default:                                                            break;
+                }
+            }
+            break;
+
+        case OpMemberDecorate:
+            if (operandCount >= 3) {
+                Member* decorated = member(operands[0], operands[1]);
+                if (decorated == nullptr)
+                    return fail("member index is out of range");
+                const unsigned int literal = operandCount >= 4 ? operands[3] : 0;
+                switch (operands[2]) {
+                case DecorationOffset:       decorated->offset = (int)literal;       break;
+                case DecorationMatrixStride: decorated->matrixStride = (int)literal; break;
+                case DecorationRowMajor:     decorated->rowMajor = true;             break;
+                default:                                                             break;
+                }
+            }
+            break;
+
+        case OpTypeVoid:
+        case OpTypeBool:
+        case OpTypeInt:
+        case OpTypeFloat:
+        case OpTypeImage:
+        case OpTypeSampler:
+        case OpTypeVector:
+        case OpTypeMatrix:
+        case OpTypeSampledImage:
+        case OpTypeArray:
+        case OpTypeRuntimeArray:
+        case OpTypeStruct:
+        case OpTypePointer:
+            if (! declareType(instruction))
+                return false;
+            break;
+
+        case OpConstant:
+        case OpSpecConstant:
+            if (operandCount < 2 || operands[1] >= bound)
+                return fail("constant has a bad result id");
+            if (declared(operands[1]))
+                return fail("result id is declared twice");
+            ids[operands[1]].instruction = instruction;
+            break;
+
+        case OpVariable:
+            if (operandCount < 3 || operands[1] >= bound)
+                return fail("variable has a bad result id");
+            if (declared(operands[1]))
+                return fail("result id is declared twice");
+            ids[operands[1]].instruction = instruction;
+            if (! addVariable(operands[1]))
+                return false;
+            break;
+
+        case OpFunction:
+            // nothing reflected is declared past here
+            w = size;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // associate buffers with their counter buffers, found by name as in TReflection::buildCounterIndices()
+    for (size_t b = 0; b < records.uniformBlocks.size(); ++b) {
+        const std::string counterName = records.uniformBlocks[b].name + "@count";
+        for (size_t c = 0; c < records.uniformBlocks.size(); ++c) {
+            if (records.uniformBlocks[c].name == counterName)
+                records.uniformBlocks[b].counterIndex = (int)c;
+        }
+    }
+
+    return true;
+}
+
+// Reflect what 'variable', just declared, holds, if it is a uniform, a buffer or a vertex attribute.
+bool Reflector::addVariable(Id variable)
+{
+    const IdInfo& declaration = info(variable);
+    const StorageClass storage = (StorageClass)word(variable, 3);
+    const Id type = word(word(variable, 1), 3);
+    const Id elementType = stripArrays(type);
+
+    switch (storage) {
+    case StorageClassUniform:
+    case StorageClassStorageBuffer:
+    case StorageClassPushConstant:
+    {
+        const IdInfo& block = info(elementType);
+        if (op(elementType) != OpTypeStruct || ! (block.block || block.bufferBlock))
+            return true;
+
+        // uniform blocks are laid out std140 by default, buffers and push constants std430
+        const bool std140 = storage == StorageClassUniform && block.block;
+
+        int blockIndex = -1;
+        if (type != elementType) {
+            unsigned int elements = 1;
+            for (Id array = type; array != elementType; array = word(array, 2))
+                elements *= arrayLength(array);
+            for (unsigned int e = 0; e < elements; ++e)
+                blockIndex = addBlock(block.name + "[" + std::to_string(e) + "]", elementType, declaration.binding,
+                                      declaration.set, std140);
+        } else
+            blockIndex = addBlock(block.name, elementType, declaration.binding, declaration.set, std140);
+        if (blockIndex < 0)
+            return fail("block size is out of range");
+
+        return addObject(elementType, declaration.name.empty() ? "" : block.name, 0, nullptr, blockIndex, -1, -1,
+                         false);
+    }
+
+    case StorageClassUniformConstant:
+    case StorageClassAtomicCounter:
+        return addObject(type, declaration.name, -1, nullptr, -1, declaration.binding, declaration.set,
+                         storage == StorageClassAtomicCounter);
+
+    case StorageClassInput:
+        if (vertex && op(elementType) != OpTypeStruct) {
+            glslang::TReflectionRecord attribute = { declaration.name, 0, glType(type, false), 0, 0, -1, -1, -1 };
+            records.attributes.push_back(attribute);
+        }
+        return true;
+
+    default:
+        return true;
+    }
+}
+
+// Add the uniforms for an object of 'type' called 'name', down to the leaves of any aggregate.
+// 'offset' is -1 outside of blocks, and 'member' is the struct member it is, if it is one.
+bool Reflector::addObject(Id type, const std::string& name, int offset, const Member* member, int blockIndex,
+                          int binding, int set, bool atomic)
+{
+    const Id elementType = stripArrays(type);
+    if (op(elementType) == OpTypeStruct) {
+        if (type != elementType) {
+            // an array of structs, expanded an element at a time
+            const Id element = word(type, 2);
+            const int stride = info(type).arrayStride;
+            const unsigned int elements = std::max(arrayLength(type), 1u);
+            for (unsigned int e = 0; e < elements; ++e) {
+                const int elementOffset = offset >= 0 ? SizeSum(offset, SizeProduct(e, stride)) : -1;
+                if (offset >= 0 && elementOffset < 0)
+                    return fail("offset is out of range");
+                if (! addObject(element, name + "[" + std::to_string(e) + "]", elementOffset, member, blockIndex,
+                                binding, set, atomic))
+                    return false;
+            }
+        } else {
+            const std::vector<Member>& members = info(type).members;
+            for (unsigned int m = 0; m < members.size(); ++m) {
+                const int memberOffset = offset >= 0 ? SizeSum(offset, members[m].offset) : -1;
+                if (offset >= 0 && memberOffset < 0)
+                    return fail("offset is out of range");
+                if (! addObject(word(type, 2 + m), name.empty() ? members[m].name : name + "." + members[m].name,
+                                memberOffset, &members[m], blockIndex, -1, -1, atomic))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    const int size = type != elementType ? (int)arrayLength(type) : 1;
+    const auto existing = uniformIndices.find(name);
+    if (existing == uniformIndices.end()) {
+        uniformIndices[name] = (int)records.uniforms.size();
+        glslang::TReflectionRecord uniform = { name, offset, glType(type, atomic), size, blockIndex, -1, binding, set };
+        records.uniforms.push_back(uniform);
+    } else if (size > 1) {
+        int& reflectedSize = records.uniforms[existing->second].size;
+        reflectedSize = std::max(size, reflectedSize);
+    }
+
+    return true;
+}
+
+// Add the block 'name', of struct 'type', if it isn't there yet, and return its index,
+// or -1 if its size is out of range.
+int Reflector::addBlock(const std::string& name, Id type, int binding, int set, bool std140)
+{
+    const auto existing = blockIndices.find(name);
+    if (existing != blockIndices.end())
+        return existing->second;
+
+    // as for the front end, the end of the last member, without padding
+    int size = 0;
+    const std::vector<Member>& members = info(type).members;
+    if (! members.empty()) {
+        const Member& last = members.back();
+        size = SizeSum(last.offset, sizeOf(word(type, 2 + (unsigned int)members.size() - 1), &last, std140));
+        if (size < 0)
+            return -1;
+    }
+
+    const int blockIndex = (int)records.uniformBlocks.size();
+    blockIndices[name] = blockIndex;
+    glslang::TReflectionRecord block = { name, -1, -1, size, -1, -1, binding, set };
+    records.uniformBlocks.push_back(block);
+
+    return blockIndex;
+}
+
+Id Reflector::stripArrays(Id type)
+{
+    while (op(type) == OpTypeArray || op(type) == OpTypeRuntimeArray)
+        type = word(type, 2);
+
+    return type;
+}
+
+// The length of array 'type': 0 if it is a runtime array, or sized by something other than a constant.
+unsigned int Reflector::arrayLength(Id type)
+{
+    if (op(type) != OpTypeArray)
+        return 0;
+
+    const Id length = word(type, 3);
+    return op(length) == OpConstant || op(length) == OpSpecConstant ? word(length, 3) : 0;
+}
+
+// The GL API #define for the type of an object of 'type', as mapToGlType() in reflection.cpp gives for the
+// source type.  SPIR-V has no atomic counter type, that comes from the storage class, as 'atomic'.
+int Reflector::glType(Id type, bool atomic)
+{
+    type = stripArrays(type);
+    if (atomic)
+        return GL_UNSIGNED_INT_ATOMIC_COUNTER;
+
+    int rows = 1;
+    int columns = 1;
+    Id component = type;
+    switch (op(type)) {
+    case OpTypeImage:
+        return samplerGlType(type);
+    case OpTypeSampledImage:
+        return samplerGlType(word(type, 2));
+    case OpTypeVector:
+        rows = (int)word(type, 3);
+        component = word(type, 2);
+        break;
+    case OpTypeMatrix:
+        columns = (int)word(type, 3);
+        rows = (int)word(word(type, 2), 3);
+        component = word(word(type, 2), 2);
+        break;
+    default:
+        break;
+    }
+
+    const unsigned int width = word(component, 2);
+    if (columns > 1) {
+        if (columns > 4 || rows < 2 || rows > 4 || op(component) != OpTypeFloat)
+            return 0;
+
+        static const int floatMatrices[3][3] = {
+            { GL_FLOAT_MAT2,   GL_FLOAT_MAT2x3, GL_FLOAT_MAT2x4 },
+            { GL_FLOAT_MAT3x2, GL_FLOAT_MAT3,   GL_FLOAT_MAT3x4 },
+            { GL_FLOAT_MAT4x2, GL_FLOAT_MAT4x3, GL_FLOAT_MAT4 },
+        };
+        static const int doubleMatrices[3][3] = {
+            { GL_DOUBLE_MAT2,   GL_DOUBLE_MAT2x3, GL_DOUBLE_MAT2x4 },
+            { GL_DOUBLE_MAT3x2, GL_DOUBLE_MAT3,   GL_DOUBLE_MAT3x4 },
+            { GL_DOUBLE_MAT4x2, GL_DOUBLE_MAT4x3, GL_DOUBLE_MAT4 },
+        };
+#ifdef AMD_EXTENSIONS
+        static const int float16Matrices[3][3] = {
+            { GL_FLOAT16_MAT2_AMD,   GL_FLOAT16_MAT2x3_AMD, GL_FLOAT16_MAT2x4_AMD },
+            { GL_FLOAT16_MAT3x2_AMD, GL_FLOAT16_MAT3_AMD,   GL_FLOAT16_MAT3x4_AMD },
+            { GL_FLOAT16_MAT4x2_AMD, GL_FLOAT16_MAT4x3_AMD, GL_FLOAT16_MAT4_AMD },
+        };
+#endif
+        switch (width) {
+        case 32: return floatMatrices[columns - 2][rows - 2];
+        case 64: return doubleMatrices[columns - 2][rows - 2];
+#ifdef AMD_EXTENSIONS
+        case 16: return float16Matrices[columns - 2][rows - 2];
+#endif
+        default: return 0;
+        }
+    }
+
+    if (rows > 1) {
+        const int offset = rows - 2;
+        switch (op(component)) {
+        case OpTypeFloat:
+            switch (width) {
+            case 32: return GL_FLOAT_VEC2 + offset;
+            case 64: return GL_DOUBLE_VEC2 + offset;
+#ifdef AMD_EXTENSIONS
+            case 16: return GL_FLOAT16_VEC2_NV + offset;
+#endif
+            default: return 0;
+            }
+        case OpTypeInt:
+            switch (width) {
+            case 32: return (word(component, 3) ? GL_INT_VEC2 : GL_UNSIGNED_INT_VEC2) + offset;
+            case 64: return (word(component, 3) ? GL_INT64_ARB : GL_UNSIGNED_INT64_ARB) + offset;
+            default: return 0;
+            }
+        case OpTypeBool:
+            return GL_BOOL_VEC2 + offset;
+        default:
+            return 0;
+        }
+    }
+
+    switch (op(component)) {
+    case OpTypeFloat:
+        switch (width) {
+        case 32: return GL_FLOAT;
+        case 64: return GL_DOUBLE;
+#ifdef AMD_EXTENSIONS
+        case 16: return GL_FLOAT16_NV;
+#endif
+        default: return 0;
+        }
+    case OpTypeInt:
+        switch (width) {
+        case 32: return word(component, 3) ? GL_INT : GL_UNSIGNED_INT;
+        case 64: return word(component, 3) ? GL_INT64_ARB : GL_UNSIGNED_INT64_ARB;
+        default: return 0;
+        }
+    case OpTypeBool:
+        return GL_BOOL;
+    default:
+        return 0;
+    }
+}
+
+// The GL API #define for image type 'image', as mapSamplerToGlType() in reflection.cpp gives.  A storage
+// image is an image, and a sampled one, combined with a sampler or not, is a sampler.
+int Reflector::samplerGlType(Id image)
+{
+    enum { Float, Int, Uint } basic;
+    const Id sampledType = word(image, 2);
+    if (op(sampledType) == OpTypeFloat && word(sampledType, 2) == 32)
+        basic = Float;
+    else if (op(sampledType) == OpTypeInt && word(sampledType, 2) == 32)
+        basic = word(sampledType, 3) ? Int : Uint;
+    else
+        return 0;
+
+    const Dim dim = (Dim)word(image, 3);
+    const bool shadow = word(image, 4) == 1;
+    const bool arrayed = word(image, 5) != 0;
+    const bool ms = word(image, 6) != 0;
+
+    if (word(image, 7) != 2) {
+        // a sampler...
+        switch (basic) {
+        case Float:
+            switch (dim) {
+            case Dim1D:
+                if (shadow)
+                    return arrayed ? GL_SAMPLER_1D_ARRAY_SHADOW : GL_SAMPLER_1D_SHADOW;
+                return arrayed ? GL_SAMPLER_1D_ARRAY : GL_SAMPLER_1D;
+            case Dim2D:
+                if (ms)
+                    return arrayed ? GL_SAMPLER_2D_MULTISAMPLE_ARRAY : GL_SAMPLER_2D_MULTISAMPLE;
+                if (shadow)
+                    return arrayed ? GL_SAMPLER_2D_ARRAY_SHADOW : GL_SAMPLER_2D_SHADOW;
+                return arrayed ? GL_SAMPLER_2D_ARRAY : GL_SAMPLER_2D;
+            case Dim3D:
+                return GL_SAMPLER_3D;
+            case DimCube:
+                if (shadow)
+                    return arrayed ? GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW : GL_SAMPLER_CUBE_SHADOW;
+                return arrayed ? GL_SAMPLER_CUBE_MAP_ARRAY : GL_SAMPLER_CUBE;
+            case DimRect:
+                return shadow ? GL_SAMPLER_2D_RECT_SHADOW : GL_SAMPLER_2D_RECT;
+            case DimBuffer:
+                return GL_SAMPLER_BUFFER;
+            default:
+                return 0;
+            }
+        case Int:
+            switch (dim) {
+            case Dim1D:     return arrayed ? GL_INT_SAMPLER_1D_ARRAY : GL_INT_SAMPLER_1D;
+            case Dim2D:
+                if (ms)
+                    return arrayed ? GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY : GL_INT_SAMPLER_2D_MULTISAMPLE;
+                return arrayed ? GL_INT_SAMPLER_2D_ARRAY : GL_INT_SAMPLER_2D;
+            case Dim3D:     return GL_INT_SAMPLER_3D;
+            case DimCube:   return arrayed ? GL_INT_SAMPLER_CUBE_MAP_ARRAY : GL_INT_SAMPLER_CUBE;
+            case DimRect:   return GL_INT_SAMPLER_2D_RECT;
+            case DimBuffer: return GL_INT_SAMPLER_BUFFER;
+            default:        return 0;
+            }
+        case Uint:
+            switch (dim) {
+            case Dim1D:     return arrayed ? GL_UNSIGNED_INT_SAMPLER_1D_ARRAY : GL_UNSIGNED_INT_SAMPLER_1D;
+            case Dim2D:
+                if (ms)
+                    return arrayed ? GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY
+                                   : GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE;
+                return arrayed ? GL_UNSIGNED_INT_SAMPLER_2D_ARRAY : GL_UNSIGNED_INT_SAMPLER_2D;
+            case Dim3D:     return GL_UNSIGNED_INT_SAMPLER_3D;
+            case DimCube:   return arrayed ? GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY : GL_UNSIGNED_INT_SAMPLER_CUBE;
+            case DimRect:   return GL_UNSIGNED_INT_SAMPLER_2D_RECT;
+            case DimBuffer: return GL_UNSIGNED_INT_SAMPLER_BUFFER;
+            default:        return 0;
+            }
+        }
+    } else {
+        // an image...
+        switch (basic) {
+        case Float:
+            switch (dim) {
+            case Dim1D:     return arrayed ? GL_IMAGE_1D_ARRAY : GL_IMAGE_1D;
+            case Dim2D:
+                if (ms)
+                    return arrayed ? GL_IMAGE_2D_MULTISAMPLE_ARRAY : GL_IMAGE_2D_MULTISAMPLE;
+                return arrayed ? GL_IMAGE_2D_ARRAY : GL_IMAGE_2D;
+            case Dim3D:     return GL_IMAGE_3D;
+            case DimCube:   return arrayed ? GL_IMAGE_CUBE_MAP_ARRAY : GL_IMAGE_CUBE;
+            case DimRect:   return GL_IMAGE_2D_RECT;
+            case DimBuffer: return GL_IMAGE_BUFFER;
+            default:        return 0;
+            }
+        case Int:
+            switch (dim) {
+            case Dim1D:     return arrayed ? GL_INT_IMAGE_1D_ARRAY : GL_INT_IMAGE_1D;
+            case Dim2D:
+                if (ms)
+                    return arrayed ? GL_INT_IMAGE_2D_MULTISAMPLE_ARRAY : GL_INT_IMAGE_2D_MULTISAMPLE;
+                return arrayed ? GL_INT_IMAGE_2D_ARRAY : GL_INT_IMAGE_2D;
+            case Dim3D:     return GL_INT_IMAGE_3D;
+            case DimCube:   return arrayed ? GL_INT_IMAGE_CUBE_MAP_ARRAY : GL_INT_IMAGE_CUBE;
+            case DimRect:   return GL_INT_IMAGE_2D_RECT;
+            case DimBuffer: return GL_INT_IMAGE_BUFFER;
+            default:        return 0;
+            }
+        case Uint:
+            switch (dim) {
+            case Dim1D:     return arrayed ? GL_UNSIGNED_INT_IMAGE_1D_ARRAY : GL_UNSIGNED_INT_IMAGE_1D;
+            case Dim2D:
+                if (ms)
+                    return arrayed ? GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE_ARRAY
+                                   : GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE;
+                return arrayed ? GL_UNSIGNED_INT_IMAGE_2D_ARRAY : GL_UNSIGNED_INT_IMAGE_2D;
+            case Dim3D:     return GL_UNSIGNED_INT_IMAGE_3D;
+            case DimCube:   return arrayed ? GL_UNSIGNED_INT_IMAGE_CUBE_MAP_ARRAY : GL_UNSIGNED_INT_IMAGE_CUBE;
+            case DimRect:   return GL_UNSIGNED_INT_IMAGE_2D_RECT;
+            case DimBuffer: return GL_UNSIGNED_INT_IMAGE_BUFFER;
+            default:        return 0;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// The size in bytes of an object of 'type' in a block, laid out as its decorations say, or -1 if
+// that is out of range.  'member' is the struct member it is, if it is one, for the layout of a matrix.
+int Reflector::sizeOf(Id type, const Member* member, bool std140)
+{
+    switch (op(type)) {
+    case OpTypeBool:
+        return 4;
+    case OpTypeInt:
+    case OpTypeFloat:
+        return (int)(word(type, 2) / 8);
+    case OpTypeVector:
+        return SizeProduct(sizeOf(word(type, 2), nullptr, std140), word(type, 3));
+    case OpTypeMatrix:
+    {
+        const unsigned int columns = word(type, 3);
+        if (member == nullptr || member->matrixStride == 0)
+            return SizeProduct(sizeOf(word(type, 2), nullptr, std140), columns);
+        return SizeProduct(member->matrixStride, member->rowMajor ? word(word(type, 2), 3) : columns);
+    }
+    case OpTypeArray:
+    {
+        const int stride = info(type).arrayStride;
+        return SizeProduct(stride != 0 ? stride : sizeOf(word(type, 2), member, std140), arrayLength(type));
+    }
+    case OpTypeStruct:
+    {
+        const std::vector<Member>& members = info(type).members;
+        if (members.empty())
+            return 0;
+        const Member& last = members.back();
+        const int size = SizeSum(last.offset, sizeOf(word(type, 2 + (unsigned int)members.size() - 1), &last,
+                                                     std140));
+
+        // the padding up to the struct's alignment
+        const int alignment = alignmentOf(type, nullptr, std140);
+        if (size < 0 || alignment < 0)
+            return -1;
+        return SizeProduct(((long long)size + alignment - 1) / alignment, alignment);
+    }
+    default:
+        return 0;
+    }
+}
+
+// The base alignment of an object of 'type' in a block, as TIntermediate::getBaseAlignment() figures it,
+// or -1 if that is out of range.
+int Reflector::alignmentOf(Id type, const Member* member, bool std140)
+{
+    int alignment;
+    switch (op(type)) {
+    case OpTypeVector:
+    {
+        const unsigned int components = word(type, 3);
+        return SizeProduct(sizeOf(word(type, 2), nullptr, std140), components == 3 ? 4 : components);
+    }
+    case OpTypeMatrix:
+    {
+        // a column, or a row for a row major matrix
+        const Id column = word(type, 2);
+        const unsigned int components = member != nullptr && member->rowMajor ? word(type, 3) : word(column, 3);
+        alignment = SizeProduct(sizeOf(word(column, 2), nullptr, std140), components == 3 ? 4 : components);
+        break;
+    }
+    case OpTypeArray:
+    case OpTypeRuntimeArray:
+        alignment = alignmentOf(word(type, 2), member, std140);
+        break;
+    case OpTypeStruct:
+    {
+        alignment = 1;
+        const std::vector<Member>& members = info(type).members;
+        for (unsigned int m = 0; m < members.size(); ++m) {
+            const int memberAlignment = alignmentOf(word(type, 2 + m), &members[m], std140);
+            if (memberAlignment < 0)
+                return -1;
+            alignment = std::max(alignment, memberAlignment);
+        }
+        break;
+    }
+    default:
+        return std::max(sizeOf(type, nullptr, std140), 1);
+    }
+    if (alignment < 0)
+        return -1;
+
+    // std140 rounds aggregates up to the alignment of a vec4
+    return std140 ? std::max(alignment, 16) : alignment;
+}
+
+} // end anonymous namespace
+
+namespace spv {
+
+bool ReflectSpirv(const unsigned int* spirv, size_t size, glslang::TReflectionRecords& records, std::string& error)
+{
+    Reflector reflector(spirv, size, records, error);
+    return reflector.reflect();
+}
+
+bool ReflectSpirv(const std::vector<unsigned int>& spirv, glslang::TReflectionRecords& records, std::string& error)
+{
+    return ReflectSpirv(spirv.data(), spirv.size(), records, error);
+}
+
+} // end spv namespace
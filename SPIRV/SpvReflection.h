@@ -0,0 +1,61 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef GLSLANG_SPIRV_REFLECTION_H
+#define GLSLANG_SPIRV_REFLECTION_H
+
+#include <string>
+#include <vector>
+
+#include "../glslang/Public/ReflectionFormat.h"
+
+namespace spv {
+
+// Reflect a SPIR-V module directly, without the front end: fill 'records'
+// with the uniforms, uniform blocks, vertex attributes and local size that
+// TProgram's reflection gives for the source.  This is one pass over the
+// declarations of the module, cheap enough to do on every module load.
+//
+// SPIR-V doesn't say which objects are used, so every member of every
+// declared block is reported, not just the active ones.
+//
+// Returns false, with a message in 'error', if 'spirv' is not a well formed
+// module.
+bool ReflectSpirv(const unsigned int* spirv, size_t size, glslang::TReflectionRecords& records, std::string& error);
+bool ReflectSpirv(const std::vector<unsigned int>& spirv, glslang::TReflectionRecords& records, std::string& error);
+
+} // end spv namespace
+
+#endif // GLSLANG_SPIRV_REFLECTION_H
@@ -82,17 +82,123 @@ const MemorySemanticsMask MemorySemanticsAllMemory =
                                       MemorySemanticsAtomicCounterMemoryMask |
                                       MemorySemanticsImageMemoryMask);
 
+//
+// Memory for the instructions of a module, taken a large chunk at a time.
+// It is only given back, all at once, when the pool is destroyed; deleting an
+// instruction before then just runs its destructor.
+//
+
+class InstructionPool {
+public:
+    InstructionPool() : next(nullptr), left(0) { }
+
+    void* allocate(size_t size)
+    {
+        size = (size + alignment - 1) & ~(alignment - 1);
+        if (size > left) {
+            left = size > chunkSize ? size : chunkSize;
+            chunks.push_back(std::unique_ptr<char[]>(new char[left]));
+            next = chunks.back().get();
+        }
+        void* memory = next;
+        next += size;
+        left -= size;
+
+        return memory;
+    }
+
+protected:
+    InstructionPool(const InstructionPool&);
+    InstructionPool& operator=(InstructionPool&);
+
+    static const size_t alignment = 16;        // enough for any instruction
+    static const size_t chunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]> > chunks;
+    char* next;    // the unused part of the last chunk
+    size_t left;
+};
+
+//
+// Where instructions are dumped in binary form.  The words go to a buffer,
+// which is handed to a sink whenever it fills up and at flush(); without a
+// sink, the buffer must have room for all of them.  A writer without a
+// buffer only counts the words, to size one.
+//
+
+class WordWriter {
+public:
+    typedef std::function<void(const unsigned int* words, size_t count)> Sink;
+
+    WordWriter() : buffer(nullptr), next(nullptr), end(nullptr), count(0) { }
+    WordWriter(unsigned int* buffer, size_t size, const Sink& sink = Sink()) :
+        buffer(buffer), next(buffer), end(buffer + size), sink(sink), count(0) { }
+
+    bool isCounting() const { return buffer == nullptr; }
+    size_t getCount() const { return count; }  // of the words written or counted
+
+    void write(unsigned int word)
+    {
+        ++count;
+        if (buffer == nullptr)
+            return;
+        if (next == end)
+            flush();
+        assert(next != end);
+        *(next++) = word;
+    }
+
+    // Count words without writing them; only for a writer that just counts.
+    void skip(size_t words)
+    {
+        assert(isCounting());
+        count += words;
+    }
+
+    void flush()
+    {
+        if (sink && next != buffer) {
+            sink(buffer, next - buffer);
+            next = buffer;
+        }
+    }
+
+protected:
+    WordWriter(const WordWriter&);
+    WordWriter& operator=(WordWriter&);
+
+    unsigned int* buffer;
+    unsigned int* next;
+    unsigned int* end;
+    Sink sink;
+    size_t count;
+};
+
 //
 // SPIR-V IR instruction.
 //
+// Instructions made by new come from the pool of their module:
+//     new (module) Instruction(...)
+// and are freed with it.  The first few operands are held in the instruction
+// itself.
+//
 
 class Instruction {
 public:
-    Instruction(Id resultId, Id typeId, Op opCode) : resultId(resultId), typeId(typeId), opCode(opCode), block(nullptr) { }
-    explicit Instruction(Op opCode) : resultId(NoResult), typeId(NoType), opCode(opCode), block(nullptr) { }
-    virtual ~Instruction() {}
-    void addIdOperand(Id id) { operands.push_back(id); }
-    void addImmediateOperand(unsigned int immediate) { operands.push_back(immediate); }
+    Instruction(Id resultId, Id typeId, Op opCode) : resultId(resultId), typeId(typeId), opCode(opCode),
+        operands(inlineOperands), numOperands(0), operandCapacity(numInlineOperands), block(nullptr) { }
+    explicit Instruction(Op opCode) : resultId(NoResult), typeId(NoType), opCode(opCode),
+        operands(inlineOperands), numOperands(0), operandCapacity(numInlineOperands), block(nullptr) { }
+    virtual ~Instruction()
+    {
+        if (operands != inlineOperands)
+            delete [] operands;
+    }
+    static void* operator new(size_t size, Module& module);
+    static void operator delete(void*) { }
+    static void operator delete(void*, Module&) { }
+    void addIdOperand(Id id) { addOperand(id); }
+    void addImmediateOperand(unsigned int immediate) { addOperand(immediate); }
     void addStringOperand(const char* str)
     {
         unsigned int word;
@@ -122,41 +228,68 @@ public:
     void setBlock(Block* b) { block = b; }
     Block* getBlock() const { return block; }
     Op getOpCode() const { return opCode; }
-    int getNumOperands() const { return (int)operands.size(); }
+    int getNumOperands() const { return numOperands; }
     Id getResultId() const { return resultId; }
     Id getTypeId() const { return typeId; }
     Id getIdOperand(int op) const { return operands[op]; }
     unsigned int getImmediateOperand(int op) const { return operands[op]; }
 
-    // Write out the binary form.
-    void dump(std::vector<unsigned int>& out) const
+    unsigned int getWordCount() const
     {
-        // Compute the wordCount
         unsigned int wordCount = 1;
         if (typeId)
             ++wordCount;
         if (resultId)
             ++wordCount;
-        wordCount += (unsigned int)operands.size();
+
+        return wordCount + (unsigned int)numOperands;
+    }
+
+    // Write out the binary form.
+    void dump(WordWriter& out) const
+    {
+        if (out.isCounting()) {
+            out.skip(getWordCount());
+            return;
+        }
 
         // Write out the beginning of the instruction
-        out.push_back(((wordCount) << WordCountShift) | opCode);
+        out.write((getWordCount() << WordCountShift) | opCode);
         if (typeId)
-            out.push_back(typeId);
+            out.write(typeId);
         if (resultId)
-            out.push_back(resultId);
+            out.write(resultId);
 
         // Write out the operands
-        for (int op = 0; op < (int)operands.size(); ++op)
-            out.push_back(operands[op]);
+        for (int op = 0; op < numOperands; ++op)
+            out.write(operands[op]);
     }
 
 protected:
     Instruction(const Instruction&);
+
+    void addOperand(Id word)
+    {
+        if (numOperands == operandCapacity) {
+            operandCapacity *= 2;
+            Id* grown = new Id[operandCapacity];
+            std::copy(operands, operands + numOperands, grown);
+            if (operands != inlineOperands)
+                delete [] operands;
+            operands = grown;
+        }
+        operands[numOperands++] = word;
+    }
+
+    static const int numInlineOperands = 4;
+
     Id resultId;
     Id typeId;
     Op opCode;
-    std::vector<Id> operands;
+    Id* operands;   // inlineOperands, until there are more than fit there
+    int numOperands;
+    int operandCapacity;
+    Id inlineOperands[numInlineOperands];
     Block* block;
 };
 
@@ -213,7 +346,7 @@ public:
         }
     }
 
-    void dump(std::vector<unsigned int>& out) const
+    void dump(WordWriter& out) const
     {
         instructions[0]->dump(out);
         for (int i = 0; i < (int)localVariables.size(); ++i)
@@ -282,7 +415,7 @@ public:
     void setImplicitThis() { implicitThis = true; }
     bool hasImplicitThis() const { return implicitThis; }
 
-    void dump(std::vector<unsigned int>& out) const
+    void dump(WordWriter& out) const
     {
         // OpFunction
         functionInstruction.dump(out);
@@ -327,11 +460,16 @@ public:
         spv::Id resultId = instruction->getResultId();
         // map the instruction's result id
         if (resultId >= idToInstruction.size())
-            idToInstruction.resize(resultId + 16);
+            idToInstruction.resize(std::max((size_t)resultId + 16, 2 * idToInstruction.size()));
         idToInstruction[resultId] = instruction;
     }
 
+    // Where the instructions of the module are made; it must outlive them.
+    InstructionPool& getInstructionPool() { return instructionPool; }
+
     Instruction* getInstruction(Id id) const { return idToInstruction[id]; }
+    // The instruction 'id' is the result of, or nullptr; 'id' may be any word.
+    Instruction* findInstruction(Id id) const { return id < idToInstruction.size() ? idToInstruction[id] : nullptr; }
     const std::vector<Function*>& getFunctions() const { return functions; }
     spv::Id getTypeId(Id resultId) const { return idToInstruction[resultId]->getTypeId(); }
     StorageClass getStorageClass(Id typeId) const
@@ -340,7 +478,7 @@ public:
         return (StorageClass)idToInstruction[typeId]->getImmediateOperand(0);
     }
 
-    void dump(std::vector<unsigned int>& out) const
+    void dump(WordWriter& out) const
     {
         for (int f = 0; f < (int)functions.size(); ++f)
             functions[f]->dump(out);
@@ -353,6 +491,8 @@ protected:
     // map from result id to instruction having that result id
     std::vector<Instruction*> idToInstruction;
 
+    InstructionPool instructionPool;
+
     // map from a result id to its type id
 };
 
@@ -360,6 +500,11 @@ protected:
 // Implementation (it's here due to circular type definitions).
 //
 
+__inline void* Instruction::operator new(size_t size, Module& module)
+{
+    return module.getInstructionPool().allocate(size);
+}
+
 // Add both
 // - the OpFunction instruction
 // - all the OpFunctionParameter instructions
@@ -376,7 +521,7 @@ __inline Function::Function(Id id, Id resultType, Id functionType, Id firstParam
     Instruction* typeInst = parent.getInstruction(functionType);
     int numParams = typeInst->getNumOperands() - 1;
     for (int p = 0; p < numParams; ++p) {
-        Instruction* param = new Instruction(firstParamId + p, typeInst->getIdOperand(p + 1), OpFunctionParameter);
+        Instruction* param = new (parent) Instruction(firstParamId + p, typeInst->getIdOperand(p + 1), OpFunctionParameter);
         parent.mapInstruction(param);
         parameterInstructions.push_back(param);
     }
@@ -391,7 +536,7 @@ __inline void Function::addLocalVariable(std::unique_ptr<Instruction> inst)
 
 __inline Block::Block(Id id, Function& parent) : parent(parent), unreachable(false)
 {
-    instructions.push_back(std::unique_ptr<Instruction>(new Instruction(id, NoType, OpLabel)));
+    instructions.push_back(std::unique_ptr<Instruction>(new (parent.getParent()) Instruction(id, NoType, OpLabel)));
     instructions.back()->setBlock(this);
     parent.getParent().mapInstruction(instructions.back().get());
 }
@@ -55,7 +55,10 @@
 #include <cctype>
 #include <cmath>
 #include <array>
+#include <fstream>
+#include <functional>
 #include <memory>
+#include <ostream>
 #include <thread>
 
 #include "../glslang/OSDependent/osinclude.h"
@@ -97,6 +100,12 @@ enum TOptions {
     EOptionStdin                = (1 << 27),
     EOptionOptimizeDisable      = (1 << 28),
     EOptionOptimizeSize         = (1 << 29),
+    EOptionEliminateDeadCode    = (1 << 30),
+    EOptionValueNumbering       = (1LL << 31),
+    EOptionInlineFunctions      = (1LL << 32),
+    EOptionParallelLink         = (1LL << 33),
+    EOptionSaveReflection       = (1LL << 34),
+    EOptionForwardLoads         = (1LL << 35),
 };
 
 //
@@ -143,13 +152,15 @@ void ProcessConfigFile()
     }
 }
 
-int Options = 0;
+long long Options = 0;
 const char* ExecutableName = nullptr;
 const char* binaryFileName = nullptr;
 const char* entryPointName = nullptr;
 const char* sourceEntryPointName = nullptr;
 const char* shaderStageName = nullptr;
 const char* variableName = nullptr;
+int InlineBudget = 0;                    // 0 keeps the default
+bool ReflectionJson = false;             // for --save-reflection
 std::vector<std::string> IncludeDirectoryList;
 int ClientInputSemanticsVersion = 100;   // maps to, say, #define VULKAN 100
 int VulkanClientVersion = 100;           // would map to, say, Vulkan 1.0
@@ -240,6 +251,36 @@ const char* GetBinaryName(EShLanguage stage)
     return name;
 }
 
+//
+// Save the reflection of 'program' next to the binary of its first stage,
+// for --save-reflection.
+//
+void SaveReflection(const glslang::TProgram& program)
+{
+    int stage = 0;
+    while (stage < EShLangCount && program.getIntermediate((EShLanguage)stage) == nullptr)
+        ++stage;
+    if (stage == EShLangCount)
+        return;
+
+    std::string name = GetBinaryName((EShLanguage)stage);
+    std::string contents;
+    if (ReflectionJson) {
+        name += ".refl.json";
+        program.serializeReflectionJson(contents);
+    } else {
+        name += ".refl";
+        std::vector<unsigned char> binary;
+        program.serializeReflection(binary);
+        contents.assign(binary.begin(), binary.end());
+    }
+
+    std::ofstream out(name.c_str(), std::ios::binary | std::ios::out);
+    if (out.fail())
+        printf("ERROR: Failed to open file: %s\n", name.c_str());
+    out.write(contents.data(), contents.size());
+}
+
 //
 // *.conf => this is a config file that can set limits/resources
 //
@@ -416,28 +457,51 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
                                 Error("--client expects vulkan100 or opengl100");
                         }
                         bumpArg();
+                    } else if (lowerword == "eliminate-dead-code" || // synonyms
+                               lowerword == "edc") {
+                        Options |= EOptionEliminateDeadCode;
                     } else if (lowerword == "flatten-uniform-arrays" || // synonyms
                                lowerword == "flatten-uniform-array"  ||
                                lowerword == "fua") {
                         Options |= EOptionFlattenUniformArrays;
+                    } else if (lowerword == "forward-loads") {
+                        Options |= EOptionForwardLoads;
                     } else if (lowerword == "hlsl-offsets") {
                         Options |= EOptionHlslOffsets;
                     } else if (lowerword == "hlsl-iomap" ||
                                lowerword == "hlsl-iomapper" ||
                                lowerword == "hlsl-iomapping") {
                         Options |= EOptionHlslIoMapping;
+                    } else if (lowerword == "inline-functions" || // synonyms
+                               lowerword == "inline") {
+                        Options |= EOptionInlineFunctions;
+                    } else if (lowerword == "inline-budget") {
+                        if (argc <= 1 || atoi(argv[1]) <= 0)
+                            Error("no positive <nodes> provided for --inline-budget");
+                        InlineBudget = atoi(argv[1]);
+                        bumpArg();
+                        break;
                     } else if (lowerword == "keep-uncalled" || // synonyms
                                lowerword == "ku") {
                         Options |= EOptionKeepUncalled;
                     } else if (lowerword == "no-storage-format" || // synonyms
                                lowerword == "nsf") {
                         Options |= EOptionNoStorageFormat;
+                    } else if (lowerword == "parallel-link") {
+                        Options |= EOptionParallelLink;
                     } else if (lowerword == "relaxed-errors") {
                         Options |= EOptionRelaxedErrors;
                     } else if (lowerword == "resource-set-bindings" ||  // synonyms
                                lowerword == "resource-set-binding"  ||
                                lowerword == "rsb") {
                         ProcessResourceSetBindingBase(argc, argv, baseResourceSetBinding);
+                    } else if (lowerword == "save-reflection") {
+                        if (argc <= 1 || (strcmp(argv[1], "binary") != 0 && strcmp(argv[1], "json") != 0))
+                            Error("--save-reflection expected binary or json");
+                        Options |= EOptionSaveReflection;
+                        ReflectionJson = strcmp(argv[1], "json") == 0;
+                        bumpArg();
+                        break;
                     } else if (lowerword == "shift-image-bindings" ||  // synonyms
                                lowerword == "shift-image-binding"  ||
                                lowerword == "sib") {
@@ -489,6 +553,9 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
                                 Error("--target-env expected vulkan1.0 or opengl");
                         }
                         bumpArg();
+                    } else if (lowerword == "value-numbering" || // synonyms
+                               lowerword == "lvn") {
+                        Options |= EOptionValueNumbering;
                     } else if (lowerword == "variable-name" || // synonyms
                         lowerword == "vn") {
                         Options |= EOptionOutputHexadecimal;
@@ -636,6 +703,10 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
     if (binaryFileName && (Options & EOptionSpv) == 0)
         Error("no binary generation requested (e.g., -V)");
 
+    // the reflection is saved next to the binary
+    if ((Options & EOptionSaveReflection) && (Options & EOptionSpv) == 0)
+        Error("--save-reflection requires binary generation (e.g., -V)");
+
     if ((Options & EOptionFlattenUniformArrays) != 0 &&
         (Options & EOptionReadHlsl) == 0)
         Error("uniform array flattening only valid when compiling HLSL source.");
@@ -664,6 +735,14 @@ void SetMessageOptions(EShMessages& messages)
         messages = (EShMessages)(messages | EShMsgCascadingErrors);
     if (Options & EOptionKeepUncalled)
         messages = (EShMessages)(messages | EShMsgKeepUncalled);
+    if (Options & EOptionEliminateDeadCode)
+        messages = (EShMessages)(messages | EShMsgEliminateDeadCode);
+    if (Options & EOptionValueNumbering)
+        messages = (EShMessages)(messages | EShMsgValueNumbering);
+    if (Options & EOptionInlineFunctions)
+        messages = (EShMessages)(messages | EShMsgInlineFunctions);
+    if (Options & EOptionParallelLink)
+        messages = (EShMessages)(messages | EShMsgParallelLink);
     if (Options & EOptionHlslOffsets)
         messages = (EShMessages)(messages | EShMsgHlslOffsets);
     if (Options & EOptionDebug)
@@ -721,6 +800,64 @@ void StderrIfNonEmpty(const char* str)
         fprintf(stderr, "%s\n", str);
 }
 
+// Writes a shader's or program's debug log (the AST, under -i) to stdout while
+// it is being produced, instead of after it has all been collected.  Output is
+// laid out as PutsIfNonEmpty() on the name, the info log, and then the debug log
+// would lay it out, except that info-log text added after the debug log started
+// streaming comes last.
+class TDebugLogStreamBuf : public std::streambuf {
+public:
+    TDebugLogStreamBuf(const char* name, std::function<const char*()> getInfoLog)
+        : name(name), getInfoLog(getInfoLog), started(false), wroteDebug(false), infoPrinted(0) { }
+
+    // Call once the log is complete.
+    void finish()
+    {
+        start();
+        if (wroteDebug)
+            putchar('\n');
+        const char* info = getInfoLog();
+        if (strlen(info) > infoPrinted)
+            PutsIfNonEmpty(info + infoPrinted);
+    }
+
+protected:
+    int overflow(int c) override
+    {
+        if (c != EOF) {
+            char ch = (char)c;
+            xsputn(&ch, 1);
+        }
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        start();
+        fwrite(s, 1, (size_t)n, stdout);
+        wroteDebug = wroteDebug || n > 0;
+        return n;
+    }
+
+    // Everything that comes before the debug log.
+    void start()
+    {
+        if (started)
+            return;
+        started = true;
+        PutsIfNonEmpty(name);
+        const char* info = getInfoLog();
+        PutsIfNonEmpty(info);
+        infoPrinted = strlen(info);
+    }
+
+    const char* name;
+    std::function<const char*()> getInfoLog;
+    bool started;
+    bool wroteDebug;
+    size_t infoPrinted;
+};
+
 // Simple bundling of what makes a compilation unit for ease in passing around,
 // and separation of handling file IO versus API (programmatic) compilation.
 struct ShaderCompUnit {
@@ -774,6 +911,19 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
     // Per-shader processing...
     //
 
+    // With -i, stream the (possibly huge) AST dumps rather than holding them.
+    // A program linking several stages prints all its info log before any of
+    // its debug log, which can't be kept while streaming, so only stream a
+    // single-stage program.
+    const bool streamLogs = (Options & EOptionIntermediate) &&
+                            ! (Options & EOptionSuppressInfolog) &&
+                            ! (Options & EOptionMemoryLeakMode);
+    bool streamProgramLog = streamLogs;
+    for (auto it = compUnits.cbegin(); it != compUnits.cend(); ++it) {
+        if (it->stage != compUnits.front().stage)
+            streamProgramLog = false;
+    }
+
     glslang::TProgram& program = *new glslang::TProgram;
     for (auto it = compUnits.cbegin(); it != compUnits.cend(); ++it) {
         const auto &compUnit = *it;
@@ -810,6 +960,9 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
         if (Options & EOptionAutoMapLocations)
             shader->setAutoMapLocations(true);
 
+        if (InlineBudget > 0)
+            shader->setInlineBudget(InlineBudget);
+
         // Set up the environment, some subsettings take precedence over earlier
         // ways of setting things.
         if (Options & EOptionSpv) {
@@ -847,12 +1000,21 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
             StderrIfNonEmpty(shader->getInfoDebugLog());
             continue;
         }
-        if (! shader->parse(&Resources, defaultVersion, false, messages, includer))
+        if (streamLogs) {
+            TDebugLogStreamBuf debugLog(compUnit.fileName[0].c_str(), [shader] { return shader->getInfoLog(); });
+            std::ostream debugStream(&debugLog);
+            shader->setInfoDebugLogStream(&debugStream);
+            if (! shader->parse(&Resources, defaultVersion, false, messages, includer))
+                CompileFailed = true;
+            shader->setInfoDebugLogStream(nullptr);
+            debugLog.finish();
+        } else if (! shader->parse(&Resources, defaultVersion, false, messages, includer))
             CompileFailed = true;
 
         program.addShader(shader);
 
-        if (! (Options & EOptionSuppressInfolog) &&
+        if (! streamLogs &&
+            ! (Options & EOptionSuppressInfolog) &&
             ! (Options & EOptionMemoryLeakMode)) {
             PutsIfNonEmpty(compUnit.fileName[0].c_str());
             PutsIfNonEmpty(shader->getInfoLog());
@@ -865,8 +1027,13 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
     //
 
     // Link
+    TDebugLogStreamBuf programDebugLog(nullptr, [&program] { return program.getInfoLog(); });
+    std::ostream programDebugStream(&programDebugLog);
+    if (streamProgramLog)
+        program.setInfoDebugLogStream(&programDebugStream);
     if (! (Options & EOptionOutputPreprocessed) && ! program.link(messages))
         LinkFailed = true;
+    program.setInfoDebugLogStream(nullptr);
 
     // Map IO
     if (Options & EOptionSpv) {
@@ -875,16 +1042,19 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
     }
 
     // Report
-    if (! (Options & EOptionSuppressInfolog) &&
-        ! (Options & EOptionMemoryLeakMode)) {
+    if (streamProgramLog)
+        programDebugLog.finish();
+    else if (! (Options & EOptionSuppressInfolog) &&
+             ! (Options & EOptionMemoryLeakMode)) {
         PutsIfNonEmpty(program.getInfoLog());
         PutsIfNonEmpty(program.getInfoDebugLog());
     }
 
     // Reflect
-    if (Options & EOptionDumpReflection) {
+    if (Options & (EOptionDumpReflection | EOptionSaveReflection)) {
         program.buildReflection();
-        program.dumpReflection();
+        if (Options & EOptionDumpReflection)
+            program.dumpReflection();
     }
 
     // Dump SPIR-V
@@ -902,6 +1072,7 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
                         spvOptions.generateDebugInfo = true;
                     spvOptions.disableOptimizer = (Options & EOptionOptimizeDisable) != 0;
                     spvOptions.optimizeSize = (Options & EOptionOptimizeSize) != 0;
+                    spvOptions.forwardLoads = (Options & EOptionForwardLoads) != 0;
                     glslang::GlslangToSpv(*program.getIntermediate((EShLanguage)stage), spirv, &logger, &spvOptions);
 
                     // Dump the spv to a file or stdout, etc., but only if not doing
@@ -919,6 +1090,9 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
                     }
                 }
             }
+
+            if ((Options & EOptionSaveReflection) && ! (Options & EOptionMemoryLeakMode))
+                SaveReflection(program);
         }
     }
 
@@ -1257,22 +1431,35 @@ void usage()
            "                                       'location' (fragile, not cross stage)\n"
            "  --aml                                synonym for --auto-map-locations\n"
            "  --client {vulkan<ver>|opengl<ver>}   see -V and -G\n"
+           "  --eliminate-dead-code                remove unreachable code, unread stores,\n"
+           "                                       and unused globals before code generation\n"
+           "  --edc                                synonym for --eliminate-dead-code\n"
            "  --flatten-uniform-arrays             flatten uniform texture/sampler arrays to\n"
            "                                       scalars\n"
            "  --fua                                synonym for --flatten-uniform-arrays\n"
+           "  --forward-loads                      reuse values already loaded or stored in\n"
+           "                                       a block instead of loading them again\n"
            "  --hlsl-offsets                       Allow block offsets to follow HLSL rules\n"
            "                                       Works independently of source language\n"
            "  --hlsl-iomap                         Perform IO mapping in HLSL register space\n"
+           "  --inline-functions                   inline calls to small functions before\n"
+           "                                       code generation\n"
+           "  --inline                             synonym for --inline-functions\n"
+           "  --inline-budget <nodes>              largest function body, in AST nodes, that\n"
+           "                                       --inline-functions inlines (default 64)\n"
            "  --keep-uncalled                      don't eliminate uncalled functions\n"
            "  --ku                                 synonym for --keep-uncalled\n"
            "  --no-storage-format                  use Unknown image format\n"
            "  --nsf                                synonym for --no-storage-format\n"
+           "  --parallel-link                      link the stages of a program concurrently\n"
            "  --relaxed-errors                     relaxed GLSL semantic error-checking mode\n"
            "  --resource-set-binding [stage] name set binding\n"
            "              Set descriptor set and binding for individual resources\n"
            "  --resource-set-binding [stage] set\n"
            "              Set descriptor set for all resources\n"
            "  --rsb [stage] type set binding       synonym for --resource-set-binding\n"
+           "  --save-reflection {binary|json}      save the program's reflection next to the\n"
+           "                                       binary, as <binary>.refl or <binary>.refl.json\n"
            "  --shift-image-binding [stage] num    base binding number for images (uav)\n"
            "  --sib [stage] num                    synonym for --shift-image-binding\n"
            "  --shift-sampler-binding [stage] num  base binding number for samplers\n"
@@ -1299,6 +1486,9 @@ void usage()
            "                                       semantics selected by --client) defaults:\n"
            "                                        'vulkan1.0' under '--client vulkan<ver>'\n"
            "                                        'opengl' under '--client opengl<ver>'\n"
+           "  --value-numbering                    compute expressions repeated in straight-line\n"
+           "                                       code just once, before code generation\n"
+           "  --lvn                                synonym for --value-numbering\n"
            "  --variable-name <name>               Creates a C header file that contains a\n"
            "                                       uint32_t array named <name>\n"
            "                                       initialized with the shader binary code.\n"
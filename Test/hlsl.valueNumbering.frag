@@ -0,0 +1,31 @@
+cbuffer Params {
+    float4x4 World;
+    float4 Tint;
+    float Scale;
+};
+
+Texture2D tex;
+SamplerState samp;
+
+float4 main(float4 pos : SV_Position, float2 uv : TEXCOORD0) : SV_Target0
+{
+    // repeated matrix indexing and swizzles
+    float3 n = World[0].xyz * Scale + World[1].xyz;
+    float3 m = World[0].xyz * Scale + World[1].xyz * 2.0;
+    float lit = dot(World[0].xyz * Scale + World[1].xyz, n);
+
+    // a store in between gives a new value
+    float4 c = tex.Sample(samp, uv) * Tint.x * Tint.y;
+    uv = uv * 2.0;
+    float4 d = tex.Sample(samp, uv) * Tint.x * Tint.y;
+
+    // precise operations don't share with imprecise ones
+    precise float p = pos.x * pos.y + pos.z;
+    float q = pos.x * pos.y + pos.z;
+    float r = pos.x * pos.y + pos.z;
+
+    // not always computed
+    float s = lit > 0.5 ? (Tint.x * Tint.y + Tint.z) * Scale : 0.0;
+
+    return c + d + float4(n + m, lit) * (p + q + r + s);
+}
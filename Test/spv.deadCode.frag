@@ -0,0 +1,66 @@
+#version 450
+
+layout(location = 0) in vec4 color;
+layout(location = 1) flat in int selector;
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) uniform sampler2D tex;
+
+const bool useTexture = false;
+
+vec4 unusedGlobal;                  // never mentioned
+vec4 writtenOnly = vec4(1.0);       // only ever written
+float counter;
+
+float helper(float x)               // only called from dead code
+{
+    return x * 2.0;
+}
+
+float bump(inout float x)
+{
+    x += 1.0;
+    return x;
+}
+
+void main()
+{
+    vec4 result = color;
+    vec4 unused = color * 2.0;      // never read
+    float first = color.x;          // only read by 'second', which is never read
+    float second = first + 1.0;
+    float bumped = bump(counter);   // never read, but the call stays
+    float self = 0.0;               // only read to update itself
+    for (int i = 0; i < 4; ++i) {
+        self = self + 1.0;
+    }
+    writtenOnly = color;
+
+    if (useTexture) {
+        result = texture(tex, color.xy) * helper(color.z);
+    } else {
+        result *= 0.5;
+    }
+
+    while (false) {
+        result = vec4(0.0);
+    }
+
+    color.x + color.y;              // value ignored
+
+    switch (selector) {
+    case 0:
+        result.x = 1.0;
+        break;
+        result.y = 2.0;             // unreachable
+    case 1:
+        result.z = counter;
+        break;
+    default:
+        break;
+    }
+
+    fragColor = result;
+    return;
+    fragColor = vec4(0.0);          // unreachable
+}
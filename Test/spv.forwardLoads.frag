@@ -0,0 +1,38 @@
+#version 450
+
+layout(location = 0) in vec4 color;
+layout(location = 1) flat in int index;
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) buffer Data { vec4 values[]; } data;
+
+float counter;
+
+void bump(inout float x)
+{
+    x += 1.0;
+    counter += x;
+}
+
+void main()
+{
+    vec4 v = color;                    // the input is loaded once
+    vec4 w = v * color + v;            // both reused
+    float f = w.x;
+    f = f * f;                         // the stored value is reused
+
+    w.y = f;                           // storing a component forgets w
+    fragColor = w + w;
+
+    bump(f);                           // a call forgets everything
+    fragColor += vec4(f + counter);
+
+    data.values[index] = v;            // buffer memory isn't followed
+    fragColor += data.values[index] + data.values[index];
+
+    if (f > 1.0)                       // a new block starts afresh
+        fragColor += vec4(f);
+
+    memoryBarrier();                   // so does a barrier
+    fragColor += vec4(f) + color;
+}
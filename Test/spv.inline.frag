@@ -0,0 +1,69 @@
+#version 450
+
+layout(location = 0) in vec4 color;
+layout(location = 1) in float scale;
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) uniform sampler2D tex;
+
+float counter;
+
+float square(float x)
+{
+    return x * x;
+}
+
+void split(vec4 v, out vec3 rgb, inout float a)
+{
+    rgb = v.rgb;
+    a *= v.a;
+}
+
+float saturated(float s)            // early returns
+{
+    if (s < 0.0)
+        return 0.0;
+    if (s > 1.0)
+        return 1.0;
+    return s;
+}
+
+float bump()                        // writes a global
+{
+    counter += 1.0;
+    return counter;
+}
+
+vec4 sample2D(sampler2D s, vec2 coord)
+{
+    return texture(s, coord);
+}
+
+float firstPositive(vec4 v)         // returns from a loop: not inlined
+{
+    for (int i = 0; i < 4; ++i) {
+        if (v[i] > 0.0)
+            return v[i];
+    }
+    return 0.0;
+}
+
+void main()
+{
+    vec3 rgb;
+    float a = 1.0;
+    split(color, rgb, a);
+
+    float s = saturated(scale);
+    for (int i = 0; i < 4; ++i) {
+        s += square(float(i)) * 0.1;
+    }
+
+    float b = counter + bump();     // counter is read first: bump() stays
+    float c = bump() + counter;
+    bool positive = s > 0.0 && square(s) > 0.5;
+
+    fragColor = vec4(rgb * square(s), a) + sample2D(tex, color.xy) * firstPositive(color);
+    if (positive)
+        fragColor *= b + c;
+}
@@ -99,6 +99,9 @@ inline long long int atoll (const char* str)
 #include <string>
 #include <cstdio>
 #include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
 
 #include "PoolAlloc.h"
 
@@ -190,6 +193,213 @@ template <class K, class D, class HASH = std::hash<K>, class PRED = std::equal_t
 class TUnorderedMap : public std::unordered_map<K, D, HASH, PRED, pool_allocator<std::pair<K const, D> > > {
 };
 
+//
+// Used by TSmallVector: as for std::vector, integral arguments to insert() and
+// assign() are a count and a value, not an iterator range.
+//
+template <class InputIt> struct TEnableIfIterator : std::enable_if<! std::is_integral<InputIt>::value> { };
+
+//
+// Pool allocator version of a vector that holds its first N elements inline,
+// for containers that almost always stay small.  Only the first growth past
+// N allocates (from the same pool TVector would use), instead of every
+// container needing at least one allocation.
+//
+// Elements are copied by assignment and never destroyed, so this is only
+// for plain element types, like pointers and enums.
+//
+template <class T, int N> class TSmallVector {
+public:
+    POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
+
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    TSmallVector() : allocator(&GetThreadPoolAllocator()), elements(inlineElements), count(0), capacityCount(N) { }
+    explicit TSmallVector(size_type n, const T& value = T()) :
+        allocator(&GetThreadPoolAllocator()), elements(inlineElements), count(0), capacityCount(N)
+    {
+        assign(n, value);
+    }
+    TSmallVector(const TSmallVector& copyOf) :
+        allocator(copyOf.allocator), elements(inlineElements), count(0), capacityCount(N)
+    {
+        assign(copyOf.begin(), copyOf.end());
+    }
+    TSmallVector& operator=(const TSmallVector& copyOf)
+    {
+        if (this != &copyOf)
+            assign(copyOf.begin(), copyOf.end());
+
+        return *this;
+    }
+
+    iterator begin() { return elements; }
+    iterator end() { return elements + count; }
+    const_iterator begin() const { return elements; }
+    const_iterator end() const { return elements + count; }
+    const_iterator cbegin() const { return elements; }
+    const_iterator cend() const { return elements + count; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    size_type size() const { return count; }
+    size_type capacity() const { return capacityCount; }
+    bool empty() const { return count == 0; }
+
+    T* data() { return elements; }
+    const T* data() const { return elements; }
+    T& operator[](size_type i) { assert(i < count); return elements[i]; }
+    const T& operator[](size_type i) const { assert(i < count); return elements[i]; }
+    T& at(size_type i) { assert(i < count); return elements[i]; }
+    const T& at(size_type i) const { assert(i < count); return elements[i]; }
+    T& front() { assert(count > 0); return elements[0]; }
+    const T& front() const { assert(count > 0); return elements[0]; }
+    T& back() { assert(count > 0); return elements[count - 1]; }
+    const T& back() const { assert(count > 0); return elements[count - 1]; }
+
+    void reserve(size_type n)
+    {
+        if (n <= capacityCount)
+            return;
+
+        T* newElements = reinterpret_cast<T*>(allocator->allocate(n * sizeof(T)));
+        for (size_type i = 0; i < count; ++i)
+            newElements[i] = elements[i];
+        elements = newElements;
+        capacityCount = static_cast<unsigned int>(n);
+    }
+
+    void clear() { count = 0; }
+    void resize(size_type n, const T& value = T())
+    {
+        if (n > count) {
+            reserve(n);
+            for (size_type i = count; i < n; ++i)
+                elements[i] = value;
+        }
+        count = static_cast<unsigned int>(n);
+    }
+
+    void assign(size_type n, const T& value)
+    {
+        clear();
+        resize(n, value);
+    }
+    template <class InputIt, class = typename TEnableIfIterator<InputIt>::type> void assign(InputIt first, InputIt last)
+    {
+        clear();
+        insert(end(), first, last);
+    }
+
+    void push_back(const T& value)
+    {
+        if (count == capacityCount) {
+            // 'value' might be one of our own elements
+            const T copy = value;
+            grow(count + 1);
+            elements[count++] = copy;
+        } else
+            elements[count++] = value;
+    }
+    void pop_back() { assert(count > 0); --count; }
+
+    iterator insert(const_iterator pos, const T& value) { return insert(pos, 1, value); }
+    iterator insert(const_iterator pos, size_type n, const T& value)
+    {
+        const T copy = value;
+        size_type at = makeRoom(pos, n);
+        for (size_type i = 0; i < n; ++i)
+            elements[at + i] = copy;
+
+        return elements + at;
+    }
+    template <class InputIt, class = typename TEnableIfIterator<InputIt>::type>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        // Gather first, as the source range could be within this vector, and
+        // a single-pass input range could not be measured up front anyway.
+        TSmallVector source;
+        for (; first != last; ++first)
+            source.push_back(*first);
+
+        size_type at = makeRoom(pos, source.size());
+        for (size_type i = 0; i < source.size(); ++i)
+            elements[at + i] = source[i];
+
+        return elements + at;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type at = first - elements;
+        size_type n = last - first;
+        for (size_type i = at; i + n < count; ++i)
+            elements[i] = elements[i + n];
+        count -= static_cast<unsigned int>(n);
+
+        return elements + at;
+    }
+
+    // Pool memory changes hands; only inline elements, at most N of them, are copied.
+    void swap(TSmallVector& other)
+    {
+        if (this == &other)
+            return;
+
+        if (! isInline() && ! other.isInline())
+            std::swap(elements, other.elements);
+        else if (isInline() && other.isInline())
+            std::swap_ranges(inlineElements, inlineElements + std::max(count, other.count), other.inlineElements);
+        else {
+            TSmallVector& inlined = isInline() ? *this : other;
+            TSmallVector& pooled = isInline() ? other : *this;
+            for (unsigned int i = 0; i < inlined.count; ++i)
+                pooled.inlineElements[i] = inlined.inlineElements[i];
+            inlined.elements = pooled.elements;
+            pooled.elements = pooled.inlineElements;
+        }
+        std::swap(count, other.count);
+        std::swap(capacityCount, other.capacityCount);
+        std::swap(allocator, other.allocator);
+    }
+
+protected:
+    bool isInline() const { return elements == inlineElements; }
+    void grow(size_type minCapacity) { reserve(std::max(minCapacity, static_cast<size_type>(2 * capacityCount))); }
+
+    // Open a gap of 'n' elements at 'pos', returning the gap's index.
+    size_type makeRoom(const_iterator pos, size_type n)
+    {
+        size_type at = pos - elements;
+        if (count + n > capacityCount)
+            grow(count + n);
+        for (size_type i = count; i > at; --i)
+            elements[i - 1 + n] = elements[i - 1];
+        count += static_cast<unsigned int>(n);
+
+        return at;
+    }
+
+    TPoolAllocator* allocator;  // same pool choice as pool_allocator makes for TVector
+    T* elements;                // either inlineElements, or pool memory after growing past N
+    unsigned int count;         // 32 bits are plenty, and keep the container small
+    unsigned int capacityCount;
+    T inlineElements[N];
+};
+
 //
 // Persistent string memory.  Should only be used for strings that survive
 // across compiles/links.
@@ -37,6 +37,7 @@
 
 #include "../Include/Common.h"
 #include <cmath>
+#include <ostream>
 
 namespace glslang {
 
@@ -67,7 +68,7 @@ enum TOutputStream {
 //
 class TInfoSinkBase {
 public:
-    TInfoSinkBase() : outputStream(4) {}
+    TInfoSinkBase() : outputStream(4), stream(nullptr), streamBufferSize(0) {}
     void erase() { sink.erase(); }
     TInfoSinkBase& operator<<(const TPersistString& t) { append(t); return *this; }
     TInfoSinkBase& operator<<(char c)                  { append(1, c); return *this; }
@@ -119,6 +120,26 @@ public:
         outputStream = output;
     }
 
+    // Hand the log to 'out' as it grows, rather than holding all of it:
+    // text collects in the sink until it reaches 'bufferSize' bytes, and is
+    // then written to 'out' and dropped, so c_str() only sees what has not
+    // been written yet.  Passing nullptr goes back to accumulating.
+    void setStream(std::ostream* out, size_t bufferSize = 64 * 1024)
+    {
+        flush();
+        stream = out;
+        streamBufferSize = bufferSize;
+    }
+
+    // Write out whatever a streaming sink is still holding.
+    void flush()
+    {
+        if (stream != nullptr && sink.size() > 0) {
+            stream->write(sink.data(), sink.size());
+            sink.erase();
+        }
+    }
+
 protected:
     void append(const char* s);
 
@@ -128,9 +149,13 @@ protected:
 
     void checkMem(size_t growth) { if (sink.capacity() < sink.size() + growth + 2)
                                        sink.reserve(sink.capacity() +  sink.capacity() / 2); }
+    void checkStream() { if (stream != nullptr && sink.size() >= streamBufferSize)
+                             flush(); }
     void appendToStream(const char* s);
     TPersistString sink;
     int outputStream;
+    std::ostream* stream;     // non-null when streaming, see setStream()
+    size_t streamBufferSize;
 };
 
 } // end namespace glslang
@@ -130,6 +130,8 @@ private:
 #   endif
 };
 
+class TTypeTable;
+
 //
 // There are several stacks.  One is to track the pushing and popping
 // of the user, and not yet implemented.  The others are simply a
@@ -176,6 +178,18 @@ public:
     //
     void* allocate(size_t numBytes);
 
+    //
+    // The table interning the types made in this pool (see TTypeTable), which
+    // must itself be allocated from the pool.  It goes when the memory it was
+    // allocated in is popped.
+    //
+    TTypeTable* getTypeTable() const { return typeTable; }
+    void setTypeTable(TTypeTable* table)
+    {
+        typeTable = table;
+        typeTableDepth = stack.size();
+    }
+
     //
     // There is no deallocate.  The point of this class is that
     // deallocation can be skipped by the user of it, as the model
@@ -240,6 +254,9 @@ protected:
 
     int numCalls;           // just an interesting statistic
     size_t totalBytes;      // just an interesting statistic
+
+    TTypeTable* typeTable;  // nullptr until made, see setTypeTable()
+    size_t typeTableDepth;  // size of 'stack' when 'typeTable' was allocated
 private:
     TPoolAllocator& operator=(const TPoolAllocator&);  // don't allow assignment operator
     TPoolAllocator(const TPoolAllocator&);  // don't allow default copy constructor
@@ -470,6 +470,60 @@ public:
         specConstant = false;
     }
 
+    // Every field is the same; this has to name all of them.
+    bool operator==(const TQualifier& right) const
+    {
+        return semanticName == right.semanticName &&
+               storage == right.storage &&
+               builtIn == right.builtIn &&
+               declaredBuiltIn == right.declaredBuiltIn &&
+               precision == right.precision &&
+               invariant == right.invariant &&
+               noContraction == right.noContraction &&
+               centroid == right.centroid &&
+               smooth == right.smooth &&
+               flat == right.flat &&
+               nopersp == right.nopersp &&
+#ifdef AMD_EXTENSIONS
+               explicitInterp == right.explicitInterp &&
+#endif
+               patch == right.patch &&
+               sample == right.sample &&
+               coherent == right.coherent &&
+               volatil == right.volatil &&
+               restrict == right.restrict &&
+               readonly == right.readonly &&
+               writeonly == right.writeonly &&
+               specConstant == right.specConstant &&
+               layoutMatrix == right.layoutMatrix &&
+               layoutPacking == right.layoutPacking &&
+               layoutOffset == right.layoutOffset &&
+               layoutAlign == right.layoutAlign &&
+               layoutLocation == right.layoutLocation &&
+               layoutComponent == right.layoutComponent &&
+               layoutSet == right.layoutSet &&
+               layoutBinding == right.layoutBinding &&
+               layoutIndex == right.layoutIndex &&
+               layoutStream == right.layoutStream &&
+               layoutXfbBuffer == right.layoutXfbBuffer &&
+               layoutXfbStride == right.layoutXfbStride &&
+               layoutXfbOffset == right.layoutXfbOffset &&
+               layoutAttachment == right.layoutAttachment &&
+               layoutSpecConstantId == right.layoutSpecConstantId &&
+               layoutFormat == right.layoutFormat &&
+#ifdef NV_EXTENSIONS
+               layoutPassthrough == right.layoutPassthrough &&
+               layoutViewportRelative == right.layoutViewportRelative &&
+               layoutSecondaryViewportRelativeOffset == right.layoutSecondaryViewportRelativeOffset &&
+#endif
+               layoutPushConstant == right.layoutPushConstant;
+    }
+
+    bool operator!=(const TQualifier& right) const
+    {
+        return ! operator==(right);
+    }
+
     const char*         semanticName;
     TStorageQualifier   storage   : 6;
     TBuiltInVariable    builtIn   : 8;
@@ -1330,6 +1384,8 @@ public:
         assert(fieldName);
         return *fieldName;
     }
+    virtual bool hasTypeName() const { return typeName != nullptr; }
+    virtual bool hasFieldName() const { return fieldName != nullptr; }
 
     virtual TBasicType getBasicType() const { return basicType; }
     virtual const TSampler& getSampler() const { return sampler; }
@@ -1493,6 +1549,12 @@ public:
         arraySizes = new TArraySizes;
         *arraySizes = s;
     }
+    void transferArraySizes(TArraySizes* s)
+    {
+        // For setting an already allocated set of sizes that this type can use
+        // (no copy made), e.g., to restore sharing of an array descriptor.
+        arraySizes = s;
+    }
     void clearArraySizes()
     {
         arraySizes = 0;
@@ -1549,7 +1611,8 @@ public:
         }
     }
 
-    TString getCompleteString() const
+    // 'getPrecision' false leaves out precision qualifiers, including those of members.
+    TString getCompleteString(bool getPrecision = true) const
     {
         TString typeString;
 
@@ -1692,7 +1755,7 @@ public:
                 }
             }
         }
-        if (qualifier.precision != EpqNone) {
+        if (getPrecision && qualifier.precision != EpqNone) {
             appendStr(" ");
             appendStr(getPrecisionQualifierString());
         }
@@ -1721,7 +1784,7 @@ public:
             appendStr("{");
             for (size_t i = 0; i < structure->size(); ++i) {
                 if (! (*structure)[i].type->hiddenMember()) {
-                    typeString.append((*structure)[i].type->getCompleteString());
+                    typeString.append((*structure)[i].type->getCompleteString(getPrecision));
                     typeString.append(" ");
                     typeString.append((*structure)[i].type->getFieldName());
                     if (i < structure->size() - 1)
@@ -1775,6 +1838,12 @@ public:
         name += ';' ;
     }
 
+    // Structural stand-ins for the mangled name, to tell types apart without
+    // building strings: types whose mangled names are equal have the same
+    // signature hash, and are the same signature.
+    size_t getSignatureHash() const;
+    bool sameSignature(const TType& right) const;
+
     // Do two structure types match?  They could be declared independently,
     // in different places, but still might satisfy the definition of matching.
     // From the spec:
@@ -1844,6 +1913,9 @@ public:
     // See if two types match in all ways (just the actual type, not qualification)
     bool operator==(const TType& right) const
     {
+        if (this == &right)
+            return true;
+
         return sameElementType(right) && sameArrayness(right);
     }
 
@@ -1852,6 +1924,36 @@ public:
         return ! operator==(right);
     }
 
+    // Whether 'right' could be a shallow copy of this type: every field is the
+    // same, and the parts shallow copies share are the same objects.
+    bool sameShallow(const TType& right) const
+    {
+        return basicType == right.basicType &&
+               vectorSize == right.vectorSize &&
+               matrixCols == right.matrixCols &&
+               matrixRows == right.matrixRows &&
+               vector1 == right.vector1 &&
+               sampler == right.sampler &&
+               qualifier == right.qualifier &&
+               arraySizes == right.arraySizes &&
+               structure == right.structure &&
+               fieldName == right.fieldName &&
+               typeName == right.typeName;
+    }
+
+    // A hash that agrees with sameShallow().
+    size_t getShallowHash() const
+    {
+        size_t hash = basicType;
+        hash = hash * 31 + (vectorSize | matrixCols << 4 | matrixRows << 8);
+        hash = hash * 31 + (qualifier.storage | qualifier.precision << 6 | qualifier.builtIn << 9);
+        hash = hash * 31 + (qualifier.layoutLocation | qualifier.layoutBinding << 12);
+        hash = hash * 31 + std::hash<const void*>()(arraySizes);
+        hash = hash * 31 + std::hash<const void*>()(structure);
+
+        return hash;
+    }
+
 protected:
     // Require consumer to pick between deep copy and shallow copy.
     TType(const TType& type);
@@ -1913,6 +2015,60 @@ protected:
     TSampler sampler;
 };
 
+//
+// Hash-conses types: identical types (see TType::sameShallow()) get one
+// shared node, so a type is held once however many AST nodes have it, and
+// two interned types are the same exactly when their pointers are.  The
+// shared nodes must not be changed.
+//
+// Each pool has its own table, and its nodes come from that pool, so they
+// go away together; see current().
+//
+class TTypeTable {
+public:
+    POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
+
+    TTypeTable() { }
+
+    // The shared node for types identical to 'type'.
+    const TType* intern(const TType& type)
+    {
+        tTypeSet::const_iterator it = types.find(&type);
+        if (it != types.end())
+            return *it;
+
+        TType* node = new TType;
+        node->shallowCopy(type);
+        types.insert(node);
+
+        return node;
+    }
+
+    // The table for the current thread's pool, made on first use.
+    static TTypeTable& current()
+    {
+        TPoolAllocator& pool = GetThreadPoolAllocator();
+        if (pool.getTypeTable() == nullptr)
+            pool.setTypeTable(new TTypeTable);
+
+        return *pool.getTypeTable();
+    }
+
+protected:
+    TTypeTable(const TTypeTable&);
+    TTypeTable& operator=(const TTypeTable&);
+
+    struct TTypeHash {
+        size_t operator()(const TType* type) const { return type->getShallowHash(); }
+    };
+    struct TTypeEqual {
+        bool operator()(const TType* left, const TType* right) const { return left->sameShallow(*right); }
+    };
+    typedef std::unordered_set<const TType*, TTypeHash, TTypeEqual, pool_allocator<const TType*> > tTypeSet;
+
+    tTypeSet types;
+};
+
 } // end namespace glslang
 
 #endif // _TYPES_INCLUDED_
@@ -853,33 +853,67 @@ struct TIntermNodePair {
 //
 // Intermediate class for nodes that have a type.
 //
+//
+// The type is interned (see TTypeTable), and so shared with other nodes of
+// the same type, until the node is given a writable type of its own by
+// getWritableType().  After that, setType() changes that type in place, as it
+// did before.  Precision, which changes most often, is set by setPrecision(),
+// which keeps the type shared.
+//
 class TIntermTyped : public TIntermNode {
 public:
-    TIntermTyped(const TType& t) { type.shallowCopy(t); }
-    TIntermTyped(TBasicType basicType) { TType bt(basicType); type.shallowCopy(bt); }
+    TIntermTyped(const TType& t) : type(TTypeTable::current().intern(t)), writableType(nullptr) { }
+    TIntermTyped(TBasicType basicType) : writableType(nullptr) { TType bt(basicType); type = TTypeTable::current().intern(bt); }
     virtual       TIntermTyped* getAsTyped()       { return this; }
     virtual const TIntermTyped* getAsTyped() const { return this; }
-    virtual void setType(const TType& t) { type.shallowCopy(t); }
-    virtual const TType& getType() const { return type; }
-    virtual TType& getWritableType() { return type; }
+    virtual void setType(const TType& t)
+    {
+        if (writableType != nullptr)
+            writableType->shallowCopy(t);
+        else
+            type = TTypeTable::current().intern(t);
+    }
+    virtual const TType& getType() const { return *type; }
+    virtual TType& getWritableType()
+    {
+        if (writableType == nullptr) {
+            writableType = new TType;
+            writableType->shallowCopy(*type);
+            type = writableType;
+        }
+        return *writableType;
+    }
 
-    virtual TBasicType getBasicType() const { return type.getBasicType(); }
-    virtual TQualifier& getQualifier() { return type.getQualifier(); }
-    virtual const TQualifier& getQualifier() const { return type.getQualifier(); }
+    virtual TBasicType getBasicType() const { return type->getBasicType(); }
+    virtual const TQualifier& getQualifier() const { return type->getQualifier(); }
+    void setPrecision(TPrecisionQualifier precision)
+    {
+        if (type->getQualifier().precision == precision)
+            return;
+        if (writableType != nullptr)
+            writableType->getQualifier().precision = precision;
+        else {
+            TType t;
+            t.shallowCopy(*type);
+            t.getQualifier().precision = precision;
+            type = TTypeTable::current().intern(t);
+        }
+    }
     virtual void propagatePrecision(TPrecisionQualifier);
-    virtual int getVectorSize() const { return type.getVectorSize(); }
-    virtual int getMatrixCols() const { return type.getMatrixCols(); }
-    virtual int getMatrixRows() const { return type.getMatrixRows(); }
-    virtual bool isMatrix() const { return type.isMatrix(); }
-    virtual bool isArray()  const { return type.isArray(); }
-    virtual bool isVector() const { return type.isVector(); }
-    virtual bool isScalar() const { return type.isScalar(); }
-    virtual bool isStruct() const { return type.isStruct(); }
-    TString getCompleteString() const { return type.getCompleteString(); }
+    virtual int getVectorSize() const { return type->getVectorSize(); }
+    virtual int getMatrixCols() const { return type->getMatrixCols(); }
+    virtual int getMatrixRows() const { return type->getMatrixRows(); }
+    virtual bool isMatrix() const { return type->isMatrix(); }
+    virtual bool isArray()  const { return type->isArray(); }
+    virtual bool isVector() const { return type->isVector(); }
+    virtual bool isScalar() const { return type->isScalar(); }
+    virtual bool isStruct() const { return type->isStruct(); }
+    TString getCompleteString() const { return type->getCompleteString(); }
 
 protected:
     TIntermTyped& operator=(const TIntermTyped&);
-    TType type;
+    const TType* type;     // interned, unless it is 'writableType'
+    TType* writableType;   // nullptr until the node has a type of its own
 };
 
 //
@@ -945,6 +979,7 @@ public:
     virtual void traverse(TIntermTraverser*);
     TOperator getFlowOp() const { return flowOp; }
     TIntermTyped* getExpression() const { return expression; }
+    void setExpression(TIntermTyped* e) { expression = e; }
 protected:
     TOperator flowOp;
     TIntermTyped* expression;
@@ -1064,11 +1099,11 @@ public:
     void setOperationPrecision(TPrecisionQualifier p) { operationPrecision = p; }
     TPrecisionQualifier getOperationPrecision() const { return operationPrecision != EpqNone ?
                                                                                      operationPrecision :
-                                                                                     type.getQualifier().precision; }
+                                                                                     type->getQualifier().precision; }
     TString getCompleteString() const
     {
-        TString cs = type.getCompleteString();
-        if (getOperationPrecision() != type.getQualifier().precision) {
+        TString cs = type->getCompleteString();
+        if (getOperationPrecision() != type->getQualifier().precision) {
             cs += ", operation at ";
             cs += GetPrecisionQualifierString(getOperationPrecision());
         }
@@ -1290,15 +1325,17 @@ protected:
     TIntermTyped* operand;
 };
 
-typedef TVector<TIntermNode*> TIntermSequence;
-typedef TVector<TStorageQualifier> TQualifierList;
+// Aggregates (function calls, constructors, operator wrappers, ...) nearly always
+// have just a handful of operands, so keep those inline in the node.
+typedef TSmallVector<TIntermNode*, 4> TIntermSequence;
+typedef TSmallVector<TStorageQualifier, 4> TQualifierList;
 //
 // Nodes that operate on an arbitrary sized set of children.
 //
 class TIntermAggregate : public TIntermOperator {
 public:
-    TIntermAggregate() : TIntermOperator(EOpNull), userDefined(false), pragmaTable(0) { }
-    TIntermAggregate(TOperator o) : TIntermOperator(o), pragmaTable(0) { }
+    TIntermAggregate() : TIntermOperator(EOpNull), userDefined(false), optimize(false), debug(false), pragmaTable(0) { }
+    TIntermAggregate(TOperator o) : TIntermOperator(o), userDefined(false), optimize(false), debug(false), pragmaTable(0) { }
     ~TIntermAggregate() { delete pragmaTable; }
     virtual       TIntermAggregate* getAsAggregate()       { return this; }
     virtual const TIntermAggregate* getAsAggregate() const { return this; }
@@ -1317,6 +1354,7 @@ public:
     bool getOptimize() const { return optimize; }
     bool getDebug() const { return debug; }
     void addToPragmaTable(const TPragmaTable& pTable);
+    bool hasPragmaTable() const { return pragmaTable != nullptr; }
     const TPragmaTable& getPragmaTable() const { return *pragmaTable; }
 protected:
     TIntermAggregate(const TIntermAggregate&); // disallow copy constructor
@@ -1341,6 +1379,7 @@ public:
         TIntermTyped(type), condition(cond), trueBlock(trueB), falseBlock(falseB), control(ESelectionControlNone) {}
     virtual void traverse(TIntermTraverser*);
     virtual TIntermTyped* getCondition() const { return condition; }
+    void setCondition(TIntermTyped* c) { condition = c; }
     virtual TIntermNode* getTrueBlock() const { return trueBlock; }
     virtual TIntermNode* getFalseBlock() const { return falseBlock; }
     virtual       TIntermSelection* getAsSelectionNode()       { return this; }
@@ -1365,6 +1404,7 @@ public:
     TIntermSwitch(TIntermTyped* cond, TIntermAggregate* b) : condition(cond), body(b), control(ESelectionControlNone) { }
     virtual void traverse(TIntermTraverser*);
     virtual TIntermNode* getCondition() const { return condition; }
+    void setCondition(TIntermTyped* c) { condition = c; }
     virtual TIntermAggregate* getBody() const { return body; }
     virtual       TIntermSwitch* getAsSwitchNode()       { return this; }
     virtual const TIntermSwitch* getAsSwitchNode() const { return this; }
@@ -1383,6 +1423,20 @@ enum TVisit
     EvPostVisit
 };
 
+//
+// The node classes having children, as told to the traverser by their traverse().
+//
+enum TTraversalNode
+{
+    EtnBinary,
+    EtnUnary,
+    EtnAggregate,
+    EtnSelection,
+    EtnLoop,
+    EtnBranch,
+    EtnSwitch
+};
+
 //
 // For traversing the tree.  User should derive from this,
 // put their traversal specific data in it, and then pass
@@ -1404,6 +1458,12 @@ enum TVisit
 //
 // If you process children yourself, or don't want them processed, return false.
 //
+// The walk itself does not recurse through the C++ stack: the nodes' traverse()
+// methods hand themselves to traverseNode(), which keeps its own stack of
+// partially visited nodes.  So arbitrarily deep trees (long expression chains,
+// deeply nested selections, ...) are fine, as are visit*() methods that call
+// traverse() on a subtree themselves.
+//
 class TIntermTraverser {
 public:
     POOL_ALLOCATOR_NEW_DELETE(glslang::GetThreadPoolAllocator())
@@ -1413,7 +1473,8 @@ public:
             postVisit(postVisit),
             rightToLeft(rightToLeft),
             depth(0),
-            maxDepth(0) { }
+            maxDepth(0),
+            entering(nullptr) { }
     virtual ~TIntermTraverser() { }
 
     virtual void visitSymbol(TIntermSymbol*)               { }
@@ -1446,6 +1507,10 @@ public:
         return path.size() == 0 ? NULL : path.back();
     }
 
+    // Visit the subtree rooted at 'node', which has children as described by 'kind'.
+    // This is for the nodes' traverse() methods; use node->traverse(traverser) to walk a tree.
+    void traverseNode(TIntermNode* node, TTraversalNode kind);
+
     const bool preVisit;
     const bool inVisit;
     const bool postVisit;
@@ -1454,11 +1519,30 @@ public:
 protected:
     TIntermTraverser& operator=(TIntermTraverser&);
 
+    // A node whose children are being visited.
+    struct TTraversalFrame {
+        TIntermNode* node;
+        TTraversalNode kind;
+        int step;    // how far along visiting the children (and in-visits) this node is
+        bool visit;  // false once an in-visit asked to stop, which also skips the post-visit
+    };
+
+    bool visitNode(TVisit, TIntermNode*, TTraversalNode);
+    void enterNode(TIntermNode*, TTraversalNode);
+    TIntermNode* advanceFrame(size_t frame);
+
     int depth;
     int maxDepth;
 
     // All the nodes from root to the current node's parent during traversing.
     TVector<TIntermNode *> path;
+
+    // Nodes whose children are being visited, innermost last; shared by nested walks.
+    TVector<TTraversalFrame> frames;
+
+    // The child being handed to its traverse(), which should only get it started.
+    // (Anything else reaching traverseNode() is a new walk, e.g., from a visit function.)
+    TIntermNode* entering;
 };
 
 // KHR_vulkan_glsl says "Two arrays sized with specialization constants are the same type only if
@@ -47,6 +47,7 @@ void TInfoSinkBase::append(const char* s)
             checkMem(strlen(s));
             sink.append(s);
         }
+        checkStream();
     }
 
 //#ifdef _WIN32
@@ -63,6 +64,7 @@ void TInfoSinkBase::append(int count, char c)
     if (outputStream & EString) {
         checkMem(count);
         sink.append(count, c);
+        checkStream();
     }
 
 //#ifdef _WIN32
@@ -83,6 +85,7 @@ void TInfoSinkBase::append(const TPersistString& t)
     if (outputStream & EString) {
         checkMem(t.size());
         sink.append(t);
+        checkStream();
     }
 
 //#ifdef _WIN32
@@ -99,6 +102,7 @@ void TInfoSinkBase::append(const TString& t)
     if (outputStream & EString) {
         checkMem(t.size());
         sink.append(t.c_str());
+        checkStream();
     }
 
 //#ifdef _WIN32
@@ -42,7 +42,6 @@ namespace glslang {
 //
 // Traverse the intermediate representation tree, and
 // call a node type specific function for each node.
-// Done recursively through the member function Traverse().
 // Node types can be skipped if their function to call is 0,
 // but their subtree will still be traversed.
 // Nodes with children can have their whole subtree skipped
@@ -52,6 +51,13 @@ namespace glslang {
 // preVisit, postVisit, and rightToLeft control what order
 // nodes are visited in.
 //
+// Nodes with children don't traverse them through recursive calls
+// to traverse().  Instead, they pass themselves to the traverser's
+// traverseNode(), which walks the subtree with an explicit stack of
+// frames, one per node whose children are still being visited.
+// Each frame is a small state machine, stepping through the node's
+// children and in-visits in the same order a recursive walk would.
+//
 
 //
 // Traversal functions for terminals are straightforward....
@@ -72,231 +78,244 @@ void TIntermConstantUnion::traverse(TIntermTraverser *it)
 }
 
 //
-// Traverse a binary node.
+// Nodes with children let the traverser's explicit stack do the work.
 //
 void TIntermBinary::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
-
-    //
-    // visit the node before children if pre-visiting.
-    //
-    if (it->preVisit)
-        visit = it->visitBinary(EvPreVisit, this);
-
-    //
-    // Visit the children, in the right order.
-    //
-    if (visit) {
-        it->incrementDepth(this);
-
-        if (it->rightToLeft) {
-            if (right)
-                right->traverse(it);
-
-            if (it->inVisit)
-                visit = it->visitBinary(EvInVisit, this);
-
-            if (visit && left)
-                left->traverse(it);
-        } else {
-            if (left)
-                left->traverse(it);
-
-            if (it->inVisit)
-                visit = it->visitBinary(EvInVisit, this);
-
-            if (visit && right)
-                right->traverse(it);
-        }
-
-        it->decrementDepth();
-    }
-
-    //
-    // Visit the node after the children, if requested and the traversal
-    // hasn't been canceled yet.
-    //
-    if (visit && it->postVisit)
-        it->visitBinary(EvPostVisit, this);
+    it->traverseNode(this, EtnBinary);
 }
 
-//
-// Traverse a unary node.  Same comments in binary node apply here.
-//
 void TIntermUnary::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
-
-    if (it->preVisit)
-        visit = it->visitUnary(EvPreVisit, this);
-
-    if (visit) {
-        it->incrementDepth(this);
-        operand->traverse(it);
-        it->decrementDepth();
-    }
-
-    if (visit && it->postVisit)
-        it->visitUnary(EvPostVisit, this);
+    it->traverseNode(this, EtnUnary);
 }
 
-//
-// Traverse an aggregate node.  Same comments in binary node apply here.
-//
 void TIntermAggregate::traverse(TIntermTraverser *it)
 {
-    bool visit = true;
-
-    if (it->preVisit)
-        visit = it->visitAggregate(EvPreVisit, this);
-
-    if (visit) {
-        it->incrementDepth(this);
-
-        if (it->rightToLeft) {
-            for (TIntermSequence::reverse_iterator sit = sequence.rbegin(); sit != sequence.rend(); sit++) {
-                (*sit)->traverse(it);
+    it->traverseNode(this, EtnAggregate);
+}
 
-                if (visit && it->inVisit) {
-                    if (*sit != sequence.front())
-                        visit = it->visitAggregate(EvInVisit, this);
-                }
-            }
-        } else {
-            for (TIntermSequence::iterator sit = sequence.begin(); sit != sequence.end(); sit++) {
-                (*sit)->traverse(it);
+void TIntermSelection::traverse(TIntermTraverser *it)
+{
+    it->traverseNode(this, EtnSelection);
+}
 
-                if (visit && it->inVisit) {
-                    if (*sit != sequence.back())
-                        visit = it->visitAggregate(EvInVisit, this);
-                }
-            }
-        }
+void TIntermLoop::traverse(TIntermTraverser *it)
+{
+    it->traverseNode(this, EtnLoop);
+}
 
-        it->decrementDepth();
-    }
+void TIntermBranch::traverse(TIntermTraverser *it)
+{
+    it->traverseNode(this, EtnBranch);
+}
 
-    if (visit && it->postVisit)
-        it->visitAggregate(EvPostVisit, this);
+void TIntermSwitch::traverse(TIntermTraverser* it)
+{
+    it->traverseNode(this, EtnSwitch);
 }
 
 //
-// Traverse a selection node.  Same comments in binary node apply here.
+// Walk the subtree rooted at 'node'.
 //
-void TIntermSelection::traverse(TIntermTraverser *it)
+// This is either the start of a walk (from the top, or from a visit function
+// processing children itself), or the loop below handing a child to its
+// traverse() to find out what kind of node it is.  In the latter case, just
+// get the child started, and return to the loop that is already running.
+//
+void TIntermTraverser::traverseNode(TIntermNode* node, TTraversalNode kind)
 {
-    bool visit = true;
+    if (node == entering) {
+        entering = nullptr;
+        enterNode(node, kind);
+        return;
+    }
 
-    if (it->preVisit)
-        visit = it->visitSelection(EvPreVisit, this);
+    // Frames below 'base' belong to walks that are waiting on this one.
+    const size_t base = frames.size();
 
-    if (visit) {
-        it->incrementDepth(this);
-        if (it->rightToLeft) {
-            if (falseBlock)
-                falseBlock->traverse(it);
-            if (trueBlock)
-                trueBlock->traverse(it);
-            condition->traverse(it);
-        } else {
-            condition->traverse(it);
-            if (trueBlock)
-                trueBlock->traverse(it);
-            if (falseBlock)
-                falseBlock->traverse(it);
+    enterNode(node, kind);
+    while (frames.size() > base) {
+        TIntermNode* child = advanceFrame(frames.size() - 1);
+        if (child != nullptr) {
+            entering = child;
+            child->traverse(this);
+            entering = nullptr;  // in case 'child' was a terminal, which doesn't look at it
         }
-        it->decrementDepth();
     }
-
-    if (visit && it->postVisit)
-        it->visitSelection(EvPostVisit, this);
 }
 
 //
-// Traverse a loop node.  Same comments in binary node apply here.
+// Call the visit function for a node with children.
 //
-void TIntermLoop::traverse(TIntermTraverser *it)
+bool TIntermTraverser::visitNode(TVisit visit, TIntermNode* node, TTraversalNode kind)
 {
-    bool visit = true;
-
-    if (it->preVisit)
-        visit = it->visitLoop(EvPreVisit, this);
-
-    if (visit) {
-        it->incrementDepth(this);
-
-        if (it->rightToLeft) {
-            if (terminal)
-                terminal->traverse(it);
-
-            if (body)
-                body->traverse(it);
-
-            if (test)
-                test->traverse(it);
-        } else {
-            if (test)
-                test->traverse(it);
-
-            if (body)
-                body->traverse(it);
-
-            if (terminal)
-                terminal->traverse(it);
-        }
-
-        it->decrementDepth();
+    switch (kind) {
+    case EtnBinary:    return visitBinary(visit, static_cast<TIntermBinary*>(node));
+    case EtnUnary:     return visitUnary(visit, static_cast<TIntermUnary*>(node));
+    case EtnAggregate: return visitAggregate(visit, static_cast<TIntermAggregate*>(node));
+    case EtnSelection: return visitSelection(visit, static_cast<TIntermSelection*>(node));
+    case EtnLoop:      return visitLoop(visit, static_cast<TIntermLoop*>(node));
+    case EtnBranch:    return visitBranch(visit, static_cast<TIntermBranch*>(node));
+    case EtnSwitch:    return visitSwitch(visit, static_cast<TIntermSwitch*>(node));
+    default:
+        assert(0);
+        return false;
     }
-
-    if (visit && it->postVisit)
-        it->visitLoop(EvPostVisit, this);
 }
 
 //
-// Traverse a branch node.  Same comments in binary node apply here.
+// Pre-visit the node, and if its children are to be visited, push a frame for it.
 //
-void TIntermBranch::traverse(TIntermTraverser *it)
+void TIntermTraverser::enterNode(TIntermNode* node, TTraversalNode kind)
 {
-    bool visit = true;
-
-    if (it->preVisit)
-        visit = it->visitBranch(EvPreVisit, this);
-
-    if (visit && expression) {
-        it->incrementDepth(this);
-        expression->traverse(it);
-        it->decrementDepth();
+    //
+    // visit the node before children if pre-visiting.
+    //
+    if (preVisit && ! visitNode(EvPreVisit, node, kind))
+        return;
+
+    // A branch without an expression has no children, and no depth.
+    if (kind == EtnBranch && static_cast<TIntermBranch*>(node)->getExpression() == nullptr) {
+        if (postVisit)
+            visitBranch(EvPostVisit, static_cast<TIntermBranch*>(node));
+        return;
     }
 
-    if (visit && it->postVisit)
-        it->visitBranch(EvPostVisit, this);
+    incrementDepth(node);
+
+    TTraversalFrame frame = { node, kind, 0, true };
+    frames.push_back(frame);
 }
 
 //
-// Traverse a switch node.
+// Take the next step for the node in frames[frame]: return the next child to visit,
+// or do an in-visit and return nullptr, or finish the node and pop its frame.
 //
-void TIntermSwitch::traverse(TIntermTraverser* it)
+// Visit functions can start nested walks, which push (and pop) more frames, so
+// don't hold on to a reference to frames[frame] across any visit.
+//
+TIntermNode* TIntermTraverser::advanceFrame(size_t frame)
 {
-    bool visit = true;
+    TIntermNode* node = frames[frame].node;
+    const int step = frames[frame].step++;
+    bool done = false;
+    TIntermNode* child = nullptr;
+
+    switch (frames[frame].kind) {
+    case EtnBinary:
+    {
+        //
+        // Visit the children, in the right order, with the in-visit between them.
+        //
+        TIntermBinary* binary = static_cast<TIntermBinary*>(node);
+        TIntermNode* first  = rightToLeft ? binary->getRight() : binary->getLeft();
+        TIntermNode* second = rightToLeft ? binary->getLeft()  : binary->getRight();
+        switch (step) {
+        case 0:
+            child = first;
+            break;
+        case 1:
+            if (inVisit)
+                frames[frame].visit = visitBinary(EvInVisit, binary);
+            break;
+        case 2:
+            if (frames[frame].visit)
+                child = second;
+            else
+                done = true;
+            break;
+        default:
+            done = true;
+            break;
+        }
+        break;
+    }
 
-    if (it->preVisit)
-        visit = it->visitSwitch(EvPreVisit, this);
+    case EtnAggregate:
+    {
+        // Even steps visit a child, odd steps do the in-visit after that child
+        // (unless it's the last one).  An in-visit returning false doesn't stop
+        // the remaining children from being visited, just the later visits.
+        TIntermAggregate* aggregate = static_cast<TIntermAggregate*>(node);
+        const TIntermSequence& sequence = aggregate->getSequence();
+        const size_t index = step / 2;
+        if (index >= sequence.size()) {
+            done = true;
+            break;
+        }
+        TIntermNode* current = sequence[rightToLeft ? sequence.size() - 1 - index : index];
+        if (step % 2 == 0)
+            child = current;
+        else if (frames[frame].visit && inVisit) {
+            if (current != (rightToLeft ? sequence.front() : sequence.back()))
+                frames[frame].visit = visitAggregate(EvInVisit, aggregate);
+        }
+        break;
+    }
 
-    if (visit) {
-        it->incrementDepth(this);
-        if (it->rightToLeft) {
-            body->traverse(it);
-            condition->traverse(it);
-        } else {
-            condition->traverse(it);
-            body->traverse(it);
+    default:
+    {
+        // The rest have a fixed list of (optional) children, and no in-visits.
+        TIntermNode* children[3] = { };
+        int numChildren = 0;
+        switch (frames[frame].kind) {
+        case EtnUnary:
+            children[numChildren++] = static_cast<TIntermUnary*>(node)->getOperand();
+            break;
+        case EtnSelection:
+        {
+            TIntermSelection* selection = static_cast<TIntermSelection*>(node);
+            children[numChildren++] = selection->getCondition();
+            children[numChildren++] = selection->getTrueBlock();
+            children[numChildren++] = selection->getFalseBlock();
+            break;
+        }
+        case EtnLoop:
+        {
+            TIntermLoop* loop = static_cast<TIntermLoop*>(node);
+            children[numChildren++] = loop->getTest();
+            children[numChildren++] = loop->getBody();
+            children[numChildren++] = loop->getTerminal();
+            break;
         }
-        it->decrementDepth();
+        case EtnBranch:
+            children[numChildren++] = static_cast<TIntermBranch*>(node)->getExpression();
+            break;
+        case EtnSwitch:
+        {
+            TIntermSwitch* switchNode = static_cast<TIntermSwitch*>(node);
+            children[numChildren++] = switchNode->getCondition();
+            children[numChildren++] = switchNode->getBody();
+            break;
+        }
+        default:
+            assert(0);
+            break;
+        }
+
+        if (step < numChildren)
+            child = children[rightToLeft ? numChildren - 1 - step : step];
+        else
+            done = true;
+        break;
     }
+    }
+
+    if (! done)
+        return child;
+
+    //
+    // Visit the node after the children, if requested and the traversal
+    // hasn't been canceled yet.
+    //
+    const TTraversalFrame finished = frames[frame];
+    frames.pop_back();
+    decrementDepth();
+    if (finished.visit && postVisit)
+        visitNode(EvPostVisit, finished.node, finished.kind);
 
-    if (visit && it->postVisit)
-        it->visitSwitch(EvPostVisit, this);
+    return nullptr;
 }
 
 } // end namespace glslang
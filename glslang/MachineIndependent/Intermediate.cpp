@@ -1733,14 +1733,14 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
     //
     TIntermSelection* node = new TIntermSelection(cond, trueBlock, falseBlock, trueBlock->getType());
     node->setLoc(loc);
-    node->getQualifier().precision = std::max(trueBlock->getQualifier().precision, falseBlock->getQualifier().precision);
+    node->setPrecision(std::max(trueBlock->getQualifier().precision, falseBlock->getQualifier().precision));
 
     if ((cond->getQualifier().isConstant() && specConstantPropagates(*trueBlock, *falseBlock)) ||
         (cond->getQualifier().isSpecConstant() && trueBlock->getQualifier().isConstant() &&
                                                  falseBlock->getQualifier().isConstant()))
-        node->getQualifier().makeSpecConstant();
+        node->getWritableType().getQualifier().makeSpecConstant();
     else
-        node->getQualifier().makeTemporary();
+        node->getWritableType().getQualifier().makeTemporary();
 
     return node;
 }
@@ -1753,8 +1753,10 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(const TConstUnionArray& unionArray, const TType& t, const TSourceLoc& loc, bool literal) const
 {
-    TIntermConstantUnion* node = new TIntermConstantUnion(unionArray, t);
-    node->getQualifier().storage = EvqConst;
+    TType type;
+    type.shallowCopy(t);
+    type.getQualifier().storage = EvqConst;
+    TIntermConstantUnion* node = new TIntermConstantUnion(unionArray, type);
     node->setLoc(loc);
     if (literal)
         node->setLiteral();
@@ -1906,6 +1908,25 @@ const TIntermTyped* TIntermediate::findLValueBase(const TIntermTyped* node, bool
     } while (true);
 }
 
+//
+// Return the largest symbol id in the tree, so passes making new variables
+// can give them ids above it.
+//
+int TIntermediate::getMaxSymbolId() const
+{
+    class TMaxIdTraverser : public TIntermTraverser {
+    public:
+        TMaxIdTraverser() : maxId(0) { }
+        void visitSymbol(TIntermSymbol* node) override { maxId = std::max(maxId, node->getId()); }
+        int maxId;
+    } maxIdTraverser;
+
+    if (treeRoot != nullptr)
+        treeRoot->traverse(&maxIdTraverser);
+
+    return maxIdTraverser.maxId;
+}
+
 //
 // Create while and do-while loop nodes.
 //
@@ -2360,8 +2381,10 @@ bool TIntermediate::promoteUnary(TIntermUnary& node)
             return false;
     }
 
-    node.setType(operand->getType());
-    node.getWritableType().getQualifier().makeTemporary();
+    TType type;
+    type.shallowCopy(operand->getType());
+    type.getQualifier().makeTemporary();
+    node.setType(type);
 
     return true;
 }
@@ -2374,7 +2397,7 @@ void TIntermUnary::updatePrecision()
     if (getBasicType() == EbtInt || getBasicType() == EbtUint || getBasicType() == EbtFloat) {
 #endif
         if (operand->getQualifier().precision > getQualifier().precision)
-            getQualifier().precision = operand->getQualifier().precision;
+            setPrecision(operand->getQualifier().precision);
     }
 }
 
@@ -2412,8 +2435,10 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
 
     // Base assumption:  just make the type the same as the left
     // operand.  Only deviations from this will be coded.
-    node.setType(left->getType());
-    node.getWritableType().getQualifier().clear();
+    TType type;
+    type.shallowCopy(left->getType());
+    type.getQualifier().clear();
+    node.setType(type);
 
     // Composite and opaque types don't having pending operator changes, e.g.,
     // array, structure, and samplers.  Just establish final type and correctness.
@@ -2753,8 +2778,10 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
         if (left->isVector() && right->isVector() && left->getVectorSize() != right->getVectorSize())
             return false;
         if (right->isVector() || right->isMatrix()) {
-            node.getWritableType().shallowCopy(right->getType());
-            node.getWritableType().getQualifier().makeTemporary();
+            TType rightType;
+            rightType.shallowCopy(right->getType());
+            rightType.getQualifier().makeTemporary();
+            node.setType(rightType);
         }
         break;
 
@@ -2865,7 +2892,7 @@ void TIntermBinary::updatePrecision()
 #else
     if (getBasicType() == EbtInt || getBasicType() == EbtUint || getBasicType() == EbtFloat) {
 #endif
-        getQualifier().precision = std::max(right->getQualifier().precision, left->getQualifier().precision);
+        setPrecision(std::max(right->getQualifier().precision, left->getQualifier().precision));
         if (getQualifier().precision != EpqNone) {
             left->propagatePrecision(getQualifier().precision);
             right->propagatePrecision(getQualifier().precision);
@@ -2882,7 +2909,7 @@ void TIntermTyped::propagatePrecision(TPrecisionQualifier newPrecision)
 #endif
         return;
 
-    getQualifier().precision = newPrecision;
+    setPrecision(newPrecision);
 
     TIntermBinary* binaryNode = getAsBinaryNode();
     if (binaryNode) {
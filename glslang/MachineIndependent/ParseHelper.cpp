@@ -960,7 +960,7 @@ TIntermTyped* TParseContext::handleFunctionCall(const TSourceLoc& loc, TFunction
                         if (lValueErrorCheck(arguments->getLoc(), "assign", arg->getAsTyped()))
                             error(arguments->getLoc(), "Non-L-value cannot be passed for 'out' or 'inout' parameters.", "out", "");
                     }
-                    TQualifier& argQualifier = arg->getAsTyped()->getQualifier();
+                    const TQualifier& argQualifier = arg->getAsTyped()->getQualifier();
                     if (argQualifier.isMemory()) {
                         const char* message = "argument cannot drop memory qualifier when passed to formal parameter";
                         if (argQualifier.volatil && ! formalQualifier.volatil)
@@ -1141,13 +1141,13 @@ void TParseContext::computeBuiltinPrecisions(TIntermTyped& node, const TFunction
 
     // Propagate precision through this node and its children. That algorithm stops
     // when a precision is found, so start by clearing this subroot precision
-    opNode->getQualifier().precision = EpqNone;
+    opNode->setPrecision(EpqNone);
     if (operationPrecision != EpqNone) {
         opNode->propagatePrecision(operationPrecision);
         opNode->setOperationPrecision(operationPrecision);
     }
     // Now, set the result precision, which might not match
-    opNode->getQualifier().precision = resultPrecision;
+    opNode->setPrecision(resultPrecision);
 }
 
 TIntermNode* TParseContext::handleReturnValue(const TSourceLoc& loc, TIntermTyped* value)
@@ -1620,7 +1620,7 @@ void TParseContext::nonOpBuiltInCheck(const TSourceLoc& loc, const TFunction& fn
     // built-in texturing functions get their return value precision from the precision of the sampler
     if (fnCandidate.getType().getQualifier().precision == EpqNone &&
         fnCandidate.getParamCount() > 0 && fnCandidate[0].type->getBasicType() == EbtSampler)
-        callNode.getQualifier().precision = callNode.getSequence()[0]->getAsTyped()->getQualifier().precision;
+        callNode.setPrecision(callNode.getSequence()[0]->getAsTyped()->getQualifier().precision);
 
     if (fnCandidate.getName().compare(0, 7, "texture") == 0) {
         if (fnCandidate.getName().compare(0, 13, "textureGather") == 0) {
@@ -4904,23 +4904,20 @@ const TFunction* TParseContext::findFunction(const TSourceLoc& loc, const TFunct
 // Function finding algorithm for ES and desktop 110.
 const TFunction* TParseContext::findFunctionExact(const TSourceLoc& loc, const TFunction& call, bool& builtIn)
 {
-    TSymbol* symbol = symbolTable.find(call.getMangledName(), &builtIn);
-    if (symbol == nullptr) {
+    const TFunction* function = symbolTable.findFunction(call, &builtIn);
+    if (function == nullptr)
         error(loc, "no matching overloaded function found", call.getName().c_str(), "");
 
-        return nullptr;
-    }
-
-    return symbol->getAsFunction();
+    return function;
 }
 
 // Function finding algorithm for desktop versions 120 through 330.
 const TFunction* TParseContext::findFunction120(const TSourceLoc& loc, const TFunction& call, bool& builtIn)
 {
     // first, look for an exact match
-    TSymbol* symbol = symbolTable.find(call.getMangledName(), &builtIn);
-    if (symbol)
-        return symbol->getAsFunction();
+    const TFunction* exact = symbolTable.findFunction(call, &builtIn);
+    if (exact)
+        return exact;
 
     // exact match not found, look through a list of overloaded functions of the same name
 
@@ -4933,7 +4930,7 @@ const TFunction* TParseContext::findFunction120(const TSourceLoc& loc, const TFu
 
     const TFunction* candidate = nullptr;
     TVector<const TFunction*> candidateList;
-    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn);
+    symbolTable.findFunctionNameList(call.getName(), candidateList, builtIn);
 
     for (auto it = candidateList.begin(); it != candidateList.end(); ++it) {
         const TFunction& function = *(*it);
@@ -5026,15 +5023,15 @@ const TFunction* TParseContext::findFunction120(const TSourceLoc& loc, const TFu
 const TFunction* TParseContext::findFunction400(const TSourceLoc& loc, const TFunction& call, bool& builtIn)
 {
     // first, look for an exact match
-    TSymbol* symbol = symbolTable.find(call.getMangledName(), &builtIn);
-    if (symbol)
-        return symbol->getAsFunction();
+    const TFunction* exact = symbolTable.findFunction(call, &builtIn);
+    if (exact)
+        return exact;
 
     // no exact match, use the generic selector, parameterized by the GLSL rules
 
     // create list of candidates to send
     TVector<const TFunction*> candidateList;
-    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn);
+    symbolTable.findFunctionNameList(call.getName(), candidateList, builtIn);
 
     // can 'from' convert to 'to'?
     const auto convertible = [this](const TType& from, const TType& to, TOperator, int) -> bool {
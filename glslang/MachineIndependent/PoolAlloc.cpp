@@ -107,7 +107,9 @@ TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
     alignment(allocationAlignment),
     freeList(nullptr),
     inUseList(nullptr),
-    numCalls(0)
+    numCalls(0),
+    typeTable(nullptr),
+    typeTableDepth(0)
 {
     //
     // Don't allow page sizes we know are smaller than all common
@@ -230,6 +232,9 @@ void TPoolAllocator::pop()
     if (stack.size() < 1)
         return;
 
+    if (typeTable != nullptr && typeTableDepth >= stack.size())
+        typeTable = nullptr;
+
     tHeader* page = stack.back().page;
     currentPageOffset = stack.back().offset;
 
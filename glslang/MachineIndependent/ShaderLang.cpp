@@ -45,6 +45,7 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <thread>
 #include "SymbolTable.h"
 #include "ParseHelper.h"
 #include "Scan.h"
@@ -1685,6 +1686,8 @@ void TShader::setFlattenUniformArrays(bool flatten)     { intermediate->setFlatt
 void TShader::setNoStorageFormat(bool useUnknownFormat) { intermediate->setNoStorageFormat(useUnknownFormat); }
 void TShader::setResourceSetBinding(const std::vector<std::string>& base)   { intermediate->setResourceSetBinding(base); }
 void TShader::setTextureSamplerTransformMode(EShTextureSamplerTransformMode mode) { intermediate->setTextureSamplerTransformMode(mode); }
+// Largest function body, in AST nodes, that EShMsgInlineFunctions inlines
+void TShader::setInlineBudget(int nodes)                { intermediate->setInlineBudget(nodes); }
 
 //
 // Turn the shader strings into a parse tree in the TIntermediate.
@@ -1702,11 +1705,14 @@ bool TShader::parse(const TBuiltInResource* builtInResources, int defaultVersion
     if (! preamble)
         preamble = "";
 
-    return CompileDeferred(compiler, strings, numStrings, lengths, stringNames,
-                           preamble, EShOptNone, builtInResources, defaultVersion,
-                           defaultProfile, forceDefaultVersionAndProfile,
-                           forwardCompatible, messages, *intermediate, includer, sourceEntryPointName,
-                           &environment);
+    bool success = CompileDeferred(compiler, strings, numStrings, lengths, stringNames,
+                                   preamble, EShOptNone, builtInResources, defaultVersion,
+                                   defaultProfile, forceDefaultVersionAndProfile,
+                                   forwardCompatible, messages, *intermediate, includer, sourceEntryPointName,
+                                   &environment);
+    infoSink->debug.flush();
+
+    return success;
 }
 
 // Fill in a string with the result of preprocessing ShaderStrings
@@ -1732,6 +1738,36 @@ bool TShader::preprocess(const TBuiltInResource* builtInResources,
                               forwardCompatible, message, includer, *intermediate, output_string);
 }
 
+//
+// Save the tree built by parse() (appending to 'binary').
+//
+// Returns true for success.
+//
+bool TShader::serialize(std::vector<unsigned char>& binary) const
+{
+    if (pool == nullptr)
+        return false;
+
+    return intermediate->serialize(binary);
+}
+
+//
+// Restore a tree saved by serialize(), in place of calling parse().
+//
+// Returns true for success.
+//
+bool TShader::deserialize(const TBuiltInResource* builtInResources, const unsigned char* binary, size_t size)
+{
+    if (! InitThread())
+        return false;
+
+    pool = new TPoolAllocator();
+    SetThreadPoolAllocator(*pool);
+    intermediate->setLimits(*builtInResources);
+
+    return intermediate->deserialize(binary, size);
+}
+
 const char* TShader::getInfoLog()
 {
     return infoSink->info.c_str();
@@ -1742,12 +1778,18 @@ const char* TShader::getInfoDebugLog()
     return infoSink->debug.c_str();
 }
 
+void TShader::setInfoDebugLogStream(std::ostream* stream)
+{
+    infoSink->debug.setStream(stream);
+}
+
 TProgram::TProgram() : pool(0), reflection(0), ioMapper(nullptr), linked(false)
 {
     infoSink = new TInfoSink;
     for (int s = 0; s < EShLangCount; ++s) {
         intermediate[s] = 0;
         newedIntermediate[s] = false;
+        stagePool[s] = nullptr;
     }
 }
 
@@ -1761,6 +1803,11 @@ TProgram::~TProgram()
         if (newedIntermediate[s])
             delete intermediate[s];
 
+    for (int s = 0; s < EShLangCount; ++s)
+        delete stagePool[s];
+    for (auto unitPool = unitPools.begin(); unitPool != unitPools.end(); ++unitPool)
+        delete unitPool->second;
+
     delete pool;
 }
 
@@ -1781,22 +1828,76 @@ bool TProgram::link(EShMessages messages)
     pool = new TPoolAllocator();
     SetThreadPoolAllocator(*pool);
 
-    for (int s = 0; s < EShLangCount; ++s) {
-        if (! linkStage((EShLanguage)s, messages))
-            error = true;
+    if (messages & EShMsgParallelLink)
+        error = ! linkStagesParallel(messages);
+    else {
+        for (int s = 0; s < EShLangCount; ++s) {
+            if (! linkStage((EShLanguage)s, messages, *infoSink))
+                error = true;
+        }
     }
 
     // TODO: Link: cross-stage error checking
 
+    infoSink->debug.flush();
+
     return ! error;
 }
 
+//
+// Link each stage with units on its own thread, for EShMsgParallelLink.
+//
+// A TPoolAllocator is not thread safe, so each thread allocates from a pool
+// of its own, kept by the program for as long as the stage's TIntermediate.
+// Each thread also logs to a sink of its own; these are appended to the
+// program's sink in stage order once all threads are done, so the log reads
+// as for a serial link.
+//
+// Return true for success.
+//
+bool TProgram::linkStagesParallel(EShMessages messages)
+{
+    TInfoSink stageInfoSink[EShLangCount];
+    bool stageLinked[EShLangCount];
+    std::thread threads[EShLangCount];
+
+    for (int s = 0; s < EShLangCount; ++s) {
+        stageLinked[s] = true;
+        if (stages[s].size() == 0)
+            continue;
+
+        stagePool[s] = new TPoolAllocator();
+        threads[s] = std::thread([this, s, messages, &stageInfoSink, &stageLinked]() {
+            InitThread();
+            TPoolAllocator& threadPool = GetThreadPoolAllocator();
+            SetThreadPoolAllocator(*stagePool[s]);
+
+            stageLinked[s] = linkStage((EShLanguage)s, messages, stageInfoSink[s]);
+
+            // DetachThread() frees the thread's own pool, not the stage's
+            SetThreadPoolAllocator(threadPool);
+            DetachThread();
+        });
+    }
+
+    bool success = true;
+    for (int s = 0; s < EShLangCount; ++s) {
+        if (threads[s].joinable())
+            threads[s].join();
+        infoSink->info << stageInfoSink[s].info.c_str();
+        infoSink->debug << stageInfoSink[s].debug.c_str();
+        success = stageLinked[s] && success;
+    }
+
+    return success;
+}
+
 //
 // Merge the compilation units within the given stage into a single TIntermediate.
 //
 // Return true for success.
 //
-bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
+bool TProgram::linkStage(EShLanguage stage, EShMessages messages, TInfoSink& sink)
 {
     if (stages[stage].size() == 0)
         return true;
@@ -1811,10 +1912,10 @@ bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
     }
 
     if (numEsShaders > 0 && numNonEsShaders > 0) {
-        infoSink->info.message(EPrefixError, "Cannot mix ES profile with non-ES profile shaders");
+        sink.info.message(EPrefixError, "Cannot mix ES profile with non-ES profile shaders");
         return false;
     } else if (numEsShaders > 1) {
-        infoSink->info.message(EPrefixError, "Cannot attach multiple ES shaders of the same type to a single program");
+        sink.info.message(EPrefixError, "Cannot attach multiple ES shaders of the same type to a single program");
         return false;
     }
 
@@ -1837,27 +1938,98 @@ bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
             intermediate[stage]->setOriginUpperLeft();
         }
         intermediate[stage]->setSpv(firstIntermediate->getSpv());
+        intermediate[stage]->setInlineBudget(firstIntermediate->getInlineBudget());
 
         newedIntermediate[stage] = true;
     }
 
     if (messages & EShMsgAST)
-        infoSink->info << "\nLinked " << StageName(stage) << " stage:\n\n";
+        sink.info << "\nLinked " << StageName(stage) << " stage:\n\n";
 
     if (stages[stage].size() > 1) {
         std::list<TShader*>::const_iterator it;
         for (it = stages[stage].begin(); it != stages[stage].end(); ++it)
-            intermediate[stage]->merge(*infoSink, *(*it)->intermediate);
+            intermediate[stage]->merge(sink, *(*it)->intermediate);
     }
 
-    intermediate[stage]->finalCheck(*infoSink, (messages & EShMsgKeepUncalled) != 0);
+    intermediate[stage]->finalCheck(sink, (messages & EShMsgKeepUncalled) != 0);
+
+    if ((messages & EShMsgInlineFunctions) && intermediate[stage]->getNumErrors() == 0)
+        intermediate[stage]->inlineFunctions((messages & EShMsgKeepUncalled) != 0);
+
+    if ((messages & EShMsgEliminateDeadCode) && intermediate[stage]->getNumErrors() == 0)
+        intermediate[stage]->eliminateDeadCode((messages & EShMsgKeepUncalled) != 0);
+
+    if ((messages & EShMsgValueNumbering) && intermediate[stage]->getNumErrors() == 0)
+        intermediate[stage]->numberValues();
 
     if (messages & EShMsgAST)
-        intermediate[stage]->output(*infoSink, true);
+        intermediate[stage]->output(sink, true);
 
     return intermediate[stage]->getNumErrors() == 0;
 }
 
+//
+// Replace the compilation units of a stage of a linked program, and link
+// just that stage.  See ShaderLang.h.
+//
+// Return true for success.
+//
+bool TProgram::relinkStage(TShader* shader, EShMessages messages, TIoMapResolver* resolver)
+{
+    if (! linked)
+        return false;
+
+    const EShLanguage stage = shader->stage;
+
+    // reflection points into the intermediates, so goes first
+    const bool reflected = reflection != nullptr;
+    delete reflection;
+    reflection = nullptr;
+
+    if (newedIntermediate[stage])
+        delete intermediate[stage];
+    intermediate[stage] = nullptr;
+    newedIntermediate[stage] = false;
+
+    // Link into a pool of the unit's own.  What linking allocates, like the
+    // types it makes writable, stays in the unit's tree after the unit is
+    // replaced, and is used again if the unit is given back, so no link's
+    // pool is freed before the program.
+    TPoolAllocator*& unitPool = unitPools[shader];
+    if (unitPool == nullptr)
+        unitPool = new TPoolAllocator();
+
+    stages[stage].clear();
+    stages[stage].push_back(shader);
+
+    TPoolAllocator& previousAllocator = GetThreadPoolAllocator();
+    SetThreadPoolAllocator(*unitPool);
+
+    infoSink->info.erase();
+    infoSink->debug.erase();
+
+    bool success = linkStage(stage, messages, *infoSink);
+    if (success && ioMapper)
+        success = ioMapper->addStage(stage, *intermediate[stage], *infoSink, resolver);
+
+    SetThreadPoolAllocator(previousAllocator);
+    infoSink->debug.flush();
+
+    if (success && reflected)
+        success = buildReflection();
+
+    // The program is no longer linked, and any reflection is left empty,
+    // rather than describing stages that do not fit together.
+    if (! success) {
+        linked = false;
+        if (reflected && reflection == nullptr)
+            reflection = new TReflection;
+    }
+
+    return success;
+}
+
 const char* TProgram::getInfoLog()
 {
     return infoSink->info.c_str();
@@ -1868,6 +2040,11 @@ const char* TProgram::getInfoDebugLog()
     return infoSink->debug.c_str();
 }
 
+void TProgram::setInfoDebugLogStream(std::ostream* stream)
+{
+    infoSink->debug.setStream(stream);
+}
+
 //
 // Reflection implementation.
 //
@@ -1911,6 +2088,33 @@ unsigned TProgram::getLocalSize(int dim) const               { return reflection
 
 void TProgram::dumpReflection()                      { reflection->dump(); }
 
+bool TProgram::getReflectionRecords(TReflectionRecords& records) const
+{
+    if (reflection == nullptr)
+        return false;
+
+    reflection->getRecords(records);
+    return true;
+}
+
+bool TProgram::serializeReflection(std::vector<unsigned char>& binary) const
+{
+    if (reflection == nullptr)
+        return false;
+
+    reflection->serialize(binary);
+    return true;
+}
+
+bool TProgram::serializeReflectionJson(std::string& json) const
+{
+    if (reflection == nullptr)
+        return false;
+
+    reflection->serializeJson(json);
+    return true;
+}
+
 //
 // I/O mapping implementation.
 //
@@ -1931,4 +2135,14 @@ bool TProgram::mapIO(TIoMapResolver* resolver)
     return true;
 }
 
+bool TProgram::mapIO(TIoMapBatchResolver& resolver)
+{
+    if (! linked || ioMapper)
+        return false;
+
+    ioMapper = new TIoMapper;
+
+    return ioMapper->addStages(intermediate, *infoSink, resolver);
+}
+
 } // end namespace glslang
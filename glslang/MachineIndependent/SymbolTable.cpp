@@ -47,92 +47,145 @@ namespace glslang {
 // TType helper function needs a place to live.
 //
 
+namespace {
+
+//
+// Gathers the short pieces of a mangled name in a local buffer, so the
+// destination string is grown by a few appends instead of one per character.
+// This matters because pool memory is never reclaimed: every reallocation of
+// a growing pool TString leaves its old buffer behind.
+//
+class TMangledNameBuffer {
+public:
+    explicit TMangledNameBuffer(TString& n) : name(n), size(0) { }
+    ~TMangledNameBuffer() { flush(); }
+
+    void add(char c)
+    {
+        if (size == sizeof(text))
+            flush();
+        text[size++] = c;
+    }
+    void add(const char* s)
+    {
+        while (*s != 0)
+            add(*s++);
+    }
+    void add(const TString& s)
+    {
+        flush();
+        name.append(s);
+    }
+    void addInt(int i)
+    {
+        char digits[12]; // plenty enough space for a 32-bit int
+        snprintf(digits, sizeof(digits), "%d", i);
+        add(digits);
+    }
+    void flush()
+    {
+        name.append(text, size);
+        size = 0;
+    }
+
+protected:
+    TMangledNameBuffer(const TMangledNameBuffer&);
+    TMangledNameBuffer& operator=(const TMangledNameBuffer&);
+
+    TString& name;
+    char text[32];
+    size_t size;
+};
+
+} // end anonymous namespace
+
 //
 // Recursively generate mangled names.
 //
 void TType::buildMangledName(TString& mangledName) const
 {
+    TMangledNameBuffer mangled(mangledName);
+
     if (isMatrix())
-        mangledName += 'm';
+        mangled.add('m');
     else if (isVector())
-        mangledName += 'v';
+        mangled.add('v');
 
     switch (basicType) {
-    case EbtFloat:              mangledName += 'f';      break;
-    case EbtDouble:             mangledName += 'd';      break;
+    case EbtFloat:              mangled.add('f');      break;
+    case EbtDouble:             mangled.add('d');      break;
 #ifdef AMD_EXTENSIONS
-    case EbtFloat16:            mangledName += "f16";    break;
+    case EbtFloat16:            mangled.add("f16");    break;
 #endif
-    case EbtInt:                mangledName += 'i';      break;
-    case EbtUint:               mangledName += 'u';      break;
-    case EbtInt64:              mangledName += "i64";    break;
-    case EbtUint64:             mangledName += "u64";    break;
+    case EbtInt:                mangled.add('i');      break;
+    case EbtUint:               mangled.add('u');      break;
+    case EbtInt64:              mangled.add("i64");    break;
+    case EbtUint64:             mangled.add("u64");    break;
 #ifdef AMD_EXTENSIONS
-    case EbtInt16:              mangledName += "i16";    break;
-    case EbtUint16:             mangledName += "u16";    break;
+    case EbtInt16:              mangled.add("i16");    break;
+    case EbtUint16:             mangled.add("u16");    break;
 #endif
-    case EbtBool:               mangledName += 'b';      break;
-    case EbtAtomicUint:         mangledName += "au";     break;
+    case EbtBool:               mangled.add('b');      break;
+    case EbtAtomicUint:         mangled.add("au");     break;
     case EbtSampler:
         switch (sampler.type) {
-        case EbtInt:   mangledName += "i"; break;
-        case EbtUint:  mangledName += "u"; break;
+        case EbtInt:   mangled.add('i'); break;
+        case EbtUint:  mangled.add('u'); break;
         default: break; // some compilers want this
         }
         if (sampler.image)
-            mangledName += "I";  // a normal image
+            mangled.add('I');  // a normal image
         else if (sampler.sampler)
-            mangledName += "p";  // a "pure" sampler
+            mangled.add('p');  // a "pure" sampler
         else if (!sampler.combined)
-            mangledName += "t";  // a "pure" texture
+            mangled.add('t');  // a "pure" texture
         else
-            mangledName += "s";  // traditional combined sampler
+            mangled.add('s');  // traditional combined sampler
         if (sampler.arrayed)
-            mangledName += "A";
+            mangled.add('A');
         if (sampler.shadow)
-            mangledName += "S";
+            mangled.add('S');
         if (sampler.external)
-            mangledName += "E";
+            mangled.add('E');
         switch (sampler.dim) {
-        case Esd1D:       mangledName += "1";  break;
-        case Esd2D:       mangledName += "2";  break;
-        case Esd3D:       mangledName += "3";  break;
-        case EsdCube:     mangledName += "C";  break;
-        case EsdRect:     mangledName += "R2"; break;
-        case EsdBuffer:   mangledName += "B";  break;
-        case EsdSubpass:  mangledName += "P";  break;
+        case Esd1D:       mangled.add('1');  break;
+        case Esd2D:       mangled.add('2');  break;
+        case Esd3D:       mangled.add('3');  break;
+        case EsdCube:     mangled.add('C');  break;
+        case EsdRect:     mangled.add("R2"); break;
+        case EsdBuffer:   mangled.add('B');  break;
+        case EsdSubpass:  mangled.add('P');  break;
         default: break; // some compilers want this
         }
 
         if (sampler.hasReturnStruct()) {
             // Name mangle for sampler return struct uses struct table index.
-            mangledName += "-tx-struct";
-
-            char text[16]; // plenty enough space for the small integers.
-            snprintf(text, sizeof(text), "%d-", sampler.structReturnIndex);
-            mangledName += text;
+            mangled.add("-tx-struct");
+            mangled.addInt(sampler.structReturnIndex);
+            mangled.add('-');
         } else {
             switch (sampler.getVectorSize()) {
-            case 1: mangledName += "1"; break;
-            case 2: mangledName += "2"; break;
-            case 3: mangledName += "3"; break;
+            case 1: mangled.add('1'); break;
+            case 2: mangled.add('2'); break;
+            case 3: mangled.add('3'); break;
             case 4: break; // default to prior name mangle behavior
             }
         }
 
         if (sampler.ms)
-            mangledName += "M";
+            mangled.add('M');
         break;
     case EbtStruct:
     case EbtBlock:
         if (basicType == EbtStruct)
-            mangledName += "struct-";
+            mangled.add("struct-");
         else
-            mangledName += "block-";
+            mangled.add("block-");
         if (typeName)
-            mangledName += *typeName;
+            mangled.add(*typeName);
         for (unsigned int i = 0; i < structure->size(); ++i) {
-            mangledName += '-';
+            mangled.add('-');
+            mangled.flush();
             (*structure)[i].type->buildMangledName(mangledName);
         }
     default:
@@ -140,10 +193,10 @@ void TType::buildMangledName(TString& mangledName) const
     }
 
     if (getVectorSize() > 0)
-        mangledName += static_cast<char>('0' + getVectorSize());
+        mangled.add(static_cast<char>('0' + getVectorSize()));
     else {
-        mangledName += static_cast<char>('0' + getMatrixCols());
-        mangledName += static_cast<char>('0' + getMatrixRows());
+        mangled.add(static_cast<char>('0' + getMatrixCols()));
+        mangled.add(static_cast<char>('0' + getMatrixRows()));
     }
 
     if (arraySizes) {
@@ -157,13 +210,159 @@ void TType::buildMangledName(TString& mangledName) const
                     snprintf(buf, maxSize, "s%p", arraySizes->getDimNode(i));
             } else
                 snprintf(buf, maxSize, "%d", arraySizes->getDimSize(i));
-            mangledName += '[';
-            mangledName += buf;
-            mangledName += ']';
+            mangled.add('[');
+            mangled.add(buf);
+            mangled.add(']');
         }
     }
 }
 
+namespace {
+
+// Fold 'value' into 'hash'.
+size_t HashCombine(size_t hash, size_t value)
+{
+    return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+// What buildMangledName() shows of a type, other than struct members and
+// array sizes, packed into one number.
+unsigned long long SignatureShape(const TType& type)
+{
+    unsigned long long shape = type.getBasicType();
+    shape = shape << 2 | (type.isMatrix() ? 2 : type.isVector() ? 1 : 0);
+    if (type.getVectorSize() > 0)
+        shape = shape << 9 | type.getVectorSize();
+    else
+        shape = shape << 9 | 1 << 8 | type.getMatrixCols() << 4 | type.getMatrixRows();
+
+    if (type.getBasicType() == EbtSampler) {
+        const TSampler& sampler = type.getSampler();
+        shape = shape << 2 | (sampler.type == EbtInt ? 1 : sampler.type == EbtUint ? 2 : 0);
+        shape = shape << 2 | (sampler.image ? 0 : sampler.sampler ? 1 : ! sampler.combined ? 2 : 3);
+        shape = shape << 3 | sampler.arrayed << 2 | sampler.shadow << 1 | sampler.external;
+        shape = shape << 8 | sampler.dim;
+        if (sampler.hasReturnStruct())
+            shape = shape << 5 | 1 << 4 | sampler.structReturnIndex;
+        else
+            shape = shape << 5 | sampler.getVectorSize();
+        shape = shape << 1 | sampler.ms;
+    }
+
+    return shape;
+}
+
+// Array dimension 'd' as buildMangledName() shows it: its size, or its
+// specialization constant.
+size_t HashArrayDim(const TArraySizes& sizes, int d)
+{
+    const TIntermTyped* node = sizes.getDimNode(d);
+    if (node == nullptr)
+        return sizes.getDimSize(d);
+    if (node->getAsSymbolNode())
+        return static_cast<size_t>(node->getAsSymbolNode()->getId());
+
+    return std::hash<const void*>()(node);
+}
+
+bool SameArrayDim(const TArraySizes& left, const TArraySizes& right, int d)
+{
+    const TIntermTyped* leftNode = left.getDimNode(d);
+    const TIntermTyped* rightNode = right.getDimNode(d);
+    if (leftNode == nullptr || rightNode == nullptr)
+        return leftNode == rightNode && left.getDimSize(d) == right.getDimSize(d);
+    if (leftNode->getAsSymbolNode() && rightNode->getAsSymbolNode())
+        return leftNode->getAsSymbolNode()->getId() == rightNode->getAsSymbolNode()->getId();
+
+    return leftNode == rightNode;
+}
+
+} // end anonymous namespace
+
+//
+// The signature functions follow buildMangledName(), and have to be kept in
+// step with it.
+//
+size_t TType::getSignatureHash() const
+{
+    size_t hash = std::hash<unsigned long long>()(SignatureShape(*this));
+    if (basicType == EbtStruct || basicType == EbtBlock) {
+        if (typeName != nullptr && ! typeName->empty())
+            hash = HashCombine(hash, std::hash<TString>()(*typeName));
+        for (unsigned int i = 0; i < structure->size(); ++i)
+            hash = HashCombine(hash, (*structure)[i].type->getSignatureHash());
+    }
+
+    if (arraySizes != nullptr) {
+        for (int d = 0; d < arraySizes->getNumDims(); ++d)
+            hash = HashCombine(hash, HashArrayDim(*arraySizes, d));
+    }
+
+    return hash;
+}
+
+bool TType::sameSignature(const TType& right) const
+{
+    if (SignatureShape(*this) != SignatureShape(right))
+        return false;
+
+    if (basicType == EbtStruct || basicType == EbtBlock) {
+        const bool named = typeName != nullptr && ! typeName->empty();
+        const bool rightNamed = right.typeName != nullptr && ! right.typeName->empty();
+        if (named != rightNamed || (named && *typeName != *right.typeName))
+            return false;
+        if (structure->size() != right.structure->size())
+            return false;
+        for (unsigned int i = 0; i < structure->size(); ++i) {
+            if (! (*structure)[i].type->sameSignature(*(*right.structure)[i].type))
+                return false;
+        }
+    }
+
+    const int dims = arraySizes != nullptr ? arraySizes->getNumDims() : 0;
+    const int rightDims = right.arraySizes != nullptr ? right.arraySizes->getNumDims() : 0;
+    if (dims != rightDims)
+        return false;
+    for (int d = 0; d < dims; ++d) {
+        if (! SameArrayDim(*arraySizes, *right.arraySizes, d))
+            return false;
+    }
+
+    return true;
+}
+
+//
+// The mangled name of a function is its name, followed by a '(' and the
+// mangled names of its parameters other than 'this'.
+//
+void TFunction::buildMangledName() const
+{
+    if (name == nullptr)
+        return;
+
+    // size it once for typical parameters, rather than regrowing it in the pool
+    mangledName.reserve(name->size() + 1 + 6 * (parameters.size() - thisParameterCount));
+    mangledName.append(*name);
+    mangledName.append(1, '(');
+    for (unsigned int i = thisParameterCount; i < parameters.size(); ++i)
+        parameters[i].type->appendMangledName(mangledName);
+}
+
+// Whether 'right' would have the same parameter part of its mangled name.
+bool TFunction::sameSignature(const TFunction& right) const
+{
+    if (signature != right.signature ||
+        parameters.size() - thisParameterCount != right.parameters.size() - right.thisParameterCount)
+        return false;
+
+    for (unsigned int i = thisParameterCount, j = right.thisParameterCount; i < parameters.size(); ++i, ++j) {
+        if (! parameters[i].type->sameSignature(*right.parameters[j].type))
+            return false;
+    }
+
+    return true;
+}
+
 //
 // Dump functions.
 //
@@ -317,6 +516,8 @@ TFunction::TFunction(const TFunction& copyOf) : TSymbol(copyOf)
         setExtensions(copyOf.numExtensions, copyOf.extensions);
     returnType.deepCopy(copyOf.returnType);
     mangledName = copyOf.mangledName;
+    signature = copyOf.signature;
+    thisParameterCount = copyOf.thisParameterCount;
     op = copyOf.op;
     defined = copyOf.defined;
     prototyped = copyOf.prototyped;
@@ -217,12 +217,11 @@ class TFunction : public TSymbol {
 public:
     explicit TFunction(TOperator o) :
         TSymbol(0),
-        op(o),
+        signature(0), thisParameterCount(0), op(o),
         defined(false), prototyped(false), implicitThis(false), illegalImplicitThis(false), defaultParamCount(0) { }
     TFunction(const TString *name, const TType& retType, TOperator tOp = EOpNull) :
         TSymbol(name),
-        mangledName(*name + '('),
-        op(tOp),
+        signature(0), thisParameterCount(0), op(tOp),
         defined(false), prototyped(false), implicitThis(false), illegalImplicitThis(false), defaultParamCount(0)
     {
         returnType.shallowCopy(retType);
@@ -236,12 +235,14 @@ public:
 
     // Install 'p' as the (non-'this') last parameter.
     // Non-'this' parameters are reflected in both the list of parameters and the
-    // mangled name.
+    // mangled name, and in the signature.
     virtual void addParameter(TParameter& p)
     {
         assert(writable);
         parameters.push_back(p);
-        p.type->appendMangledName(mangledName);
+        signature = signature * 31 + p.type->getSignatureHash();
+        if (! mangledName.empty())
+            p.type->appendMangledName(mangledName);
 
         if (p.defaultValue != nullptr)
             defaultParamCount++;
@@ -254,21 +255,37 @@ public:
         TParameter p = { NewPoolTString(name), new TType, nullptr };
         p.type->shallowCopy(type);
         parameters.insert(parameters.begin(), p);
+        ++thisParameterCount;
     }
 
     virtual void addPrefix(const char* prefix) override
     {
         TSymbol::addPrefix(prefix);
-        mangledName.insert(0, prefix);
+        if (! mangledName.empty())
+            mangledName.insert(0, prefix);
     }
 
     virtual void removePrefix(const TString& prefix)
     {
+        getMangledName();
         assert(mangledName.compare(0, prefix.size(), prefix) == 0);
         mangledName.erase(0, prefix.size());
     }
 
-    virtual const TString& getMangledName() const override { return mangledName; }
+    // The mangled name is built the first time it is asked for.  Looking up
+    // a call doesn't need it, see getSignature().
+    virtual const TString& getMangledName() const override
+    {
+        if (mangledName.empty())
+            buildMangledName();
+        return mangledName;
+    }
+
+    // A hash of the parameters in the mangled name, which with the name and
+    // sameSignature() stands in for the mangled name as an overload key.
+    size_t getSignature() const { return signature; }
+    bool sameSignature(const TFunction& right) const;
+
     virtual const TType& getType() const override { return returnType; }
     virtual TBuiltInVariable getDeclaredBuiltInType() const { return declaredBuiltIn; }
     virtual TType& getWritableType() override { return returnType; }
@@ -299,12 +316,16 @@ protected:
     explicit TFunction(const TFunction&);
     TFunction& operator=(const TFunction&);
 
+    void buildMangledName() const;
+
     typedef TVector<TParameter> TParamList;
     TParamList parameters;
     TType returnType;
     TBuiltInVariable declaredBuiltIn;
 
-    TString mangledName;
+    mutable TString mangledName;  // empty until built, see getMangledName()
+    size_t signature;
+    int thisParameterCount;
     TOperator op;
     bool defined;
     bool prototyped;
@@ -385,15 +406,15 @@ public:
             const TString& insertName = symbol.getMangledName();
             if (symbol.getAsFunction()) {
                 // make sure there isn't a variable of this name
-                if (! separateNameSpaces && level.find(name) != level.end())
+                if (! separateNameSpaces && find(name) != nullptr)
                     return false;
 
                 // insert, and whatever happens is okay
-                level.insert(tLevelPair(insertName, &symbol));
+                insertEntry(insertName, &symbol);
 
                 return true;
             } else
-                return level.insert(tLevelPair(insertName, &symbol)).second;
+                return insertEntry(insertName, &symbol);
         }
     }
 
@@ -414,7 +435,7 @@ public:
         const TTypeList& types = *symbol.getAsVariable()->getType().getStruct();
         for (unsigned int m = firstMember; m < types.size(); ++m) {
             TAnonMember* member = new TAnonMember(&types[m].type->getFieldName(), m, *symbol.getAsVariable(), symbol.getAsVariable()->getAnonId());
-            if (! level.insert(tLevelPair(member->getMangledName(), member)).second)
+            if (! insertEntry(member->getMangledName(), member))
                 return false;
         }
 
@@ -423,17 +444,48 @@ public:
 
     TSymbol* find(const TString& name) const
     {
-        tLevel::const_iterator it = level.find(name);
-        if (it == level.end())
+        return find(name, hashName(name));
+    }
+
+    // Find using a hash already computed by hashName(), so a search through
+    // many levels only hashes the name once.
+    TSymbol* find(const TString& name, size_t hash) const
+    {
+        tHashLevel::const_iterator it = hashedLevel.find(TSymbolKey(&name, hash));
+        if (it == hashedLevel.end())
             return 0;
         else
             return (*it).second;
     }
 
+    static size_t hashName(const TString& name) { return std::hash<TString>()(name); }
+
+    // Find the function 'call' would have the mangled name of, using a hash
+    // already computed by hashFunction().
+    TFunction* findFunction(const TFunction& call, size_t hash) const
+    {
+        const TString& name = call.getName();
+        tFunctionLevel::const_iterator it = functionLevel.find(TFunctionKey(name.c_str(), name.size(), &call, hash));
+        if (it == functionLevel.end())
+            return nullptr;
+        else
+            return (*it).second;
+    }
+
+    static size_t hashFunction(const TFunction& call)
+    {
+        return hashFunction(call.getName().c_str(), call.getName().size(), call);
+    }
+
+    // Find the functions of the given name; a mangled name can be given, in
+    // which case only its part before the '(' is used.
     void findFunctionNameList(const TString& name, TVector<const TFunction*>& list)
     {
         size_t parenAt = name.find_first_of('(');
-        TString base(name, 0, parenAt + 1);
+        if (parenAt == TString::npos)
+            parenAt = name.size();
+        TString base(name, 0, parenAt);
+        base += '(';
 
         tLevel::const_iterator begin = level.lower_bound(base);
         base[parenAt] = ')';  // assume ')' is lexically after '('
@@ -529,7 +581,81 @@ protected:
     typedef const tLevel::value_type tLevelPair;
     typedef std::pair<tLevel::iterator, bool> tInsertResult;
 
+    // Exact-name lookups go through a hashed index over the same symbols.
+    // Its keys point at the names owned by 'level' (std::map nodes never move),
+    // so names are stored once, with their hash computed once at insertion.
+    // 'level' is still needed for the ordered, prefix-based searches
+    // (function overload lists, dump, etc.).
+    struct TSymbolKey {
+        TSymbolKey(const TString* n, size_t h) : name(n), hash(h) { }
+        const TString* name;
+        size_t hash;
+    };
+    struct TSymbolKeyHash {
+        size_t operator()(const TSymbolKey& key) const { return key.hash; }
+    };
+    struct TSymbolKeyEqual {
+        bool operator()(const TSymbolKey& lhs, const TSymbolKey& rhs) const
+        {
+            return lhs.hash == rhs.hash && *lhs.name == *rhs.name;
+        }
+    };
+    typedef TUnorderedMap<TSymbolKey, TSymbol*, TSymbolKeyHash, TSymbolKeyEqual> tHashLevel;
+
+    // Functions are also indexed by their name and parameter signature, which
+    // match exactly when the mangled names do, so calls can be looked up without
+    // building mangled names.  The name is the part of the mangled name (owned
+    // by 'level') before its '('.
+    struct TFunctionKey {
+        TFunctionKey(const char* n, size_t l, const TFunction* f, size_t h) : name(n), length(l), function(f), hash(h) { }
+        const char* name;
+        size_t length;
+        const TFunction* function;
+        size_t hash;
+    };
+    struct TFunctionKeyHash {
+        size_t operator()(const TFunctionKey& key) const { return key.hash; }
+    };
+    struct TFunctionKeyEqual {
+        bool operator()(const TFunctionKey& lhs, const TFunctionKey& rhs) const
+        {
+            return lhs.hash == rhs.hash && lhs.length == rhs.length &&
+                   std::char_traits<char>::compare(lhs.name, rhs.name, lhs.length) == 0 && lhs.function->sameSignature(*rhs.function);
+        }
+    };
+    typedef TUnorderedMap<TFunctionKey, TFunction*, TFunctionKeyHash, TFunctionKeyEqual> tFunctionLevel;
+
+    static size_t hashFunction(const char* name, size_t length, const TFunction& function)
+    {
+        size_t hash = 2166136261u;
+        for (size_t c = 0; c < length; ++c)
+            hash = (hash ^ static_cast<unsigned char>(name[c])) * 16777619u;
+
+        return hash ^ function.getSignature();
+    }
+
+    // Add to both the ordered and hashed views; returns false if the name was already present.
+    bool insertEntry(const TString& name, TSymbol* symbol)
+    {
+        tInsertResult result = level.insert(tLevelPair(name, symbol));
+        if (result.second) {
+            const TString& key = result.first->first;
+            hashedLevel.insert(tHashLevel::value_type(TSymbolKey(&key, hashName(name)), symbol));
+
+            TFunction* function = symbol->getAsFunction();
+            size_t parenAt = key.find_first_of('(');
+            if (function != nullptr && parenAt != TString::npos) {
+                const size_t hash = hashFunction(key.c_str(), parenAt, *function);
+                functionLevel.insert(tFunctionLevel::value_type(TFunctionKey(key.c_str(), parenAt, function, hash), function));
+            }
+        }
+
+        return result.second;
+    }
+
     tLevel level;  // named mappings
+    tHashLevel hashedLevel;  // exact-name index into 'level'
+    tFunctionLevel functionLevel;  // signature index of the functions in 'level'
     TPrecisionQualifier *defaultPrecision;
     int anonId;
     bool thisLevel;  // True if this level of the symbol table is a structure scope containing member function
@@ -694,13 +820,14 @@ public:
     // at a built-in level or the current top-scope level.
     TSymbol* find(const TString& name, bool* builtIn = 0, bool* currentScope = 0, int* thisDepthP = 0)
     {
+        const size_t hash = TSymbolTableLevel::hashName(name);
         int level = currentLevel();
         TSymbol* symbol;
         int thisDepth = 0;
         do {
             if (table[level]->isThisLevel())
                 ++thisDepth;
-            symbol = table[level]->find(name);
+            symbol = table[level]->find(name, hash);
             --level;
         } while (symbol == nullptr && level >= 0);
         level++;
@@ -717,18 +844,47 @@ public:
         return symbol;
     }
 
+    // Find the function a call would have the mangled name of, as find() would
+    // with the mangled name.
+    TFunction* findFunction(const TFunction& call, bool* builtIn = 0, bool* currentScope = 0, int* thisDepthP = 0)
+    {
+        const size_t hash = TSymbolTableLevel::hashFunction(call);
+        int level = currentLevel();
+        TFunction* function;
+        int thisDepth = 0;
+        do {
+            if (table[level]->isThisLevel())
+                ++thisDepth;
+            function = table[level]->findFunction(call, hash);
+            --level;
+        } while (function == nullptr && level >= 0);
+        level++;
+        if (builtIn)
+            *builtIn = isBuiltInLevel(level);
+        if (currentScope)
+            *currentScope = isGlobalLevel(currentLevel()) || level == currentLevel();  // consider shared levels as "current scope" WRT user globals
+        if (thisDepthP != nullptr) {
+            if (! table[level]->isThisLevel())
+                thisDepth = 0;
+            *thisDepthP = thisDepth;
+        }
+
+        return function;
+    }
+
     // Find of a symbol that returns how many layers deep of nested
     // structures-with-member-functions ('this' scopes) deep the symbol was
     // found in.
     TSymbol* find(const TString& name, int& thisDepth)
     {
+        const size_t hash = TSymbolTableLevel::hashName(name);
         int level = currentLevel();
         TSymbol* symbol;
         thisDepth = 0;
         do {
             if (table[level]->isThisLevel())
                 ++thisDepth;
-            symbol = table[level]->find(name);
+            symbol = table[level]->find(name, hash);
             --level;
         } while (symbol == 0 && level >= 0);
 
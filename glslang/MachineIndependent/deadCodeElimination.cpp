@@ -0,0 +1,573 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "localintermediate.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+//
+// Dead code elimination on the AST of a linked stage, so code generation
+// never sees it.  Asked for through EShMsgEliminateDeadCode.
+//
+//  - Unreachable statements are dropped: the untaken side of an 'if' with a
+//    constant condition (the taken side is spliced in its place), 'while'
+//    loops whose condition is constant false, and whatever follows a return,
+//    break, continue, or discard, up to the next case label.
+//  - Stores to locals and private globals that are never read are dropped,
+//    as are statements that just compute a value and ignore it.  A store
+//    whose right side has side effects is replaced by its right side.
+//    Dropping a store can leave what it read unread, so this cascades.
+//  - Functions no longer called from the entry point are dropped.
+//  - Private globals no longer mentioned at all are dropped from the linker
+//    objects, so no variable is generated for them.
+//
+// Only statements directly in a statement list are candidates; e.g., a store
+// nested in an expression, or making up the whole body of an 'if', stays.
+//
+
+namespace glslang {
+
+//
+// Whether an operator just computes a value from its operands: it writes
+// nothing (including through out parameters), calls nothing, and has no
+// other effect, so it can be dropped if its value is not used.
+//
+bool TIntermediate::isPureOperator(TOperator op)
+{
+    if (op >= EOpConvIntToBool && op < EOpAdd)            // conversions
+        return true;
+    if (op >= EOpAdd && op <= EOpVectorSwizzle)           // arithmetic, comparison, indexing, ...
+        return true;
+    if (op >= EOpRadians && op <= EOpSmoothStep)          // all but modf() write nothing
+        return op != EOpModf;
+    if (op >= EOpFloatBitsToInt && op <= EOpRefract)      // bit casts, packing, geometry
+        return true;
+    if (op > EOpConstructGuardStart && op < EOpConstructGuardEnd)
+        return true;
+    if (op > EOpSamplingGuardBegin && op < EOpSparseTextureGuardBegin)  // non-sparse sampling
+        return true;
+
+    switch (op) {
+    case EOpNegative:
+    case EOpLogicalNot:
+    case EOpVectorLogicalNot:
+    case EOpBitwiseNot:
+    case EOpIsNan:
+    case EOpIsInf:
+    case EOpFma:
+    case EOpLdexp:
+    case EOpDPdx:
+    case EOpDPdy:
+    case EOpFwidth:
+    case EOpDPdxFine:
+    case EOpDPdyFine:
+    case EOpFwidthFine:
+    case EOpDPdxCoarse:
+    case EOpDPdyCoarse:
+    case EOpFwidthCoarse:
+    case EOpMatrixTimesMatrix:
+    case EOpOuterProduct:
+    case EOpDeterminant:
+    case EOpMatrixInverse:
+    case EOpTranspose:
+    case EOpAny:
+    case EOpAll:
+    case EOpArrayLength:
+    case EOpImageQuerySize:
+    case EOpImageQuerySamples:
+    case EOpImageLoad:
+    case EOpSubpassLoad:
+    case EOpSubpassLoadMS:
+    case EOpTextureQuerySize:
+    case EOpTextureQueryLod:
+    case EOpTextureQueryLevels:
+    case EOpTextureQuerySamples:
+    case EOpBitfieldExtract:
+    case EOpBitfieldInsert:
+    case EOpBitFieldReverse:
+    case EOpBitCount:
+    case EOpFindLSB:
+    case EOpFindMSB:
+    case EOpIsFinite:
+    case EOpLog10:
+    case EOpRcp:
+    case EOpSaturate:
+    case EOpMatrixSwizzle:
+        return true;
+    default:
+        return false;
+    }
+}
+
+namespace {
+
+// Finds out whether a subtree is an expression of only pure operators.
+class TPureTraverser : public TIntermTraverser {
+public:
+    TPureTraverser() : pure(true) { }
+
+    bool visitBinary(TVisit, TIntermBinary* node) override { return check(node->getOp()); }
+    bool visitUnary(TVisit, TIntermUnary* node) override { return check(node->getOp()); }
+    bool visitAggregate(TVisit, TIntermAggregate* node) override
+    {
+        // the selectors of a swizzle are a sequence
+        TIntermNode* parent = getParentNode();
+        if (parent && parent->getAsBinaryNode() && parent->getAsBinaryNode()->getOp() == EOpVectorSwizzle)
+            return pure;
+
+        return check(node->getOp());
+    }
+    bool visitSelection(TVisit, TIntermSelection*) override { return pure; }
+    bool visitLoop(TVisit, TIntermLoop*) override { pure = false; return false; }
+    bool visitBranch(TVisit, TIntermBranch*) override { pure = false; return false; }
+    bool visitSwitch(TVisit, TIntermSwitch*) override { pure = false; return false; }
+
+    bool pure;
+
+protected:
+    bool check(TOperator op)
+    {
+        if (! TIntermediate::isPureOperator(op))
+            pure = false;
+        return pure;
+    }
+};
+
+} // end anonymous namespace
+
+//
+// Whether a subtree is an expression of only pure operators.
+//
+bool TIntermediate::isPure(TIntermNode* node)
+{
+    TPureTraverser purity;
+    node->traverse(&purity);
+
+    return purity.pure;
+}
+
+namespace {
+
+// Variables read and written only by function bodies and global initializers.
+bool IsPrivateVariable(const TIntermSymbol* symbol)
+{
+    const TQualifier& qualifier = symbol->getQualifier();
+
+    return (qualifier.storage == EvqTemporary || qualifier.storage == EvqGlobal) &&
+           qualifier.builtIn == EbvNone;
+}
+
+// Returns true if 'node' is a front-end constant scalar bool, and gives its value.
+bool GetConstantCondition(TIntermTyped* node, bool& value)
+{
+    TIntermConstantUnion* constant = node->getAsConstantUnion();
+    if (constant == nullptr || constant->getBasicType() != EbtBool || ! constant->isScalar() ||
+        constant->getQualifier().isSpecConstant())
+        return false;
+
+    value = constant->getConstArray()[0].getBConst();
+
+    return true;
+}
+
+//
+// Base for the traversers that work on statement lists.
+//
+// Not every sequence (EOpSequence) is a statement list: HLSL also makes
+// sequences inside expressions, whose value is that of their last child.
+// So a sequence is only taken as a statement list if it is the tree root, a
+// function body, the body of a loop or switch, a side of an 'if' statement,
+// or a statement in another statement list.  This needs the traversal to
+// start at the tree root.
+//
+class TStatementListTraverser : public TIntermTraverser {
+public:
+    TStatementListTraverser(bool inVisit = false, bool postVisit = false) :
+        TIntermTraverser(true, inVisit, postVisit) { }
+
+    bool visitAggregate(TVisit visit, TIntermAggregate* node) override
+    {
+        if (node->getOp() == EOpLinkerObjects)
+            return false;
+
+        if (visit == EvPreVisit && isStatementListHere(node))
+            lists.insert(node);
+        if (isStatementList(node))
+            return visitStatementList(visit, node);
+
+        return true;
+    }
+
+protected:
+    virtual bool visitStatementList(TVisit, TIntermAggregate*) { return true; }
+
+    bool isStatementList(const TIntermNode* node) const { return lists.find(node) != lists.end(); }
+
+    // Whether 'node', being pre-visited, is a statement list.
+    bool isStatementListHere(const TIntermAggregate* node)
+    {
+        if (node->getOp() != EOpSequence)
+            return false;
+
+        TIntermNode* parent = getParentNode();
+        if (parent == nullptr)
+            return true;
+        if (const TIntermAggregate* aggregate = parent->getAsAggregate())
+            return aggregate->getOp() == EOpFunction || isStatementList(aggregate);
+        if (const TIntermSelection* selection = parent->getAsSelectionNode())
+            return selection->getBasicType() == EbtVoid && selection->getCondition() != node;
+        if (const TIntermLoop* loop = parent->getAsLoopNode())
+            return loop->getBody() == node;
+        if (const TIntermSwitch* switchNode = parent->getAsSwitchNode())
+            return switchNode->getBody() == node;
+
+        return false;
+    }
+
+    std::unordered_set<const TIntermNode*> lists;
+};
+
+//
+// Drops the unreachable statements from each statement list.
+//
+class TUnreachableCodeTraverser : public TStatementListTraverser {
+public:
+    TUnreachableCodeTraverser() { }
+
+protected:
+    bool visitStatementList(TVisit, TIntermAggregate* node) override
+    {
+        TIntermSequence kept;
+        bool reachable = true;
+        bool changed = false;
+        for (TIntermNode* statement : node->getSequence())
+            changed = add(kept, statement, reachable) || changed;
+        if (changed)
+            node->getSequence() = kept;
+
+        return true;
+    }
+
+    // Append 'statement' to 'kept', or what is left of it; return true if that
+    // isn't just 'statement'.
+    bool add(TIntermSequence& kept, TIntermNode* statement, bool& reachable)
+    {
+        if (statement == nullptr)
+            return false;
+
+        TIntermBranch* branch = statement->getAsBranchNode();
+        if (branch && (branch->getFlowOp() == EOpCase || branch->getFlowOp() == EOpDefault))
+            reachable = true;
+        if (! reachable)
+            return true;
+
+        bool condition;
+        TIntermSelection* selection = statement->getAsSelectionNode();
+        if (selection && selection->getBasicType() == EbtVoid &&
+            GetConstantCondition(selection->getCondition(), condition)) {
+            TIntermNode* taken = condition ? selection->getTrueBlock() : selection->getFalseBlock();
+            TIntermAggregate* block = taken ? taken->getAsAggregate() : nullptr;
+            if (block && block->getOp() == EOpSequence) {
+                for (TIntermNode* child : block->getSequence())
+                    add(kept, child, reachable);
+            } else
+                add(kept, taken, reachable);
+            return true;
+        }
+
+        TIntermLoop* loop = statement->getAsLoopNode();
+        if (loop && loop->testFirst() && loop->getTest() &&
+            GetConstantCondition(loop->getTest(), condition) && ! condition)
+            return true;
+
+        kept.push_back(statement);
+        if (branch && branch->getFlowOp() != EOpCase && branch->getFlowOp() != EOpDefault)
+            reachable = false;
+
+        return false;
+    }
+};
+
+// A statement storing to a private variable: statement list and index.
+struct TStore {
+    TIntermAggregate* list;
+    size_t index;
+    bool pure;  // the right side has no side effects
+};
+
+typedef std::unordered_map<long long, int> TReadCounts;
+typedef std::unordered_map<long long, std::vector<TStore>> TStores;
+
+//
+// Counts the reads of each variable, and finds the statements that store
+// to private variables.  Statements that only compute a value are dropped
+// on the way.
+//
+// A read of a variable in the pure right side of a store to that same
+// variable isn't counted, as it can only matter if the store does.
+//
+class TStoreTraverser : public TStatementListTraverser {
+public:
+    TStoreTraverser(TReadCounts& reads, TStores& stores) :
+        TStatementListTraverser(true, true), reads(reads), stores(stores), storeId(-1) { }
+
+    void visitSymbol(TIntermSymbol* symbol) override
+    {
+        if (storeTargets.find(symbol) == storeTargets.end() && symbol->getId() != storeId)
+            ++reads[symbol->getId()];
+    }
+
+    bool visitBinary(TVisit visit, TIntermBinary* node) override
+    {
+        auto store = storeIds.find(node);
+        if (store != storeIds.end())
+            storeId = visit == EvInVisit ? store->second : -1;
+
+        return true;
+    }
+
+protected:
+    bool visitStatementList(TVisit visit, TIntermAggregate* node) override
+    {
+        if (visit != EvPreVisit)
+            return true;
+
+        TIntermSequence& statements = node->getSequence();
+        for (size_t s = 0; s < statements.size(); ++s) {
+            TIntermNode* statement = statements[s];
+            if (statement == nullptr)
+                continue;
+
+            TIntermBinary* binary = statement->getAsBinaryNode();
+            TIntermSymbol* target = binary && binary->getOp() == EOpAssign ? binary->getLeft()->getAsSymbolNode()
+                                                                            : nullptr;
+            if (target && IsPrivateVariable(target)) {
+                TStore store = { node, s, TIntermediate::isPure(binary->getRight()) };
+                stores[target->getId()].push_back(store);
+                storeTargets.insert(target);
+                storeIds[binary] = store.pure ? target->getId() : -1;
+            } else if (statement->getAsTyped() && TIntermediate::isPure(statement))
+                statements[s] = nullptr;
+        }
+
+        return true;
+    }
+
+    TReadCounts& reads;
+    TStores& stores;
+    std::unordered_set<const TIntermSymbol*> storeTargets;  // left sides of the stores
+    std::unordered_map<const TIntermBinary*, long long> storeIds;
+    long long storeId;  // the variable stored to by the pure right side being traversed
+};
+
+// Takes back the reads in the right side of a store that is dropped, and
+// collects the variables that leaves unread.
+class TDroppedReadTraverser : public TIntermTraverser {
+public:
+    TDroppedReadTraverser(TReadCounts& reads, const TStores& stores, long long storeId,
+                          std::vector<long long>& unread) :
+        reads(reads), stores(stores), storeId(storeId), unread(unread) { }
+
+    void visitSymbol(TIntermSymbol* symbol) override
+    {
+        if (symbol->getId() != storeId && --reads[symbol->getId()] == 0 &&
+            stores.find(symbol->getId()) != stores.end())
+            unread.push_back(symbol->getId());
+    }
+
+protected:
+    TReadCounts& reads;
+    const TStores& stores;
+    long long storeId;
+    std::vector<long long>& unread;
+};
+
+// Lists the functions called.
+class TCallTraverser : public TIntermTraverser {
+public:
+    TCallTraverser(std::vector<const TString*>& callees) : callees(callees) { }
+
+    bool visitAggregate(TVisit, TIntermAggregate* node) override
+    {
+        if (node->getOp() == EOpFunctionCall)
+            callees.push_back(&node->getName());
+
+        return node->getOp() != EOpLinkerObjects;
+    }
+
+protected:
+    std::vector<const TString*>& callees;
+};
+
+//
+// Removes what was dropped (nullptr) from statement lists, as well as lists
+// left empty, and notes which variables are still mentioned.
+//
+class TCompactTraverser : public TStatementListTraverser {
+public:
+    TCompactTraverser(std::unordered_set<long long>& mentioned) :
+        TStatementListTraverser(false, true), mentioned(mentioned) { }
+
+    void visitSymbol(TIntermSymbol* symbol) override { mentioned.insert(symbol->getId()); }
+
+protected:
+    bool visitStatementList(TVisit visit, TIntermAggregate* node) override
+    {
+        if (visit == EvPostVisit) {
+            TIntermSequence& statements = node->getSequence();
+            statements.erase(std::remove_if(statements.begin(), statements.end(),
+                                            [this](TIntermNode* statement) {
+                                                return statement == nullptr ||
+                                                       (isStatementList(statement) &&
+                                                        statement->getAsAggregate()->getSequence().empty());
+                                            }),
+                             statements.end());
+        }
+
+        return true;
+    }
+
+    std::unordered_set<long long>& mentioned;
+};
+
+} // end anonymous namespace
+
+//
+// Drop the stores to variables that are never read.  The statements are just
+// set to nullptr, or to what has to stay of them; see TCompactTraverser.
+//
+void TIntermediate::eliminateDeadStores()
+{
+    TReadCounts reads;
+    TStores stores;
+    TStoreTraverser storeTraverser(reads, stores);
+    treeRoot->traverse(&storeTraverser);
+
+    std::vector<long long> unread;
+    for (auto it = stores.begin(); it != stores.end(); ++it) {
+        if (reads[it->first] == 0)
+            unread.push_back(it->first);
+    }
+
+    while (! unread.empty()) {
+        const long long id = unread.back();
+        unread.pop_back();
+        for (const TStore& store : stores[id]) {
+            TIntermNode*& statement = store.list->getSequence()[store.index];
+            TIntermTyped* right = statement->getAsBinaryNode()->getRight();
+            if (store.pure) {
+                statement = nullptr;
+                TDroppedReadTraverser dropped(reads, stores, id, unread);
+                right->traverse(&dropped);
+            } else
+                statement = right;
+        }
+    }
+}
+
+//
+// Drop the functions not called, directly or not, from the entry point or
+// a global initializer.  Returns true if any were dropped.
+//
+bool TIntermediate::eliminateUncalledFunctions()
+{
+    TIntermSequence& globals = treeRoot->getAsAggregate()->getSequence();
+
+    std::unordered_map<TString, size_t> functions;
+    std::vector<const TString*> callees;
+    TCallTraverser callTraverser(callees);
+    for (size_t g = 0; g < globals.size(); ++g) {
+        TIntermAggregate* function = globals[g] ? globals[g]->getAsAggregate() : nullptr;
+        if (function && function->getOp() == EOpFunction)
+            functions[function->getName()] = g;
+        else if (globals[g])
+            globals[g]->traverse(&callTraverser);
+    }
+
+    // Without an entry point, nothing can be said to be called.
+    const TString entryPoint(getEntryPointMangledName().c_str());
+    if (functions.find(entryPoint) == functions.end())
+        return false;
+
+    std::unordered_set<size_t> called;
+    callees.push_back(&entryPoint);
+    while (! callees.empty()) {
+        auto function = functions.find(*callees.back());
+        callees.pop_back();
+        if (function != functions.end() && called.insert(function->second).second)
+            globals[function->second]->traverse(&callTraverser);
+    }
+
+    bool dropped = false;
+    for (auto it = functions.begin(); it != functions.end(); ++it) {
+        if (called.find(it->second) == called.end()) {
+            globals[it->second] = nullptr;
+            dropped = true;
+        }
+    }
+
+    return dropped;
+}
+
+//
+// See the top of the file.
+//
+void TIntermediate::eliminateDeadCode(bool keepUncalled)
+{
+    if (treeRoot == nullptr)
+        return;
+
+    TUnreachableCodeTraverser unreachable;
+    treeRoot->traverse(&unreachable);
+
+    do
+        eliminateDeadStores();
+    while (! keepUncalled && eliminateUncalledFunctions());
+
+    std::unordered_set<long long> mentioned;
+    TCompactTraverser compact(mentioned);
+    treeRoot->traverse(&compact);
+
+    TIntermSequence& linkerObjects = findLinkerObjects();
+    linkerObjects.erase(std::remove_if(linkerObjects.begin(), linkerObjects.end(),
+                                       [&mentioned](TIntermNode* object) {
+                                           TIntermSymbol* symbol = object->getAsSymbolNode();
+                                           return symbol && IsPrivateVariable(symbol) &&
+                                                  mentioned.find(symbol->getId()) == mentioned.end();
+                                       }),
+                        linkerObjects.end());
+}
+
+} // end namespace glslang
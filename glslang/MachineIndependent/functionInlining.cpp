@@ -0,0 +1,837 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "localintermediate.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//
+// Inlining of calls to small functions on the AST of a linked stage, so code
+// generation makes neither the call nor the copies of its arguments.  Asked
+// for through EShMsgInlineFunctions; a function is small enough if its body
+// has at most TIntermediate::getInlineBudget() nodes.
+//
+// A call is inlined where it is a whole statement, or the right side of a
+// store to a variable (possibly indexed by constants) its arguments don't
+// mention.  Other calls are first moved into a store to a new temporary,
+// ahead of their statement, if nothing the statement computes before the
+// call could be changed by it.  Calls under ?:, on the right of && or ||, or
+// in the test of a loop, stay as they are.
+//
+// The body is copied in place of the call, with new variables for its
+// locals.  Parameters become locals too, set from the arguments before the
+// body, and for 'out' and 'inout' parameters, copied back to them after it.
+// An 'in' parameter the body never writes reads its argument instead, when
+// that is a constant or a variable the call can't change, and opaque
+// parameters always do.  A return stores its value where the call's value
+// went.  A body with a return before its end is put in a
+// 'do { } while (false)' loop, which its returns break out of.
+//
+// Not inlined are functions with a return inside a loop or switch, calls
+// with an 'out', 'inout', or opaque argument that isn't a variable indexed by
+// constants, and calls in a statement that isn't in a statement list (e.g.,
+// making up the whole body of an 'if').  Functions left uncalled are then
+// removed, unless asked to keep them.
+//
+
+namespace glslang {
+
+namespace {
+
+// What is known about a function, for inlining calls to it.
+struct TCallee {
+    TIntermAggregate* parameters;
+    TIntermAggregate* body;             // nullptr if empty
+    int size;                           // nodes in the body
+    bool inlinable;                     // no return inside a loop or switch
+    bool earlyReturn;                   // a return before the end of the body
+    std::unordered_set<int> written;    // ids of what the body writes, through assignments, ++, --, and calls
+};
+
+typedef std::unordered_map<TString, TCallee> TCallees;
+
+// Whether 'node' is a variable, possibly indexed by constants, swizzled, or
+// selecting a member: something a copy of reads or writes the same memory.
+bool IsConstantChain(const TIntermTyped* node)
+{
+    while (const TIntermBinary* binary = node->getAsBinaryNode()) {
+        switch (binary->getOp()) {
+        case EOpIndexDirect:
+        case EOpIndexDirectStruct:
+        case EOpVectorSwizzle:
+            node = binary->getLeft();
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return node->getAsSymbolNode() != nullptr;
+}
+
+const TIntermSymbol* GetChainBase(const TIntermTyped* node)
+{
+    const TIntermTyped* base = TIntermediate::findLValueBase(node, true);
+    return base ? base->getAsSymbolNode() : nullptr;
+}
+
+// Whether a called function could change a variable; conservatively, any
+// variable that isn't local, read-only, or a plain uniform.
+bool IsWritableByCalls(const TIntermSymbol* symbol)
+{
+    const TQualifier& qualifier = symbol->getQualifier();
+    if (qualifier.volatil || symbol->getType().containsOpaque())
+        return true;
+
+    switch (qualifier.storage) {
+    case EvqTemporary:
+    case EvqConst:
+    case EvqVaryingIn:
+    case EvqUniform:
+    case EvqIn:
+    case EvqOut:
+    case EvqInOut:
+    case EvqConstReadOnly:
+    case EvqVertexId:
+    case EvqInstanceId:
+    case EvqFace:
+    case EvqFragCoord:
+    case EvqPointCoord:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// Measures a function body, and notes what it writes and where it returns.
+class TCalleeTraverser : public TIntermTraverser {
+public:
+    TCalleeTraverser(TCallee& callee) : TIntermTraverser(true, false, true), callee(callee), depth(0), last(nullptr)
+    {
+        if (callee.body != nullptr && ! callee.body->getSequence().empty())
+            last = callee.body->getSequence().back();
+    }
+
+    void visitSymbol(TIntermSymbol*) override { ++callee.size; }
+    void visitConstantUnion(TIntermConstantUnion*) override { ++callee.size; }
+
+    bool visitBinary(TVisit visit, TIntermBinary* node) override
+    {
+        if (visit == EvPreVisit) {
+            ++callee.size;
+            if (node->getOp() >= EOpAssign && node->getOp() <= EOpRightShiftAssign)
+                write(node->getLeft());
+        }
+
+        return true;
+    }
+
+    bool visitUnary(TVisit visit, TIntermUnary* node) override
+    {
+        if (visit == EvPreVisit) {
+            ++callee.size;
+            if (! TIntermediate::isPureOperator(node->getOp()))
+                write(node->getOperand());
+        }
+
+        return true;
+    }
+
+    bool visitAggregate(TVisit visit, TIntermAggregate* node) override
+    {
+        if (visit != EvPreVisit)
+            return true;
+
+        ++callee.size;
+        if (node->getOp() == EOpSequence || TIntermediate::isPureOperator(node->getOp()))
+            return true;
+
+        const TIntermSequence& arguments = node->getSequence();
+        const TQualifierList& qualifiers = node->getQualifierList();
+        for (size_t a = 0; a < arguments.size(); ++a) {
+            bool out = node->getOp() != EOpFunctionCall ||
+                       (a < qualifiers.size() && (qualifiers[a] == EvqOut || qualifiers[a] == EvqInOut));
+            if (out && arguments[a]->getAsTyped())
+                write(arguments[a]->getAsTyped());
+        }
+
+        return true;
+    }
+
+    bool visitSelection(TVisit visit, TIntermSelection*) override
+    {
+        if (visit == EvPreVisit)
+            ++callee.size;
+
+        return true;
+    }
+
+    bool visitLoop(TVisit visit, TIntermLoop*) override
+    {
+        enter(visit);
+        return true;
+    }
+
+    bool visitSwitch(TVisit visit, TIntermSwitch*) override
+    {
+        enter(visit);
+        return true;
+    }
+
+    bool visitBranch(TVisit visit, TIntermBranch* node) override
+    {
+        if (visit == EvPreVisit) {
+            ++callee.size;
+            if (node->getFlowOp() == EOpReturn) {
+                if (depth > 0)
+                    callee.inlinable = false;
+                else if (node != last)
+                    callee.earlyReturn = true;
+            }
+        }
+
+        return true;
+    }
+
+protected:
+    void enter(TVisit visit)
+    {
+        if (visit == EvPreVisit) {
+            ++callee.size;
+            ++depth;
+        } else
+            --depth;
+    }
+
+    void write(const TIntermTyped* node)
+    {
+        if (const TIntermSymbol* base = GetChainBase(node))
+            callee.written.insert(base->getId());
+    }
+
+    TCallee& callee;
+    int depth;                 // of loops and switches
+    const TIntermNode* last;   // the last statement of the body
+};
+
+// Lists the variables read under a node.
+class TReadTraverser : public TIntermTraverser {
+public:
+    TReadTraverser(std::vector<const TIntermSymbol*>& reads) : reads(reads) { }
+
+    void visitSymbol(TIntermSymbol* node) override { reads.push_back(node); }
+
+protected:
+    std::vector<const TIntermSymbol*>& reads;
+};
+
+class TInliner {
+public:
+    TInliner(TIntermediate& intermediate) :
+        intermediate(intermediate), budget(intermediate.getInlineBudget()),
+        nextId(intermediate.getMaxSymbolId() + 1), growth(0), maxGrowth(0), result(nullptr),
+        breakOnReturn(false), remapping(true) { }
+
+    void addFunction(TIntermAggregate* function);
+    void inlineList(TIntermAggregate* list);
+
+    bool canInline(const TIntermAggregate* call) const;
+    bool isOutArgument(const TIntermAggregate* call, int id) const;
+
+protected:
+    TIntermAggregate* inlineStatement(TIntermNode* statement);
+    void inlineBody(TIntermNode* body);
+    TIntermAggregate* expand(TIntermAggregate* call, TIntermTyped* target);
+    bool isUnchanged(const TIntermTyped* argument, const TIntermAggregate* call) const;
+
+    TIntermNode* clone(TIntermNode*);
+    TIntermTyped* cloneTyped(TIntermTyped* node) { return node ? clone(node)->getAsTyped() : nullptr; }
+    TIntermTyped* copy(TIntermTyped*);
+    TIntermTyped* cloneSymbol(TIntermSymbol*);
+    TIntermNode* cloneReturn(TIntermBranch*);
+
+    TIntermSymbol* newVariable(const TString& name, const TType&, const TSourceLoc&);
+    TIntermSymbol* newRead(const TIntermSymbol* variable, const TSourceLoc&) const;
+
+    TIntermediate& intermediate;
+    int budget;
+    int nextId;
+    int growth;       // nodes inlined so far
+    int maxGrowth;    // nodes inlining stops at
+    TCallees callees;
+
+    // For the call being expanded:
+    std::unordered_map<int, const TIntermSymbol*> variables;  // the new variable for each local and parameter
+    std::unordered_map<int, TIntermTyped*> arguments;         // the argument read for each parameter not copied
+    TIntermTyped* result;                                     // where returns store their value, if anywhere
+    bool breakOnReturn;
+    bool remapping;                                           // cloning the callee, not an argument
+};
+
+//
+// Finds the first call in an expression that can be inlined and moved ahead
+// of it: one that is always computed, and that can't change anything
+// computed before it.
+//
+class TCallFinder : public TIntermTraverser {
+public:
+    TCallFinder(const TInliner& inliner) :
+        TIntermTraverser(true, true, true), inliner(inliner), call(nullptr), parent(nullptr), blocked(false) { }
+
+    void visitSymbol(TIntermSymbol* node) override { reads.push_back(node); }
+
+    bool visitBinary(TVisit visit, TIntermBinary* node) override
+    {
+        if (done())
+            return false;
+
+        // only the left side of && and || is always computed
+        if (visit == EvInVisit && (node->getOp() == EOpLogicalAnd || node->getOp() == EOpLogicalOr)) {
+            skip(node->getRight());
+            return false;
+        }
+        if (visit == EvPostVisit)
+            computed(node->getOp());
+
+        return true;
+    }
+
+    bool visitUnary(TVisit visit, TIntermUnary* node) override
+    {
+        if (done())
+            return false;
+        if (visit == EvPostVisit)
+            computed(node->getOp());
+
+        return true;
+    }
+
+    bool visitAggregate(TVisit visit, TIntermAggregate* node) override
+    {
+        if (done())
+            return false;
+
+        if (visit == EvPreVisit && inliner.canInline(node) && canMove(node)) {
+            call = node;
+            parent = getParentNode();
+            return false;
+        }
+        if (visit == EvPostVisit && node->getOp() != EOpSequence)
+            computed(node->getOp());
+
+        return true;
+    }
+
+    bool visitSelection(TVisit, TIntermSelection* node) override
+    {
+        if (! done())
+            skip(node);
+
+        return false;
+    }
+
+    TIntermAggregate* call;
+    TIntermNode* parent;     // of the call, nullptr if it is the whole expression
+
+protected:
+    bool done() const { return call != nullptr || blocked; }
+
+    void computed(TOperator op)
+    {
+        if (! TIntermediate::isPureOperator(op))
+            blocked = true;
+    }
+
+    // What isn't always computed still can't be moved across.
+    void skip(TIntermNode* node)
+    {
+        if (! TIntermediate::isPure(node))
+            blocked = true;
+        TReadTraverser readTraverser(reads);
+        node->traverse(&readTraverser);
+    }
+
+    bool canMove(const TIntermAggregate* node) const
+    {
+        for (const TIntermSymbol* read : reads) {
+            if (IsWritableByCalls(read) || inliner.isOutArgument(node, read->getId()))
+                return false;
+        }
+
+        return true;
+    }
+
+    const TInliner& inliner;
+    std::vector<const TIntermSymbol*> reads;   // computed before the current node
+    bool blocked;
+};
+
+void TInliner::addFunction(TIntermAggregate* function)
+{
+    const TIntermSequence& sequence = function->getSequence();
+    TCallee callee;
+    callee.parameters = sequence[0]->getAsAggregate();
+    callee.body = sequence.size() > 1 && sequence[1] ? sequence[1]->getAsAggregate() : nullptr;
+    callee.size = 0;
+    callee.inlinable = sequence.size() == 1 || sequence[1] == nullptr ||
+                       (callee.body != nullptr && callee.body->getOp() == EOpSequence);
+    callee.earlyReturn = false;
+
+    if (callee.inlinable && callee.body != nullptr) {
+        TCalleeTraverser calleeTraverser(callee);
+        callee.body->traverse(&calleeTraverser);
+    }
+
+    // No more than the functions have, times eight, gets inlined.
+    maxGrowth += 8 * std::min(callee.size, budget);
+
+    callees[function->getName()] = callee;
+}
+
+bool TInliner::canInline(const TIntermAggregate* call) const
+{
+    if (call->getOp() != EOpFunctionCall)
+        return false;
+
+    auto it = callees.find(call->getName());
+    if (it == callees.end())
+        return false;
+
+    const TCallee& callee = it->second;
+    if (! callee.inlinable || callee.size > budget || growth + callee.size > maxGrowth)
+        return false;
+
+    const TIntermSequence& parameters = callee.parameters->getSequence();
+    const TIntermSequence& args = call->getSequence();
+    if (parameters.size() != args.size())
+        return false;
+
+    for (size_t p = 0; p < parameters.size(); ++p) {
+        const TIntermSymbol* parameter = parameters[p]->getAsSymbolNode();
+        const TIntermTyped* argument = args[p]->getAsTyped();
+        if (parameter == nullptr || argument == nullptr)
+            return false;
+
+        TStorageQualifier storage = parameter->getQualifier().storage;
+        if ((storage == EvqOut || storage == EvqInOut || parameter->getType().containsOpaque()) &&
+            ! IsConstantChain(argument))
+            return false;
+    }
+
+    return true;
+}
+
+// Whether 'id' is the variable of an 'out' or 'inout' argument of 'call'.
+bool TInliner::isOutArgument(const TIntermAggregate* call, int id) const
+{
+    const TIntermSequence& parameters = callees.find(call->getName())->second.parameters->getSequence();
+    const TIntermSequence& args = call->getSequence();
+    for (size_t p = 0; p < parameters.size(); ++p) {
+        TStorageQualifier storage = parameters[p]->getAsSymbolNode()->getQualifier().storage;
+        const TIntermSymbol* base = GetChainBase(args[p]->getAsTyped());
+        if ((storage == EvqOut || storage == EvqInOut) && base && base->getId() == id)
+            return true;
+    }
+
+    return false;
+}
+
+// Whether an argument reads the same value throughout the inlined body.
+bool TInliner::isUnchanged(const TIntermTyped* argument, const TIntermAggregate* call) const
+{
+    if (argument->getAsConstantUnion())
+        return true;
+
+    const TIntermSymbol* symbol = argument->getAsSymbolNode();
+    return symbol && ! IsWritableByCalls(symbol) && ! isOutArgument(call, symbol->getId());
+}
+
+void TInliner::inlineList(TIntermAggregate* list)
+{
+    TIntermSequence& statements = list->getSequence();
+    for (size_t s = 0; s < statements.size(); ++s) {
+        TIntermNode* statement = statements[s];
+        if (statement == nullptr)
+            continue;
+
+        TIntermAggregate* aggregate = statement->getAsAggregate();
+        if (aggregate && aggregate->getOp() == EOpSequence) {
+            inlineList(aggregate);
+            continue;
+        }
+
+        if (TIntermAggregate* replacement = inlineStatement(statement)) {
+            statements[s] = replacement;
+            inlineList(replacement);
+            continue;
+        }
+
+        if (TIntermSelection* selection = statement->getAsSelectionNode()) {
+            if (selection->getBasicType() == EbtVoid) {
+                inlineBody(selection->getTrueBlock());
+                inlineBody(selection->getFalseBlock());
+            }
+        } else if (TIntermLoop* loop = statement->getAsLoopNode())
+            inlineBody(loop->getBody());
+        else if (TIntermSwitch* switchNode = statement->getAsSwitchNode())
+            inlineBody(switchNode->getBody());
+    }
+}
+
+// Only a body that is a statement list has room for more statements.
+void TInliner::inlineBody(TIntermNode* body)
+{
+    TIntermAggregate* list = body ? body->getAsAggregate() : nullptr;
+    if (list && list->getOp() == EOpSequence)
+        inlineList(list);
+}
+
+//
+// Return what replaces 'statement': the expansion of a call, or a sequence
+// storing a call to a temporary and then doing 'statement' with that.
+// Return nullptr to leave it as is.
+//
+TIntermAggregate* TInliner::inlineStatement(TIntermNode* statement)
+{
+    // The expression computed first, and how to replace it.
+    TIntermTyped* expression = statement->getAsTyped();
+    TIntermSelection* selection = statement->getAsSelectionNode();
+    TIntermSwitch* switchNode = statement->getAsSwitchNode();
+    TIntermBranch* branch = statement->getAsBranchNode();
+    TIntermBinary* store = statement->getAsBinaryNode();
+    if (store && (store->getOp() != EOpAssign || ! IsConstantChain(store->getLeft())))
+        store = nullptr;
+
+    if (selection && selection->getBasicType() == EbtVoid)
+        expression = selection->getCondition();
+    else if (switchNode)
+        expression = switchNode->getCondition()->getAsTyped();
+    else if (branch)
+        expression = branch->getFlowOp() == EOpReturn ? branch->getExpression() : nullptr;
+    else if (store) {
+        TIntermAggregate* call = store->getRight()->getAsAggregate();
+        if (call && canInline(call)) {
+            std::vector<const TIntermSymbol*> reads;
+            TReadTraverser readTraverser(reads);
+            call->traverse(&readTraverser);
+            int target = GetChainBase(store->getLeft())->getId();
+            if (std::none_of(reads.begin(), reads.end(),
+                             [target](const TIntermSymbol* read) { return read->getId() == target; }))
+                return expand(call, store->getLeft());
+        }
+
+        // storing happens after the right side is computed
+        expression = store->getRight();
+    }
+    if (expression == nullptr)
+        return nullptr;
+
+    if (expression == statement) {
+        TIntermAggregate* call = expression->getAsAggregate();
+        if (call && canInline(call))
+            return expand(call, nullptr);
+    }
+
+    TCallFinder finder(*this);
+    expression->traverse(&finder);
+    TIntermAggregate* call = finder.call;
+    if (call == nullptr)
+        return nullptr;
+
+    TIntermSymbol* temporary = newVariable("@result", call->getType(), call->getLoc());
+    TIntermSymbol* read = newRead(temporary, call->getLoc());
+    if (TIntermBinary* binary = finder.parent ? finder.parent->getAsBinaryNode() : nullptr) {
+        if (binary->getLeft() == call)
+            binary->setLeft(read);
+        else
+            binary->setRight(read);
+    } else if (TIntermUnary* unary = finder.parent ? finder.parent->getAsUnaryNode() : nullptr)
+        unary->setOperand(read);
+    else if (TIntermAggregate* aggregate = finder.parent ? finder.parent->getAsAggregate() : nullptr)
+        std::replace(aggregate->getSequence().begin(), aggregate->getSequence().end(), (TIntermNode*)call,
+                     (TIntermNode*)read);
+    else if (selection)
+        selection->setCondition(read);
+    else if (switchNode)
+        switchNode->setCondition(read);
+    else if (branch)
+        branch->setExpression(read);
+    else if (store)
+        store->setRight(read);
+
+    TIntermAggregate* sequence = new TIntermAggregate(EOpSequence);
+    sequence->setLoc(statement->getLoc());
+    sequence->getSequence().push_back(intermediate.addBinaryNode(EOpAssign, newRead(temporary, call->getLoc()), call,
+                                                                 call->getLoc(), temporary->getType()));
+    sequence->getSequence().push_back(statement);
+
+    return sequence;
+}
+
+//
+// Make the statements replacing 'call', storing its value to 'target', if
+// not nullptr.
+//
+TIntermAggregate* TInliner::expand(TIntermAggregate* call, TIntermTyped* target)
+{
+    const TCallee& callee = callees.find(call->getName())->second;
+    const TIntermSequence& parameters = callee.parameters->getSequence();
+    TIntermSequence& args = call->getSequence();
+    const TSourceLoc& loc = call->getLoc();
+
+    TIntermAggregate* expansion = new TIntermAggregate(EOpSequence);
+    expansion->setLoc(loc);
+    TIntermSequence& statements = expansion->getSequence();
+    TIntermSequence copies;
+
+    variables.clear();
+    arguments.clear();
+    for (size_t p = 0; p < parameters.size(); ++p) {
+        const TIntermSymbol* parameter = parameters[p]->getAsSymbolNode();
+        TIntermTyped* argument = args[p]->getAsTyped();
+        TStorageQualifier storage = parameter->getQualifier().storage;
+        bool out = storage == EvqOut || storage == EvqInOut;
+        if (parameter->getType().containsOpaque() ||
+            (! out && callee.written.find(parameter->getId()) == callee.written.end() &&
+             isUnchanged(argument, call))) {
+            arguments[parameter->getId()] = argument;
+            continue;
+        }
+
+        TIntermSymbol* variable = newVariable(parameter->getName(), parameter->getType(), parameter->getLoc());
+        variables[parameter->getId()] = variable;
+        if (storage != EvqOut)
+            statements.push_back(intermediate.addBinaryNode(EOpAssign, newRead(variable, argument->getLoc()), argument,
+                                                            argument->getLoc(), variable->getType()));
+        if (out)
+            copies.push_back(intermediate.addBinaryNode(EOpAssign, copy(argument), newRead(variable, loc), loc,
+                                                        argument->getType()));
+    }
+
+    result = target;
+    breakOnReturn = callee.earlyReturn;
+    if (callee.body != nullptr) {
+        TIntermNode* body = clone(callee.body);
+        if (breakOnReturn)
+            body = intermediate.addLoop(body, intermediate.addConstantUnion(false, loc), nullptr, false, loc);
+        statements.push_back(body);
+    }
+    statements.insert(statements.end(), copies.begin(), copies.end());
+
+    growth += callee.size;
+
+    return expansion;
+}
+
+TIntermNode* TInliner::clone(TIntermNode* node)
+{
+    if (node == nullptr)
+        return nullptr;
+
+    TIntermNode* cloned = nullptr;
+    if (TIntermSymbol* symbol = node->getAsSymbolNode())
+        return cloneSymbol(symbol);
+    else if (TIntermConstantUnion* constant = node->getAsConstantUnion()) {
+        TIntermConstantUnion* constantCopy = new TIntermConstantUnion(constant->getConstArray(), constant->getType());
+        if (constant->isLiteral())
+            constantCopy->setLiteral();
+        cloned = constantCopy;
+    } else if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        TIntermBinary* binaryCopy = new TIntermBinary(binary->getOp());
+        binaryCopy->setType(binary->getType());
+        binaryCopy->setOperationPrecision(binary->getOperationPrecision());
+        binaryCopy->setLeft(cloneTyped(binary->getLeft()));
+        binaryCopy->setRight(cloneTyped(binary->getRight()));
+        cloned = binaryCopy;
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        TIntermUnary* unaryCopy = new TIntermUnary(unary->getOp());
+        unaryCopy->setType(unary->getType());
+        unaryCopy->setOperationPrecision(unary->getOperationPrecision());
+        unaryCopy->setOperand(cloneTyped(unary->getOperand()));
+        cloned = unaryCopy;
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        TIntermAggregate* aggregateCopy = new TIntermAggregate(aggregate->getOp());
+        aggregateCopy->setType(aggregate->getType());
+        aggregateCopy->setOperationPrecision(aggregate->getOperationPrecision());
+        for (TIntermNode* child : aggregate->getSequence()) {
+            if (TIntermNode* childCopy = clone(child))
+                aggregateCopy->getSequence().push_back(childCopy);
+        }
+        aggregateCopy->getQualifierList() = aggregate->getQualifierList();
+        aggregateCopy->setName(aggregate->getName());
+        if (aggregate->isUserDefined())
+            aggregateCopy->setUserDefined();
+        aggregateCopy->setOptimize(aggregate->getOptimize());
+        aggregateCopy->setDebug(aggregate->getDebug());
+        cloned = aggregateCopy;
+    } else if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        TIntermSelection* selectionCopy = new TIntermSelection(cloneTyped(selection->getCondition()),
+                                                               clone(selection->getTrueBlock()),
+                                                               clone(selection->getFalseBlock()),
+                                                               selection->getType());
+        selectionCopy->setSelectionControl(selection->getSelectionControl());
+        cloned = selectionCopy;
+    } else if (TIntermSwitch* switchNode = node->getAsSwitchNode()) {
+        TIntermSwitch* switchCopy = new TIntermSwitch(cloneTyped(switchNode->getCondition()->getAsTyped()),
+                                                      clone(switchNode->getBody())->getAsAggregate());
+        switchCopy->setSelectionControl(switchNode->getSelectionControl());
+        cloned = switchCopy;
+    } else if (TIntermLoop* loop = node->getAsLoopNode()) {
+        TIntermLoop* loopCopy = new TIntermLoop(clone(loop->getBody()), cloneTyped(loop->getTest()),
+                                                cloneTyped(loop->getTerminal()), loop->testFirst());
+        loopCopy->setLoopControl(loop->getLoopControl());
+        cloned = loopCopy;
+    } else if (TIntermBranch* branch = node->getAsBranchNode()) {
+        if (branch->getFlowOp() == EOpReturn && remapping)
+            return cloneReturn(branch);
+        cloned = new TIntermBranch(branch->getFlowOp(), cloneTyped(branch->getExpression()));
+    }
+
+    if (cloned != nullptr)
+        cloned->setLoc(node->getLoc());
+
+    return cloned;
+}
+
+// Copy an argument, to read or write it again.
+TIntermTyped* TInliner::copy(TIntermTyped* node)
+{
+    bool wasRemapping = remapping;
+    remapping = false;
+    TIntermTyped* nodeCopy = cloneTyped(node);
+    remapping = wasRemapping;
+
+    return nodeCopy;
+}
+
+TIntermTyped* TInliner::cloneSymbol(TIntermSymbol* symbol)
+{
+    if (remapping) {
+        auto argument = arguments.find(symbol->getId());
+        if (argument != arguments.end()) {
+            TIntermTyped* read = copy(argument->second);
+            read->setLoc(symbol->getLoc());
+            return read;
+        }
+
+        auto variable = variables.find(symbol->getId());
+        if (variable == variables.end() && symbol->getQualifier().storage == EvqTemporary)
+            variable = variables.insert(std::make_pair(symbol->getId(),
+                                                       newVariable(symbol->getName(), symbol->getType(),
+                                                                   symbol->getLoc()))).first;
+        if (variable != variables.end())
+            return newRead(variable->second, symbol->getLoc());
+    }
+
+    TIntermSymbol* symbolCopy = intermediate.addSymbol(*symbol);
+#ifdef ENABLE_HLSL
+    symbolCopy->setFlattenSubset(symbol->getFlattenSubset());
+#endif
+
+    return symbolCopy;
+}
+
+// A return stores its value where the call's value goes, and leaves the body.
+TIntermNode* TInliner::cloneReturn(TIntermBranch* branch)
+{
+    const TSourceLoc& loc = branch->getLoc();
+    TIntermAggregate* sequence = new TIntermAggregate(EOpSequence);
+    sequence->setLoc(loc);
+
+    if (TIntermTyped* expression = cloneTyped(branch->getExpression())) {
+        if (result != nullptr)
+            expression = intermediate.addBinaryNode(EOpAssign, copy(result), expression, loc, result->getType());
+        sequence->getSequence().push_back(expression);
+    }
+    if (breakOnReturn)
+        sequence->getSequence().push_back(intermediate.addBranch(EOpBreak, loc));
+
+    return sequence->getSequence().empty() ? nullptr : sequence;
+}
+
+// Make a new local variable, for a parameter, local, or value of a call.
+TIntermSymbol* TInliner::newVariable(const TString& name, const TType& type, const TSourceLoc& loc)
+{
+    TType variableType;
+    variableType.shallowCopy(type);
+    variableType.makeTemporary();
+    TIntermSymbol* variable = new TIntermSymbol(nextId++, name, variableType);
+    variable->setLoc(loc);
+
+    return variable;
+}
+
+TIntermSymbol* TInliner::newRead(const TIntermSymbol* variable, const TSourceLoc& loc) const
+{
+    TIntermSymbol* read = intermediate.addSymbol(*variable);
+    read->setLoc(loc);
+
+    return read;
+}
+
+} // end anonymous namespace
+
+//
+// See the top of the file.
+//
+void TIntermediate::inlineFunctions(bool keepUncalled)
+{
+    if (treeRoot == nullptr)
+        return;
+
+    TInliner inliner(*this);
+    TIntermSequence& globals = treeRoot->getAsAggregate()->getSequence();
+    for (TIntermNode* global : globals) {
+        TIntermAggregate* function = global ? global->getAsAggregate() : nullptr;
+        if (function && function->getOp() == EOpFunction)
+            inliner.addFunction(function);
+    }
+
+    for (TIntermNode* global : globals) {
+        TIntermAggregate* function = global ? global->getAsAggregate() : nullptr;
+        if (function && function->getOp() == EOpFunction && function->getSequence().size() > 1) {
+            TIntermAggregate* body = function->getSequence()[1] ? function->getSequence()[1]->getAsAggregate() : nullptr;
+            if (body && body->getOp() == EOpSequence)
+                inliner.inlineList(body);
+        }
+    }
+
+    if (! keepUncalled && eliminateUncalledFunctions())
+        globals.erase(std::remove(globals.begin(), globals.end(), nullptr), globals.end());
+}
+
+} // end namespace glslang
@@ -0,0 +1,1389 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "localintermediate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+//
+// Binary serialization of a TIntermediate.
+//
+// This saves everything the front end produced for one compilation unit:
+// the AST (including the linker objects), the call graph, the shader-level
+// qualifiers and settings, and the module processes.  Loading it back gives
+// the same TIntermediate parsing would have, without running the
+// preprocessor, scanner, or parser.
+//
+// Layout:
+//
+//   header:   magic, format version, build configuration, stage
+//   fields:   the shader-level state of the TIntermediate
+//   records:  array sizes, structures, and nodes, each written once, and
+//             only after everything it refers to; ended by EbrEnd
+//   root:     reference to the tree root
+//
+// Numbers are LEB128 varints (zig-zag for signed values), so the common
+// small values take one byte.  References to records are 1-based indexes
+// into the records of the same kind, with 0 meaning nullptr.  Names are
+// pooled: the first use writes the text, later uses write its index.
+//
+// Because records only ever refer back to earlier records, reading is one
+// forward pass with no recursion, and whatever the parser shared (nodes,
+// structures, array sizes) comes back shared.
+//
+
+namespace glslang {
+
+namespace {
+
+const unsigned int BinaryMagic = 0x42534c47;  // "GLSB"
+
+// Bump whenever the encoding changes; other versions are rejected on load.
+const unsigned int BinaryVersion = 1;
+
+// Build options that change which fields exist, and hence are serialized.
+enum TBinaryConfig {
+    EbcAmdExtensions = 1 << 0,
+    EbcNvExtensions  = 1 << 1,
+    EbcHlsl          = 1 << 2,
+};
+
+unsigned int GetBinaryConfig()
+{
+    unsigned int config = 0;
+#ifdef AMD_EXTENSIONS
+    config |= EbcAmdExtensions;
+#endif
+#ifdef NV_EXTENSIONS
+    config |= EbcNvExtensions;
+#endif
+#ifdef ENABLE_HLSL
+    config |= EbcHlsl;
+#endif
+    return config;
+}
+
+enum TBinaryRecord {
+    EbrEnd,
+    EbrArraySizes,
+    EbrStruct,
+    EbrSymbol,
+    EbrConstantUnion,
+    EbrBinary,
+    EbrUnary,
+    EbrAggregate,
+    EbrSelection,
+    EbrSwitch,
+    EbrLoop,
+    EbrBranch,
+};
+
+// The operation precision, or EpqNone when it just follows the result precision.
+TPrecisionQualifier GetOwnOperationPrecision(const TIntermOperator& node)
+{
+    TPrecisionQualifier precision = node.getOperationPrecision();
+    return precision == node.getType().getQualifier().precision ? EpqNone : precision;
+}
+
+class TBinaryWriter {
+public:
+    explicit TBinaryWriter(std::vector<unsigned char>& binary) : binary(binary) { }
+
+    void putHeader(EShLanguage stage)
+    {
+        for (int b = 0; b < 4; ++b)
+            binary.push_back((unsigned char)(BinaryMagic >> (8 * b)));
+        putUint(BinaryVersion);
+        putUint(GetBinaryConfig());
+        putUint(stage);
+    }
+
+    void putUint(unsigned long long value)
+    {
+        while (value >= 0x80) {
+            binary.push_back((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        binary.push_back((unsigned char)value);
+    }
+    void putInt(long long value) { putUint(((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63)); }
+    void putBool(bool value) { putUint(value ? 1 : 0); }
+    void putDouble(double value)
+    {
+        unsigned long long bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (int b = 0; b < 8; ++b)
+            binary.push_back((unsigned char)(bits >> (8 * b)));
+    }
+    void putString(const char* text, size_t length)
+    {
+        putUint(length);
+        binary.insert(binary.end(), text, text + length);
+    }
+    void putString(const std::string& text) { putString(text.c_str(), text.size()); }
+    template<class C> void putStrings(const C& strings)
+    {
+        putUint(strings.size());
+        for (auto it = strings.begin(); it != strings.end(); ++it)
+            putString(*it);
+    }
+
+    // Pooled names: 0 for nullptr, 1 followed by the text for a first use,
+    // or 2 plus the index of an earlier use.
+    void putName(const char* text, size_t length)
+    {
+        if (text == nullptr) {
+            putUint(0);
+            return;
+        }
+        std::string name(text, length);
+        auto it = names.find(name);
+        if (it != names.end()) {
+            putUint(it->second + 2);
+            return;
+        }
+        size_t index = names.size();
+        names[name] = index;
+        putUint(1);
+        putString(name);
+    }
+    void putName(const char* name) { putName(name, name != nullptr ? strlen(name) : 0); }
+    void putName(const TString& name) { putName(name.c_str(), name.size()); }
+
+    bool putTree(TIntermNode* root);
+
+protected:
+    enum TObjectKind {
+        EokNode,
+        EokStruct,
+        EokArraySizes,
+    };
+
+    // An object waiting to be written; it is first expanded into the
+    // objects it refers to, and written once all of those have been.
+    struct TPending {
+        TObjectKind kind;
+        const void* object;
+        bool expanded;
+    };
+
+    typedef std::unordered_map<const void*, size_t> TIndexMap;
+
+    TIndexMap& getIndexMap(TObjectKind kind)
+    {
+        switch (kind) {
+        case EokStruct:     return structIndexes;
+        case EokArraySizes: return arraySizesIndexes;
+        default:            return nodeIndexes;
+        }
+    }
+
+    bool schedule(TObjectKind kind, const void* object);
+    bool scheduleType(const TType&);
+    bool scheduleReferences(const TPending&);
+    bool putRecord(const TPending&);
+    bool putNode(TIntermNode*);
+
+    void putRef(TObjectKind kind, const void* object)
+    {
+        putUint(object == nullptr ? 0 : getIndexMap(kind)[object] + 1);
+    }
+    void putNodeRef(const TIntermNode* node) { putRef(EokNode, node); }
+    void putLoc(const TSourceLoc&);
+    void putSampler(const TSampler&);
+    void putQualifier(const TQualifier&);
+    void putType(const TType&);
+    bool putConstants(const TConstUnionArray&);
+
+    std::vector<unsigned char>& binary;
+    std::unordered_map<std::string, size_t> names;
+    TIndexMap nodeIndexes;
+    TIndexMap structIndexes;
+    TIndexMap arraySizesIndexes;
+    std::vector<TPending> pending;
+    std::unordered_set<const void*> expanding;  // objects whose references are still being written
+
+private:
+    TBinaryWriter& operator=(TBinaryWriter&);
+};
+
+//
+// Write all the records the tree needs, children before parents, and then the
+// reference to the root.  Walks with an explicit stack, so deep expressions
+// are no problem.
+//
+// Returns false if the tree holds something that is not serializable.
+//
+bool TBinaryWriter::putTree(TIntermNode* root)
+{
+    if (! schedule(EokNode, root))
+        return false;
+
+    while (! pending.empty()) {
+        TPending entry = pending.back();
+        TIndexMap& indexes = getIndexMap(entry.kind);
+        if (indexes.find(entry.object) != indexes.end()) {
+            // scheduled more than once, and already written
+            pending.pop_back();
+        } else if (! entry.expanded) {
+            pending.back().expanded = true;
+            expanding.insert(entry.object);
+            if (! scheduleReferences(entry))
+                return false;
+        } else {
+            expanding.erase(entry.object);
+            pending.pop_back();
+            size_t index = indexes.size();
+            if (! putRecord(entry))
+                return false;
+            indexes[entry.object] = index;
+        }
+    }
+
+    putUint(EbrEnd);
+    putNodeRef(root);
+
+    return true;
+}
+
+// Returns false when 'object' refers back to itself.
+bool TBinaryWriter::schedule(TObjectKind kind, const void* object)
+{
+    if (object == nullptr)
+        return true;
+    if (expanding.find(object) != expanding.end())
+        return false;
+
+    TIndexMap& indexes = getIndexMap(kind);
+    if (indexes.find(object) == indexes.end())
+        pending.push_back({ kind, object, false });
+
+    return true;
+}
+
+bool TBinaryWriter::scheduleType(const TType& type)
+{
+    return schedule(EokStruct, type.getStruct()) &&
+           schedule(EokArraySizes, type.getArraySizes());
+}
+
+// Schedule what the object refers to.  Things scheduled last are written
+// first, so they are pushed in reverse order to keep the records in the
+// natural left-to-right order.
+bool TBinaryWriter::scheduleReferences(const TPending& entry)
+{
+    switch (entry.kind) {
+    case EokArraySizes:
+    {
+        const TArraySizes& arraySizes = *static_cast<const TArraySizes*>(entry.object);
+        for (int d = arraySizes.getNumDims() - 1; d >= 0; --d) {
+            if (! schedule(EokNode, arraySizes.getDimNode(d)))
+                return false;
+        }
+        return true;
+    }
+    case EokStruct:
+    {
+        const TTypeList& members = *static_cast<const TTypeList*>(entry.object);
+        for (int m = (int)members.size() - 1; m >= 0; --m) {
+            if (! scheduleType(*members[m].type))
+                return false;
+        }
+        return true;
+    }
+    default:
+        break;
+    }
+
+    TIntermNode* node = const_cast<TIntermNode*>(static_cast<const TIntermNode*>(entry.object));
+    TIntermNode* children[3] = { nullptr, nullptr, nullptr };
+
+    if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        const TIntermSequence& sequence = aggregate->getSequence();
+        for (int n = (int)sequence.size() - 1; n >= 0; --n) {
+            if (! schedule(EokNode, sequence[n]))
+                return false;
+        }
+    } else if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        children[0] = binary->getLeft();
+        children[1] = binary->getRight();
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        children[0] = unary->getOperand();
+    } else if (TIntermSymbol* symbol = node->getAsSymbolNode()) {
+        children[0] = symbol->getConstSubtree();
+    } else if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        children[0] = selection->getCondition();
+        children[1] = selection->getTrueBlock();
+        children[2] = selection->getFalseBlock();
+    } else if (TIntermSwitch* switchNode = node->getAsSwitchNode()) {
+        children[0] = switchNode->getCondition();
+        children[1] = switchNode->getBody();
+    } else if (TIntermLoop* loop = node->getAsLoopNode()) {
+        children[0] = loop->getBody();
+        children[1] = loop->getTest();
+        children[2] = loop->getTerminal();
+    } else if (TIntermBranch* branch = node->getAsBranchNode()) {
+        children[0] = branch->getExpression();
+    }
+
+    for (int c = 2; c >= 0; --c) {
+        if (! schedule(EokNode, children[c]))
+            return false;
+    }
+
+    if (node->getAsTyped() != nullptr)
+        return scheduleType(node->getAsTyped()->getType());
+
+    return true;
+}
+
+bool TBinaryWriter::putRecord(const TPending& entry)
+{
+    switch (entry.kind) {
+    case EokArraySizes:
+    {
+        const TArraySizes& arraySizes = *static_cast<const TArraySizes*>(entry.object);
+        putUint(EbrArraySizes);
+        putInt(arraySizes.getImplicitSize());
+        putUint(arraySizes.getNumDims());
+        for (int d = 0; d < arraySizes.getNumDims(); ++d) {
+            putUint((unsigned int)arraySizes.getDimSize(d));
+            putNodeRef(arraySizes.getDimNode(d));
+        }
+        return true;
+    }
+    case EokStruct:
+    {
+        const TTypeList& members = *static_cast<const TTypeList*>(entry.object);
+        putUint(EbrStruct);
+        putUint(members.size());
+        for (size_t m = 0; m < members.size(); ++m) {
+            putType(*members[m].type);
+            putLoc(members[m].loc);
+        }
+        return true;
+    }
+    default:
+        return putNode(const_cast<TIntermNode*>(static_cast<const TIntermNode*>(entry.object)));
+    }
+}
+
+bool TBinaryWriter::putNode(TIntermNode* node)
+{
+    if (TIntermSymbol* symbol = node->getAsSymbolNode()) {
+        putUint(EbrSymbol);
+        putLoc(symbol->getLoc());
+        putType(symbol->getType());
+        putInt(symbol->getId());
+        putName(symbol->getName());
+        if (! putConstants(symbol->getConstArray()))
+            return false;
+        putNodeRef(symbol->getConstSubtree());
+#ifdef ENABLE_HLSL
+        putInt(symbol->getFlattenSubset());
+#endif
+    } else if (TIntermConstantUnion* constant = node->getAsConstantUnion()) {
+        putUint(EbrConstantUnion);
+        putLoc(constant->getLoc());
+        putType(constant->getType());
+        if (! putConstants(constant->getConstArray()))
+            return false;
+        putBool(constant->isLiteral());
+    } else if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        putUint(EbrBinary);
+        putLoc(binary->getLoc());
+        putType(binary->getType());
+        putUint(binary->getOp());
+        putUint(GetOwnOperationPrecision(*binary));
+        putNodeRef(binary->getLeft());
+        putNodeRef(binary->getRight());
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        putUint(EbrUnary);
+        putLoc(unary->getLoc());
+        putType(unary->getType());
+        putUint(unary->getOp());
+        putUint(GetOwnOperationPrecision(*unary));
+        putNodeRef(unary->getOperand());
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        putUint(EbrAggregate);
+        putLoc(aggregate->getLoc());
+        putType(aggregate->getType());
+        putUint(aggregate->getOp());
+        putUint(GetOwnOperationPrecision(*aggregate));
+        const TIntermSequence& sequence = aggregate->getSequence();
+        putUint(sequence.size());
+        for (size_t n = 0; n < sequence.size(); ++n)
+            putNodeRef(sequence[n]);
+        const TQualifierList& qualifiers = aggregate->getQualifierList();
+        putUint(qualifiers.size());
+        for (size_t q = 0; q < qualifiers.size(); ++q)
+            putUint(qualifiers[q]);
+        putName(aggregate->getName());
+        putBool(aggregate->isUserDefined());
+        putBool(aggregate->getOptimize());
+        putBool(aggregate->getDebug());
+        putBool(aggregate->hasPragmaTable());
+        if (aggregate->hasPragmaTable()) {
+            const TPragmaTable& pragmas = aggregate->getPragmaTable();
+            putUint(pragmas.size());
+            for (auto it = pragmas.begin(); it != pragmas.end(); ++it) {
+                putName(it->first);
+                putName(it->second);
+            }
+        }
+    } else if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        putUint(EbrSelection);
+        putLoc(selection->getLoc());
+        putType(selection->getType());
+        putNodeRef(selection->getCondition());
+        putNodeRef(selection->getTrueBlock());
+        putNodeRef(selection->getFalseBlock());
+        putUint(selection->getSelectionControl());
+    } else if (TIntermSwitch* switchNode = node->getAsSwitchNode()) {
+        putUint(EbrSwitch);
+        putLoc(switchNode->getLoc());
+        putNodeRef(switchNode->getCondition());
+        putNodeRef(switchNode->getBody());
+        putUint(switchNode->getSelectionControl());
+    } else if (TIntermLoop* loop = node->getAsLoopNode()) {
+        putUint(EbrLoop);
+        putLoc(loop->getLoc());
+        putNodeRef(loop->getBody());
+        putNodeRef(loop->getTest());
+        putNodeRef(loop->getTerminal());
+        putBool(loop->testFirst());
+        putUint(loop->getLoopControl());
+    } else if (TIntermBranch* branch = node->getAsBranchNode()) {
+        putUint(EbrBranch);
+        putLoc(branch->getLoc());
+        putUint(branch->getFlowOp());
+        putNodeRef(branch->getExpression());
+    } else {
+        // e.g., an unresolved TIntermMethod, which never survives a successful parse
+        return false;
+    }
+
+    return true;
+}
+
+void TBinaryWriter::putLoc(const TSourceLoc& loc)
+{
+    putName(loc.name);
+    putInt(loc.string);
+    putInt(loc.line);
+    putInt(loc.column);
+}
+
+void TBinaryWriter::putSampler(const TSampler& sampler)
+{
+    putUint(sampler.type);
+    putUint(sampler.dim);
+    unsigned int flags = 0;
+    int bit = 0;
+    flags |= (unsigned int)sampler.arrayed  << bit++;
+    flags |= (unsigned int)sampler.shadow   << bit++;
+    flags |= (unsigned int)sampler.ms       << bit++;
+    flags |= (unsigned int)sampler.image    << bit++;
+    flags |= (unsigned int)sampler.combined << bit++;
+    flags |= (unsigned int)sampler.sampler  << bit++;
+    flags |= (unsigned int)sampler.external << bit++;
+    putUint(flags);
+    putUint(sampler.vectorSize);
+    putUint(sampler.structReturnIndex);
+}
+
+void TBinaryWriter::putQualifier(const TQualifier& qualifier)
+{
+    putName(qualifier.semanticName);
+    putUint(qualifier.storage);
+    putUint(qualifier.builtIn);
+    putUint(qualifier.declaredBuiltIn);
+    putUint(qualifier.precision);
+
+    unsigned long long flags = 0;
+    int bit = 0;
+    flags |= (unsigned long long)qualifier.invariant          << bit++;
+    flags |= (unsigned long long)qualifier.noContraction      << bit++;
+    flags |= (unsigned long long)qualifier.centroid           << bit++;
+    flags |= (unsigned long long)qualifier.smooth             << bit++;
+    flags |= (unsigned long long)qualifier.flat               << bit++;
+    flags |= (unsigned long long)qualifier.nopersp            << bit++;
+#ifdef AMD_EXTENSIONS
+    flags |= (unsigned long long)qualifier.explicitInterp     << bit++;
+#endif
+    flags |= (unsigned long long)qualifier.patch              << bit++;
+    flags |= (unsigned long long)qualifier.sample             << bit++;
+    flags |= (unsigned long long)qualifier.coherent           << bit++;
+    flags |= (unsigned long long)qualifier.volatil            << bit++;
+    flags |= (unsigned long long)qualifier.restrict           << bit++;
+    flags |= (unsigned long long)qualifier.readonly           << bit++;
+    flags |= (unsigned long long)qualifier.writeonly          << bit++;
+    flags |= (unsigned long long)qualifier.specConstant       << bit++;
+    flags |= (unsigned long long)qualifier.layoutPushConstant << bit++;
+#ifdef NV_EXTENSIONS
+    flags |= (unsigned long long)qualifier.layoutPassthrough      << bit++;
+    flags |= (unsigned long long)qualifier.layoutViewportRelative << bit++;
+#endif
+    putUint(flags);
+
+    putUint(qualifier.layoutMatrix);
+    putUint(qualifier.layoutPacking);
+    putInt(qualifier.layoutOffset);
+    putInt(qualifier.layoutAlign);
+    putUint(qualifier.layoutLocation);
+    putUint(qualifier.layoutComponent);
+    putUint(qualifier.layoutSet);
+    putUint(qualifier.layoutBinding);
+    putUint(qualifier.layoutIndex);
+    putUint(qualifier.layoutStream);
+    putUint(qualifier.layoutXfbBuffer);
+    putUint(qualifier.layoutXfbStride);
+    putUint(qualifier.layoutXfbOffset);
+    putUint(qualifier.layoutAttachment);
+    putUint(qualifier.layoutSpecConstantId);
+    putUint(qualifier.layoutFormat);
+#ifdef NV_EXTENSIONS
+    putInt(qualifier.layoutSecondaryViewportRelativeOffset);
+#endif
+}
+
+void TBinaryWriter::putType(const TType& type)
+{
+    putUint(type.getBasicType());
+    putUint(type.getVectorSize());
+    putUint(type.getMatrixCols());
+    putUint(type.getMatrixRows());
+    putBool(type.getVectorSize() == 1 && type.isVector());
+    putSampler(type.getSampler());
+    putQualifier(type.getQualifier());
+    putRef(EokArraySizes, type.getArraySizes());
+    putRef(EokStruct, type.getStruct());
+    putName(type.hasFieldName() ? type.getFieldName().c_str() : nullptr);
+    putName(type.hasTypeName() ? type.getTypeName().c_str() : nullptr);
+}
+
+bool TBinaryWriter::putConstants(const TConstUnionArray& constants)
+{
+    putUint(constants.size());
+    for (int c = 0; c < constants.size(); ++c) {
+        const TConstUnion& constant = constants[c];
+        putUint(constant.getType());
+        switch (constant.getType()) {
+        case EbtInt:    putInt(constant.getIConst());     break;
+        case EbtUint:   putUint(constant.getUConst());    break;
+        case EbtInt64:  putInt(constant.getI64Const());   break;
+        case EbtUint64: putUint(constant.getU64Const());  break;
+        case EbtDouble: putDouble(constant.getDConst());  break;
+        case EbtBool:   putBool(constant.getBConst());    break;
+        case EbtString: putName(*constant.getSConst());   break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+class TBinaryReader {
+public:
+    TBinaryReader(const unsigned char* binary, size_t size, TIntermediate& intermediate)
+        : current(binary), end(binary + size), intermediate(intermediate), bad(false) { }
+
+    bool good() const { return ! bad; }
+    bool atEnd() const { return current == end; }
+
+    bool getHeader(EShLanguage stage)
+    {
+        if (end - current < 4)
+            return false;
+        unsigned int magic = 0;
+        for (int b = 0; b < 4; ++b)
+            magic |= (unsigned int)*current++ << (8 * b);
+
+        return magic == BinaryMagic &&
+               getUint() == BinaryVersion &&
+               getUint() == GetBinaryConfig() &&
+               getUint() == (unsigned long long)stage &&
+               good();
+    }
+
+    unsigned long long getUint()
+    {
+        unsigned long long value = 0;
+        for (int shift = 0; shift < 64 && current != end; shift += 7) {
+            unsigned char byte = *current++;
+            value |= (unsigned long long)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+        bad = true;
+        return 0;
+    }
+    long long getInt()
+    {
+        unsigned long long value = getUint();
+        return (long long)(value >> 1) ^ -(long long)(value & 1);
+    }
+    bool getBool() { return getUint() != 0; }
+    double getDouble()
+    {
+        unsigned long long bits = 0;
+        if (end - current < 8)
+            bad = true;
+        else {
+            for (int b = 0; b < 8; ++b)
+                bits |= (unsigned long long)*current++ << (8 * b);
+        }
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    std::string getString()
+    {
+        unsigned long long length = getUint();
+        if (length > (unsigned long long)(end - current)) {
+            bad = true;
+            return std::string();
+        }
+        std::string text(reinterpret_cast<const char*>(current), (size_t)length);
+        current += length;
+        return text;
+    }
+    template<class C> void getStrings(C& strings)
+    {
+        strings.clear();
+        unsigned long long count = getUint();
+        for (unsigned long long s = 0; s < count && good(); ++s)
+            strings.insert(strings.end(), getString());
+    }
+
+    // See TBinaryWriter::putName(); returns nullptr for a nullptr name.
+    const TString* getName()
+    {
+        unsigned long long code = getUint();
+        if (code == 0)
+            return nullptr;
+        if (code == 1) {
+            std::string text = getString();
+            names.push_back(NewPoolTString(text.c_str()));
+            return names.back();
+        }
+        if (code - 2 >= names.size()) {
+            bad = true;
+            return nullptr;
+        }
+        return names[(size_t)(code - 2)];
+    }
+    // For names that must be there.
+    const TString& getRequiredName()
+    {
+        const TString* name = getName();
+        if (name == nullptr) {
+            bad = true;
+            return emptyName;
+        }
+        return *name;
+    }
+
+    bool getTree(TIntermNode*& root);
+
+protected:
+    TIntermNode* getNodeRef()
+    {
+        unsigned long long ref = getUint();
+        if (ref == 0)
+            return nullptr;
+        if (ref > nodes.size()) {
+            bad = true;
+            return nullptr;
+        }
+        return nodes[(size_t)(ref - 1)];
+    }
+    TIntermTyped* getTypedRef()
+    {
+        TIntermNode* node = getNodeRef();
+        if (node != nullptr && node->getAsTyped() == nullptr)
+            bad = true;
+        return node != nullptr ? node->getAsTyped() : nullptr;
+    }
+    template<class T> T* getRef(const std::vector<T*>& records)
+    {
+        unsigned long long ref = getUint();
+        if (ref == 0)
+            return nullptr;
+        if (ref > records.size()) {
+            bad = true;
+            return nullptr;
+        }
+        return records[(size_t)(ref - 1)];
+    }
+
+    TIntermNode* getNode(unsigned long long tag);
+    void getArraySizes();
+    void getStruct();
+    TSourceLoc getLoc();
+    void getSampler(TSampler&);
+    void getQualifier(TQualifier&);
+    void getType(TType&);
+    TConstUnionArray getConstants();
+
+    const unsigned char* current;
+    const unsigned char* end;
+    TIntermediate& intermediate;
+    bool bad;
+    std::vector<const TString*> names;
+    std::vector<TIntermNode*> nodes;
+    std::vector<TTypeList*> structs;
+    std::vector<TArraySizes*> arraySizes;
+    const TString emptyName;
+
+private:
+    TBinaryReader& operator=(TBinaryReader&);
+};
+
+bool TBinaryReader::getTree(TIntermNode*& root)
+{
+    while (good()) {
+        unsigned long long tag = getUint();
+        switch (tag) {
+        case EbrEnd:
+            root = getNodeRef();
+            return good();
+        case EbrArraySizes:
+            getArraySizes();
+            break;
+        case EbrStruct:
+            getStruct();
+            break;
+        default:
+        {
+            TIntermNode* node = getNode(tag);
+            if (node == nullptr)
+                return false;
+            nodes.push_back(node);
+            break;
+        }
+        }
+    }
+
+    return false;
+}
+
+TIntermNode* TBinaryReader::getNode(unsigned long long tag)
+{
+    TSourceLoc loc = getLoc();
+    TIntermNode* node = nullptr;
+
+    switch (tag) {
+    case EbrSymbol:
+    {
+        TType type;
+        getType(type);
+        int id = (int)getInt();
+        const TString& name = getRequiredName();
+        TConstUnionArray constants = getConstants();
+        TIntermTyped* subtree = getTypedRef();
+        TIntermSymbol* symbol = new TIntermSymbol(id, name, type);
+        symbol->setConstArray(constants);
+        symbol->setConstSubtree(subtree);
+#ifdef ENABLE_HLSL
+        symbol->setFlattenSubset((int)getInt());
+#endif
+        node = symbol;
+        break;
+    }
+    case EbrConstantUnion:
+    {
+        TType type;
+        getType(type);
+        TConstUnionArray constants = getConstants();
+        TIntermConstantUnion* constant = new TIntermConstantUnion(constants, type);
+        if (getBool())
+            constant->setLiteral();
+        node = constant;
+        break;
+    }
+    case EbrBinary:
+    {
+        TType type;
+        getType(type);
+        TIntermBinary* binary = new TIntermBinary((TOperator)getUint());
+        binary->setType(type);
+        binary->setOperationPrecision((TPrecisionQualifier)getUint());
+        binary->setLeft(getTypedRef());
+        binary->setRight(getTypedRef());
+        node = binary;
+        break;
+    }
+    case EbrUnary:
+    {
+        TType type;
+        getType(type);
+        TIntermUnary* unary = new TIntermUnary((TOperator)getUint());
+        unary->setType(type);
+        unary->setOperationPrecision((TPrecisionQualifier)getUint());
+        unary->setOperand(getTypedRef());
+        node = unary;
+        break;
+    }
+    case EbrAggregate:
+    {
+        TType type;
+        getType(type);
+        TIntermAggregate* aggregate = new TIntermAggregate((TOperator)getUint());
+        aggregate->setType(type);
+        aggregate->setOperationPrecision((TPrecisionQualifier)getUint());
+        unsigned long long count = getUint();
+        for (unsigned long long n = 0; n < count && good(); ++n)
+            aggregate->getSequence().push_back(getNodeRef());
+        count = getUint();
+        for (unsigned long long q = 0; q < count && good(); ++q)
+            aggregate->getQualifierList().push_back((TStorageQualifier)getUint());
+        aggregate->setName(getRequiredName());
+        if (getBool())
+            aggregate->setUserDefined();
+        aggregate->setOptimize(getBool());
+        aggregate->setDebug(getBool());
+        if (getBool()) {
+            TPragmaTable pragmas;
+            count = getUint();
+            for (unsigned long long p = 0; p < count && good(); ++p) {
+                const TString& name = getRequiredName();
+                pragmas[name] = getRequiredName();
+            }
+            aggregate->addToPragmaTable(pragmas);
+        }
+        node = aggregate;
+        break;
+    }
+    case EbrSelection:
+    {
+        TType type;
+        getType(type);
+        TIntermTyped* condition = getTypedRef();
+        TIntermNode* trueBlock = getNodeRef();
+        TIntermNode* falseBlock = getNodeRef();
+        TIntermSelection* selection = new TIntermSelection(condition, trueBlock, falseBlock, type);
+        selection->setSelectionControl((TSelectionControl)getUint());
+        node = selection;
+        break;
+    }
+    case EbrSwitch:
+    {
+        TIntermTyped* condition = getTypedRef();
+        TIntermNode* body = getNodeRef();
+        if (body != nullptr && body->getAsAggregate() == nullptr)
+            bad = true;
+        TIntermSwitch* switchNode = new TIntermSwitch(condition, body != nullptr ? body->getAsAggregate() : nullptr);
+        switchNode->setSelectionControl((TSelectionControl)getUint());
+        node = switchNode;
+        break;
+    }
+    case EbrLoop:
+    {
+        TIntermNode* body = getNodeRef();
+        TIntermTyped* test = getTypedRef();
+        TIntermTyped* terminal = getTypedRef();
+        bool testFirst = getBool();
+        TIntermLoop* loop = new TIntermLoop(body, test, terminal, testFirst);
+        loop->setLoopControl((TLoopControl)getUint());
+        node = loop;
+        break;
+    }
+    case EbrBranch:
+    {
+        TOperator flowOp = (TOperator)getUint();
+        node = new TIntermBranch(flowOp, getTypedRef());
+        break;
+    }
+    default:
+        bad = true;
+        return nullptr;
+    }
+
+    node->setLoc(loc);
+
+    return good() ? node : nullptr;
+}
+
+void TBinaryReader::getArraySizes()
+{
+    TArraySizes* sizes = new TArraySizes;
+    sizes->setImplicitSize((int)getInt());
+    unsigned long long numDims = getUint();
+    for (unsigned long long d = 0; d < numDims && good(); ++d) {
+        int size = (int)getUint();
+        sizes->addInnerSize(size, getTypedRef());
+    }
+    arraySizes.push_back(sizes);
+}
+
+void TBinaryReader::getStruct()
+{
+    TTypeList* members = new TTypeList;
+    unsigned long long count = getUint();
+    for (unsigned long long m = 0; m < count && good(); ++m) {
+        TTypeLoc member;
+        member.type = new TType;
+        getType(*member.type);
+        member.loc = getLoc();
+        members->push_back(member);
+    }
+    structs.push_back(members);
+}
+
+TSourceLoc TBinaryReader::getLoc()
+{
+    TSourceLoc loc;
+    const TString* name = getName();
+    loc.name = name != nullptr ? name->c_str() : nullptr;
+    loc.string = (int)getInt();
+    loc.line = (int)getInt();
+    loc.column = (int)getInt();
+
+    return loc;
+}
+
+void TBinaryReader::getSampler(TSampler& sampler)
+{
+    sampler.type = (TBasicType)getUint();
+    sampler.dim = (TSamplerDim)getUint();
+    unsigned int flags = (unsigned int)getUint();
+    int bit = 0;
+    sampler.arrayed  = ((flags >> bit++) & 1) != 0;
+    sampler.shadow   = ((flags >> bit++) & 1) != 0;
+    sampler.ms       = ((flags >> bit++) & 1) != 0;
+    sampler.image    = ((flags >> bit++) & 1) != 0;
+    sampler.combined = ((flags >> bit++) & 1) != 0;
+    sampler.sampler  = ((flags >> bit++) & 1) != 0;
+    sampler.external = ((flags >> bit++) & 1) != 0;
+    sampler.vectorSize = (unsigned int)getUint();
+    sampler.structReturnIndex = (unsigned int)getUint();
+}
+
+void TBinaryReader::getQualifier(TQualifier& qualifier)
+{
+    qualifier.clear();
+
+    const TString* semanticName = getName();
+    qualifier.semanticName = semanticName != nullptr ? intermediate.addSemanticName(*semanticName) : nullptr;
+    qualifier.storage = (TStorageQualifier)getUint();
+    qualifier.builtIn = (TBuiltInVariable)getUint();
+    qualifier.declaredBuiltIn = (TBuiltInVariable)getUint();
+    qualifier.precision = (TPrecisionQualifier)getUint();
+
+    unsigned long long flags = getUint();
+    int bit = 0;
+    qualifier.invariant          = ((flags >> bit++) & 1) != 0;
+    qualifier.noContraction      = ((flags >> bit++) & 1) != 0;
+    qualifier.centroid           = ((flags >> bit++) & 1) != 0;
+    qualifier.smooth             = ((flags >> bit++) & 1) != 0;
+    qualifier.flat               = ((flags >> bit++) & 1) != 0;
+    qualifier.nopersp            = ((flags >> bit++) & 1) != 0;
+#ifdef AMD_EXTENSIONS
+    qualifier.explicitInterp     = ((flags >> bit++) & 1) != 0;
+#endif
+    qualifier.patch              = ((flags >> bit++) & 1) != 0;
+    qualifier.sample             = ((flags >> bit++) & 1) != 0;
+    qualifier.coherent           = ((flags >> bit++) & 1) != 0;
+    qualifier.volatil            = ((flags >> bit++) & 1) != 0;
+    qualifier.restrict           = ((flags >> bit++) & 1) != 0;
+    qualifier.readonly           = ((flags >> bit++) & 1) != 0;
+    qualifier.writeonly          = ((flags >> bit++) & 1) != 0;
+    qualifier.specConstant       = ((flags >> bit++) & 1) != 0;
+    qualifier.layoutPushConstant = ((flags >> bit++) & 1) != 0;
+#ifdef NV_EXTENSIONS
+    qualifier.layoutPassthrough      = ((flags >> bit++) & 1) != 0;
+    qualifier.layoutViewportRelative = ((flags >> bit++) & 1) != 0;
+#endif
+
+    qualifier.layoutMatrix = (TLayoutMatrix)getUint();
+    qualifier.layoutPacking = (TLayoutPacking)getUint();
+    qualifier.layoutOffset = (int)getInt();
+    qualifier.layoutAlign = (int)getInt();
+    qualifier.layoutLocation = (unsigned int)getUint();
+    qualifier.layoutComponent = (unsigned int)getUint();
+    qualifier.layoutSet = (unsigned int)getUint();
+    qualifier.layoutBinding = (unsigned int)getUint();
+    qualifier.layoutIndex = (unsigned int)getUint();
+    qualifier.layoutStream = (unsigned int)getUint();
+    qualifier.layoutXfbBuffer = (unsigned int)getUint();
+    qualifier.layoutXfbStride = (unsigned int)getUint();
+    qualifier.layoutXfbOffset = (unsigned int)getUint();
+    qualifier.layoutAttachment = (unsigned int)getUint();
+    qualifier.layoutSpecConstantId = (unsigned int)getUint();
+    qualifier.layoutFormat = (TLayoutFormat)getUint();
+#ifdef NV_EXTENSIONS
+    qualifier.layoutSecondaryViewportRelativeOffset = (int)getInt();
+#endif
+}
+
+void TBinaryReader::getType(TType& type)
+{
+    TBasicType basicType = (TBasicType)getUint();
+    int vectorSize = (int)getUint();
+    int matrixCols = (int)getUint();
+    int matrixRows = (int)getUint();
+    bool vector1 = getBool();
+    TType read(basicType, EvqTemporary, vectorSize, matrixCols, matrixRows, vector1);
+
+    getSampler(read.getSampler());
+    getQualifier(read.getQualifier());
+    read.transferArraySizes(getRef(arraySizes));
+    read.setStruct(getRef(structs));
+    const TString* fieldName = getName();
+    if (fieldName != nullptr)
+        read.setFieldName(*fieldName);
+    const TString* typeName = getName();
+    if (typeName != nullptr)
+        read.setTypeName(*typeName);
+
+    type.shallowCopy(read);
+}
+
+TConstUnionArray TBinaryReader::getConstants()
+{
+    unsigned long long size = getUint();
+    if (size > (unsigned long long)(end - current)) {
+        // each constant takes at least a byte
+        bad = true;
+        return TConstUnionArray();
+    }
+
+    TConstUnionArray constants((int)size);
+    for (int c = 0; c < (int)size && good(); ++c) {
+        TConstUnion& constant = constants[c];
+        switch ((TBasicType)getUint()) {
+        case EbtInt:    constant.setIConst((int)getInt());                   break;
+        case EbtUint:   constant.setUConst((unsigned int)getUint());         break;
+        case EbtInt64:  constant.setI64Const(getInt());                      break;
+        case EbtUint64: constant.setU64Const(getUint());                     break;
+        case EbtDouble: constant.setDConst(getDouble());                     break;
+        case EbtBool:   constant.setBConst(getBool());                       break;
+        case EbtString: constant.setSConst(&getRequiredName());              break;
+        default:
+            bad = true;
+            break;
+        }
+    }
+
+    return constants;
+}
+
+} // end anonymous namespace
+
+//
+// Save this intermediate, as left by parsing, into 'binary' (appending).
+//
+// Returns false if the tree is not in a state that can be saved.
+//
+bool TIntermediate::serialize(std::vector<unsigned char>& binary) const
+{
+    TBinaryWriter out(binary);
+
+    out.putHeader(language);
+
+    out.putUint(source);
+    out.putString(entryPointName);
+    out.putString(entryPointMangledName);
+    out.putUint(profile);
+    out.putInt(version);
+    out.putUint(spvVersion.spv);
+    out.putInt(spvVersion.vulkanGlsl);
+    out.putInt(spvVersion.vulkan);
+    out.putInt(spvVersion.openGl);
+    out.putStrings(requestedExtensions);
+    out.putInt(numEntryPoints);
+    out.putInt(numErrors);
+    out.putInt(numPushConstants);
+    out.putBool(recursive);
+
+    // shader-level qualifiers
+    out.putInt(invocations);
+    out.putInt(vertices);
+    out.putUint(inputPrimitive);
+    out.putUint(outputPrimitive);
+    out.putBool(pixelCenterInteger);
+    out.putBool(originUpperLeft);
+    out.putUint(vertexSpacing);
+    out.putUint(vertexOrder);
+    out.putBool(pointMode);
+    for (int dim = 0; dim < 3; ++dim) {
+        out.putInt(localSize[dim]);
+        out.putInt(localSizeSpecId[dim]);
+    }
+    out.putBool(earlyFragmentTests);
+    out.putBool(postDepthCoverage);
+    out.putUint(depthLayout);
+    out.putBool(depthReplacing);
+    out.putInt(blendEquations);
+    out.putBool(xfbMode);
+    out.putBool(multiStream);
+#ifdef NV_EXTENSIONS
+    out.putBool(layoutOverrideCoverage);
+    out.putBool(geoPassthroughEXT);
+#endif
+
+    // settings given before parsing
+    out.putUint(shiftSamplerBinding);
+    out.putUint(shiftTextureBinding);
+    out.putUint(shiftImageBinding);
+    out.putUint(shiftUboBinding);
+    out.putUint(shiftSsboBinding);
+    out.putUint(shiftUavBinding);
+    out.putStrings(resourceSetBinding);
+    out.putBool(autoMapBindings);
+    out.putBool(autoMapLocations);
+    out.putBool(flattenUniformArrays);
+    out.putBool(useUnknownFormat);
+    out.putBool(hlslOffsets);
+    out.putBool(useStorageBuffer);
+    out.putBool(hlslIoMapping);
+    out.putUint(textureSamplerTransformMode);
+
+    out.putUint(callGraph.size());
+    for (auto call = callGraph.begin(); call != callGraph.end(); ++call) {
+        out.putName(call->caller);
+        out.putName(call->callee);
+    }
+
+    out.putUint(ioAccessed.size());
+    for (auto name = ioAccessed.begin(); name != ioAccessed.end(); ++name)
+        out.putName(*name);
+
+    for (int set = 0; set < 4; ++set) {
+        out.putUint(usedIo[set].size());
+        for (auto range = usedIo[set].begin(); range != usedIo[set].end(); ++range) {
+            out.putInt(range->location.start);
+            out.putInt(range->location.last);
+            out.putInt(range->component.start);
+            out.putInt(range->component.last);
+            out.putUint(range->basicType);
+            out.putInt(range->index);
+        }
+    }
+
+    out.putUint(usedAtomics.size());
+    for (auto range = usedAtomics.begin(); range != usedAtomics.end(); ++range) {
+        out.putInt(range->binding.start);
+        out.putInt(range->binding.last);
+        out.putInt(range->offset.start);
+        out.putInt(range->offset.last);
+    }
+
+    out.putUint(xfbBuffers.size());
+    for (auto buffer = xfbBuffers.begin(); buffer != xfbBuffers.end(); ++buffer) {
+        out.putUint(buffer->ranges.size());
+        for (auto range = buffer->ranges.begin(); range != buffer->ranges.end(); ++range) {
+            out.putInt(range->start);
+            out.putInt(range->last);
+        }
+        out.putUint(buffer->stride);
+        out.putUint(buffer->implicitStride);
+        out.putBool(buffer->containsDouble);
+    }
+
+    // sorted, so equal intermediates give equal binaries
+    std::vector<int> constantIds(usedConstantId.begin(), usedConstantId.end());
+    std::sort(constantIds.begin(), constantIds.end());
+    out.putUint(constantIds.size());
+    for (size_t id = 0; id < constantIds.size(); ++id)
+        out.putInt(constantIds[id]);
+
+    out.putUint(semanticNameSet.size());
+    for (auto name = semanticNameSet.begin(); name != semanticNameSet.end(); ++name)
+        out.putName(*name);
+
+    out.putString(sourceFile);
+    out.putString(sourceText);
+    out.putStrings(processes.getProcesses());
+    out.putBool(needToLegalize);
+
+    return out.putTree(treeRoot);
+}
+
+//
+// Replace the contents of this intermediate with those saved by serialize().
+// Everything is allocated from the current thread's pool, as parsing would.
+//
+// Returns false if 'binary' was not made by serialize() for this stage, or by
+// a differently configured or versioned build.  The intermediate is not
+// usable after a failure.
+//
+bool TIntermediate::deserialize(const unsigned char* binary, size_t size)
+{
+    TBinaryReader in(binary, size, *this);
+
+    if (! in.getHeader(language))
+        return false;
+
+    source = (EShSource)in.getUint();
+    entryPointName = in.getString();
+    entryPointMangledName = in.getString();
+    profile = (EProfile)in.getUint();
+    version = (int)in.getInt();
+    spvVersion.spv = (unsigned int)in.getUint();
+    spvVersion.vulkanGlsl = (int)in.getInt();
+    spvVersion.vulkan = (int)in.getInt();
+    spvVersion.openGl = (int)in.getInt();
+    in.getStrings(requestedExtensions);
+    numEntryPoints = (int)in.getInt();
+    numErrors = (int)in.getInt();
+    numPushConstants = (int)in.getInt();
+    recursive = in.getBool();
+
+    invocations = (int)in.getInt();
+    vertices = (int)in.getInt();
+    inputPrimitive = (TLayoutGeometry)in.getUint();
+    outputPrimitive = (TLayoutGeometry)in.getUint();
+    pixelCenterInteger = in.getBool();
+    originUpperLeft = in.getBool();
+    vertexSpacing = (TVertexSpacing)in.getUint();
+    vertexOrder = (TVertexOrder)in.getUint();
+    pointMode = in.getBool();
+    for (int dim = 0; dim < 3; ++dim) {
+        localSize[dim] = (int)in.getInt();
+        localSizeSpecId[dim] = (int)in.getInt();
+    }
+    earlyFragmentTests = in.getBool();
+    postDepthCoverage = in.getBool();
+    depthLayout = (TLayoutDepth)in.getUint();
+    depthReplacing = in.getBool();
+    blendEquations = (int)in.getInt();
+    xfbMode = in.getBool();
+    multiStream = in.getBool();
+#ifdef NV_EXTENSIONS
+    layoutOverrideCoverage = in.getBool();
+    geoPassthroughEXT = in.getBool();
+#endif
+
+    shiftSamplerBinding = (unsigned int)in.getUint();
+    shiftTextureBinding = (unsigned int)in.getUint();
+    shiftImageBinding = (unsigned int)in.getUint();
+    shiftUboBinding = (unsigned int)in.getUint();
+    shiftSsboBinding = (unsigned int)in.getUint();
+    shiftUavBinding = (unsigned int)in.getUint();
+    in.getStrings(resourceSetBinding);
+    autoMapBindings = in.getBool();
+    autoMapLocations = in.getBool();
+    flattenUniformArrays = in.getBool();
+    useUnknownFormat = in.getBool();
+    hlslOffsets = in.getBool();
+    useStorageBuffer = in.getBool();
+    hlslIoMapping = in.getBool();
+    textureSamplerTransformMode = (EShTextureSamplerTransformMode)in.getUint();
+
+    callGraph.clear();
+    unsigned long long count = in.getUint();
+    for (unsigned long long c = 0; c < count && in.good(); ++c) {
+        const TString& caller = in.getRequiredName();
+        const TString& callee = in.getRequiredName();
+        callGraph.push_back(TCall(caller, callee));
+    }
+
+    ioAccessed.clear();
+    count = in.getUint();
+    for (unsigned long long n = 0; n < count && in.good(); ++n)
+        ioAccessed.insert(in.getRequiredName());
+
+    clearUsedRanges();
+    for (int set = 0; set < 4; ++set) {
+        count = in.getUint();
+        for (unsigned long long r = 0; r < count && in.good(); ++r) {
+            int locationStart = (int)in.getInt();
+            int locationLast = (int)in.getInt();
+            int componentStart = (int)in.getInt();
+            int componentLast = (int)in.getInt();
+            TBasicType basicType = (TBasicType)in.getUint();
+            int index = (int)in.getInt();
+            addUsedIoRange(set, TIoRange(TRange(locationStart, locationLast), TRange(componentStart, componentLast),
+                                         basicType, index));
+        }
+    }
+
+    count = in.getUint();
+    for (unsigned long long r = 0; r < count && in.good(); ++r) {
+        int bindingStart = (int)in.getInt();
+        int bindingLast = (int)in.getInt();
+        int offsetStart = (int)in.getInt();
+        int offsetLast = (int)in.getInt();
+        addUsedOffsetRange(TOffsetRange(TRange(bindingStart, bindingLast), TRange(offsetStart, offsetLast)));
+    }
+
+    xfbBuffers.clear();
+    count = in.getUint();
+    for (unsigned long long b = 0; b < count && in.good(); ++b) {
+        TXfbBuffer buffer;
+        unsigned long long numRanges = in.getUint();
+        for (unsigned long long r = 0; r < numRanges && in.good(); ++r) {
+            int start = (int)in.getInt();
+            int last = (int)in.getInt();
+            buffer.ranges.push_back(TRange(start, last));
+        }
+        buffer.stride = (unsigned int)in.getUint();
+        buffer.implicitStride = (unsigned int)in.getUint();
+        buffer.containsDouble = in.getBool();
+        xfbBuffers.push_back(buffer);
+    }
+
+    usedConstantId.clear();
+    count = in.getUint();
+    for (unsigned long long i = 0; i < count && in.good(); ++i)
+        usedConstantId.insert((int)in.getInt());
+
+    count = in.getUint();
+    for (unsigned long long n = 0; n < count && in.good(); ++n)
+        addSemanticName(in.getRequiredName());
+
+    sourceFile = in.getString();
+    sourceText = in.getString();
+    std::vector<std::string> processStrings;
+    in.getStrings(processStrings);
+    processes = TProcesses();
+    addProcesses(processStrings);
+    needToLegalize = in.getBool();
+
+    TIntermNode* root = nullptr;
+    if (! in.getTree(root) || ! in.atEnd())
+        return false;
+    treeRoot = root;
+
+    return true;
+}
+
+} // end namespace glslang
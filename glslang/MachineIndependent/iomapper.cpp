@@ -113,6 +113,8 @@ struct TVarEntryInfo
 
 typedef std::vector<TVarEntryInfo> TVarLiveMap;
 
+// Collects an entry per visit of an in, out, or uniform variable, which
+// SortAndMergeEntries() then makes one entry per variable.
 class TVarGatherTraverser : public TLiveTraverser
 {
 public:
@@ -137,11 +139,7 @@ public:
 
         if (target) {
             TVarEntryInfo ent = { base->getId(), base, !traverseAll };
-            TVarLiveMap::iterator at = std::lower_bound(target->begin(), target->end(), ent, TVarEntryInfo::TOrderById());
-            if (at != target->end() && at->id == ent.id)
-              at->live = at->live || !traverseAll; // update live state
-            else
-              target->insert(at, ent);
+            target->push_back(ent);
         }
     }
 
@@ -151,38 +149,51 @@ private:
     TVarLiveMap&    uniformList;
 };
 
+// Sort the entries gathered in 'list' by id, and merge the ones for the same
+// variable: the first one gathered stays, live if any of them was.
+static void SortAndMergeEntries(TVarLiveMap& list)
+{
+    std::stable_sort(list.begin(), list.end(), TVarEntryInfo::TOrderById());
+
+    if (list.empty())
+        return;
+
+    TVarLiveMap::iterator kept = list.begin();
+    for (TVarLiveMap::iterator it = list.begin() + 1; it != list.end(); ++it) {
+        if (it->id == kept->id)
+            kept->live = kept->live || it->live;
+        else
+            *++kept = *it;
+    }
+    list.erase(kept + 1, list.end());
+}
+
 class TVarSetTraverser : public TLiveTraverser
 {
 public:
     TVarSetTraverser(const TIntermediate& i, const TVarLiveMap& inList, const TVarLiveMap& outList, const TVarLiveMap& uniformList)
       : TLiveTraverser(i, true, true, true, false)
-      , inputList(inList)
-      , outputList(outList)
-      , uniformList(uniformList)
     {
+        entries.reserve(inList.size() + outList.size() + uniformList.size());
+        for (const TVarLiveMap* list : { &inList, &outList, &uniformList }) {
+            for (const TVarEntryInfo& ent : *list)
+                entries[ent.id] = &ent;
+        }
     }
 
 
     virtual void visitSymbol(TIntermSymbol* base)
     {
-        const TVarLiveMap* source;
-        if (base->getQualifier().storage == EvqVaryingIn)
-            source = &inputList;
-        else if (base->getQualifier().storage == EvqVaryingOut)
-            source = &outputList;
-        else if (base->getQualifier().isUniformOrBuffer())
-            source = &uniformList;
-        else
+        if (base->getQualifier().storage != EvqVaryingIn &&
+            base->getQualifier().storage != EvqVaryingOut &&
+            ! base->getQualifier().isUniformOrBuffer())
             return;
 
-        TVarEntryInfo ent = { base->getId() };
-        TVarLiveMap::const_iterator at = std::lower_bound(source->begin(), source->end(), ent, TVarEntryInfo::TOrderById());
-        if (at == source->end())
-            return;
-
-        if (at->id != ent.id)
+        const auto entry = entries.find(base->getId());
+        if (entry == entries.end())
             return;
 
+        const TVarEntryInfo* at = entry->second;
         if (at->newBinding != -1)
             base->getWritableType().getQualifier().layoutBinding = at->newBinding;
         if (at->newSet != -1)
@@ -196,9 +207,7 @@ public:
     }
 
   private:
-    const TVarLiveMap&    inputList;
-    const TVarLiveMap&    outputList;
-    const TVarLiveMap&    uniformList;
+    std::unordered_map<int, const TVarEntryInfo*> entries;
 };
 
 struct TNotifyUniformAdaptor
@@ -210,9 +219,9 @@ struct TNotifyUniformAdaptor
       , resolver(r)
     {
     }
-    inline void operator()(TVarEntryInfo& ent)
+    inline void operator()(TIoMapVariable& var)
     {
-        resolver.notifyBinding(stage, ent.symbol->getName().c_str(), ent.symbol->getType(), ent.live);
+        resolver.notifyBinding(stage, var.name, *var.type, var.live);
     }
 private:
     TNotifyUniformAdaptor& operator=(TNotifyUniformAdaptor&);
@@ -227,59 +236,56 @@ struct TNotifyInOutAdaptor
       , resolver(r)
     {
     }
-    inline void operator()(TVarEntryInfo& ent)
+    inline void operator()(TIoMapVariable& var)
     {
-        resolver.notifyInOut(stage, ent.symbol->getName().c_str(), ent.symbol->getType(), ent.live);
+        resolver.notifyInOut(stage, var.name, *var.type, var.live);
     }
 private:
     TNotifyInOutAdaptor& operator=(TNotifyInOutAdaptor&);
 };
 
+// Report the binding and set 'var' was mapped to if they are out of range;
+// return false if either is.
+static bool CheckMappedRanges(const TIoMapVariable& var, TInfoSink& infoSink)
+{
+    bool inRange = true;
+    if (var.newBinding >= int(TQualifier::layoutBindingEnd)) {
+        TString err = TString("mapped binding out of range: ") + var.name;
+
+        infoSink.info.message(EPrefixInternalError, err.c_str());
+        inRange = false;
+    }
+    if (var.newSet >= int(TQualifier::layoutSetEnd)) {
+        TString err = TString("mapped set out of range: ") + var.name;
+
+        infoSink.info.message(EPrefixInternalError, err.c_str());
+        inRange = false;
+    }
+
+    return inRange;
+}
+
 struct TResolverUniformAdaptor
 {
-    TResolverUniformAdaptor(EShLanguage s, TIoMapResolver& r, TInfoSink& i, bool& e, TIntermediate& interm)
+    TResolverUniformAdaptor(EShLanguage s, TIoMapResolver& r, TInfoSink& i, bool& e)
       : stage(s)
       , resolver(r)
       , infoSink(i)
       , error(e)
-      , intermediate(interm)
     {
     }
 
-    inline void operator()(TVarEntryInfo& ent)
+    inline void operator()(TIoMapVariable& var)
     {
-        ent.newLocation = -1;
-        ent.newComponent = -1;
-        ent.newBinding = -1;
-        ent.newSet = -1;
-        ent.newIndex = -1;
-        const bool isValid = resolver.validateBinding(stage, ent.symbol->getName().c_str(), ent.symbol->getType(),
-                                                             ent.live);
+        const bool isValid = resolver.validateBinding(stage, var.name, *var.type, var.live);
         if (isValid) {
-            ent.newBinding = resolver.resolveBinding(stage, ent.symbol->getName().c_str(), ent.symbol->getType(),
-                                                            ent.live);
-            ent.newSet = resolver.resolveSet(stage, ent.symbol->getName().c_str(), ent.symbol->getType(), ent.live);
-            ent.newLocation = resolver.resolveUniformLocation(stage, ent.symbol->getName().c_str(),
-                                                                     ent.symbol->getType(), ent.live);
-
-            if (ent.newBinding != -1) {
-                if (ent.newBinding >= int(TQualifier::layoutBindingEnd)) {
-                    TString err = "mapped binding out of range: " + ent.symbol->getName();
-
-                    infoSink.info.message(EPrefixInternalError, err.c_str());
-                    error = true;
-                }
-            }
-            if (ent.newSet != -1) {
-                if (ent.newSet >= int(TQualifier::layoutSetEnd)) {
-                    TString err = "mapped set out of range: " + ent.symbol->getName();
-
-                    infoSink.info.message(EPrefixInternalError, err.c_str());
-                    error = true;
-                }
-            }
+            var.newBinding = resolver.resolveBinding(stage, var.name, *var.type, var.live);
+            var.newSet = resolver.resolveSet(stage, var.name, *var.type, var.live);
+            var.newLocation = resolver.resolveUniformLocation(stage, var.name, *var.type, var.live);
+            if (! CheckMappedRanges(var, infoSink))
+                error = true;
         } else {
-            TString errorMsg = "Invalid binding: " + ent.symbol->getName();
+            TString errorMsg = TString("Invalid binding: ") + var.name;
             infoSink.info.message(EPrefixInternalError, errorMsg.c_str());
             error = true;
         }
@@ -289,7 +295,6 @@ struct TResolverUniformAdaptor
     TIoMapResolver& resolver;
     TInfoSink&      infoSink;
     bool&           error;
-    TIntermediate&  intermediate;
 
 private:
     TResolverUniformAdaptor& operator=(TResolverUniformAdaptor&);
@@ -297,42 +302,24 @@ private:
 
 struct TResolverInOutAdaptor
 {
-    TResolverInOutAdaptor(EShLanguage s, TIoMapResolver& r, TInfoSink& i, bool& e, TIntermediate& interm)
+    TResolverInOutAdaptor(EShLanguage s, TIoMapResolver& r, TInfoSink& i, bool& e)
       : stage(s)
       , resolver(r)
       , infoSink(i)
       , error(e)
-      , intermediate(interm)
     {
     }
 
-    inline void operator()(TVarEntryInfo& ent)
+    inline void operator()(TIoMapVariable& var)
     {
-        ent.newLocation = -1;
-        ent.newComponent = -1;
-        ent.newBinding = -1;
-        ent.newSet = -1;
-        ent.newIndex = -1;
-        const bool isValid = resolver.validateInOut(stage,
-                                                    ent.symbol->getName().c_str(),
-                                                    ent.symbol->getType(),
-                                                    ent.live);
+        const bool isValid = resolver.validateInOut(stage, var.name, *var.type, var.live);
         if (isValid) {
-            ent.newLocation = resolver.resolveInOutLocation(stage,
-                                                            ent.symbol->getName().c_str(),
-                                                            ent.symbol->getType(),
-                                                            ent.live);
-            ent.newComponent = resolver.resolveInOutComponent(stage,
-                                                              ent.symbol->getName().c_str(),
-                                                              ent.symbol->getType(),
-                                                              ent.live);
-            ent.newIndex = resolver.resolveInOutIndex(stage,
-                                                      ent.symbol->getName().c_str(),
-                                                      ent.symbol->getType(),
-                                                      ent.live);
+            var.newLocation = resolver.resolveInOutLocation(stage, var.name, *var.type, var.live);
+            var.newComponent = resolver.resolveInOutComponent(stage, var.name, *var.type, var.live);
+            var.newIndex = resolver.resolveInOutIndex(stage, var.name, *var.type, var.live);
         } else {
             TString errorMsg = "Invalid shader In/Out variable semantic: ";
-            errorMsg += ent.symbol->getType().getQualifier().semanticName;
+            errorMsg += var.type->getQualifier().semanticName;
             infoSink.info.message(EPrefixInternalError, errorMsg.c_str());
             error = true;
         }
@@ -342,12 +329,151 @@ struct TResolverInOutAdaptor
     TIoMapResolver& resolver;
     TInfoSink&      infoSink;
     bool&           error;
-    TIntermediate&  intermediate;
 
 private:
     TResolverInOutAdaptor& operator=(TResolverInOutAdaptor&);
 };
 
+bool TIoMapResolverAdapter::resolve(std::vector<TIoMapStage>& stages, std::string& log)
+{
+    TInfoSink infoSink;
+    bool hadError = false;
+    for (TIoMapStage& stage : stages) {
+        TNotifyInOutAdaptor inOutNotify(stage.stage, resolver);
+        TNotifyUniformAdaptor uniformNotify(stage.stage, resolver);
+        TResolverUniformAdaptor uniformResolve(stage.stage, resolver, infoSink, hadError);
+        TResolverInOutAdaptor inOutResolve(stage.stage, resolver, infoSink, hadError);
+        resolver.beginNotifications(stage.stage);
+        std::for_each(stage.inputs.begin(), stage.inputs.end(), inOutNotify);
+        std::for_each(stage.outputs.begin(), stage.outputs.end(), inOutNotify);
+        std::for_each(stage.uniforms.begin(), stage.uniforms.end(), uniformNotify);
+        resolver.endNotifications(stage.stage);
+        resolver.beginResolve(stage.stage);
+        std::for_each(stage.inputs.begin(), stage.inputs.end(), inOutResolve);
+        std::for_each(stage.outputs.begin(), stage.outputs.end(), inOutResolve);
+        std::for_each(stage.uniforms.begin(), stage.uniforms.end(), uniformResolve);
+        resolver.endResolve(stage.stage);
+    }
+    log += infoSink.info.c_str();
+
+    return !hadError;
+}
+
+bool TIoMapLayoutRegistry::resolve(std::vector<TIoMapStage>& stages, std::string& log)
+{
+    const auto isResource = [](const TType& type) {
+        return type.getBasicType() == EbtSampler || type.getBasicType() == EbtBlock;
+    };
+    // precision doesn't change what a resource is bound to
+    const auto keyOf = [](const TIoMapVariable& var) {
+        return std::string(var.name) + " " + var.type->getCompleteString(false).c_str();
+    };
+
+    // bindings given in the shaders are never handed out
+    std::set<TSlot> given;
+    for (const TIoMapStage& stage : stages) {
+        for (const TIoMapVariable& var : stage.uniforms) {
+            const TQualifier& qualifier = var.type->getQualifier();
+            if (isResource(*var.type) && qualifier.hasBinding())
+                given.insert(TSlot(qualifier.hasSet() ? qualifier.layoutSet : 0, qualifier.layoutBinding));
+        }
+    }
+
+    // nor can one held for a resource be, so fail before assigning anything
+    bool clashed = false;
+    for (const TIoMapStage& stage : stages) {
+        for (const TIoMapVariable& var : stage.uniforms) {
+            if (! isResource(*var.type) || var.type->getQualifier().hasBinding() || ! var.live)
+                continue;
+
+            const auto assignment = assignments.find(keyOf(var));
+            if (assignment != assignments.end() && given.find(assignment->second) != given.end()) {
+                log += "ERROR: set " + std::to_string(assignment->second.first) +
+                       " binding " + std::to_string(assignment->second.second) +
+                       ", held for '" + var.name + "', is given to another resource in the shader\n";
+                clashed = true;
+            }
+        }
+    }
+    if (clashed)
+        return false;
+
+    taken.insert(given.begin(), given.end());
+    for (TIoMapStage& stage : stages) {
+        for (TIoMapVariable& var : stage.uniforms) {
+            const TQualifier& qualifier = var.type->getQualifier();
+            if (! isResource(*var.type) || qualifier.hasBinding() || ! var.live)
+                continue;
+
+            const std::string key = keyOf(var);
+            auto assignment = assignments.find(key);
+            if (assignment == assignments.end()) {
+                const int set = qualifier.hasSet() ? qualifier.layoutSet : 0;
+                int& binding = nextBinding[set];
+                while (taken.find(TSlot(set, binding)) != taken.end())
+                    ++binding;
+                assign(key, TSlot(set, binding));
+                assignment = assignments.find(key);
+            }
+            var.newSet = assignment->second.first;
+            var.newBinding = assignment->second.second;
+        }
+    }
+
+    return true;
+}
+
+void TIoMapLayoutRegistry::serialize(std::string& text) const
+{
+    text.clear();
+    for (const auto& assignment : assignments) {
+        text += std::to_string(assignment.second.first) + " " + std::to_string(assignment.second.second) + " " +
+                assignment.first + "\n";
+    }
+}
+
+bool TIoMapLayoutRegistry::deserialize(const std::string& text)
+{
+    // read it all before adding any of it
+    std::vector<std::pair<std::string, TSlot>> loaded;
+    std::set<TSlot> loadedSlots;
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t end = text.find('\n', position);
+        if (end == std::string::npos)
+            end = text.size();
+        const std::string line = text.substr(position, end - position);
+        position = end + 1;
+
+        int set;
+        int binding;
+        int keyStart = -1;
+        if (sscanf(line.c_str(), "%d %d %n", &set, &binding, &keyStart) != 2 || keyStart < 0 ||
+            keyStart >= (int)line.size() || set < 0 || binding < 0)
+            return false;
+
+        const std::string key = line.substr(keyStart);
+        const TSlot slot(set, binding);
+        const auto held = assignments.find(key);
+        if ((held != assignments.end() && held->second != slot) ||
+            (held == assignments.end() && taken.find(slot) != taken.end()) ||
+            ! loadedSlots.insert(slot).second)
+            return false;
+        loaded.push_back(std::make_pair(key, slot));
+    }
+
+    for (const auto& assignment : loaded)
+        assign(assignment.first, assignment.second);
+
+    return true;
+}
+
+bool TIoMapLayoutRegistry::assign(const std::string& key, TSlot slot)
+{
+    taken.insert(slot);
+    return assignments.insert(std::make_pair(key, slot)).second;
+}
+
 // Base class for shared TIoMapResolver services, used by several derivations.
 struct TDefaultIoResolverBase : public glslang::TIoMapResolver
 {
@@ -364,6 +490,7 @@ struct TDefaultIoResolverBase : public glslang::TIoMapResolver
     typedef std::vector<int> TSlotSet;
     typedef std::unordered_map<int, TSlotSet> TSlotSetMap;
     TSlotSetMap slots;
+    std::unordered_map<int, std::unordered_map<int, int>> nextFreeSlot;  // by set and base
 
     TSlotSet::iterator findSlot(int set, int slot)
     {
@@ -390,15 +517,18 @@ struct TDefaultIoResolverBase : public glslang::TIoMapResolver
 
     int getFreeSlot(int set, int base)
     {
-        TSlotSet::iterator at = findSlot(set, base);
-        if (at == slots[set].end())
-            return reserveSlot(set, base);
+        // Slots are only ever taken, so the first free one from 'base' can't
+        // move back: start looking where the last look from 'base' ended.
+        int& next = nextFreeSlot[set][base];
+        int slot = std::max(base, next);
+        TSlotSet::iterator at = findSlot(set, slot);
 
         // look in locksteps, if they not match, then there is a free slot
-        for (; at != slots[set].end(); ++at, ++base)
-            if (*at != base)
+        for (; at != slots[set].end(); ++at, ++slot)
+            if (*at != slot)
                 break;
-        return reserveSlot(set, base);
+        next = slot;
+        return reserveSlot(set, slot);
     }
 
     virtual bool validateBinding(EShLanguage /*stage*/, const char* /*name*/, const glslang::TType& type, bool /*is_live*/) override = 0;
@@ -677,6 +807,125 @@ protected:
 };
 
 
+// The variables of one stage being mapped.
+struct TStageVarMaps {
+    EShLanguage stage;
+    TIntermediate* intermediate;
+    TVarLiveMap inVarMap;
+    TVarLiveMap outVarMap;
+    TVarLiveMap uniformVarMap;
+};
+
+// Gather the in, out, and uniform variables of a stage, live and dead.
+//
+// Returns false if the input is too malformed to do this.
+static bool GatherVariables(TStageVarMaps& maps)
+{
+    TIntermediate& intermediate = *maps.intermediate;
+    if (intermediate.getNumEntryPoints() != 1 || intermediate.isRecursive())
+        return false;
+
+    TIntermNode* root = intermediate.getTreeRoot();
+    if (root == nullptr)
+        return false;
+
+    TVarGatherTraverser iter_binding_all(intermediate, true, maps.inVarMap, maps.outVarMap, maps.uniformVarMap);
+    TVarGatherTraverser iter_binding_live(intermediate, false, maps.inVarMap, maps.outVarMap, maps.uniformVarMap);
+
+    root->traverse(&iter_binding_all);
+    iter_binding_live.pushFunction(intermediate.getEntryPointMangledName().c_str());
+
+    while (!iter_binding_live.functions.empty()) {
+        TIntermNode* function = iter_binding_live.functions.back();
+        iter_binding_live.functions.pop_back();
+        function->traverse(&iter_binding_live);
+    }
+
+    SortAndMergeEntries(maps.inVarMap);
+    SortAndMergeEntries(maps.outVarMap);
+    SortAndMergeEntries(maps.uniformVarMap);
+
+    // sort entries by priority. see TVarEntryInfo::TOrderByPriority for info.
+    std::sort(maps.uniformVarMap.begin(), maps.uniformVarMap.end(), TVarEntryInfo::TOrderByPriority());
+
+    return true;
+}
+
+static void ToIoMapVariables(const TVarLiveMap& varMap, std::vector<TIoMapVariable>& variables)
+{
+    variables.reserve(varMap.size());
+    for (const TVarEntryInfo& ent : varMap) {
+        TIoMapVariable var = { ent.symbol->getName().c_str(), &ent.symbol->getType(), ent.live, -1, -1, -1, -1, -1 };
+        variables.push_back(var);
+    }
+}
+
+static bool FromIoMapVariables(const std::vector<TIoMapVariable>& variables, TVarLiveMap& varMap)
+{
+    if (variables.size() != varMap.size())
+        return false;
+
+    for (size_t v = 0; v < varMap.size(); ++v) {
+        varMap[v].newBinding = variables[v].newBinding;
+        varMap[v].newSet = variables[v].newSet;
+        varMap[v].newLocation = variables[v].newLocation;
+        varMap[v].newComponent = variables[v].newComponent;
+        varMap[v].newIndex = variables[v].newIndex;
+    }
+
+    return true;
+}
+
+// Have 'resolver' map the variables gathered for the stages in 'stageMaps',
+// and apply what it maps them to, unless that fails.  The bindings and sets
+// a successful resolve() gives the uniforms are range checked, unless
+// 'resolverChecksRanges', as TIoMapResolverAdapter does while resolving each
+// uniform.
+static bool ResolveAndApply(std::vector<TStageVarMaps>& stageMaps, TInfoSink& infoSink,
+                            TIoMapBatchResolver& resolver, bool resolverChecksRanges)
+{
+    std::vector<TIoMapStage> stages(stageMaps.size());
+    for (size_t s = 0; s < stageMaps.size(); ++s) {
+        stages[s].stage = stageMaps[s].stage;
+        ToIoMapVariables(stageMaps[s].inVarMap, stages[s].inputs);
+        ToIoMapVariables(stageMaps[s].outVarMap, stages[s].outputs);
+        ToIoMapVariables(stageMaps[s].uniformVarMap, stages[s].uniforms);
+    }
+
+    std::string log;
+    bool hadError = !resolver.resolve(stages, log);
+    infoSink.info << log.c_str();
+
+    if (stages.size() != stageMaps.size()) {
+        infoSink.info.message(EPrefixInternalError, "resolver changed the stages to map");
+        return false;
+    }
+    for (size_t s = 0; s < stageMaps.size(); ++s) {
+        if (!FromIoMapVariables(stages[s].inputs, stageMaps[s].inVarMap) ||
+            !FromIoMapVariables(stages[s].outputs, stageMaps[s].outVarMap) ||
+            !FromIoMapVariables(stages[s].uniforms, stageMaps[s].uniformVarMap)) {
+            infoSink.info.message(EPrefixInternalError, "resolver changed the variables to map");
+            return false;
+        }
+
+        if (! resolverChecksRanges && ! hadError) {
+            for (const TIoMapVariable& var : stages[s].uniforms) {
+                if (! CheckMappedRanges(var, infoSink))
+                    hadError = true;
+            }
+        }
+    }
+
+    if (!hadError) {
+        for (TStageVarMaps& maps : stageMaps) {
+            TVarSetTraverser iter_iomap(*maps.intermediate, maps.inVarMap, maps.outVarMap, maps.uniformVarMap);
+            maps.intermediate->getTreeRoot()->traverse(&iter_iomap);
+        }
+    }
+
+    return !hadError;
+}
+
 // Map I/O variables to provided offsets, and make bindings for
 // unbound but live variables.
 //
@@ -696,11 +945,10 @@ bool TIoMapper::addStage(EShLanguage stage, TIntermediate &intermediate, TInfoSi
         resolver == nullptr)
         return true;
 
-    if (intermediate.getNumEntryPoints() != 1 || intermediate.isRecursive())
-        return false;
-
-    TIntermNode* root = intermediate.getTreeRoot();
-    if (root == nullptr)
+    std::vector<TStageVarMaps> stageMaps(1);
+    stageMaps[0].stage = stage;
+    stageMaps[0].intermediate = &intermediate;
+    if (!GatherVariables(stageMaps[0]))
         return false;
 
     // if no resolver is provided, use the default resolver with the given shifts and auto map settings
@@ -730,46 +978,30 @@ bool TIoMapper::addStage(EShLanguage stage, TIntermediate &intermediate, TInfoSi
         resolver = resolverBase;
     }
 
-    TVarLiveMap inVarMap, outVarMap, uniformVarMap;
-    TVarGatherTraverser iter_binding_all(intermediate, true, inVarMap, outVarMap, uniformVarMap);
-    TVarGatherTraverser iter_binding_live(intermediate, false, inVarMap, outVarMap, uniformVarMap);
+    TIoMapResolverAdapter adapter(*resolver);
 
-    root->traverse(&iter_binding_all);
-    iter_binding_live.pushFunction(intermediate.getEntryPointMangledName().c_str());
-
-    while (!iter_binding_live.functions.empty()) {
-        TIntermNode* function = iter_binding_live.functions.back();
-        iter_binding_live.functions.pop_back();
-        function->traverse(&iter_binding_live);
-    }
-
-    // sort entries by priority. see TVarEntryInfo::TOrderByPriority for info.
-    std::sort(uniformVarMap.begin(), uniformVarMap.end(), TVarEntryInfo::TOrderByPriority());
-
-    bool hadError = false;
-    TNotifyInOutAdaptor inOutNotify(stage, *resolver);
-    TNotifyUniformAdaptor uniformNotify(stage, *resolver);
-    TResolverUniformAdaptor uniformResolve(stage, *resolver, infoSink, hadError, intermediate);
-    TResolverInOutAdaptor inOutResolve(stage, *resolver, infoSink, hadError, intermediate);
-    resolver->beginNotifications(stage);
-    std::for_each(inVarMap.begin(), inVarMap.end(), inOutNotify);
-    std::for_each(outVarMap.begin(), outVarMap.end(), inOutNotify);
-    std::for_each(uniformVarMap.begin(), uniformVarMap.end(), uniformNotify);
-    resolver->endNotifications(stage);
-    resolver->beginResolve(stage);
-    std::for_each(inVarMap.begin(), inVarMap.end(), inOutResolve);
-    std::for_each(outVarMap.begin(), outVarMap.end(), inOutResolve);
-    std::for_each(uniformVarMap.begin(), uniformVarMap.end(), uniformResolve);
-    resolver->endResolve(stage);
+    return ResolveAndApply(stageMaps, infoSink, adapter, true);
+}
 
-    if (!hadError) {
-        // sort by id again, so we can use lower bound to find entries
-        std::sort(uniformVarMap.begin(), uniformVarMap.end(), TVarEntryInfo::TOrderById());
-        TVarSetTraverser iter_iomap(intermediate, inVarMap, outVarMap, uniformVarMap);
-        root->traverse(&iter_iomap);
+// Map the I/O variables of all the stages with one call to a batch resolver.
+//
+// Returns false if the input is too malformed to do this.
+bool TIoMapper::addStages(TIntermediate* const intermediates[EShLangCount], TInfoSink& infoSink,
+                          TIoMapBatchResolver& resolver)
+{
+    std::vector<TStageVarMaps> stageMaps;
+    for (int s = 0; s < EShLangCount; ++s) {
+        if (intermediates[s] == nullptr)
+            continue;
+
+        stageMaps.push_back(TStageVarMaps());
+        stageMaps.back().stage = (EShLanguage)s;
+        stageMaps.back().intermediate = intermediates[s];
+        if (!GatherVariables(stageMaps.back()))
+            return false;
     }
 
-    return !hadError;
+    return ResolveAndApply(stageMaps, infoSink, resolver, false);
 }
 
 } // end namespace glslang
@@ -56,6 +56,8 @@ public:
 
     // grow the reflection stage by stage
     bool addStage(EShLanguage, TIntermediate&, TInfoSink&, TIoMapResolver*);
+    // map all the stages present in 'intermediates', indexed by stage, at once
+    bool addStages(TIntermediate* const intermediates[EShLangCount], TInfoSink&, TIoMapBatchResolver&);
 };
 
 } // end namespace glslang
@@ -47,6 +47,11 @@
 #include "localintermediate.h"
 #include "../Include/InfoSink.h"
 
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
 namespace glslang {
 
 //
@@ -229,36 +234,45 @@ void TIntermediate::mergeBodies(TInfoSink& infoSink, TIntermSequence& globals, c
 //
 void TIntermediate::mergeLinkerObjects(TInfoSink& infoSink, TIntermSequence& linkerObjects, const TIntermSequence& unitLinkerObjects)
 {
+    // Index the objects already there by name, in order, so each unit object
+    // finds its matches without scanning them all.
+    std::unordered_map<TString, std::vector<std::size_t>> objectsByName;
+    objectsByName.reserve(linkerObjects.size());
+    for (std::size_t linkObj = 0; linkObj < linkerObjects.size(); ++linkObj) {
+        TIntermSymbol* symbol = linkerObjects[linkObj]->getAsSymbolNode();
+        assert(symbol);
+        objectsByName[symbol->getName()].push_back(linkObj);
+    }
+
     // Error check and merge the linker objects (duplicates should not be created)
-    std::size_t initialNumLinkerObjects = linkerObjects.size();
     for (unsigned int unitLinkObj = 0; unitLinkObj < unitLinkerObjects.size(); ++unitLinkObj) {
-        bool merge = true;
-        for (std::size_t linkObj = 0; linkObj < initialNumLinkerObjects; ++linkObj) {
+        TIntermSymbol* unitSymbol = unitLinkerObjects[unitLinkObj]->getAsSymbolNode();
+        assert(unitSymbol);
+        auto matches = objectsByName.find(unitSymbol->getName());
+        if (matches == objectsByName.end()) {
+            linkerObjects.push_back(unitLinkerObjects[unitLinkObj]);
+            continue;
+        }
+
+        // filter out copy
+        for (std::size_t linkObj : matches->second) {
             TIntermSymbol* symbol = linkerObjects[linkObj]->getAsSymbolNode();
-            TIntermSymbol* unitSymbol = unitLinkerObjects[unitLinkObj]->getAsSymbolNode();
-            assert(symbol && unitSymbol);
-            if (symbol->getName() == unitSymbol->getName()) {
-                // filter out copy
-                merge = false;
-
-                // but if one has an initializer and the other does not, update
-                // the initializer
-                if (symbol->getConstArray().empty() && ! unitSymbol->getConstArray().empty())
-                    symbol->setConstArray(unitSymbol->getConstArray());
-
-                // Similarly for binding
-                if (! symbol->getQualifier().hasBinding() && unitSymbol->getQualifier().hasBinding())
-                    symbol->getQualifier().layoutBinding = unitSymbol->getQualifier().layoutBinding;
-
-                // Update implicit array sizes
-                mergeImplicitArraySizes(symbol->getWritableType(), unitSymbol->getType());
-
-                // Check for consistent types/qualification/initializers etc.
-                mergeErrorCheck(infoSink, *symbol, *unitSymbol, false);
-            }
+
+            // but if one has an initializer and the other does not, update
+            // the initializer
+            if (symbol->getConstArray().empty() && ! unitSymbol->getConstArray().empty())
+                symbol->setConstArray(unitSymbol->getConstArray());
+
+            // Similarly for binding
+            if (! symbol->getQualifier().hasBinding() && unitSymbol->getQualifier().hasBinding())
+                symbol->getWritableType().getQualifier().layoutBinding = unitSymbol->getQualifier().layoutBinding;
+
+            // Update implicit array sizes
+            mergeImplicitArraySizes(symbol->getWritableType(), unitSymbol->getType());
+
+            // Check for consistent types/qualification/initializers etc.
+            mergeErrorCheck(infoSink, *symbol, *unitSymbol, false);
         }
-        if (merge)
-            linkerObjects.push_back(unitLinkerObjects[unitLinkObj]);
     }
 }
 
@@ -517,85 +531,136 @@ void TIntermediate::finalCheck(TInfoSink& infoSink, bool keepUncalled)
     treeRoot->traverse(&finalLinkTraverser);
 }
 
+namespace {
+
 //
-// See if the call graph contains any static recursion, which is disallowed
-// by the specification.
+// The call graph indexed for its algorithms: each function name interned
+// once, as a number, with the calls each function makes.  Calls are numbered
+// in call-graph order.
 //
-void TIntermediate::checkCallGraphCycles(TInfoSink& infoSink)
-{
-    // Clear fields we'll use for this.
-    for (TGraph::iterator call = callGraph.begin(); call != callGraph.end(); ++call) {
-        call->visited = false;
-        call->currentPath = false;
-        call->errorGiven = false;
+class TCallIndex {
+public:
+    explicit TCallIndex(const std::list<TCall>& callGraph)
+    {
+        for (const TCall& call : callGraph) {
+            callers.push_back(intern(call.caller));
+            callees.push_back(intern(call.callee));
+            callsBy[callers.back()].push_back((int)calls.size());
+            calls.push_back(&call);
+        }
     }
 
-    //
-    // Loop, looking for a new connected subgraph.  One subgraph is handled per loop iteration.
-    //
+    // Return the number of a function, or -1 if it is in no call.
+    int find(const TString& name) const
+    {
+        auto function = functions.find(name);
+        return function == functions.end() ? -1 : function->second;
+    }
 
-    TCall* newRoot;
-    do {
-        // See if we have unvisited parts of the graph.
-        newRoot = 0;
-        for (TGraph::iterator call = callGraph.begin(); call != callGraph.end(); ++call) {
-            if (! call->visited) {
-                newRoot = &(*call);
-                break;
-            }
-        }
+    int numFunctions() const { return (int)callsBy.size(); }
+    int numCalls() const { return (int)calls.size(); }
 
-        // If not, we are done.
-        if (! newRoot)
-            break;
+    std::vector<const TCall*> calls;
+    std::vector<int> callers;               // function number of each call's caller
+    std::vector<int> callees;               // function number of each call's callee
+    std::vector<std::vector<int>> callsBy;  // numbers of the calls each function makes, in order
 
-        // Otherwise, we found a new subgraph, process it:
-        // See what all can be reached by this new root, and if any of
-        // that is recursive.  This is done by depth-first traversals, seeing
-        // if a new call is found that was already in the currentPath (a back edge),
-        // thereby detecting recursion.
-        std::list<TCall*> stack;
-        newRoot->currentPath = true; // currentPath will be true iff it is on the stack
-        stack.push_back(newRoot);
-        while (! stack.empty()) {
-            // get a caller
-            TCall* call = stack.back();
-
-            // Add to the stack just one callee.
-            // This algorithm always terminates, because only !visited and !currentPath causes a push
-            // and all pushes change currentPath to true, and all pops change visited to true.
-            TGraph::iterator child = callGraph.begin();
-            for (; child != callGraph.end(); ++child) {
-
-                // If we already visited this node, its whole subgraph has already been processed, so skip it.
-                if (child->visited)
-                    continue;
-
-                if (call->callee == child->caller) {
-                    if (child->currentPath) {
+protected:
+    int intern(const TString& name)
+    {
+        auto function = functions.insert(std::make_pair(name, numFunctions()));
+        if (function.second)
+            callsBy.push_back(std::vector<int>());
+
+        return function.first->second;
+    }
+
+    std::unordered_map<TString, int> functions;
+};
+
+} // end anonymous namespace
+
+//
+// See if the call graph contains any static recursion, which is disallowed
+// by the specification.
+//
+// This is Tarjan's strongly connected components algorithm, on the graph
+// whose nodes are the calls, where call A->B leads to each call B makes.
+// Recursion is a component with more than one call, or a call of a function
+// by itself.  The depth-first search takes roots and callees in call-graph
+// order, and each call found back on the current search path is reported,
+// once, as the recursion.
+//
+void TIntermediate::checkCallGraphCycles(TInfoSink& infoSink)
+{
+    TCallIndex index(callGraph);
+
+    std::vector<int> order(index.numCalls(), -1);      // when the search reached each call
+    std::vector<int> lowlink(index.numCalls());
+    std::vector<int> nextCallee(index.numCalls(), 0);  // of those the call's callee makes
+    std::vector<bool> currentPath(index.numCalls(), false);
+    std::vector<bool> onStack(index.numCalls(), false);
+    std::vector<bool> errorGiven(index.numCalls(), false);
+    std::vector<int> finishedCalls(index.numFunctions(), 0);  // calls of each function in a found component
+    std::vector<int> path;
+    std::vector<int> stack;
+    int count = 0;
+
+    const auto enter = [&](int call) {
+        order[call] = lowlink[call] = count++;
+        currentPath[call] = onStack[call] = true;
+        path.push_back(call);
+        stack.push_back(call);
+    };
+
+    for (int root = 0; root < index.numCalls(); ++root) {
+        if (order[root] >= 0)
+            continue;
+
+        enter(root);
+        while (! path.empty()) {
+            const int call = path.back();
+            const int callee = index.callees[call];
+            const std::vector<int>& calleeCalls = index.callsBy[callee];
+
+            // Look at the next call the callee makes, unless they are all done.
+            if (nextCallee[call] < (int)calleeCalls.size() && finishedCalls[callee] < (int)calleeCalls.size()) {
+                const int child = calleeCalls[nextCallee[call]++];
+                if (order[child] < 0)
+                    enter(child);
+                else if (onStack[child]) {
+                    lowlink[call] = std::min(lowlink[call], order[child]);
+                    if (currentPath[child] && ! errorGiven[child]) {
                         // Then, we found a back edge
-                        if (! child->errorGiven) {
-                            error(infoSink, "Recursion detected:");
-                            infoSink.info << "    " << call->callee << " calling " << child->callee << "\n";
-                            child->errorGiven = true;
-                            recursive = true;
-                        }
-                    } else {
-                        child->currentPath = true;
-                        stack.push_back(&(*child));
-                        break;
+                        error(infoSink, "Recursion detected:");
+                        infoSink.info << "    " << index.calls[call]->callee << " calling " << index.calls[child]->callee << "\n";
+                        errorGiven[child] = true;
                     }
                 }
+                continue;
             }
-            if (child == callGraph.end()) {
-                // no more callees, we bottomed out, never look at this node again
-                stack.back()->currentPath = false;
-                stack.back()->visited = true;
-                stack.pop_back();
-            }
-        }  // end while, meaning nothing left to process in this subtree
 
-    } while (newRoot);  // redundant loop check; should always exit via the 'break' above
+            // no more callees, we bottomed out
+            currentPath[call] = false;
+            path.pop_back();
+            if (! path.empty())
+                lowlink[path.back()] = std::min(lowlink[path.back()], lowlink[call]);
+
+            if (lowlink[call] == order[call]) {
+                int size = 0;
+                int member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    ++finishedCalls[index.callers[member]];
+                    ++size;
+                } while (member != call);
+                if (size > 1 || index.callers[call] == index.callees[call])
+                    recursive = true;
+            }
+        }
+    }
 }
 
 //
@@ -605,11 +670,7 @@ void TIntermediate::checkCallGraphCycles(TInfoSink& infoSink)
 //
 void TIntermediate::checkCallGraphBodies(TInfoSink& infoSink, bool keepUncalled)
 {
-    // Clear fields we'll use for this.
-    for (TGraph::iterator call = callGraph.begin(); call != callGraph.end(); ++call) {
-        call->visited = false;
-        call->calleeBodyPosition = -1;
-    }
+    TCallIndex index(callGraph);
 
     // The top level of the AST includes function definitions (bodies).
     // Compare these to function calls in the call graph.
@@ -617,51 +678,45 @@ void TIntermediate::checkCallGraphBodies(TInfoSink& infoSink, bool keepUncalled)
     // how to map the call-graph node to the location in the AST.
     TIntermSequence &functionSequence = getTreeRoot()->getAsAggregate()->getSequence();
     std::vector<bool> reachable(functionSequence.size(), true); // so that non-functions are reachable
+    std::vector<int> bodyPosition(index.numFunctions(), -1);
     for (int f = 0; f < (int)functionSequence.size(); ++f) {
         glslang::TIntermAggregate* node = functionSequence[f]->getAsAggregate();
         if (node && (node->getOp() == glslang::EOpFunction)) {
             if (node->getName().compare(getEntryPointMangledName().c_str()) != 0)
                 reachable[f] = false; // so that function bodies are unreachable, until proven otherwise
-            for (TGraph::iterator call = callGraph.begin(); call != callGraph.end(); ++call) {
-                if (call->callee == node->getName())
-                    call->calleeBodyPosition = f;
-            }
+            int function = index.find(node->getName());
+            if (function >= 0)
+                bodyPosition[function] = f;
         }
     }
 
-    // Start call-graph traversal by visiting the entry point nodes.
-    for (TGraph::iterator call = callGraph.begin(); call != callGraph.end(); ++call) {
-        if (call->caller.compare(getEntryPointMangledName().c_str()) == 0)
-            call->visited = true;
+    // Find every function the entry point reaches through the call graph.
+    std::vector<bool> called(index.numFunctions(), false);
+    std::vector<int> worklist;
+    int entryPoint = index.find(getEntryPointMangledName().c_str());
+    if (entryPoint >= 0) {
+        called[entryPoint] = true;
+        worklist.push_back(entryPoint);
     }
-
-    // Propagate 'visited' through the call-graph to every part of the graph it
-    // can reach (seeded with the entry-point setting above).
-    bool changed;
-    do {
-        changed = false;
-        for (auto call1 = callGraph.begin(); call1 != callGraph.end(); ++call1) {
-            if (call1->visited) {
-                for (TGraph::iterator call2 = callGraph.begin(); call2 != callGraph.end(); ++call2) {
-                    if (! call2->visited) {
-                        if (call1->callee == call2->caller) {
-                            changed = true;
-                            call2->visited = true;
-                        }
-                    }
-                }
+    while (! worklist.empty()) {
+        int caller = worklist.back();
+        worklist.pop_back();
+        for (int call : index.callsBy[caller]) {
+            if (! called[index.callees[call]]) {
+                called[index.callees[call]] = true;
+                worklist.push_back(index.callees[call]);
             }
         }
-    } while (changed);
+    }
 
-    // Any call-graph node set to visited but without a callee body is an error.
-    for (TGraph::iterator call = callGraph.begin(); call != callGraph.end(); ++call) {
-        if (call->visited) {
-            if (call->calleeBodyPosition == -1) {
+    // Any call made from a reached function but without a callee body is an error.
+    for (int call = 0; call < index.numCalls(); ++call) {
+        if (called[index.callers[call]]) {
+            if (bodyPosition[index.callees[call]] == -1) {
                 error(infoSink, "No function definition (body) found: ");
-                infoSink.info << "    " << call->callee << "\n";
+                infoSink.info << "    " << index.calls[call]->callee << "\n";
             } else
-                reachable[call->calleeBodyPosition] = true;
+                reachable[bodyPosition[index.callees[call]]] = true;
         }
     }
 
@@ -808,7 +863,7 @@ int TIntermediate::addUsedLocation(const TQualifier& qualifier, const TType& typ
         // check for collisions
         collision = checkLocationRange(set, range, type, typeCollision);
         if (collision < 0) {
-            usedIo[set].push_back(range);
+            addUsedIoRange(set, range);
 
             // Second range:
             TRange locationRange2(qualifier.layoutLocation + 1, qualifier.layoutLocation + 1);
@@ -818,7 +873,7 @@ int TIntermediate::addUsedLocation(const TQualifier& qualifier, const TType& typ
             // check for collisions
             collision = checkLocationRange(set, range2, type, typeCollision);
             if (collision < 0)
-                usedIo[set].push_back(range2);
+                addUsedIoRange(set, range2);
         }
     } else {
         // Not a dvec3 in/out split across two locations, generic path.
@@ -841,7 +896,7 @@ int TIntermediate::addUsedLocation(const TQualifier& qualifier, const TType& typ
             collision = checkLocationRange(set, range, type, typeCollision);
 
         if (collision < 0)
-            usedIo[set].push_back(range);
+            addUsedIoRange(set, range);
     }
 
     return collision;
@@ -854,18 +909,18 @@ int TIntermediate::addUsedLocation(const TQualifier& qualifier, const TType& typ
 //
 int TIntermediate::checkLocationRange(int set, const TIoRange& range, const TType& type, bool& typeCollision)
 {
-    for (size_t r = 0; r < usedIo[set].size(); ++r) {
-        if (range.overlap(usedIo[set][r])) {
-            // there is a collision; pick one
-            return std::max(range.location.start, usedIo[set][r].location.start);
-        } else if (range.location.overlap(usedIo[set][r].location) && type.getBasicType() != usedIo[set][r].basicType) {
-            // aliased-type mismatch
-            typeCollision = true;
-            return std::max(range.location.start, usedIo[set][r].location.start);
-        }
-    }
-
-    return -1; // no collision
+    // Of the ranges sharing a location, the first colliding, in the order they were added.
+    int r = usedIoIndex[set].findFirst(range.location, [&](int used) {
+        return range.overlap(usedIo[set][used]) || type.getBasicType() != usedIo[set][used].basicType;
+    });
+    if (r < 0)
+        return -1; // no collision
+
+    // there is a collision, or an aliased-type mismatch; pick one
+    if (! range.overlap(usedIo[set][r]))
+        typeCollision = true;
+
+    return std::max(range.location.start, usedIo[set][r].location.start);
 }
 
 // Accumulate bindings and offsets, and check for collisions
@@ -879,19 +934,44 @@ int TIntermediate::addUsedOffsets(int binding, int offset, int numOffsets)
     TRange offsetRange(offset, offset + numOffsets - 1);
     TOffsetRange range(bindingRange, offsetRange);
 
-    // check for collisions, except for vertex inputs on desktop
-    for (size_t r = 0; r < usedAtomics.size(); ++r) {
-        if (range.overlap(usedAtomics[r])) {
-            // there is a collision; pick one
-            return std::max(offset, usedAtomics[r].offset.start);
-        }
+    auto offsets = usedAtomicsIndex.find(binding);
+    int r = offsets == usedAtomicsIndex.end() ? -1 : offsets->second.findFirst(offsetRange, [](int) { return true; });
+    if (r >= 0) {
+        // there is a collision; pick one
+        return std::max(offset, usedAtomics[r].offset.start);
     }
 
-    usedAtomics.push_back(range);
+    addUsedOffsetRange(range);
 
     return -1; // no collision
 }
 
+// Record a used location range, indexing it for checkLocationRange().
+void TIntermediate::addUsedIoRange(int set, const TIoRange& range)
+{
+    usedIoIndex[set].add(range.location, (int)usedIo[set].size());
+    usedIo[set].push_back(range);
+}
+
+// Record a used offset range, indexing it for addUsedOffsets(); the binding
+// range is a single binding.
+void TIntermediate::addUsedOffsetRange(const TOffsetRange& range)
+{
+    usedAtomicsIndex[range.binding.start].add(range.offset, (int)usedAtomics.size());
+    usedAtomics.push_back(range);
+}
+
+// Forget all used location and offset ranges, and their indexes.
+void TIntermediate::clearUsedRanges()
+{
+    for (int set = 0; set < 4; ++set) {
+        usedIo[set].clear();
+        usedIoIndex[set] = TRangeIndex();
+    }
+    usedAtomics.clear();
+    usedAtomicsIndex.clear();
+}
+
 // Accumulate used constant_id values.
 //
 // Return false is one was already used.
@@ -41,6 +41,7 @@
 #include "Versions.h"
 
 #include <algorithm>
+#include <map>
 #include <set>
 
 class TInfoSink;
@@ -90,15 +91,12 @@ private:
 
 // Used for call-graph algorithms for detecting recursion, missing bodies, and dead bodies.
 // A "call" is a pair: <caller, callee>.
-// There can be duplicates. General assumption is the list is small.
+// There can be duplicates.  The algorithms index the list by function first
+// (see TCallIndex in linkValidate.cpp), so it can be large.
 struct TCall {
     TCall(const TString& pCaller, const TString& pCallee) : caller(pCaller), callee(pCallee) { }
     TString caller;
     TString callee;
-    bool visited;
-    bool currentPath;
-    bool errorGiven;
-    int calleeBodyPosition;
 };
 
 // A generic 1-D range.
@@ -112,6 +110,112 @@ struct TRange {
     int last;
 };
 
+// Finds which of a set of ranges overlap a given one, without looking at the
+// rest: an interval tree, kept as a treap ordered by start, where each node
+// also knows the greatest 'last' below it.  A subtree can then be skipped if
+// it ends before the given range, or starts after it.  Each range is added
+// with an id, e.g., its index in a list of ranges.
+class TRangeIndex {
+public:
+    TRangeIndex() : root(-1) { }
+
+    void add(const TRange& range, int id)
+    {
+        TNode node = { range, id, range.last, Priority(id), -1, -1 };
+        nodes.push_back(node);
+        root = insert(root, (int)nodes.size() - 1);
+    }
+    size_t size() const { return nodes.size(); }
+
+    // Return the lowest id of the ranges overlapping 'range' that 'accept'
+    // takes, or -1 if none.
+    template<class P>
+    int findFirst(const TRange& range, P accept) const
+    {
+        int first = -1;
+        findFirst(root, range, accept, first);
+
+        return first;
+    }
+
+protected:
+    struct TNode {
+        TRange range;
+        int id;
+        int maxLast;        // greatest range.last in this subtree
+        unsigned int priority;
+        int left;
+        int right;
+    };
+
+    // A well-mixed function of the id, so that adding ranges in order of
+    // start still gives a balanced tree.
+    static unsigned int Priority(int id)
+    {
+        unsigned int h = (unsigned int)id;
+        h = (h ^ (h >> 16)) * 0x45d9f3bu;
+        h = (h ^ (h >> 16)) * 0x45d9f3bu;
+        return h ^ (h >> 16);
+    }
+
+    void update(int n)
+    {
+        TNode& node = nodes[n];
+        node.maxLast = node.range.last;
+        if (node.left >= 0)
+            node.maxLast = std::max(node.maxLast, nodes[node.left].maxLast);
+        if (node.right >= 0)
+            node.maxLast = std::max(node.maxLast, nodes[node.right].maxLast);
+    }
+
+    // Insert node 'added' into the subtree at 'n', returning the subtree's new root.
+    int insert(int n, int added)
+    {
+        if (n < 0)
+            return added;
+
+        int top = n;
+        if (nodes[added].range.start < nodes[n].range.start) {
+            nodes[n].left = insert(nodes[n].left, added);
+            if (nodes[nodes[n].left].priority > nodes[n].priority) {
+                top = nodes[n].left;
+                nodes[n].left = nodes[top].right;
+                nodes[top].right = n;
+            }
+        } else {
+            nodes[n].right = insert(nodes[n].right, added);
+            if (nodes[nodes[n].right].priority > nodes[n].priority) {
+                top = nodes[n].right;
+                nodes[n].right = nodes[top].left;
+                nodes[top].left = n;
+            }
+        }
+        update(n);
+        if (top != n)
+            update(top);
+
+        return top;
+    }
+
+    template<class P>
+    void findFirst(int n, const TRange& range, P& accept, int& first) const
+    {
+        if (n < 0 || nodes[n].maxLast < range.start)
+            return;
+
+        const TNode& node = nodes[n];
+        findFirst(node.left, range, accept, first);
+        if (node.range.start > range.last)
+            return; // so does all of the right subtree
+        if (node.range.last >= range.start && (first < 0 || node.id < first) && accept(node.id))
+            first = node.id;
+        findFirst(node.right, range, accept, first);
+    }
+
+    std::vector<TNode> nodes;
+    int root;
+};
+
 // An IO range is a 3-D rectangle; the set of (location, component, index) triples all lying
 // within the same location range, component range, and index value.  Locations don't alias unless
 // all other dimensions of their range overlap.
@@ -234,6 +338,7 @@ public:
         hlslOffsets(false),
         useStorageBuffer(false),
         hlslIoMapping(false),
+        inlineBudget(64),
         textureSamplerTransformMode(EShTexSampTransKeep),
         needToLegalize(false)
     {
@@ -251,6 +356,10 @@ public:
     void output(TInfoSink&, bool tree);
     void removeTree();
 
+    // Compact binary form of everything parsing produced (in intermSerialize.cpp)
+    bool serialize(std::vector<unsigned char>&) const;
+    bool deserialize(const unsigned char*, size_t);
+
     void setSource(EShSource s) { source = s; }
     EShSource getSource() const { return source; }
     void setEntryPointName(const char* ep)
@@ -460,6 +569,9 @@ public:
 
     // Tree ops
     static const TIntermTyped* findLValueBase(const TIntermTyped*, bool swizzleOkay);
+    static bool isPureOperator(TOperator);
+    static bool isPure(TIntermNode*);
+    int getMaxSymbolId() const;
 
     // Linkage related
     void addSymbolLinkageNodes(TIntermAggregate*& linkage, EShLanguage, TSymbolTable&);
@@ -563,6 +675,11 @@ public:
     void addToCallGraph(TInfoSink&, const TString& caller, const TString& callee);
     void merge(TInfoSink&, TIntermediate&);
     void finalCheck(TInfoSink&, bool keepUncalled);
+    void eliminateDeadCode(bool keepUncalled);
+    void numberValues();
+    void inlineFunctions(bool keepUncalled);
+    void setInlineBudget(int nodes) { inlineBudget = nodes; }
+    int getInlineBudget() const { return inlineBudget; }
 
     void addIoAccessed(const TString& name) { ioAccessed.insert(name); }
     bool inIoAccessed(const TString& name) const { return ioAccessed.find(name) != ioAccessed.end(); }
@@ -626,7 +743,12 @@ protected:
     void mergeErrorCheck(TInfoSink&, const TIntermSymbol&, const TIntermSymbol&, bool crossStage);
     void checkCallGraphCycles(TInfoSink&);
     void checkCallGraphBodies(TInfoSink&, bool keepUncalled);
+    void eliminateDeadStores();
+    bool eliminateUncalledFunctions();
     void inOutLocationCheck(TInfoSink&);
+    void addUsedIoRange(int set, const TIoRange&);
+    void addUsedOffsetRange(const TOffsetRange&);
+    void clearUsedRanges();
     TIntermSequence& findLinkerObjects() const;
     bool userOutputUsed() const;
     bool isSpecializationOperation(const TIntermOperator&) const;
@@ -692,13 +814,17 @@ protected:
     bool hlslOffsets;
     bool useStorageBuffer;
     bool hlslIoMapping;
+    int inlineBudget;
 
     typedef std::list<TCall> TGraph;
     TGraph callGraph;
 
     std::set<TString> ioAccessed;           // set of names of statically read/written I/O that might need extra checking
+    // usedIo and usedAtomics only change through addUsed*Range() and clearUsedRanges(), which keep their indexes
     std::vector<TIoRange> usedIo[4];        // sets of used locations, one for each of in, out, uniform, and buffers
     std::vector<TOffsetRange> usedAtomics;  // sets of bindings used by atomic counters
+    TRangeIndex usedIoIndex[4];             // location ranges of usedIo, by index
+    std::map<int, TRangeIndex> usedAtomicsIndex;  // offset ranges of usedAtomics per binding, by index
     std::vector<TXfbBuffer> xfbBuffers;     // all the data we need to track per xfb buffer
     std::unordered_set<int> usedConstantId; // specialization constant ids used
     std::set<TString> semanticNameSet;
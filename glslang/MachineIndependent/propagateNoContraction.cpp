@@ -272,7 +272,7 @@ TSymbolDefinitionCollectingTraverser::TSymbolDefinitionCollectingTraverser(
     NodeMapping* symbol_definition_mapping, AccessChainMapping* accesschain_mapping,
     ObjectAccesschainSet* precise_objects,
     std::unordered_set<glslang::TIntermBranch*>* precise_return_nodes)
-    : TIntermTraverser(true, false, false), symbol_definition_mapping_(*symbol_definition_mapping),
+    : TIntermTraverser(true, true, true), symbol_definition_mapping_(*symbol_definition_mapping),
       precise_objects_(*precise_objects), precise_return_nodes_(*precise_return_nodes),
       current_object_(), accesschain_mapping_(*accesschain_mapping),
       current_function_definition_node_(nullptr) {}
@@ -326,11 +326,17 @@ bool TSymbolDefinitionCollectingTraverser::visitBranch(glslang::TVisit,
 }
 
 // Visits a unary node. This might be an implicit assignment like i++, i--. etc.
-bool TSymbolDefinitionCollectingTraverser::visitUnary(glslang::TVisit /* visit */,
+// The operand is left to the traverser (between the pre-visit and the post-visit),
+// rather than traversed here, so long chains of nodes don't need deep recursion.
+bool TSymbolDefinitionCollectingTraverser::visitUnary(glslang::TVisit visit,
                                                       glslang::TIntermUnary* node)
 {
-    current_object_.clear();
-    node->getOperand()->traverse(this);
+    if (visit == glslang::EvPreVisit) {
+        // Traverses the operand node to build the access chain info for the object.
+        current_object_.clear();
+        return true;
+    }
+
     if (isAssignOperation(node->getOp())) {
         // We should always be able to get an access chain of the operand node.
         assert(!current_object_.empty());
@@ -356,12 +362,18 @@ bool TSymbolDefinitionCollectingTraverser::visitUnary(glslang::TVisit /* visit *
 
 // Visits a binary node and updates the mapping from symbol IDs to the definition
 // nodes. Also collects the access chains for the initial precise objects.
-bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit /* visit */,
+// As with unary nodes, the children are traversed by the traverser: the left node
+// after the pre-visit, and the right node (if wanted) after the in-visit.
+bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit visit,
                                                        glslang::TIntermBinary* node)
 {
-    // Traverses the left node to build the access chain info for the object.
-    current_object_.clear();
-    node->getLeft()->traverse(this);
+    if (visit == glslang::EvPreVisit) {
+        // Traverses the left node to build the access chain info for the object.
+        current_object_.clear();
+        return true;
+    }
+    if (visit == glslang::EvPostVisit)
+        return true;
 
     if (isAssignOperation(node->getOp())) {
         // We should always be able to get an access chain for the left node.
@@ -385,7 +397,7 @@ bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit /* visit
         // Traverses the right node, there may be other 'assignment'
         // operations in the right.
         current_object_.clear();
-        node->getRight()->traverse(this);
+        return true;
 
     } else if (isDereferenceOperation(node->getOp())) {
         // The left node (parent node) is a struct type object. We need to
@@ -404,7 +416,7 @@ bool TSymbolDefinitionCollectingTraverser::visitBinary(glslang::TVisit /* visit
     } else {
         // For other binary nodes, still traverse the right node.
         current_object_.clear();
-        node->getRight()->traverse(this);
+        return true;
     }
     return false;
 }
@@ -39,6 +39,9 @@
 #include "localintermediate.h"
 
 #include "gl_types.h"
+#include "../Public/ReflectionFormat.h"
+
+#include <cstdio>
 
 //
 // Grow the reflection database through a friend traverser class of TReflection and a
@@ -105,9 +108,8 @@ public:
             const TString &name = base.getName();
             const TType &type = base.getType();
 
-            TReflection::TNameToIndex::const_iterator it = reflection.nameToIndex.find(name);
-            if (it == reflection.nameToIndex.end()) {
-                reflection.nameToIndex[name] = (int)reflection.indexToAttribute.size();
+            if (reflection.getIndex(name) < 0) {
+                reflection.addName(name, (int)reflection.indexToAttribute.size());
                 reflection.indexToAttribute.push_back(TObjectReflection(name, type, 0, mapToGlType(type), 0, 0));
             }
         }
@@ -245,14 +247,14 @@ public:
         if (arraySize == 0)
             arraySize = mapToGlArraySize(*terminalType);
 
-        TReflection::TNameToIndex::const_iterator it = reflection.nameToIndex.find(name);
-        if (it == reflection.nameToIndex.end()) {
-            reflection.nameToIndex[name] = (int)reflection.indexToUniform.size();
+        const int uniformIndex = reflection.getIndex(name);
+        if (uniformIndex < 0) {
+            reflection.addName(name, (int)reflection.indexToUniform.size());
             reflection.indexToUniform.push_back(TObjectReflection(name, *terminalType, offset,
                                                                   mapToGlType(*terminalType),
                                                                   arraySize, blockIndex));
         } else if (arraySize > 1) {
-            int& reflectedArraySize = reflection.indexToUniform[it->second].size;
+            int& reflectedArraySize = reflection.indexToUniform[uniformIndex].size;
             reflectedArraySize = std::max(arraySize, reflectedArraySize);
         }
     }
@@ -347,14 +349,12 @@ public:
 
     int addBlockName(const TString& name, const TType& type, int size)
     {
-        int blockIndex;
-        TReflection::TNameToIndex::const_iterator it = reflection.nameToIndex.find(name);
-        if (reflection.nameToIndex.find(name) == reflection.nameToIndex.end()) {
+        int blockIndex = reflection.getIndex(name);
+        if (blockIndex < 0) {
             blockIndex = (int)reflection.indexToUniformBlock.size();
-            reflection.nameToIndex[name] = blockIndex;
+            reflection.addName(name, blockIndex);
             reflection.indexToUniformBlock.push_back(TObjectReflection(name, type, -1, -1, size, -1));
-        } else
-            blockIndex = it->second;
+        }
 
         return blockIndex;
     }
@@ -786,8 +786,110 @@ void TReflection::dump()
 
     // printf("Live names\n");
     // for (TNameToIndex::const_iterator it = nameToIndex.begin(); it != nameToIndex.end(); ++it)
-    //    printf("%s: %d\n", it->first.c_str(), it->second);
+    //    printf("%.*s: %d\n", (int)it->first.length, it->first.chars, it->second);
     // printf("\n");
 }
 
+namespace {
+
+void GetRecords(std::vector<TReflectionRecord>& records, const std::vector<TObjectReflection>& table)
+{
+    records.clear();
+    records.reserve(table.size());
+    for (const TObjectReflection& object : table) {
+        TReflectionRecord record = { object.name.c_str(), object.offset, object.glDefineType, object.size,
+                                     object.index, object.counterIndex, object.getBinding(), object.getSet() };
+        records.push_back(record);
+    }
+}
+
+void PutWord(std::vector<unsigned char>& binary, unsigned int word)
+{
+    for (int byte = 0; byte < 4; ++byte)
+        binary.push_back((unsigned char)(word >> (8 * byte)));
+}
+
+void PutTable(std::vector<unsigned char>& binary, const std::vector<TObjectReflection>& table)
+{
+    PutWord(binary, (unsigned int)table.size());
+    for (const TObjectReflection& object : table) {
+        PutWord(binary, (unsigned int)object.name.size());
+        binary.insert(binary.end(), object.name.begin(), object.name.end());
+        binary.resize((binary.size() + 3) / 4 * 4, 0);
+        PutWord(binary, object.offset);
+        PutWord(binary, object.glDefineType);
+        PutWord(binary, object.size);
+        PutWord(binary, object.index);
+        PutWord(binary, object.counterIndex);
+        PutWord(binary, object.getBinding());
+        PutWord(binary, object.getSet());
+    }
+}
+
+void PutJsonTable(std::string& json, const char* tableName, const std::vector<TObjectReflection>& table)
+{
+    json += ",\n  \"";
+    json += tableName;
+    json += "\": [";
+    for (size_t i = 0; i < table.size(); ++i) {
+        const TObjectReflection& object = table[i];
+        json += i == 0 ? "\n    { \"name\": \"" : ",\n    { \"name\": \"";
+        for (char c : object.name) {
+            if (c == '"' || c == '\\') {
+                json += '\\';
+                json += c;
+            } else if ((unsigned char)c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                json += escaped;
+            } else
+                json += c;
+        }
+
+        char fields[256];
+        snprintf(fields, sizeof(fields),
+                 "\", \"offset\": %d, \"glDefineType\": %d, \"size\": %d, \"index\": %d, "
+                 "\"counterIndex\": %d, \"binding\": %d, \"set\": %d }",
+                 object.offset, object.glDefineType, object.size, object.index, object.counterIndex,
+                 object.getBinding(), object.getSet());
+        json += fields;
+    }
+    json += table.empty() ? "]" : "\n  ]";
+}
+
+} // end anonymous namespace
+
+void TReflection::getRecords(TReflectionRecords& records) const
+{
+    for (int dim = 0; dim < 3; ++dim)
+        records.localSize[dim] = localSize[dim];
+    GetRecords(records.uniforms, indexToUniform);
+    GetRecords(records.uniformBlocks, indexToUniformBlock);
+    GetRecords(records.attributes, indexToAttribute);
+}
+
+void TReflection::serialize(std::vector<unsigned char>& binary) const
+{
+    binary.clear();
+    PutWord(binary, ReflectionMagic);
+    PutWord(binary, ReflectionVersion);
+    for (int dim = 0; dim < 3; ++dim)
+        PutWord(binary, localSize[dim]);
+    PutTable(binary, indexToUniform);
+    PutTable(binary, indexToUniformBlock);
+    PutTable(binary, indexToAttribute);
+}
+
+void TReflection::serializeJson(std::string& json) const
+{
+    char header[128];
+    snprintf(header, sizeof(header), "{\n  \"version\": %u,\n  \"localSize\": [%u, %u, %u]",
+             ReflectionVersion, localSize[0], localSize[1], localSize[2]);
+    json = header;
+    PutJsonTable(json, "uniforms", indexToUniform);
+    PutJsonTable(json, "uniformBlocks", indexToUniformBlock);
+    PutJsonTable(json, "attributes", indexToAttribute);
+    json += "\n}\n";
+}
+
 } // end namespace glslang
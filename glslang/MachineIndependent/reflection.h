@@ -39,8 +39,11 @@
 #include "../Public/ShaderLang.h"
 #include "../Include/Types.h"
 
+#include <cstring>
+#include <deque>
 #include <list>
 #include <set>
+#include <unordered_map>
 
 //
 // A reflection database and its interface, consistent with the OpenGL API reflection queries.
@@ -66,6 +69,12 @@ public:
             return -1;
         return type->getQualifier().layoutBinding;
     }
+    int getSet() const
+    {
+        if (type == nullptr || !type->getQualifier().hasSet())
+            return -1;
+        return type->getQualifier().layoutSet;
+    }
     void dump() const
     {
         printf("%s: offset %d, type %x, size %d, index %d, binding %d",
@@ -91,6 +100,33 @@ protected:
     const TType* type;
 };
 
+// A name held elsewhere, as the key of TReflection's name index, so looking
+// up a 'const char*' needs no TString made from it.
+struct TNameKey {
+    TNameKey(const char* chars, size_t length) : chars(chars), length(length) { }
+    bool operator==(const TNameKey& other) const
+    {
+        return length == other.length && memcmp(chars, other.chars, length) == 0;
+    }
+
+    const char* chars;
+    size_t length;
+};
+
+// The same FNV-1a hash as std::hash<TString>
+struct TNameKeyHash {
+    size_t operator()(const TNameKey& key) const
+    {
+        unsigned hash = 2166136261U;
+        for (size_t c = 0; c < key.length; ++c) {
+            hash ^= (unsigned)key.chars[c];
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+};
+
 // The full reflection database
 class TReflection {
 public:
@@ -136,40 +172,60 @@ public:
     }
 
     // for mapping any name to its index (block names, uniform names and attribute names)
-    int getIndex(const char* name) const
-    {
-        TNameToIndex::const_iterator it = nameToIndex.find(name);
-        if (it == nameToIndex.end())
-            return -1;
-        else
-            return it->second;
-    }
+    int getIndex(const char* name) const { return getIndex(TNameKey(name, strlen(name))); }
 
     // see getIndex(const char*)
-    int getIndex(const TString& name) const { return getIndex(name.c_str()); }
+    int getIndex(const TString& name) const { return getIndex(TNameKey(name.c_str(), name.size())); }
 
     // Thread local size
     unsigned getLocalSize(int dim) const { return dim <= 2 ? localSize[dim] : 0; }
 
     void dump();
 
+    // Copy the database out as ../Public/ReflectionFormat.h records, or save it
+    // in the forms described there
+    void getRecords(TReflectionRecords& records) const;
+    void serialize(std::vector<unsigned char>& binary) const;
+    void serializeJson(std::string& json) const;
+
 protected:
     friend class glslang::TReflectionTraverser;
 
     void buildCounterIndices();
     void buildAttributeReflection(EShLanguage, const TIntermediate&);
 
-    // Need a TString hash: typedef std::unordered_map<TString, int> TNameToIndex;
-    typedef std::map<TString, int> TNameToIndex;
+    int getIndex(const TNameKey& name) const
+    {
+        TNameToIndex::const_iterator it = nameToIndex.find(name);
+        if (it == nameToIndex.end())
+            return -1;
+        else
+            return it->second;
+    }
+
+    // Map 'name', not yet mapped, to 'index'.
+    void addName(const TString& name, int index)
+    {
+        names.push_back(name);
+        nameToIndex[TNameKey(names.back().c_str(), names.back().size())] = index;
+    }
+
+    typedef std::unordered_map<TNameKey, int, TNameKeyHash> TNameToIndex;
     typedef std::vector<TObjectReflection> TMapIndexToReflection;
 
     TObjectReflection badReflection; // return for queries of -1 or generally out of range; has expected descriptions with in it for this
+    std::deque<TString> names;       // the names the keys of nameToIndex point into; a deque doesn't move them
     TNameToIndex nameToIndex;        // maps names to indexes; can hold all types of data: uniform/buffer and which function names have been processed
     TMapIndexToReflection indexToUniform;
     TMapIndexToReflection indexToUniformBlock;
     TMapIndexToReflection indexToAttribute;
 
     unsigned int localSize[3];
+
+private:
+    // not copyable: the keys of nameToIndex point into this object's own 'names'
+    TReflection(TReflection&);
+    TReflection& operator=(TReflection&);
 };
 
 } // end namespace glslang
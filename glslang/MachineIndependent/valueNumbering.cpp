@@ -0,0 +1,596 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "localintermediate.h"
+
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+//
+// Local value numbering on the AST of a linked stage, so code generation
+// computes a repeated expression just once.  Asked for through
+// EShMsgValueNumbering.
+//
+// Function bodies are cut into blocks: runs of statements that store a pure
+// expression to an l-value, or just compute one.  Anything else (control
+// flow, calls, other side effects) ends the block.  Within a block, each pure
+// subexpression gets a number, the same for expressions computing the same
+// value: the same operator, type, precision, and 'noContraction' on operands
+// with the same numbers.  A read of a variable gets a new number after each
+// store to it.  A number that occurs often enough to pay for a temporary is
+// computed into one, before the statement of its first occurrence, and all
+// its occurrences read that temporary instead.
+//
+// 'noContraction' is already propagated from 'precise' variables to the
+// operations computing them (see propagateNoContraction.cpp), so operations
+// that must not be contracted never share a number with those that may be.
+//
+// Only variables nothing else writes are numbered; not buffer or shared
+// memory, outputs, or anything volatile or coherent.  Nor is anything under
+// ?:, &&, or ||, as it isn't always computed.
+//
+
+namespace glslang {
+
+namespace {
+
+typedef std::vector<long long> TValueKey;
+
+// What is known about a value number in the current block.
+struct TValue {
+    int count;                  // occurrences, less those inside others computed into a temporary
+    int size;                   // roughly, instructions computing it
+    bool candidate;             // could be computed into a temporary
+    TIntermSymbol* temporary;   // the temporary it is computed into, if any
+};
+
+// A statement of the current block: its statement list and index.
+struct TBlockStatement {
+    TIntermAggregate* list;
+    size_t index;
+};
+
+// Temporaries to insert into a statement list, before the statement at 'index'.
+struct TInsertion {
+    size_t index;
+    TIntermSequence statements;
+};
+
+class TValueNumbering;
+
+// Numbers the nodes of an expression, bottom up.
+class TNumberTraverser : public TIntermTraverser {
+public:
+    TNumberTraverser(TValueNumbering& numbering) : TIntermTraverser(true, false, true), numbering(numbering) { }
+
+    void visitSymbol(TIntermSymbol*) override;
+    void visitConstantUnion(TIntermConstantUnion*) override;
+    bool visitBinary(TVisit, TIntermBinary*) override;
+    bool visitUnary(TVisit, TIntermUnary*) override;
+    bool visitAggregate(TVisit, TIntermAggregate*) override;
+    bool visitSelection(TVisit, TIntermSelection*) override { return false; }
+
+protected:
+    TValueNumbering& numbering;
+};
+
+// Replaces occurrences of values computed into temporaries, top down.
+class TReplaceTraverser : public TIntermTraverser {
+public:
+    TReplaceTraverser(TValueNumbering& numbering) : numbering(numbering) { }
+
+    bool visitBinary(TVisit, TIntermBinary*) override;
+    bool visitUnary(TVisit, TIntermUnary*) override;
+    bool visitAggregate(TVisit, TIntermAggregate*) override;
+    bool visitSelection(TVisit, TIntermSelection*) override { return false; }
+
+protected:
+    TValueNumbering& numbering;
+};
+
+// Lists the value numbers of the nodes under a node.
+class TNumberListTraverser : public TIntermTraverser {
+public:
+    TNumberListTraverser(const std::unordered_map<const TIntermNode*, int>& nodeNumbers, const TIntermNode* root,
+                         std::vector<int>& numbers) :
+        nodeNumbers(nodeNumbers), root(root), numbers(numbers) { }
+
+    void visitSymbol(TIntermSymbol* node) override { add(node); }
+    void visitConstantUnion(TIntermConstantUnion* node) override { add(node); }
+    bool visitBinary(TVisit, TIntermBinary* node) override { add(node); return true; }
+    bool visitUnary(TVisit, TIntermUnary* node) override { add(node); return true; }
+    bool visitAggregate(TVisit, TIntermAggregate* node) override { add(node); return true; }
+
+protected:
+    void add(const TIntermNode* node)
+    {
+        auto it = nodeNumbers.find(node);
+        if (node != root && it != nodeNumbers.end())
+            numbers.push_back(it->second);
+    }
+
+    const std::unordered_map<const TIntermNode*, int>& nodeNumbers;
+    const TIntermNode* root;
+    std::vector<int>& numbers;
+};
+
+// Whether values of this type can be numbered, and kept in a temporary.
+bool IsNumberableType(const TType& type)
+{
+    if (type.isArray() || type.isStruct() || type.isOpaque())
+        return false;
+
+    switch (type.getBasicType()) {
+    case EbtVoid:
+    case EbtString:
+    case EbtBlock:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// Whether reads of a variable can be numbered: nothing writes it but the
+// stores in the function.
+bool IsNumberableVariable(const TIntermSymbol* symbol)
+{
+    const TQualifier& qualifier = symbol->getQualifier();
+    if (qualifier.volatil || qualifier.coherent)
+        return false;
+
+    switch (qualifier.storage) {
+    case EvqBuffer:
+        return qualifier.readonly;
+    case EvqShared:
+    case EvqVaryingOut:
+    case EvqFragColor:
+    case EvqFragDepth:
+        return false;
+    default:
+        return true;
+    }
+}
+
+void AddTypeKey(TValueKey& key, const TType& type)
+{
+    key.push_back(type.getBasicType());
+    key.push_back(type.getVectorSize());
+    key.push_back(type.getMatrixCols());
+    key.push_back(type.getMatrixRows());
+    key.push_back(type.getQualifier().precision);
+}
+
+//
+// The numbering of a whole tree; see the top of the file.
+//
+class TValueNumbering {
+public:
+    TValueNumbering(TIntermediate& intermediate, int maxId) :
+        intermediate(intermediate), nextId(maxId + 1), numberTraverser(*this), replaceTraverser(*this) { }
+
+    void numberFunction(TIntermAggregate* function);
+    void insertTemporaries();
+
+    void numberSymbol(TIntermSymbol*);
+    void numberConstant(TIntermConstantUnion*);
+    void numberOperation(TIntermOperator*, const TIntermSequence& operands);
+    TIntermTyped* replace(TIntermTyped*);
+
+protected:
+    void numberList(TIntermAggregate*);
+    void numberBody(TIntermNode*);
+    bool addStatement(TIntermAggregate* list, size_t index);
+    void endBlock();
+    int addValue(const TValueKey&, int size, bool candidate);
+    TIntermSymbol* newRead(const TIntermSymbol* temporary, const TSourceLoc&) const;
+
+    TIntermediate& intermediate;
+    int nextId;
+    TNumberTraverser numberTraverser;
+    TReplaceTraverser replaceTraverser;
+
+    std::unordered_map<int, int> versions;   // stores so far to each variable
+
+    // the current block
+    std::vector<TBlockStatement> block;
+    std::map<TValueKey, int> numbers;
+    std::vector<TValue> values;
+    std::unordered_map<const TIntermNode*, int> nodeNumbers;
+    TIntermSequence temporaries;   // computed before the statement being replaced in
+
+    std::unordered_map<TIntermAggregate*, std::vector<TInsertion>> insertions;
+};
+
+void TNumberTraverser::visitSymbol(TIntermSymbol* node)
+{
+    numbering.numberSymbol(node);
+}
+
+void TNumberTraverser::visitConstantUnion(TIntermConstantUnion* node)
+{
+    numbering.numberConstant(node);
+}
+
+bool TNumberTraverser::visitBinary(TVisit visit, TIntermBinary* node)
+{
+    // The right side isn't always computed.
+    if (node->getOp() == EOpLogicalAnd || node->getOp() == EOpLogicalOr)
+        return false;
+
+    if (visit == EvPostVisit) {
+        TIntermSequence operands;
+        operands.push_back(node->getLeft());
+        operands.push_back(node->getRight());
+        numbering.numberOperation(node, operands);
+    }
+
+    return true;
+}
+
+bool TNumberTraverser::visitUnary(TVisit visit, TIntermUnary* node)
+{
+    if (visit == EvPostVisit) {
+        TIntermSequence operands;
+        operands.push_back(node->getOperand());
+        numbering.numberOperation(node, operands);
+    }
+
+    return true;
+}
+
+bool TNumberTraverser::visitAggregate(TVisit visit, TIntermAggregate* node)
+{
+    if (visit == EvPostVisit)
+        numbering.numberOperation(node, node->getSequence());
+
+    return true;
+}
+
+bool TReplaceTraverser::visitBinary(TVisit, TIntermBinary* node)
+{
+    node->setLeft(numbering.replace(node->getLeft()));
+    node->setRight(numbering.replace(node->getRight()));
+
+    return false;
+}
+
+bool TReplaceTraverser::visitUnary(TVisit, TIntermUnary* node)
+{
+    node->setOperand(numbering.replace(node->getOperand()));
+
+    return false;
+}
+
+bool TReplaceTraverser::visitAggregate(TVisit, TIntermAggregate* node)
+{
+    for (TIntermNode*& operand : node->getSequence()) {
+        if (operand && operand->getAsTyped())
+            operand = numbering.replace(operand->getAsTyped());
+    }
+
+    return false;
+}
+
+int TValueNumbering::addValue(const TValueKey& key, int size, bool candidate)
+{
+    auto it = numbers.find(key);
+    if (it == numbers.end()) {
+        TValue value = { 0, size, candidate, nullptr };
+        values.push_back(value);
+        it = numbers.insert(std::make_pair(key, (int)values.size() - 1)).first;
+    }
+    ++values[it->second].count;
+
+    return it->second;
+}
+
+void TValueNumbering::numberSymbol(TIntermSymbol* node)
+{
+    if (! IsNumberableVariable(node))
+        return;
+
+    TValueKey key;
+    key.push_back('s');
+    key.push_back(node->getId());
+    key.push_back(versions[node->getId()]);
+#ifdef ENABLE_HLSL
+    key.push_back(node->getFlattenSubset());
+#endif
+    nodeNumbers[node] = addValue(key, 1, false);
+}
+
+void TValueNumbering::numberConstant(TIntermConstantUnion* node)
+{
+    if (! IsNumberableType(node->getType()))
+        return;
+
+    TValueKey key;
+    key.push_back('c');
+    AddTypeKey(key, node->getType());
+    const TConstUnionArray& constants = node->getConstArray();
+    for (int c = 0; c < constants.size(); ++c) {
+        long long bits;
+        switch (constants[c].getType()) {
+        case EbtDouble:
+        {
+            const double value = constants[c].getDConst();
+            memcpy(&bits, &value, sizeof(bits));
+            break;
+        }
+        case EbtInt:    bits = constants[c].getIConst();              break;
+        case EbtUint:   bits = constants[c].getUConst();              break;
+        case EbtInt64:  bits = constants[c].getI64Const();            break;
+        case EbtUint64: bits = (long long)constants[c].getU64Const(); break;
+        case EbtBool:   bits = constants[c].getBConst();              break;
+        default:
+            return;
+        }
+        key.push_back(constants[c].getType());
+        key.push_back(bits);
+    }
+    nodeNumbers[node] = addValue(key, 0, false);
+}
+
+void TValueNumbering::numberOperation(TIntermOperator* node, const TIntermSequence& operands)
+{
+    TValueKey key;
+    key.push_back('o');
+    key.push_back(node->getOp());
+
+    // The selectors of a swizzle are a sequence of constants, part of the operator.
+    const bool selectors = node->getOp() == EOpSequence;
+    if (! selectors) {
+        if (! TIntermediate::isPureOperator(node->getOp()) || ! IsNumberableType(node->getType()))
+            return;
+        AddTypeKey(key, node->getType());
+        key.push_back(node->getQualifier().noContraction);
+    }
+
+    // Indexing a variable, however deep, is one access chain and one load,
+    // which a temporary can't beat, so only bigger expressions are candidates.
+    int size = 1;
+    bool candidate = ! selectors && node->getQualifier().storage != EvqConst && ! node->getQualifier().isSpecConstant();
+    switch (node->getOp()) {
+    case EOpSequence:
+        size = 0;
+        break;
+    case EOpIndexDirect:
+    case EOpIndexIndirect:
+    case EOpIndexDirectStruct:
+    case EOpVectorSwizzle:
+        if (operands[0]->getAsSymbolNode() == nullptr)
+            size = 0;
+        candidate = false;
+        break;
+    default:
+        break;
+    }
+    for (TIntermNode* operand : operands) {
+        auto number = operand ? nodeNumbers.find(operand) : nodeNumbers.end();
+        if (number == nodeNumbers.end() || (selectors && operand->getAsConstantUnion() == nullptr))
+            return;
+        key.push_back(number->second);
+        size += values[number->second].size;
+    }
+
+    nodeNumbers[node] = addValue(key, size, candidate);
+}
+
+//
+// Return what is to replace 'node': a read of the temporary its value is
+// computed into, if worth it, or else 'node' itself, with its operands
+// replaced.
+//
+TIntermTyped* TValueNumbering::replace(TIntermTyped* node)
+{
+    auto number = nodeNumbers.find(node);
+    TValue* value = number != nodeNumbers.end() ? &values[number->second] : nullptr;
+
+    // A temporary costs its declaration, its name, a store, and a load per occurrence.
+    if (value == nullptr || ! value->candidate ||
+        (value->temporary == nullptr && (value->count - 1) * value->size <= value->count + 3)) {
+        node->traverse(&replaceTraverser);
+        return node;
+    }
+
+    if (value->temporary == nullptr) {
+        // The other occurrences won't compute what is under them.
+        std::vector<int> under;
+        TNumberListTraverser listTraverser(nodeNumbers, node, under);
+        node->traverse(&listTraverser);
+        for (int n : under)
+            values[n].count -= value->count - 1;
+
+        TType type;
+        type.shallowCopy(node->getType());
+        type.getQualifier().makeTemporary();
+        type.getQualifier().noContraction = false;
+        value->temporary = new TIntermSymbol(nextId++, "@value", type);
+        value->temporary->setLoc(node->getLoc());
+
+        // What is under this one may itself need temporaries, computed first.
+        node->traverse(&replaceTraverser);
+        temporaries.push_back(intermediate.addBinaryNode(EOpAssign, newRead(value->temporary, node->getLoc()), node,
+                                                         node->getLoc(), type));
+    }
+
+    return newRead(value->temporary, node->getLoc());
+}
+
+TIntermSymbol* TValueNumbering::newRead(const TIntermSymbol* temporary, const TSourceLoc& loc) const
+{
+    TIntermSymbol* read = intermediate.addSymbol(*temporary);
+    read->setLoc(loc);
+
+    return read;
+}
+
+//
+// Add the statement at 'index' in 'list' to the current block, if it is a
+// store of a pure expression, or just a pure expression, numbering it.
+// Returns false if it isn't.
+//
+bool TValueNumbering::addStatement(TIntermAggregate* list, size_t index)
+{
+    TIntermTyped* statement = list->getSequence()[index]->getAsTyped();
+    if (statement == nullptr || statement->getBasicType() == EbtVoid)
+        return false;
+
+    TIntermBinary* store = statement->getAsBinaryNode();
+    if (store && store->getOp() >= EOpAssign && store->getOp() <= EOpRightShiftAssign) {
+        const TIntermTyped* base = TIntermediate::findLValueBase(store->getLeft(), true);
+        if (base == nullptr || base->getAsSymbolNode() == nullptr ||
+            ! TIntermediate::isPure(store->getLeft()) || ! TIntermediate::isPure(store->getRight()))
+            return false;
+
+        store->getRight()->traverse(&numberTraverser);
+        ++versions[base->getAsSymbolNode()->getId()];
+    } else if (TIntermediate::isPure(statement))
+        statement->traverse(&numberTraverser);
+    else
+        return false;
+
+    TBlockStatement blockStatement = { list, index };
+    block.push_back(blockStatement);
+
+    return true;
+}
+
+//
+// Replace what is worth it in the statements of the current block, and
+// start a new one.
+//
+void TValueNumbering::endBlock()
+{
+    for (const TBlockStatement& blockStatement : block) {
+        TIntermNode* statement = blockStatement.list->getSequence()[blockStatement.index];
+        TIntermBinary* store = statement->getAsBinaryNode();
+        if (store && store->getOp() >= EOpAssign && store->getOp() <= EOpRightShiftAssign)
+            store->setRight(replace(store->getRight()));
+        else
+            statement->traverse(&replaceTraverser);
+
+        if (! temporaries.empty()) {
+            TInsertion insertion = { blockStatement.index, temporaries };
+            insertions[blockStatement.list].push_back(insertion);
+            temporaries.clear();
+        }
+    }
+
+    block.clear();
+    numbers.clear();
+    values.clear();
+    nodeNumbers.clear();
+}
+
+void TValueNumbering::numberList(TIntermAggregate* list)
+{
+    for (size_t s = 0; s < list->getSequence().size(); ++s) {
+        TIntermNode* statement = list->getSequence()[s];
+        if (statement == nullptr)
+            continue;
+
+        TIntermAggregate* aggregate = statement->getAsAggregate();
+        if (aggregate && aggregate->getOp() == EOpSequence)
+            numberList(aggregate);
+        else if (! addStatement(list, s)) {
+            endBlock();
+            if (TIntermSelection* selection = statement->getAsSelectionNode()) {
+                numberBody(selection->getTrueBlock());
+                numberBody(selection->getFalseBlock());
+            } else if (TIntermLoop* loop = statement->getAsLoopNode())
+                numberBody(loop->getBody());
+            else if (TIntermSwitch* switchNode = statement->getAsSwitchNode())
+                numberBody(switchNode->getBody());
+        }
+    }
+}
+
+// Number the body of a control-flow statement, as blocks of their own.
+void TValueNumbering::numberBody(TIntermNode* body)
+{
+    TIntermAggregate* list = body ? body->getAsAggregate() : nullptr;
+    if (list && list->getOp() == EOpSequence) {
+        numberList(list);
+        endBlock();
+    }
+}
+
+void TValueNumbering::numberFunction(TIntermAggregate* function)
+{
+    for (TIntermNode* child : function->getSequence())
+        numberBody(child);
+}
+
+void TValueNumbering::insertTemporaries()
+{
+    for (auto it = insertions.begin(); it != insertions.end(); ++it) {
+        TIntermSequence& sequence = it->first->getSequence();
+        TIntermSequence statements;
+        size_t next = 0;
+        for (const TInsertion& insertion : it->second) {
+            while (next < insertion.index)
+                statements.push_back(sequence[next++]);
+            for (TIntermNode* temporary : insertion.statements)
+                statements.push_back(temporary);
+        }
+        while (next < sequence.size())
+            statements.push_back(sequence[next++]);
+        sequence = statements;
+    }
+}
+
+} // end anonymous namespace
+
+//
+// See the top of the file.
+//
+void TIntermediate::numberValues()
+{
+    if (treeRoot == nullptr)
+        return;
+
+    TValueNumbering numbering(*this, getMaxSymbolId());
+    for (TIntermNode* global : treeRoot->getAsAggregate()->getSequence()) {
+        TIntermAggregate* function = global ? global->getAsAggregate() : nullptr;
+        if (function && function->getOp() == EOpFunction)
+            numbering.numberFunction(function);
+    }
+    numbering.insertTemporaries();
+}
+
+} // end namespace glslang
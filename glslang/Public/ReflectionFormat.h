@@ -0,0 +1,148 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef _REFLECTION_FORMAT_INCLUDED_
+#define _REFLECTION_FORMAT_INCLUDED_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//
+// The serialized form of a program's reflection, as written by
+// TProgram::serializeReflection(), and a reader for it.  This header stands
+// alone, so tools can load the reflection without glslang.
+//
+// The binary form is a sequence of 32-bit little-endian words:
+//
+//   header:   ReflectionMagic, ReflectionVersion, local size x, y, z
+//   tables:   uniforms, uniform blocks, attributes; each is a count followed
+//             by that many objects
+//   object:   name length in bytes, the name padded with zeros to a whole
+//             word, then offset, GL type, size, index, counter index,
+//             binding, and descriptor set
+//
+// Integers are stored two's complement, with -1 meaning "none", as in
+// TProgram's queries.  The JSON form (TProgram::serializeReflectionJson())
+// holds the same: an object with "version", "localSize", and the arrays
+// "uniforms", "uniformBlocks" and "attributes" of objects whose members are
+// named as in TReflectionRecord.
+//
+// A version only ever changes when the layout does; readers reject others.
+//
+
+namespace glslang {
+
+const unsigned int ReflectionMagic = 0x46524c47;  // "GLRF"
+const unsigned int ReflectionVersion = 1;
+
+// One uniform, uniform block or attribute
+struct TReflectionRecord {
+    std::string name;
+    int offset;
+    int glDefineType;
+    int size;
+    int index;
+    int counterIndex;
+    int binding;
+    int set;
+};
+
+struct TReflectionRecords {
+    unsigned int localSize[3];
+    std::vector<TReflectionRecord> uniforms;
+    std::vector<TReflectionRecord> uniformBlocks;
+    std::vector<TReflectionRecord> attributes;
+};
+
+// Read the binary form in 'binary', of 'size' bytes, into 'records'.
+// Return false if it isn't a whole reflection of this version.
+inline bool ReadReflectionRecords(const unsigned char* binary, size_t size, TReflectionRecords& records)
+{
+    size_t position = 0;
+    auto getWord = [&](unsigned int& word) {
+        if (size - position < 4)
+            return false;
+        word = binary[position] | (binary[position + 1] << 8) | (binary[position + 2] << 16) |
+               ((unsigned int)binary[position + 3] << 24);
+        position += 4;
+        return true;
+    };
+    auto getInt = [&](int& value) {
+        unsigned int word;
+        if (! getWord(word))
+            return false;
+        value = (int)word;
+        return true;
+    };
+    auto getTable = [&](std::vector<TReflectionRecord>& table) {
+        unsigned int count;
+        if (! getWord(count))
+            return false;
+        table.clear();
+        for (unsigned int r = 0; r < count; ++r) {
+            TReflectionRecord record;
+            unsigned int length;
+            if (! getWord(length) || length > size - position)
+                return false;
+            const size_t padded = ((size_t)length + 3) / 4 * 4;
+            if (padded > size - position)
+                return false;
+            record.name.assign((const char*)binary + position, length);
+            position += padded;
+            if (! getInt(record.offset) || ! getInt(record.glDefineType) || ! getInt(record.size) ||
+                ! getInt(record.index) || ! getInt(record.counterIndex) || ! getInt(record.binding) ||
+                ! getInt(record.set))
+                return false;
+            table.push_back(record);
+        }
+        return true;
+    };
+
+    unsigned int magic, version;
+    if (! getWord(magic) || magic != ReflectionMagic || ! getWord(version) || version != ReflectionVersion)
+        return false;
+    for (int dim = 0; dim < 3; ++dim) {
+        if (! getWord(records.localSize[dim]))
+            return false;
+    }
+
+    return getTable(records.uniforms) && getTable(records.uniformBlocks) && getTable(records.attributes) &&
+           position == size;
+}
+
+} // end namespace glslang
+
+#endif // _REFLECTION_FORMAT_INCLUDED_
@@ -40,6 +40,7 @@
 #include "../MachineIndependent/Versions.h"
 
 #include <cstring>
+#include <iosfwd>
 #include <vector>
 
 #ifdef _WIN32
@@ -195,6 +196,10 @@ enum EShMessages {
     EShMsgKeepUncalled     = (1 << 8),  // for testing, don't eliminate uncalled functions
     EShMsgHlslOffsets      = (1 << 9),  // allow block offsets to follow HLSL rules instead of GLSL rules
     EShMsgDebugInfo        = (1 << 10), // save debug information
+    EShMsgEliminateDeadCode = (1 << 11), // at link time, remove unreachable code, unread stores, and unused globals
+    EShMsgValueNumbering   = (1 << 12), // at link time, compute repeated expressions once, into temporaries
+    EShMsgInlineFunctions  = (1 << 13), // at link time, inline calls to small functions (see TShader::setInlineBudget())
+    EShMsgParallelLink     = (1 << 14), // link each stage of a TProgram on its own thread
 };
 
 //
@@ -302,6 +307,8 @@ SH_IMPORT_EXPORT int ShGetUniformLocation(const ShHandle uniformMap, const char*
 //
 
 #include <list>
+#include <map>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -361,6 +368,7 @@ public:
     void setFlattenUniformArrays(bool flatten);
     void setNoStorageFormat(bool useUnknownFormat);
     void setTextureSamplerTransformMode(EShTextureSamplerTransformMode mode);
+    void setInlineBudget(int nodes);
 
     // For setting up the environment (initialized in the constructor):
     void setEnvInput(EShSource lang, EShLanguage envStage, EShClient client, int version)
@@ -491,9 +499,24 @@ public:
                     bool forwardCompatible, EShMessages message, std::string* outputString,
                     Includer& includer);
 
+    // Save the result of a successful parse() as a compact, versioned binary,
+    // or load such a binary instead of calling parse(), skipping the preprocessor,
+    // scanner, and parser.  Only what parsing put in the intermediate representation
+    // is saved, not the info log.  A binary only loads into a shader of the same stage,
+    // built by the same version and configuration of glslang.  Callers caching binaries
+    // must key them on everything given to parse(), as well as the set*() calls made
+    // before it.
+    bool serialize(std::vector<unsigned char>& binary) const;
+    bool deserialize(const TBuiltInResource*, const unsigned char* binary, size_t size);
+
     const char* getInfoLog();
     const char* getInfoDebugLog();
 
+    // Write the debug log, where EShMsgAST puts the AST, to 'stream' in bounded
+    // chunks while parse() produces it, rather than collecting all of it for
+    // getInfoDebugLog().  All of it has been written by the time parse() returns.
+    void setInfoDebugLogStream(std::ostream* stream);
+
     EShLanguage getStage() const { return stage; }
 
 protected:
@@ -529,6 +552,7 @@ private:
 };
 
 class TReflection;
+struct TReflectionRecords;
 class TIoMapper;
 
 // Allows to customize the binding layout after linking.
@@ -597,6 +621,93 @@ public:
   virtual void endResolve(EShLanguage stage) = 0;
 };
 
+// A variable given to a TIoMapBatchResolver, with what it maps to.  The new*
+// members come in as -1, for "keep what the shader has", and the resolver
+// sets the ones it overrides.
+struct TIoMapVariable {
+    const char* name;
+    const TType* type;
+    bool live;
+    int newBinding;
+    int newSet;
+    int newLocation;
+    int newComponent;
+    int newIndex;
+};
+
+// The variables of one stage: inputs and outputs in declaration order, and
+// uniforms in the order TIoMapResolver describes above.
+struct TIoMapStage {
+    EShLanguage stage;
+    std::vector<TIoMapVariable> inputs;
+    std::vector<TIoMapVariable> outputs;
+    std::vector<TIoMapVariable> uniforms;
+};
+
+// A resolver given the complete variable lists at once, instead of a call
+// per variable and query, so it can assign them all together; e.g., pack
+// bindings across the stages of a program.  The limit checks of
+// TIoMapResolver apply to what it assigns.
+class TIoMapBatchResolver
+{
+public:
+  virtual ~TIoMapBatchResolver() {}
+
+  // Set the new* members of the variables of 'stages', one per stage mapped,
+  // in stage order, without adding or removing any.  Return false if they
+  // can't be mapped, with the reasons appended to 'log'.
+  virtual bool resolve(std::vector<TIoMapStage>& stages, std::string& log) = 0;
+};
+
+// Runs a TIoMapResolver as a TIoMapBatchResolver: each stage in turn gets
+// the notify pass and then the resolve pass, as mapIO(TIoMapResolver*) does.
+class TIoMapResolverAdapter : public TIoMapBatchResolver
+{
+public:
+  explicit TIoMapResolverAdapter(TIoMapResolver& resolver) : resolver(resolver) {}
+  virtual bool resolve(std::vector<TIoMapStage>& stages, std::string& log) override;
+
+protected:
+  TIoMapResolver& resolver;
+
+private:
+  TIoMapResolverAdapter& operator=(TIoMapResolverAdapter&);
+};
+
+// Set and binding assignments shared by programs, so they get compatible
+// descriptor set layouts.  Mapping a program with it binds each live
+// resource (an opaque uniform or a block) that the shader leaves unbound to
+// the binding held for a resource of the same name and type (precision
+// aside), adding one the first time such a resource is seen.  Bindings given
+// in shaders are kept, and not handed out; mapping fails if a shader gives
+// one that is held for a resource it leaves unbound.  The registry can be
+// saved and loaded, so the
+// assignments can outlive a process.  Programs sharing a registry must not
+// be mapped concurrently.
+class TIoMapLayoutRegistry : public TIoMapBatchResolver
+{
+public:
+  TIoMapLayoutRegistry() {}
+  virtual bool resolve(std::vector<TIoMapStage>& stages, std::string& log) override;
+
+  // The assignments held, as lines of "set binding name type".
+  void serialize(std::string& text) const;
+  // Add the assignments of a serialize()d registry; return false, having
+  // added none, if 'text' isn't one or conflicts with what is held.
+  bool deserialize(const std::string& text);
+
+  size_t size() const { return assignments.size(); }
+
+protected:
+  typedef std::pair<int, int> TSlot;  // set and binding
+
+  bool assign(const std::string& key, TSlot slot);
+
+  std::map<std::string, TSlot> assignments;   // by "name type"
+  std::set<TSlot> taken;                      // assigned, or given in a shader
+  std::map<int, int> nextBinding;             // by set, where to look for a free one
+};
+
 // Make one TProgram per set of shaders that will get linked together.  Add all
 // the shaders that are to be linked together.  After calling shader.parse()
 // for all shaders, call link().
@@ -614,8 +725,24 @@ public:
     const char* getInfoLog();
     const char* getInfoDebugLog();
 
+    // As for TShader::setInfoDebugLogStream(), but for the log written by link().
+    void setInfoDebugLogStream(std::ostream* stream);
+
     TIntermediate* getIntermediate(EShLanguage stage) const { return intermediate[stage]; }
 
+    // Incremental relink, after link(): make 'shader' the only compilation
+    // unit of its stage and link just that stage again; the other stages keep
+    // their linked TIntermediate.  If mapIO() was called, the new stage is
+    // mapped with 'resolver', which should be the one given to mapIO().  If
+    // buildReflection() was called, reflection is rebuilt, as its tables are
+    // shared by all stages.  The info logs then hold what the relink
+    // reported.  The shaders replaced are no longer used by the program, but
+    // what linking added to them is kept until the program is destroyed, so
+    // they can be given back to a later relinkStage(); the memory a program
+    // holds grows with each relink.  On failure, the program is no longer
+    // linked, and its reflection, if any, is empty.
+    bool relinkStage(TShader* shader, EShMessages, TIoMapResolver* resolver = NULL);
+
     // Reflection Interface
     bool buildReflection();                          // call first, to do liveness analysis, index mapping, etc.; returns false on failure
     int getNumLiveUniformVariables() const;                // can be used for glGetProgramiv(GL_ACTIVE_UNIFORMS)
@@ -638,17 +765,32 @@ public:
     const TType* getUniformBlockTType(int index) const;    // returns a TType*
     const TType* getAttributeTType(int index) const;       // returns a TType*
 
+    // All of the above at once, for reading in bulk: the uniforms, blocks and
+    // attributes, indexed as above, as the records of ReflectionFormat.h.
+    // Return false if there is no reflection.
+    bool getReflectionRecords(TReflectionRecords& records) const;
+
     void dumpReflection();
 
+    // Save the reflection built by buildReflection() in the forms described
+    // in ReflectionFormat.h; return false if there is none.
+    bool serializeReflection(std::vector<unsigned char>& binary) const;
+    bool serializeReflectionJson(std::string& json) const;
+
     // I/O mapping: apply base offsets and map live unbound variables
     // If resolver is not provided it uses the previous approach
     // and respects auto assignment and offsets.
     bool mapIO(TIoMapResolver* resolver = NULL);
+    // I/O mapping of all stages by one call to 'resolver'
+    bool mapIO(TIoMapBatchResolver& resolver);
 
 protected:
-    bool linkStage(EShLanguage, EShMessages);
+    bool linkStage(EShLanguage, EShMessages, TInfoSink&);
+    bool linkStagesParallel(EShMessages);
 
     TPoolAllocator* pool;
+    TPoolAllocator* stagePool[EShLangCount];   // the pools of a parallel link, one per stage
+    std::map<const TShader*, TPoolAllocator*> unitPools;  // the pools of relinkStage(), one per unit given
     std::list<TShader*> stages[EShLangCount];
     TIntermediate* intermediate[EShLangCount];
     bool newedIntermediate[EShLangCount];      // track which intermediate were "new" versus reusing a singleton unit in a stage
@@ -60,6 +60,7 @@ std::string FileNameAsCustomTestSuffix(
 using HlslCompileTest = GlslangTest<::testing::TestWithParam<FileNameEntryPointPair>>;
 using HlslCompileAndFlattenTest = GlslangTest<::testing::TestWithParam<FileNameEntryPointPair>>;
 using HlslLegalizeTest = GlslangTest<::testing::TestWithParam<FileNameEntryPointPair>>;
+using HlslValueNumberingTest = GlslangTest<::testing::TestWithParam<FileNameEntryPointPair>>;
 
 // Compiling HLSL to pre-legalized SPIR-V under Vulkan semantics. Expected
 // to successfully generate both AST and SPIR-V.
@@ -87,6 +88,16 @@ TEST_P(HlslLegalizeTest, FromFile)
                             "/baseLegalResults/", false);
 }
 
+// Compiling HLSL to SPIR-V under Vulkan semantics, with repeated expressions
+// computed just once.
+TEST_P(HlslValueNumberingTest, FromFile)
+{
+    loadFileCompileOptimizeAndCheck(GlobalTestSettings.testRoot, GetParam().fileName,
+                                    Source::HLSL, Semantics::Vulkan,
+                                    Target::BothASTAndSpv, EShMsgValueNumbering,
+                                    GetParam().entryPoint);
+}
+
 // clang-format off
 INSTANTIATE_TEST_CASE_P(
     ToSpirv, HlslCompileTest,
@@ -367,6 +378,16 @@ INSTANTIATE_TEST_CASE_P(
 );
 // clang-format on
 
+// clang-format off
+INSTANTIATE_TEST_CASE_P(
+    ToSpirv, HlslValueNumberingTest,
+    ::testing::ValuesIn(std::vector<FileNameEntryPointPair>{
+        {"hlsl.valueNumbering.frag", "main"},
+    }),
+    FileNameAsCustomTestSuffix
+);
+// clang-format on
+
 #ifdef ENABLE_OPT
 // clang-format off
 INSTANTIATE_TEST_CASE_P(
@@ -32,56 +32,74 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <set>
 
 #include <gtest/gtest.h>
 
 #include "TestFixture.h"
+#include "glslang/Public/ReflectionFormat.h"
 
 namespace glslangtest {
 namespace {
 
-using LinkTest = GlslangTest<
-    ::testing::TestWithParam<std::vector<std::string>>>;
+class LinkTest : public GlslangTest<
+    ::testing::TestWithParam<std::vector<std::string>>> {
+protected:
+    // Links the files of the test, adding 'linkControls' to the messages
+    // for the link, and checks the results.
+    void linkFromFile(EShMessages linkControls)
+    {
+        const auto& fileNames = GetParam();
+        const size_t fileCount = fileNames.size();
+        const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+        GlslangResult result;
 
-TEST_P(LinkTest, FromFile)
-{
-    const auto& fileNames = GetParam();
-    const size_t fileCount = fileNames.size();
-    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
-    GlslangResult result;
+        // Compile each input shader file.
+        std::vector<std::unique_ptr<glslang::TShader>> shaders;
+        for (size_t i = 0; i < fileCount; ++i) {
+            std::string contents;
+            tryLoadFile(GlobalTestSettings.testRoot + "/" + fileNames[i],
+                        "input", &contents);
+            shaders.emplace_back(
+                    new glslang::TShader(GetShaderStage(GetSuffix(fileNames[i]))));
+            auto* shader = shaders.back().get();
+            compile(shader, contents, "", controls);
+            result.shaderResults.push_back(
+                {fileNames[i], shader->getInfoLog(), shader->getInfoDebugLog()});
+        }
 
-    // Compile each input shader file.
-    std::vector<std::unique_ptr<glslang::TShader>> shaders;
-    for (size_t i = 0; i < fileCount; ++i) {
-        std::string contents;
-        tryLoadFile(GlobalTestSettings.testRoot + "/" + fileNames[i],
-                    "input", &contents);
-        shaders.emplace_back(
-                new glslang::TShader(GetShaderStage(GetSuffix(fileNames[i]))));
-        auto* shader = shaders.back().get();
-        compile(shader, contents, "", controls);
-        result.shaderResults.push_back(
-            {fileNames[i], shader->getInfoLog(), shader->getInfoDebugLog()});
-    }
+        // Link all of them.
+        glslang::TProgram program;
+        for (const auto& shader : shaders) program.addShader(shader.get());
+        program.link((EShMessages)(controls | linkControls));
+        result.linkingOutput = program.getInfoLog();
+        result.linkingError = program.getInfoDebugLog();
 
-    // Link all of them.
-    glslang::TProgram program;
-    for (const auto& shader : shaders) program.addShader(shader.get());
-    program.link(controls);
-    result.linkingOutput = program.getInfoLog();
-    result.linkingError = program.getInfoDebugLog();
+        std::ostringstream stream;
+        outputResultToStream(&stream, result, controls);
 
-    std::ostringstream stream;
-    outputResultToStream(&stream, result, controls);
+        // Check with expected results.
+        const std::string expectedOutputFname =
+            GlobalTestSettings.testRoot + "/baseResults/" + fileNames.front() + ".out";
+        std::string expectedOutput;
+        tryLoadFile(expectedOutputFname, "expected output", &expectedOutput);
 
-    // Check with expected results.
-    const std::string expectedOutputFname =
-        GlobalTestSettings.testRoot + "/baseResults/" + fileNames.front() + ".out";
-    std::string expectedOutput;
-    tryLoadFile(expectedOutputFname, "expected output", &expectedOutput);
+        checkEqAndUpdateIfRequested(expectedOutput, stream.str(), expectedOutputFname);
+    }
+};
+
+TEST_P(LinkTest, FromFile)
+{
+    linkFromFile(EShMsgDefault);
+}
 
-    checkEqAndUpdateIfRequested(expectedOutput, stream.str(), expectedOutputFname);
+// Linking the stages concurrently must give the same results.
+TEST_P(LinkTest, FromFileParallel)
+{
+    linkFromFile(EShMsgParallelLink);
 }
 
 // clang-format off
@@ -102,7 +120,437 @@ INSTANTIATE_TEST_CASE_P(
         {"missingBodies.vert"}
     })),
 );
+
+struct RelinkTestCase {
+    std::vector<std::string> fileNames;  // linked first
+    std::string replacement;             // then relinked as the only unit of its stage
+};
+
+class RelinkTest : public GlslangTest<::testing::TestWithParam<RelinkTestCase>> {
+protected:
+    glslang::TShader* compileFile(const std::string& fileName, EShMessages controls)
+    {
+        std::string contents;
+        tryLoadFile(GlobalTestSettings.testRoot + "/" + fileName, "input", &contents);
+        shaders.emplace_back(new glslang::TShader(GetShaderStage(GetSuffix(fileName))));
+        compile(shaders.back().get(), contents, "", controls);
+        return shaders.back().get();
+    }
+
+    std::vector<std::unique_ptr<glslang::TShader>> shaders;
+};
+
+// Relinking a stage must give what a fresh link gives, without touching the
+// other stages.
+TEST_P(RelinkTest, FromFile)
+{
+    const RelinkTestCase& testCase = GetParam();
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+    const EShLanguage stage = GetShaderStage(GetSuffix(testCase.replacement));
+
+    glslang::TProgram program;
+    for (const auto& fileName : testCase.fileNames)
+        program.addShader(compileFile(fileName, controls));
+    program.link(controls);
+    program.buildReflection();
+
+    glslang::TIntermediate* linked[EShLangCount];
+    for (int s = 0; s < EShLangCount; ++s)
+        linked[s] = program.getIntermediate((EShLanguage)s);
+
+    const bool relinked = program.relinkStage(compileFile(testCase.replacement, controls), controls);
+
+    // The log is that of linking the stage alone.
+    glslang::TProgram stageProgram;
+    stageProgram.addShader(compileFile(testCase.replacement, controls));
+    EXPECT_EQ(stageProgram.link(controls), relinked);
+    EXPECT_EQ(std::string(stageProgram.getInfoLog()), std::string(program.getInfoLog()));
+
+    for (int s = 0; s < EShLangCount; ++s) {
+        if (s != stage) {
+            EXPECT_EQ(linked[s], program.getIntermediate((EShLanguage)s));
+        }
+    }
+
+    // Reflection is that of the whole program linked afresh.
+    glslang::TProgram freshProgram;
+    for (const auto& fileName : testCase.fileNames) {
+        if (GetShaderStage(GetSuffix(fileName)) != stage)
+            freshProgram.addShader(compileFile(fileName, controls));
+    }
+    freshProgram.addShader(compileFile(testCase.replacement, controls));
+    ASSERT_TRUE(freshProgram.link(controls));
+    ASSERT_TRUE(freshProgram.buildReflection());
+
+    ASSERT_EQ(freshProgram.getNumLiveUniformVariables(), program.getNumLiveUniformVariables());
+    for (int u = 0; u < program.getNumLiveUniformVariables(); ++u) {
+        EXPECT_EQ(std::string(freshProgram.getUniformName(u)), std::string(program.getUniformName(u)));
+        EXPECT_EQ(freshProgram.getUniformBufferOffset(u), program.getUniformBufferOffset(u));
+        EXPECT_EQ(u, program.getUniformIndex(program.getUniformName(u)));
+    }
+    ASSERT_EQ(freshProgram.getNumLiveUniformBlocks(), program.getNumLiveUniformBlocks());
+    for (int b = 0; b < program.getNumLiveUniformBlocks(); ++b)
+        EXPECT_EQ(std::string(freshProgram.getUniformBlockName(b)), std::string(program.getUniformBlockName(b)));
+    ASSERT_EQ(freshProgram.getNumLiveAttributes(), program.getNumLiveAttributes());
+    for (int a = 0; a < program.getNumLiveAttributes(); ++a)
+        EXPECT_EQ(std::string(freshProgram.getAttributeName(a)), std::string(program.getAttributeName(a)));
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Glsl, RelinkTest,
+    ::testing::ValuesIn(std::vector<RelinkTestCase>({
+        {{"reflection.vert", "dataOut.frag"}, "conditionalDiscard.frag"},
+        {{"link1.frag", "link2.frag", "link3.frag", "reflection.vert"}, "dataOut.frag"},
+        {{"150.tesc", "150.tese", "reflection.vert"}, "400.tesc"},
+    })),
+);
+// clang-format on
+
+using RelinkFailureTest = RelinkTest;
+
+// Relinking can be repeated, also with the same shader, and a failed relink
+// leaves a program that is not linked, with empty reflection.
+TEST_F(RelinkFailureTest, FromFile)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+
+    glslang::TProgram program;
+    program.addShader(compileFile("reflection.vert", controls));
+    program.addShader(compileFile("dataOut.frag", controls));
+    ASSERT_TRUE(program.link(controls));
+    ASSERT_TRUE(program.buildReflection());
+
+    glslang::TShader* vertex = compileFile("reflection.vert", controls);
+    ASSERT_TRUE(program.relinkStage(vertex, controls));
+    ASSERT_TRUE(program.relinkStage(vertex, controls));
+    ASSERT_TRUE(program.relinkStage(compileFile("reflection.vert", controls), controls));
+    const int uniforms = program.getNumLiveUniformVariables();
+    EXPECT_LT(0, uniforms);
+
+    EXPECT_FALSE(program.relinkStage(compileFile("missingBodies.vert", controls), controls));
+    EXPECT_EQ(0, program.getNumLiveUniformVariables());
+    EXPECT_EQ(-1, program.getUniformIndex(program.getUniformName(0)));
+    EXPECT_FALSE(program.buildReflection());
+    EXPECT_FALSE(program.relinkStage(compileFile("reflection.vert", controls), controls));
+}
+
+// Shaders can be swapped in and out of a mapped program, each time reusing
+// what an earlier link of the shader left in it.
+TEST_F(RelinkFailureTest, Toggles)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+
+    glslang::TProgram program;
+    glslang::TShader* first = compileFile("dataOut.frag", controls);
+    glslang::TShader* second = compileFile("conditionalDiscard.frag", controls);
+    program.addShader(compileFile("reflection.vert", controls));
+    program.addShader(first);
+    ASSERT_TRUE(program.link(controls));
+    ASSERT_TRUE(program.mapIO());
+
+    for (int toggle = 0; toggle < 4; ++toggle) {
+        ASSERT_TRUE(program.relinkStage(second, controls));
+        ASSERT_TRUE(program.relinkStage(first, controls));
+    }
+    ASSERT_TRUE(program.buildReflection());
+    EXPECT_LT(0, program.getNumLiveUniformVariables());
+}
+
+// Packs the bindings of the uniforms of all stages: a name gets the next
+// binding the first time it is seen, and keeps it in later stages.
+class PackingResolver : public glslang::TIoMapBatchResolver {
+public:
+    bool resolve(std::vector<glslang::TIoMapStage>& stages, std::string&) override
+    {
+        ++calls;
+        for (auto& stage : stages) {
+            mappedStages.push_back(stage.stage);
+            for (auto& uniform : stage.uniforms) {
+                uniform.newBinding = bind(uniform.name);
+                uniform.newSet = 0;
+            }
+        }
+        return true;
+    }
+
+    int bind(const char* name)
+    {
+        return bindings.insert(std::make_pair(std::string(name), (int)bindings.size())).first->second;
+    }
+
+    int calls = 0;
+    std::vector<EShLanguage> mappedStages;
+    std::map<std::string, int> bindings;
+};
+
+// The same packing, a variable at a time.
+class PerVariablePackingResolver : public glslang::TIoMapResolver {
+public:
+    bool validateBinding(EShLanguage, const char*, const glslang::TType&, bool) override { return true; }
+    int resolveBinding(EShLanguage, const char* name, const glslang::TType&, bool) override
+    {
+        return packing.bind(name);
+    }
+    int resolveSet(EShLanguage, const char*, const glslang::TType&, bool) override { return 0; }
+    int resolveUniformLocation(EShLanguage, const char*, const glslang::TType&, bool) override { return -1; }
+    bool validateInOut(EShLanguage, const char*, const glslang::TType&, bool) override { return true; }
+    int resolveInOutLocation(EShLanguage, const char*, const glslang::TType&, bool) override { return -1; }
+    int resolveInOutComponent(EShLanguage, const char*, const glslang::TType&, bool) override { return -1; }
+    int resolveInOutIndex(EShLanguage, const char*, const glslang::TType&, bool) override { return -1; }
+    void notifyBinding(EShLanguage, const char*, const glslang::TType&, bool) override { }
+    void notifyInOut(EShLanguage, const char*, const glslang::TType&, bool) override { }
+    void endNotifications(EShLanguage) override { }
+    void beginNotifications(EShLanguage) override { }
+    void beginResolve(EShLanguage) override { }
+    void endResolve(EShLanguage) override { }
+
+    PackingResolver packing;
+};
+
+using BatchIoMapTest = LinkTest;
+
+// A batch resolver maps all stages in one call, to what the same resolver,
+// a variable at a time, maps them to.
+TEST_P(BatchIoMapTest, FromFile)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+
+    std::vector<std::unique_ptr<glslang::TShader>> shaders;
+    glslang::TProgram batchProgram;
+    glslang::TProgram program;
+    for (const auto& fileName : GetParam()) {
+        std::string contents;
+        tryLoadFile(GlobalTestSettings.testRoot + "/" + fileName, "input", &contents);
+        for (glslang::TProgram* linked : { &batchProgram, &program }) {
+            shaders.emplace_back(new glslang::TShader(GetShaderStage(GetSuffix(fileName))));
+            ASSERT_TRUE(compile(shaders.back().get(), contents, "", controls));
+            linked->addShader(shaders.back().get());
+        }
+    }
+    ASSERT_TRUE(batchProgram.link(controls));
+    ASSERT_TRUE(program.link(controls));
+
+    PackingResolver batchResolver;
+    ASSERT_TRUE(batchProgram.mapIO(batchResolver));
+    EXPECT_EQ(1, batchResolver.calls);
+    std::vector<EShLanguage> linkedStages;
+    for (int s = 0; s < EShLangCount; ++s) {
+        if (batchProgram.getIntermediate((EShLanguage)s))
+            linkedStages.push_back((EShLanguage)s);
+    }
+    EXPECT_EQ(linkedStages, batchResolver.mappedStages);
+    EXPECT_FALSE(batchResolver.bindings.empty());
+
+    PerVariablePackingResolver resolver;
+    ASSERT_TRUE(program.mapIO(&resolver));
+    EXPECT_EQ(batchResolver.bindings, resolver.packing.bindings);
+
+    ASSERT_TRUE(batchProgram.buildReflection());
+    ASSERT_TRUE(program.buildReflection());
+    ASSERT_EQ(program.getNumLiveUniformVariables(), batchProgram.getNumLiveUniformVariables());
+    for (int u = 0; u < batchProgram.getNumLiveUniformVariables(); ++u) {
+        const auto binding = batchResolver.bindings.find(batchProgram.getUniformName(u));
+        if (binding != batchResolver.bindings.end()) {
+            EXPECT_EQ(binding->second, batchProgram.getUniformBinding(u)) << batchProgram.getUniformName(u);
+        }
+        EXPECT_EQ(program.getUniformBinding(u), batchProgram.getUniformBinding(u));
+    }
+}
+
+// clang-format off
+INSTANTIATE_TEST_CASE_P(
+    Glsl, BatchIoMapTest,
+    ::testing::ValuesIn(std::vector<std::vector<std::string>>({
+        {"reflection.vert"},
+        {"reflection.vert", "dataOut.frag"},
+        {"reflection.vert", "conditionalDiscard.frag"},
+    })),
+);
 // clang-format on
 
+// Rejects the uniform "rejected", and maps the others out of range.
+class OutOfRangeResolver : public PerVariablePackingResolver {
+public:
+    bool validateBinding(EShLanguage, const char* name, const glslang::TType&, bool) override
+    {
+        return std::string(name) != "rejected";
+    }
+    int resolveBinding(EShLanguage, const char*, const glslang::TType&, bool) override { return 1 << 30; }
+};
+
+using IoMapErrorTest = GlslangTest<::testing::Test>;
+
+// What is wrong with each uniform is reported in the order the uniforms are
+// resolved in.
+TEST_F(IoMapErrorTest, OrderOfMessages)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+
+    glslang::TShader shader(EShLangFragment);
+    ASSERT_TRUE(compile(&shader, R"(#version 450
+uniform sampler2D after;
+uniform sampler2D before;
+uniform sampler2D rejected;
+out vec4 color;
+void main() { color = texture(after, vec2(0.0)) + texture(before, vec2(0.0)) + texture(rejected, vec2(0.0)); }
+)", "", controls));
+    glslang::TProgram program;
+    program.addShader(&shader);
+    ASSERT_TRUE(program.link(controls));
+
+    OutOfRangeResolver resolver;
+    EXPECT_FALSE(program.mapIO(&resolver));
+    const std::string log = program.getInfoLog();
+    const size_t after = log.find("mapped binding out of range: after");
+    const size_t before = log.find("mapped binding out of range: before");
+    const size_t rejected = log.find("Invalid binding: rejected");
+    ASSERT_NE(std::string::npos, after) << log;
+    ASSERT_NE(std::string::npos, before) << log;
+    ASSERT_NE(std::string::npos, rejected) << log;
+    EXPECT_LT(after, before) << log;
+    EXPECT_LT(before, rejected) << log;
+}
+
+class LayoutRegistryTest : public GlslangTest<::testing::Test> {
+protected:
+    // Link 'source' as a fragment shader and map it with 'registry', expecting
+    // that to succeed or not as 'mapped' says.
+    glslang::TProgram& map(const char* source, glslang::TIoMapLayoutRegistry& registry, bool mapped = true)
+    {
+        const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+        shaders.emplace_back(new glslang::TShader(EShLangFragment));
+        programs.emplace_back(new glslang::TProgram);
+        EXPECT_TRUE(compile(shaders.back().get(), source, "", controls));
+        programs.back()->addShader(shaders.back().get());
+        EXPECT_TRUE(programs.back()->link(controls));
+        EXPECT_EQ(mapped, programs.back()->mapIO(registry));
+        if (mapped) {
+            EXPECT_TRUE(programs.back()->buildReflection());
+        }
+        return *programs.back();
+    }
+
+    // The binding of the uniform or block 'name', or -2 if there is none.
+    static int binding(const glslang::TProgram& program, const char* name)
+    {
+        for (int u = 0; u < program.getNumLiveUniformVariables(); ++u) {
+            if (std::string(program.getUniformName(u)) == name)
+                return program.getUniformBinding(u);
+        }
+        glslang::TReflectionRecords records;
+        EXPECT_TRUE(program.getReflectionRecords(records));
+        for (const auto& block : records.uniformBlocks) {
+            if (block.name == name)
+                return block.binding;
+        }
+        return -2;
+    }
+
+    std::vector<std::unique_ptr<glslang::TShader>> shaders;
+    std::vector<std::unique_ptr<glslang::TProgram>> programs;
+};
+
+const char* const registryFirst = R"(#version 450
+layout(binding = 0) uniform sampler2D fixedTex;
+uniform sampler2D albedo;
+uniform Lights { vec4 color; } lights;
+out vec4 color;
+void main() { color = texture(fixedTex, vec2(0.0)) + texture(albedo, vec2(0.0)) + lights.color; }
+)";
+
+const char* const registrySecond = R"(#version 450
+uniform sampler2D normals;
+uniform Lights { vec4 color; } lights;
+uniform sampler2D albedo;
+out vec4 color;
+void main() { color = texture(normals, vec2(0.0)) + lights.color + texture(albedo, vec2(0.0)); }
+)";
+
+// Resources of the same name and type get the same binding in every program
+// mapped with a registry, and in those mapped with a registry loaded from it.
+TEST_F(LayoutRegistryTest, SharesBindings)
+{
+    glslang::TIoMapLayoutRegistry registry;
+    glslang::TProgram& first = map(registryFirst, registry);
+    glslang::TProgram& second = map(registrySecond, registry);
+
+    EXPECT_EQ(0, binding(first, "fixedTex"));
+    const int albedo = binding(first, "albedo");
+    const int lights = binding(first, "Lights");
+    const int normals = binding(second, "normals");
+    EXPECT_EQ(albedo, binding(second, "albedo"));
+    EXPECT_EQ(lights, binding(second, "Lights"));
+    std::set<int> distinct = { 0, albedo, lights, normals };
+    EXPECT_EQ(4u, distinct.size());
+    EXPECT_EQ(3u, registry.size());
+
+    std::string text;
+    registry.serialize(text);
+    EXPECT_EQ(3, std::count(text.begin(), text.end(), '\n'));
+
+    glslang::TIoMapLayoutRegistry loaded;
+    ASSERT_TRUE(loaded.deserialize(text));
+    EXPECT_TRUE(loaded.deserialize(text));
+    EXPECT_EQ(3u, loaded.size());
+    glslang::TProgram& reloaded = map(registrySecond, loaded);
+    EXPECT_EQ(albedo, binding(reloaded, "albedo"));
+    EXPECT_EQ(lights, binding(reloaded, "Lights"));
+    EXPECT_EQ(normals, binding(reloaded, "normals"));
+    EXPECT_EQ(3u, loaded.size());
+
+    std::string reserialized;
+    loaded.serialize(reserialized);
+    EXPECT_EQ(text, reserialized);
+
+    glslang::TIoMapLayoutRegistry conflicting;
+    EXPECT_FALSE(conflicting.deserialize("0 1 a sampler2D\n0 1 b sampler2D\n"));
+    EXPECT_FALSE(conflicting.deserialize("0 x\n"));
+    EXPECT_EQ(0u, conflicting.size());
+}
+
+// Precision doesn't make resources different.
+TEST_F(LayoutRegistryTest, IgnoresPrecision)
+{
+    glslang::TIoMapLayoutRegistry registry;
+    glslang::TProgram& low = map(R"(#version 310 es
+precision mediump float;
+uniform lowp sampler2D tex;
+uniform Material { mediump vec4 tint; } material;
+out vec4 color;
+void main() { color = texture(tex, vec2(0.0)) + material.tint; }
+)", registry);
+    glslang::TProgram& high = map(R"(#version 310 es
+precision mediump float;
+uniform highp sampler2D tex;
+uniform Material { highp vec4 tint; } material;
+out vec4 color;
+void main() { color = texture(tex, vec2(0.0)) + material.tint; }
+)", registry);
+
+    EXPECT_EQ(binding(low, "tex"), binding(high, "tex"));
+    EXPECT_EQ(binding(low, "Material"), binding(high, "Material"));
+    EXPECT_EQ(2u, registry.size());
+}
+
+// A shader can't give a binding held for a resource it leaves unbound.
+TEST_F(LayoutRegistryTest, GivenBindingClashes)
+{
+    glslang::TIoMapLayoutRegistry registry;
+    glslang::TProgram& first = map(registryFirst, registry);
+    ASSERT_EQ(1, binding(first, "albedo"));
+    const size_t held = registry.size();
+
+    glslang::TProgram& second = map(R"(#version 450
+layout(set = 0, binding = 1) uniform sampler2D x;
+uniform sampler2D albedo;
+uniform sampler2D unseen;
+out vec4 color;
+void main() { color = texture(x, vec2(0.0)) + texture(albedo, vec2(0.0)) + texture(unseen, vec2(0.0)); }
+)", registry, false);
+
+    EXPECT_NE(std::string::npos, std::string(second.getInfoLog()).find("held for 'albedo'"));
+    EXPECT_EQ(held, registry.size());
+}
+
 }  // anonymous namespace
 }  // namespace glslangtest
@@ -0,0 +1,158 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+
+#include "TestFixture.h"
+#include "glslang/Public/ReflectionFormat.h"
+
+namespace glslangtest {
+namespace {
+
+using ReflectionTest = GlslangTest<::testing::TestWithParam<std::string>>;
+
+// Check that 'records' hold what the program's queries give, entry by entry.
+void ExpectQueriedRecords(const glslang::TProgram& program, const glslang::TReflectionRecords& records)
+{
+    ASSERT_EQ(program.getNumLiveUniformVariables(), (int)records.uniforms.size());
+    for (int u = 0; u < program.getNumLiveUniformVariables(); ++u) {
+        EXPECT_EQ(program.getUniformName(u), records.uniforms[u].name);
+        EXPECT_EQ(program.getUniformBufferOffset(u), records.uniforms[u].offset);
+        EXPECT_EQ(program.getUniformType(u), records.uniforms[u].glDefineType);
+        EXPECT_EQ(program.getUniformArraySize(u), records.uniforms[u].size);
+        EXPECT_EQ(program.getUniformBlockIndex(u), records.uniforms[u].index);
+        EXPECT_EQ(program.getUniformBinding(u), records.uniforms[u].binding);
+    }
+    ASSERT_EQ(program.getNumLiveUniformBlocks(), (int)records.uniformBlocks.size());
+    for (int b = 0; b < program.getNumLiveUniformBlocks(); ++b) {
+        EXPECT_EQ(program.getUniformBlockName(b), records.uniformBlocks[b].name);
+        EXPECT_EQ(program.getUniformBlockSize(b), records.uniformBlocks[b].size);
+        EXPECT_EQ(program.getUniformBlockCounterIndex(b), records.uniformBlocks[b].counterIndex);
+    }
+    ASSERT_EQ(program.getNumLiveAttributes(), (int)records.attributes.size());
+    for (int a = 0; a < program.getNumLiveAttributes(); ++a) {
+        EXPECT_EQ(program.getAttributeName(a), records.attributes[a].name);
+        EXPECT_EQ(program.getAttributeType(a), records.attributes[a].glDefineType);
+    }
+    for (int dim = 0; dim < 3; ++dim)
+        EXPECT_EQ(program.getLocalSize(dim), records.localSize[dim]);
+}
+
+// The JSON form of the reflection is checked against the expected results,
+// and the binary form must read back to what the program's queries give.
+TEST_P(ReflectionTest, FromFile)
+{
+    const std::string fileName = GetParam();
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+
+    std::string contents;
+    tryLoadFile(GlobalTestSettings.testRoot + "/" + fileName, "input", &contents);
+    glslang::TShader shader(GetShaderStage(GetSuffix(fileName)));
+    compile(&shader, contents, "", controls);
+    glslang::TProgram program;
+    program.addShader(&shader);
+    ASSERT_TRUE(program.link(controls));
+    ASSERT_TRUE(program.buildReflection());
+
+    std::string json;
+    ASSERT_TRUE(program.serializeReflectionJson(json));
+    const std::string expectedOutputFname =
+        GlobalTestSettings.testRoot + "/baseResults/" + fileName + ".refl.json";
+    std::string expectedOutput;
+    tryLoadFile(expectedOutputFname, "expected output", &expectedOutput);
+    checkEqAndUpdateIfRequested(expectedOutput, json, expectedOutputFname);
+
+    std::vector<unsigned char> binary;
+    ASSERT_TRUE(program.serializeReflection(binary));
+    glslang::TReflectionRecords records;
+    ASSERT_TRUE(glslang::ReadReflectionRecords(binary.data(), binary.size(), records));
+    ExpectQueriedRecords(program, records);
+
+    // anything but the whole binary is rejected
+    EXPECT_FALSE(glslang::ReadReflectionRecords(binary.data(), binary.size() - 4, records));
+}
+
+// The records handed out in bulk are what the program's queries give, and
+// the same as the serialized ones, set included.
+TEST_P(ReflectionTest, Records)
+{
+    const std::string fileName = GetParam();
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+
+    std::string contents;
+    tryLoadFile(GlobalTestSettings.testRoot + "/" + fileName, "input", &contents);
+    glslang::TShader shader(GetShaderStage(GetSuffix(fileName)));
+    compile(&shader, contents, "", controls);
+    glslang::TProgram program;
+    program.addShader(&shader);
+    ASSERT_TRUE(program.link(controls));
+
+    glslang::TReflectionRecords records;
+    EXPECT_FALSE(program.getReflectionRecords(records));
+    ASSERT_TRUE(program.buildReflection());
+    ASSERT_TRUE(program.getReflectionRecords(records));
+    ExpectQueriedRecords(program, records);
+
+    std::vector<unsigned char> binary;
+    ASSERT_TRUE(program.serializeReflection(binary));
+    glslang::TReflectionRecords serialized;
+    ASSERT_TRUE(glslang::ReadReflectionRecords(binary.data(), binary.size(), serialized));
+    const auto expectSameTables = [](const std::vector<glslang::TReflectionRecord>& expected,
+                                     const std::vector<glslang::TReflectionRecord>& actual) {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t r = 0; r < expected.size(); ++r) {
+            EXPECT_EQ(expected[r].name, actual[r].name);
+            EXPECT_EQ(expected[r].counterIndex, actual[r].counterIndex);
+            EXPECT_EQ(expected[r].binding, actual[r].binding);
+            EXPECT_EQ(expected[r].set, actual[r].set);
+        }
+    };
+    expectSameTables(serialized.uniforms, records.uniforms);
+    expectSameTables(serialized.uniformBlocks, records.uniformBlocks);
+    expectSameTables(serialized.attributes, records.attributes);
+}
+
+// clang-format off
+INSTANTIATE_TEST_CASE_P(
+    Glsl, ReflectionTest,
+    ::testing::ValuesIn(std::vector<std::string>({
+        "reflection.vert",
+        "spv.310.comp",
+    })),
+);
+// clang-format on
+
+}  // anonymous namespace
+}  // namespace glslangtest
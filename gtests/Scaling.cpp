@@ -0,0 +1,209 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of 3Dlabs Inc. Ltd. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Guards the passes that used to cost time quadratic in the size of a shader:
+// each test times a pass at some size and at four times it, and fails if
+// the time grows by much more than four times.
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TestFixture.h"
+
+namespace glslangtest {
+namespace {
+
+// How much more time four times the size may take: four times for linear
+// cost, more as the data outgrows the caches, sixteen times for quadratic.
+const double growthBound = 10.0;
+
+// Measures the time of what is between its construction and seconds().
+class Stopwatch {
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) { }
+    double seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Expects the seconds 'secondsAt' returns for a size to grow about linearly
+// from size 'n' to size 4 * n.  The least of a few runs is taken for each
+// size, and times below a few milliseconds are not told apart, so neither
+// noise nor a fast machine fails the test.
+void ExpectLinear(int n, const std::function<double(int)>& secondsAt)
+{
+    const auto leastSecondsAt = [&secondsAt](int size) {
+        double least = secondsAt(size);
+        for (int run = 1; run < 3; ++run)
+            least = std::min(least, secondsAt(size));
+        return least;
+    };
+    const double floor = 0.005;
+    const double small = std::max(leastSecondsAt(n), floor);
+    const double large = leastSecondsAt(4 * n);
+    EXPECT_LE(large, growthBound * small)
+        << n << " took " << small << "s, " << 4 * n << " took " << large << "s";
+}
+
+using ScalingTest = GlslangTest<::testing::Test>;
+
+// Looking up the names of a shader with many globals, each read once.
+TEST_F(ScalingTest, SymbolLookup)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+    ExpectLinear(2000, [this, controls](int globals) {
+        std::ostringstream source;
+        source << "#version 450\n";
+        for (int g = 0; g < globals; ++g)
+            source << "float global" << g << ";\n";
+        source << "out float color;\nvoid main() {\n    color = 0.0;\n";
+        for (int g = 0; g < globals; ++g)
+            source << "    color += global" << g << ";\n";
+        source << "}\n";
+
+        glslang::TShader shader(EShLangFragment);
+        const Stopwatch stopwatch;
+        EXPECT_TRUE(compile(&shader, source.str(), "", controls));
+        return stopwatch.seconds();
+    });
+}
+
+// Linking units that all declare the same many uniforms.
+TEST_F(ScalingTest, LinkManyUnits)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+    const int units = 4;
+    ExpectLinear(5000, [this, controls](int uniforms) {
+        std::ostringstream declarations;
+        declarations << "#version 450\n";
+        for (int u = 0; u < uniforms; ++u)
+            declarations << "uniform float uniform" << u << ";\n";
+
+        std::vector<std::unique_ptr<glslang::TShader>> shaders;
+        glslang::TProgram program;
+        for (int unit = 0; unit < units; ++unit) {
+            std::ostringstream source;
+            source << declarations.str();
+            if (unit == 0) {
+                source << "out float color;\n";
+                for (int callee = 1; callee < units; ++callee)
+                    source << "float unit" << callee << "();\n";
+                source << "void main() {\n    color = 0.0;\n";
+                for (int callee = 1; callee < units; ++callee)
+                    source << "    color += unit" << callee << "();\n";
+                source << "}\n";
+            } else {
+                source << "float unit" << unit << "() { return uniform" << unit << "; }\n";
+            }
+            shaders.emplace_back(new glslang::TShader(EShLangFragment));
+            EXPECT_TRUE(compile(shaders.back().get(), source.str(), "", controls));
+            program.addShader(shaders.back().get());
+        }
+
+        const Stopwatch stopwatch;
+        EXPECT_TRUE(program.link(controls));
+        return stopwatch.seconds();
+    });
+}
+
+// Mapping the bindings of a shader that uses many textures.
+TEST_F(ScalingTest, MapManyUniforms)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+    ExpectLinear(4000, [this, controls](int textures) {
+        std::ostringstream source;
+        source << "#version 450\n";
+        for (int t = 0; t < textures; ++t)
+            source << "uniform sampler2D texture" << t << ";\n";
+        source << "out vec4 color;\nvoid main() {\n    color = vec4(0.0);\n";
+        for (int t = 0; t < textures; ++t)
+            source << "    color += texture(texture" << t << ", vec2(0.0));\n";
+        source << "}\n";
+
+        glslang::TShader shader(EShLangFragment);
+        shader.setAutoMapBindings(true);
+        glslang::TProgram program;
+        program.addShader(&shader);
+        EXPECT_TRUE(compile(&shader, source.str(), "", controls));
+        EXPECT_TRUE(program.link(controls));
+
+        const Stopwatch stopwatch;
+        EXPECT_TRUE(program.mapIO());
+        return stopwatch.seconds();
+    });
+}
+
+// Generating SPIR-V for a large table of constants.
+TEST_F(ScalingTest, ConstantTable)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::Vulkan, Target::Spv);
+    ExpectLinear(20000, [this, controls](int entries) {
+        std::ostringstream source;
+        source << "#version 450\nconst float table[" << entries << "] = float[](";
+        for (int e = 0; e < entries; ++e)
+            source << (e == 0 ? "" : ", ") << e << ".5";
+        source << ");\nlayout(location = 0) flat in int index;\nlayout(location = 0) out float color;\n"
+               << "void main() { color = table[index]; }\n";
+
+        glslang::TShader shader(EShLangFragment);
+        glslang::TProgram program;
+        program.addShader(&shader);
+        EXPECT_TRUE(compile(&shader, source.str(), "", controls));
+        EXPECT_TRUE(program.link(controls));
+
+        glslang::SpvOptions options;
+        options.disableOptimizer = true;
+        std::vector<uint32_t> spirv;
+        spv::SpvBuildLogger logger;
+        const Stopwatch stopwatch;
+        glslang::GlslangToSpv(*program.getIntermediate(EShLangFragment), spirv, &logger, &options);
+        const double seconds = stopwatch.seconds();
+        EXPECT_LT(size_t(entries) * 4, spirv.size());
+        return seconds;
+    });
+}
+
+}  // anonymous namespace
+}  // namespace glslangtest
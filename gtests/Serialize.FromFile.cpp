@@ -0,0 +1,188 @@
+//
+// Copyright (C) 2017 The Khronos Group Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of Google Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "TestFixture.h"
+
+namespace glslangtest {
+namespace {
+
+struct SerializeTestArgs {
+    const char* fileName;
+    const char* entryPoint;
+    Source      sourceLanguage;
+    Semantics   semantics;
+};
+
+// We are using SerializeTestArgs objects as parameters for instantiating
+// the template, so the global FileNameAsCustomTestSuffix() won't work since
+// it assumes std::string as parameters. Thus, an overriding one here.
+std::string FileNameAsCustomTestSuffix(
+    const ::testing::TestParamInfo<SerializeTestArgs>& info) {
+    std::string name = info.param.fileName;
+    // A valid test case suffix cannot have '.' and '-' inside.
+    std::replace(name.begin(), name.end(), '.', '_');
+    std::replace(name.begin(), name.end(), '-', '_');
+    return name;
+}
+
+class SerializeTest : public GlslangTest<::testing::TestWithParam<SerializeTestArgs>> {
+protected:
+    // Links |shader| on its own and returns the linker's AST dump, followed by
+    // the SPIR-V disassembly when |controls| asks for SPIR-V and |compiled|
+    // says the tree came from a successful compile.
+    std::string linkAndDump(glslang::TShader& shader, EShLanguage kind, EShMessages controls,
+                            bool compiled)
+    {
+        glslang::TProgram program;
+        program.addShader(&shader);
+        bool success = compiled;
+        success &= program.link(controls);
+        std::string dump = program.getInfoLog();
+
+        if (success && (controls & EShMsgSpvRules)) {
+            std::vector<uint32_t> spirv_binary;
+            spv::SpvBuildLogger logger;
+            glslang::SpvOptions options;
+            options.disableOptimizer = true;
+            glslang::GlslangToSpv(*program.getIntermediate(kind), spirv_binary, &logger, &options);
+
+            std::ostringstream disassembly_stream;
+            spv::Parameterize();
+            spv::Disassemble(disassembly_stream, spirv_binary);
+            dump += logger.getAllMessages();
+            dump += disassembly_stream.str();
+        }
+
+        return dump;
+    }
+};
+
+// Compiles a shader, stores its parsed form, loads that back into a fresh
+// shader, and checks that both link to the same AST and SPIR-V.  Trees from
+// failed compiles are round-tripped too; they just skip code generation.
+TEST_P(SerializeTest, FromFile)
+{
+    const SerializeTestArgs& args = GetParam();
+    const std::string inputFname = GlobalTestSettings.testRoot + "/" + args.fileName;
+    std::string input;
+    tryLoadFile(inputFname, "input", &input);
+
+    const EShLanguage kind = GetShaderStage(GetSuffix(args.fileName));
+    const Target target = args.semantics == Semantics::Vulkan ? Target::BothASTAndSpv : Target::AST;
+    const EShMessages controls = DeriveOptions(args.sourceLanguage, args.semantics, target);
+
+    glslang::TShader parsed(kind);
+    parsed.setAutoMapLocations(true);
+    const bool compiled = compile(&parsed, input, args.entryPoint, controls);
+
+    std::vector<unsigned char> binary;
+    ASSERT_TRUE(parsed.serialize(binary));
+
+    glslang::TShader loaded(kind);
+    ASSERT_TRUE(loaded.deserialize(&glslang::DefaultTBuiltInResource, binary.data(), binary.size()));
+
+    // Storing what was loaded must reproduce the original bytes.
+    std::vector<unsigned char> reserialized;
+    ASSERT_TRUE(loaded.serialize(reserialized));
+    EXPECT_TRUE(binary == reserialized);
+
+    EXPECT_EQ(linkAndDump(parsed, kind, controls, compiled),
+              linkAndDump(loaded, kind, controls, compiled));
+
+    // A truncated binary must be rejected rather than half loaded.
+    glslang::TShader truncated(kind);
+    EXPECT_FALSE(truncated.deserialize(&glslang::DefaultTBuiltInResource, binary.data(), binary.size() / 2));
+}
+
+// clang-format off
+INSTANTIATE_TEST_CASE_P(
+    Glsl, SerializeTest,
+    ::testing::ValuesIn(std::vector<SerializeTestArgs>{
+        {"types.frag", "", Source::GLSL, Semantics::OpenGL},
+        {"constFold.frag", "", Source::GLSL, Semantics::OpenGL},
+        {"switch.frag", "", Source::GLSL, Semantics::OpenGL},
+        {"matrix.frag", "", Source::GLSL, Semantics::OpenGL},
+        {"310.comp", "", Source::GLSL, Semantics::OpenGL},
+        {"precise.tesc", "", Source::GLSL, Semantics::OpenGL},
+        {"450.tese", "", Source::GLSL, Semantics::OpenGL},
+        {"420_size_gl_in.geom", "", Source::GLSL, Semantics::OpenGL},
+        {"300block.frag", "", Source::GLSL, Semantics::OpenGL},
+        {"uint.frag", "", Source::GLSL, Semantics::OpenGL},
+        {"spv.specConstant.vert", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.specConstantComposite.vert", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.specConstantOperations.vert", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.switch.frag", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.for-continue-break.vert", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.structAssignment.frag", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.precise.tese", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.400.frag", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.atomic.comp", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.sparseTexture.frag", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.int64.frag", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.pushConstant.vert", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.subpass.frag", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.memoryQualifier.frag", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.multiStruct.comp", "", Source::GLSL, Semantics::Vulkan},
+        {"spv.aggOps.frag", "", Source::GLSL, Semantics::Vulkan},
+    }),
+    FileNameAsCustomTestSuffix
+);
+
+INSTANTIATE_TEST_CASE_P(
+    Hlsl, SerializeTest,
+    ::testing::ValuesIn(std::vector<SerializeTestArgs>{
+        {"hlsl.struct.frag", "PixelShaderFunction", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.switch.frag", "PixelShaderFunction", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.structbuffer.frag", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.entry-out.frag", "PixelShaderFunction", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.array.implicit-size.frag", "PixelShaderFunction", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.semantic.vert", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.flatten.return.frag", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.intrinsics.frag", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.tx.overload.frag", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.basic.geom", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.hull.1.tesc", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.string.frag", "main", Source::HLSL, Semantics::Vulkan},
+        {"hlsl.texture.struct.frag", "main", Source::HLSL, Semantics::Vulkan},
+    }),
+    FileNameAsCustomTestSuffix
+);
+// clang-format on
+
+}  // anonymous namespace
+}  // namespace glslangtest
@@ -76,6 +76,11 @@ using CompileVulkanToSpirvTestAMD = GlslangTest<::testing::TestWithParam<std::st
 using CompileVulkanToSpirvTestNV = GlslangTest<::testing::TestWithParam<std::string>>;
 #endif
 using CompileUpgradeTextureToSampledTextureAndDropSamplersTest = GlslangTest<::testing::TestWithParam<std::string>>;
+using CompileVulkanToSpirvDeadCodeElimTest = GlslangTest<::testing::TestWithParam<std::string>>;
+using CompileVulkanToSpirvInlineTest = GlslangTest<::testing::TestWithParam<std::string>>;
+using CompileVulkanToSpirvForwardLoadsTest = GlslangTest<::testing::TestWithParam<std::string>>;
+using SpirvSinkTest = GlslangTest<::testing::Test>;
+using DeepExpressionTest = GlslangTest<::testing::Test>;
 
 // Compiling GLSL to SPIR-V under Vulkan semantics. Expected to successfully
 // generate SPIR-V.
@@ -86,6 +91,30 @@ TEST_P(CompileVulkanToSpirvTest, FromFile)
                             Target::Spv);
 }
 
+// Reflecting the SPIR-V compiled from GLSL under Vulkan semantics. Expected to
+// agree with the reflection of the source.
+TEST_P(CompileVulkanToSpirvTest, Reflection)
+{
+    loadFileCompileAndCheckSpirvReflection(GlobalTestSettings.testRoot, GetParam(),
+                                           Source::GLSL, Semantics::Vulkan);
+}
+
+// Generating the SPIR-V compiled from GLSL under Vulkan semantics through a
+// sink. Expected to give the same words as generating it into a vector.
+TEST_P(CompileVulkanToSpirvTest, Sink)
+{
+    loadFileCompileAndCheckSpirvSink(GlobalTestSettings.testRoot, GetParam(),
+                                     Source::GLSL, Semantics::Vulkan);
+}
+
+// Generating the SPIR-V compiled from GLSL under Vulkan semantics with loads
+// forwarded. Expected to be well formed, and reflect as without forwarding.
+TEST_P(CompileVulkanToSpirvTest, ForwardLoads)
+{
+    loadFileCompileAndCheckForwardedLoads(GlobalTestSettings.testRoot, GetParam(),
+                                          Source::GLSL, Semantics::Vulkan);
+}
+
 // Compiling GLSL to SPIR-V under OpenGL semantics. Expected to successfully
 // generate SPIR-V.
 TEST_P(CompileOpenGLToSpirvTest, FromFile)
@@ -182,6 +211,33 @@ TEST_P(CompileUpgradeTextureToSampledTextureAndDropSamplersTest, FromFile)
                                                                      Target::Spv);
 }
 
+// Compiling GLSL to SPIR-V under Vulkan semantics, with dead code eliminated
+// from the AST first.
+TEST_P(CompileVulkanToSpirvDeadCodeElimTest, FromFile)
+{
+    loadFileCompileEliminateDeadCodeAndCheck(GlobalTestSettings.testRoot, GetParam(),
+                                             Source::GLSL, Semantics::Vulkan,
+                                             Target::BothASTAndSpv);
+}
+
+// Compiling GLSL to SPIR-V under Vulkan semantics, with small functions
+// inlined in the AST first.
+TEST_P(CompileVulkanToSpirvInlineTest, FromFile)
+{
+    loadFileCompileOptimizeAndCheck(GlobalTestSettings.testRoot, GetParam(),
+                                    Source::GLSL, Semantics::Vulkan,
+                                    Target::BothASTAndSpv, EShMsgInlineFunctions);
+}
+
+// Compiling GLSL to SPIR-V under Vulkan semantics, with loads forwarded from
+// earlier loads and stores in the same block.
+TEST_P(CompileVulkanToSpirvForwardLoadsTest, FromFile)
+{
+    loadFileCompileOptimizeAndCheck(GlobalTestSettings.testRoot, GetParam(),
+                                    Source::GLSL, Semantics::Vulkan,
+                                    Target::Spv, EShMsgDefault, "", true);
+}
+
 // clang-format off
 INSTANTIATE_TEST_CASE_P(
     Glsl, CompileVulkanToSpirvTest,
@@ -441,7 +497,211 @@ INSTANTIATE_TEST_CASE_P(
     })),
     FileNameAsCustomTestSuffix
 );
+
+INSTANTIATE_TEST_CASE_P(
+    Glsl, CompileVulkanToSpirvDeadCodeElimTest,
+    ::testing::ValuesIn(std::vector<std::string>({
+        "spv.deadCode.frag",
+    })),
+    FileNameAsCustomTestSuffix
+);
+
+INSTANTIATE_TEST_CASE_P(
+    Glsl, CompileVulkanToSpirvInlineTest,
+    ::testing::ValuesIn(std::vector<std::string>({
+        "spv.inline.frag",
+    })),
+    FileNameAsCustomTestSuffix
+);
+
+INSTANTIATE_TEST_CASE_P(
+    Glsl, CompileVulkanToSpirvForwardLoadsTest,
+    ::testing::ValuesIn(std::vector<std::string>({
+        "spv.forwardLoads.frag",
+    })),
+    FileNameAsCustomTestSuffix
+);
 // clang-format on
 
+// A module with id bound 'bound' and 'instructions', each an opcode and its operands.
+std::vector<unsigned int> AssembleSpirv(unsigned int bound, const std::vector<std::vector<unsigned int>>& instructions)
+{
+    std::vector<unsigned int> words = { spv::MagicNumber, spv::Version, 0, bound, 0 };
+    for (const auto& instruction : instructions) {
+        words.push_back((unsigned int)instruction.size() << spv::WordCountShift | instruction[0]);
+        words.insert(words.end(), instruction.begin() + 1, instruction.end());
+    }
+    return words;
+}
+
+// A uniform block of struct %2, with a float member %1 decorated by 'memberDecorations',
+// declared as 'types' has it.
+std::vector<unsigned int> AssembleBlock(const std::vector<std::vector<unsigned int>>& memberDecorations,
+                                        const std::vector<std::vector<unsigned int>>& types, unsigned int bound = 10)
+{
+    std::vector<std::vector<unsigned int>> instructions = {
+        { spv::OpDecorate, 2, spv::DecorationBlock },
+    };
+    instructions.insert(instructions.end(), memberDecorations.begin(), memberDecorations.end());
+    instructions.insert(instructions.end(), types.begin(), types.end());
+    instructions.push_back({ spv::OpTypePointer, 8, spv::StorageClassUniform, 2 });
+    instructions.push_back({ spv::OpVariable, 8, 9, spv::StorageClassUniform });
+    return AssembleSpirv(bound, instructions);
+}
+
+// Why reflecting 'spirv' failed, or "" if it didn't.
+std::string ReflectionError(const std::vector<unsigned int>& spirv)
+{
+    glslang::TReflectionRecords records;
+    std::string error;
+    return spv::ReflectSpirv(spirv, records, error) ? std::string() : error;
+}
+
+// Reflecting SPIR-V doesn't trust the module: malformed ones fail, rather than
+// being read out of range.  First, the module the others break.
+// A module too big for one buffer reaches the sink over several calls, and
+// still gives the same words as generating it into a vector.
+TEST_F(SpirvSinkTest, ManyBuffers)
+{
+    std::string input = "#version 450\nlayout(location = 0) out vec4 color;\nvoid main() {\n    color = vec4(0.0);\n";
+    for (int i = 0; i < 1000; ++i)
+        input += "    color = color * " + std::to_string(i) + ".5 + vec4(" + std::to_string(i) + ");\n";
+    input += "}\n";
+
+    EXPECT_GT(compileAndCheckSpirvSink(input, EShLangFragment,
+                                       DeriveOptions(Source::GLSL, Semantics::Vulkan, Target::Spv)), 1);
+}
+
+// A chain of operations far deeper than the stack allows recursing on still
+// makes SPIR-V, with an instruction per operation.
+TEST_F(DeepExpressionTest, LongChain)
+{
+    const int operations = 50000;
+    std::string input = "#version 450\nlayout(location = 0) in float a;\nlayout(location = 0) out float o;\nvoid main() { o = a";
+    for (int i = 0; i < operations; ++i)
+        input += " + a";
+    input += "; }\n";
+
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::Vulkan, Target::Spv);
+    glslang::TShader shader(EShLangFragment);
+    ASSERT_TRUE(compile(&shader, input, "", controls));
+    glslang::TProgram program;
+    program.addShader(&shader);
+    ASSERT_TRUE(program.link(controls));
+
+    std::vector<uint32_t> spirv;
+    glslang::GlslangToSpv(*program.getIntermediate(EShLangFragment), spirv);
+    EXPECT_EQ(operations, std::count(spirv.begin(), spirv.end(), (5u << spv::WordCountShift) | spv::OpFAdd));
+}
+
+TEST(SpvReflection, WellFormedBlock)
+{
+    const auto spirv = AssembleBlock({ { spv::OpMemberName, 2, 0, 'x' },
+                                       { spv::OpMemberDecorate, 2, 0, spv::DecorationOffset, 0 } },
+                                     { { spv::OpTypeFloat, 1, 32 },
+                                       { spv::OpTypeStruct, 2, 1 } });
+    glslang::TReflectionRecords records;
+    std::string error;
+    ASSERT_TRUE(spv::ReflectSpirv(spirv, records, error)) << error;
+    ASSERT_EQ(1u, records.uniformBlocks.size());
+    EXPECT_EQ(4, records.uniformBlocks[0].size);
+    ASSERT_EQ(1u, records.uniforms.size());
+    EXPECT_EQ("x", records.uniforms[0].name);
+}
+
+// A member index of 0xFFFFFFFF, which wraps to 0 when one is added to it.
+TEST(SpvReflection, MemberIndexThatWraps)
+{
+    const auto spirv = AssembleBlock({ { spv::OpMemberName, 2, 0xFFFFFFFF, 'x' } },
+                                     { { spv::OpTypeFloat, 1, 32 },
+                                       { spv::OpTypeStruct, 2, 1 } });
+    EXPECT_EQ("member index is out of range", ReflectionError(spirv));
+}
+
+// Member indexes past the end of the struct, before and after it is declared.
+TEST(SpvReflection, MemberIndexPastTheStruct)
+{
+    const auto before = AssembleBlock({ { spv::OpMemberDecorate, 2, 100000000, spv::DecorationOffset, 0 } },
+                                      { { spv::OpTypeFloat, 1, 32 },
+                                        { spv::OpTypeStruct, 2, 1 } });
+    EXPECT_EQ("member index is out of range", ReflectionError(before));
+
+    const auto after = AssembleSpirv(10, { { spv::OpTypeFloat, 1, 32 },
+                                           { spv::OpTypeStruct, 2, 1 },
+                                           { spv::OpMemberName, 2, 1, 'x' } });
+    EXPECT_EQ("member index is out of range", ReflectionError(after));
+}
+
+// A type id declared again, as a struct of a struct of itself.
+TEST(SpvReflection, TypeRedeclaredIntoACycle)
+{
+    const auto spirv = AssembleBlock({},
+                                     { { spv::OpTypeFloat, 1, 32 },
+                                       { spv::OpTypeStruct, 2, 1 },
+                                       { spv::OpTypeStruct, 1, 2 } });
+    EXPECT_EQ("result id is declared twice", ReflectionError(spirv));
+}
+
+// Structs nested deeper than SPIR-V allows.
+TEST(SpvReflection, TypesNestedTooDeeply)
+{
+    std::vector<std::vector<unsigned int>> types = { { spv::OpTypeFloat, 10, 32 } };
+    for (unsigned int depth = 0; depth < 300; ++depth)
+        types.push_back({ spv::OpTypeStruct, 11 + depth, 10 + depth });
+    types.push_back({ spv::OpTypeStruct, 2, 310 });
+    EXPECT_EQ("types are nested too deeply", ReflectionError(AssembleBlock({}, types, 400)));
+}
+
+// Blocks whose size does not fit in an int.
+TEST(SpvReflection, BlockSizeOutOfRange)
+{
+    // a float[0x40000000] with a stride of 16
+    const auto array = AssembleBlock({ { spv::OpDecorate, 5, spv::DecorationArrayStride, 16 } },
+                                     { { spv::OpTypeFloat, 1, 32 },
+                                       { spv::OpTypeInt, 3, 32, 0 },
+                                       { spv::OpConstant, 3, 4, 0x40000000 },
+                                       { spv::OpTypeArray, 5, 1, 4 },
+                                       { spv::OpTypeStruct, 2, 5 } });
+    EXPECT_EQ("block size is out of range", ReflectionError(array));
+
+    // a float at the largest offset there is
+    const auto offset = AssembleBlock({ { spv::OpMemberDecorate, 2, 0, spv::DecorationOffset, 0x7FFFFFFF } },
+                                      { { spv::OpTypeFloat, 1, 32 },
+                                        { spv::OpTypeStruct, 2, 1 } });
+    EXPECT_EQ("block size is out of range", ReflectionError(offset));
+}
+
+// The check the forwarded loads of the corpus go through finds a value
+// used ahead of where it is defined, as a load forwarded too far would be.
+TEST(SpvForwardLoads, IdUsedBeforeDefinition)
+{
+    // %1 = float, %2 = void, %3 = fn void(), %4 = Function float*
+    const std::vector<std::vector<unsigned int>> types = {
+        { spv::OpTypeFloat, 1, 32 },
+        { spv::OpTypeVoid, 2 },
+        { spv::OpTypeFunction, 3, 2 },
+        { spv::OpTypePointer, 4, spv::StorageClassFunction, 1 },
+    };
+    const auto function = [&types](const std::vector<std::vector<unsigned int>>& body) {
+        std::vector<std::vector<unsigned int>> instructions = types;
+        instructions.push_back({ spv::OpFunction, 2, 5, spv::FunctionControlMaskNone, 3 });
+        instructions.push_back({ spv::OpLabel, 6 });
+        instructions.push_back({ spv::OpVariable, 4, 7, spv::StorageClassFunction });
+        instructions.insert(instructions.end(), body.begin(), body.end());
+        instructions.push_back({ spv::OpReturn });
+        instructions.push_back({ spv::OpFunctionEnd });
+        return AssembleSpirv(10, instructions);
+    };
+
+    EXPECT_EQ("", FindIdUsedBeforeDefinition(function({ { spv::OpLoad, 1, 8, 7 },
+                                                         { spv::OpFAdd, 1, 9, 8, 8 },
+                                                         { spv::OpStore, 7, 9 } })));
+    EXPECT_NE("", FindIdUsedBeforeDefinition(function({ { spv::OpFAdd, 1, 9, 8, 8 },
+                                                         { spv::OpLoad, 1, 8, 7 },
+                                                         { spv::OpStore, 7, 9 } })));
+    EXPECT_NE("", FindIdUsedBeforeDefinition(function({ { spv::OpLoad, 1, 8, 7 },
+                                                         { spv::OpStore, 7, 12 } })));
+}
+
 }  // anonymous namespace
 }  // namespace glslangtest
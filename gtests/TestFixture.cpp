@@ -159,4 +159,107 @@ std::string GetSuffix(const std::string& name)
     return (pos == std::string::npos) ? "" : name.substr(name.rfind('.') + 1);
 }
 
+int CountSpirvInstructions(const std::string& disassembly)
+{
+    // Each instruction is on its own line; the rest are comments and blank lines.
+    int count = 0;
+    std::istringstream lines(disassembly);
+    std::string line;
+    while (std::getline(lines, line)) {
+        const size_t start = line.find_first_not_of(' ');
+        if (start != std::string::npos && line.compare(start, 2, "//") != 0)
+            ++count;
+    }
+
+    return count;
+}
+
+std::string FindIdUsedBeforeDefinition(const std::vector<std::uint32_t>& spirv)
+{
+    spv::Parameterize();
+
+    const size_t header = 5;
+    if (spirv.size() < header)
+        return "no header";
+    const std::uint32_t bound = spirv[3];
+
+    // The result ids of the instruction at 'word', or 0 if it has none
+    // the opcode tables know of.
+    const auto resultOf = [&spirv](size_t word) -> std::uint32_t {
+        const unsigned opCode = spirv[word] & spv::OpCodeMask;
+        if (opCode >= spv::OpcodeCeiling || !spv::InstructionDesc[opCode].hasResult())
+            return 0;
+        return spirv[word + (spv::InstructionDesc[opCode].hasType() ? 2 : 1)];
+    };
+
+    std::vector<bool> definedInFunction(bound);
+    std::vector<bool> defined(bound);
+    size_t functionStart = 0;
+    for (size_t word = header; word < spirv.size(); ) {
+        const unsigned wordCount = spirv[word] >> spv::WordCountShift;
+        const unsigned opCode = spirv[word] & spv::OpCodeMask;
+        if (wordCount == 0 || word + wordCount > spirv.size())
+            return "instruction at word " + std::to_string(word) + " has a bad size";
+        const std::uint32_t result = resultOf(word);
+        if (result >= bound)
+            return "id " + std::to_string(result) + " is not below the bound";
+
+        if (opCode == spv::OpFunction) {
+            // Find what the function defines, other than the labels
+            // branches go to ahead.
+            functionStart = word;
+            std::fill(definedInFunction.begin(), definedInFunction.end(), false);
+            std::fill(defined.begin(), defined.end(), false);
+            for (size_t inner = word; inner < spirv.size() && (spirv[inner] >> spv::WordCountShift) != 0; ) {
+                const unsigned innerOp = spirv[inner] & spv::OpCodeMask;
+                const std::uint32_t innerResult = resultOf(inner);
+                if (innerOp != spv::OpLabel && innerResult != 0 && innerResult < bound)
+                    definedInFunction[innerResult] = true;
+                if (innerOp == spv::OpFunctionEnd)
+                    break;
+                inner += spirv[inner] >> spv::WordCountShift;
+            }
+        } else if (opCode == spv::OpFunctionEnd) {
+            functionStart = 0;
+        }
+
+        if (functionStart != 0 && opCode < spv::OpcodeCeiling && opCode != spv::OpPhi) {
+            // Walk the operands up to the first one whose words can't be
+            // told apart as ids without knowing more of the instruction.
+            const spv::OperandParameters& operands = spv::InstructionDesc[opCode].operands;
+            size_t operand = word + 1 + (spv::InstructionDesc[opCode].hasType() ? 1 : 0) +
+                             (spv::InstructionDesc[opCode].hasResult() ? 1 : 0);
+            bool variableIds = false;
+            for (int op = 0; operand < word + wordCount; ++op) {
+                if (!variableIds) {
+                    if (op >= operands.getNum())
+                        break;
+                    const spv::OperandClass operandClass = operands.getClass(op);
+                    if (operandClass == spv::OperandLiteralNumber || operandClass == spv::OperandImageOperands) {
+                        ++operand;
+                        continue;
+                    }
+                    if (operandClass == spv::OperandVariableIds)
+                        variableIds = true;
+                    else if (operandClass != spv::OperandId && operandClass != spv::OperandScope &&
+                             operandClass != spv::OperandMemorySemantics)
+                        break;
+                }
+                const std::uint32_t id = spirv[operand++];
+                if (id >= bound)
+                    return "id " + std::to_string(id) + " is not below the bound";
+                if (definedInFunction[id] && !defined[id])
+                    return "id " + std::to_string(id) + " is used at word " + std::to_string(word) +
+                           " before it is defined";
+            }
+        }
+        if (result != 0)
+            defined[result] = true;
+
+        word += wordCount;
+    }
+
+    return "";
+}
+
 }  // namespace glslangtest
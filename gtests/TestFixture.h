@@ -48,7 +48,9 @@
 #include "SPIRV/disassemble.h"
 #include "SPIRV/doc.h"
 #include "SPIRV/SPVRemapper.h"
+#include "SPIRV/SpvReflection.h"
 #include "StandAlone/ResourceLimits.h"
+#include "glslang/MachineIndependent/gl_types.h"
 #include "glslang/Public/ShaderLang.h"
 
 #include "Initializer.h"
@@ -96,6 +98,14 @@ bool WriteFile(const std::string& path, const std::string& contents);
 // Returns the suffix of the given |name|.
 std::string GetSuffix(const std::string& name);
 
+// Returns the number of instructions in the given SPIR-V |disassembly|.
+int CountSpirvInstructions(const std::string& disassembly);
+
+// Returns what is wrong with the ids the functions of the SPIR-V module
+// |spirv| use: an id defined in a function must be defined before it is
+// used, other than by OpPhi.  Returns an empty string if nothing is.
+std::string FindIdUsedBeforeDefinition(const std::vector<std::uint32_t>& spirv);
+
 // Base class for glslang integration tests. It contains many handy utility-like
 // methods such as reading shader source files, compiling into AST/SPIR-V, and
 // comparing with expected outputs.
@@ -199,7 +209,7 @@ public:
             const std::string& entryPointName, EShMessages controls,
             bool flattenUniformArrays = false,
             EShTextureSamplerTransformMode texSampTransMode = EShTexSampTransKeep,
-            bool disableOptimizer = true)
+            bool disableOptimizer = true, bool forwardLoads = false)
     {
         const EShLanguage kind = GetShaderStage(GetSuffix(shaderName));
 
@@ -220,6 +230,7 @@ public:
             std::vector<uint32_t> spirv_binary;
             glslang::SpvOptions options;
             options.disableOptimizer = disableOptimizer;
+            options.forwardLoads = forwardLoads;
             glslang::GlslangToSpv(*program.getIntermediate(kind),
                                   spirv_binary, &logger, &options);
 
@@ -407,6 +418,62 @@ public:
                                     expectedOutputFname);
     }
 
+    // Like loadFileCompileAndCheck(), but with dead code, including uncalled
+    // functions, eliminated from the AST before generating SPIR-V.  The output
+    // ends with how many SPIR-V instructions that took, and how many it takes
+    // without eliminating.
+    void loadFileCompileEliminateDeadCodeAndCheck(const std::string& testDir,
+                                                  const std::string& testName,
+                                                  Source source,
+                                                  Semantics semantics,
+                                                  Target target,
+                                                  const std::string& entryPointName="")
+    {
+        loadFileCompileOptimizeAndCheck(testDir, testName, source, semantics, target,
+                                        EShMsgEliminateDeadCode, entryPointName, false,
+                                        "without dead code elimination");
+    }
+
+    // Like loadFileCompileAndCheck(), but with the given link-time
+    // optimizations done on the AST before generating SPIR-V, and loads
+    // forwarded while generating it if 'forwardLoads', and without keeping
+    // uncalled functions.  The output ends with how many SPIR-V instructions
+    // that took, and how many it takes 'unoptimized'.
+    void loadFileCompileOptimizeAndCheck(const std::string& testDir,
+                                         const std::string& testName,
+                                         Source source,
+                                         Semantics semantics,
+                                         Target target,
+                                         EShMessages optimizations,
+                                         const std::string& entryPointName="",
+                                         bool forwardLoads = false,
+                                         const char* unoptimized = "unoptimized")
+    {
+        const std::string inputFname = testDir + "/" + testName;
+        const std::string expectedOutputFname =
+            testDir + "/baseResults/" + testName + ".out";
+        std::string input, expectedOutput;
+
+        tryLoadFile(inputFname, "input", &input);
+        tryLoadFile(expectedOutputFname, "expected output", &expectedOutput);
+
+        const EShMessages controls = (EShMessages)(DeriveOptions(source, semantics, target) & ~EShMsgKeepUncalled);
+        GlslangResult result = compileAndLink(testName, input, entryPointName,
+                                              (EShMessages)(controls | optimizations), false,
+                                              EShTexSampTransKeep, true, forwardLoads);
+        GlslangResult baseline = compileAndLink(testName, input, entryPointName, controls);
+
+        // Generate the hybrid output in the way of glslangValidator.
+        std::ostringstream stream;
+        outputResultToStream(&stream, result, controls);
+        stream << "Instructions: " << CountSpirvInstructions(result.spirv)
+               << " (" << CountSpirvInstructions(baseline.spirv)
+               << " " << unoptimized << ")\n";
+
+        checkEqAndUpdateIfRequested(expectedOutput, stream.str(),
+                                    expectedOutputFname);
+    }
+
     void loadFileCompileFlattenUniformsAndCheck(const std::string& testDir,
                                                 const std::string& testName,
                                                 Source source,
@@ -602,6 +669,229 @@ public:
                                     expectedOutputFname);
     }
 
+    // Compiles and links the given source |testName|, and checks that
+    // generating SPIR-V through a sink gives the same words as generating it
+    // into a vector. Shaders that can't be compiled or linked are skipped.
+    void loadFileCompileAndCheckSpirvSink(const std::string& testDir,
+                                          const std::string& testName,
+                                          Source source,
+                                          Semantics semantics)
+    {
+        std::string input;
+        tryLoadFile(testDir + "/" + testName, "input", &input);
+
+        compileAndCheckSpirvSink(input, GetShaderStage(GetSuffix(testName)),
+                                 DeriveOptions(source, semantics, Target::Spv));
+    }
+
+    // Does the checking of loadFileCompileAndCheckSpirvSink() for |input|,
+    // a |kind| shader. Returns how many times the sink was called, 0 if
+    // the shader was skipped.
+    int compileAndCheckSpirvSink(const std::string& input, EShLanguage kind,
+                                 EShMessages controls)
+    {
+        glslang::TShader shader(kind);
+        shader.setAutoMapLocations(true);
+        glslang::TProgram program;
+        program.addShader(&shader);
+        if (!compile(&shader, input, "", controls) || !program.link(controls))
+            return 0;
+
+        glslang::SpvOptions options;
+        options.disableOptimizer = true;
+        std::vector<uint32_t> spirv;
+        spv::SpvBuildLogger logger;
+        glslang::GlslangToSpv(*program.getIntermediate(kind), spirv, &logger, &options);
+
+        std::vector<uint32_t> sunk;
+        int calls = 0;
+        spv::SpvBuildLogger sinkLogger;
+        glslang::GlslangToSpv(*program.getIntermediate(kind),
+                              [&sunk, &calls](const unsigned int* words, size_t count) {
+                                  sunk.insert(sunk.end(), words, words + count);
+                                  ++calls;
+                              },
+                              &sinkLogger, &options);
+
+        EXPECT_EQ(spirv, sunk);
+        EXPECT_GE(calls, 1);
+        EXPECT_EQ(logger.getAllMessages(), sinkLogger.getAllMessages());
+        return calls;
+    }
+
+    // Compiles and links the given source |testName|, and checks the SPIR-V
+    // made of it with loads forwarded against the SPIR-V made without: its
+    // functions define each id before using it, it is no larger, and it
+    // reflects the same.  Only shaders whose expected output says they fail
+    // to compile or link are skipped.
+    void loadFileCompileAndCheckForwardedLoads(const std::string& testDir,
+                                               const std::string& testName,
+                                               Source source,
+                                               Semantics semantics)
+    {
+        std::string input, expectedOutput;
+        tryLoadFile(testDir + "/" + testName, "input", &input);
+        tryLoadFile(testDir + "/baseResults/" + testName + ".out", "expected output", &expectedOutput);
+
+        const EShMessages controls = DeriveOptions(source, semantics, Target::Spv);
+        const EShLanguage kind = GetShaderStage(GetSuffix(testName));
+        glslang::TShader shader(kind);
+        shader.setAutoMapLocations(true);
+        glslang::TProgram program;
+        program.addShader(&shader);
+        const bool compiled = compile(&shader, input, "", controls) && program.link(controls);
+        ASSERT_EQ(expectedOutput.find("SPIR-V is not generated") == std::string::npos, compiled)
+            << "compiling and linking " << testName << " does not fail or succeed as its expected output says";
+        if (!compiled)
+            return;
+
+        glslang::SpvOptions options;
+        options.disableOptimizer = true;
+        std::vector<uint32_t> spirv;
+        spv::SpvBuildLogger logger;
+        glslang::GlslangToSpv(*program.getIntermediate(kind), spirv, &logger, &options);
+
+        options.forwardLoads = true;
+        std::vector<uint32_t> forwarded;
+        spv::SpvBuildLogger forwardedLogger;
+        glslang::GlslangToSpv(*program.getIntermediate(kind), forwarded, &forwardedLogger, &options);
+
+        EXPECT_EQ("", FindIdUsedBeforeDefinition(spirv));
+        EXPECT_EQ("", FindIdUsedBeforeDefinition(forwarded));
+        EXPECT_LE(forwarded.size(), spirv.size());
+        EXPECT_EQ(logger.getAllMessages(), forwardedLogger.getAllMessages());
+
+        glslang::TReflectionRecords reflected, forwardedReflected;
+        std::string error;
+        ASSERT_TRUE(spv::ReflectSpirv(spirv, reflected, error)) << error;
+        ASSERT_TRUE(spv::ReflectSpirv(forwarded, forwardedReflected, error)) << error;
+        for (int dim = 0; dim < 3; ++dim)
+            EXPECT_EQ(reflected.localSize[dim], forwardedReflected.localSize[dim]);
+        const auto expectSameTable = [](const std::vector<glslang::TReflectionRecord>& table,
+                                        const std::vector<glslang::TReflectionRecord>& forwardedTable) {
+            ASSERT_EQ(table.size(), forwardedTable.size());
+            for (size_t r = 0; r < table.size(); ++r) {
+                EXPECT_EQ(table[r].name, forwardedTable[r].name);
+                EXPECT_EQ(table[r].offset, forwardedTable[r].offset) << table[r].name;
+                EXPECT_EQ(table[r].glDefineType, forwardedTable[r].glDefineType) << table[r].name;
+                EXPECT_EQ(table[r].size, forwardedTable[r].size) << table[r].name;
+                EXPECT_EQ(table[r].index, forwardedTable[r].index) << table[r].name;
+                EXPECT_EQ(table[r].counterIndex, forwardedTable[r].counterIndex) << table[r].name;
+                EXPECT_EQ(table[r].binding, forwardedTable[r].binding) << table[r].name;
+                EXPECT_EQ(table[r].set, forwardedTable[r].set) << table[r].name;
+            }
+        };
+        expectSameTable(reflected.uniforms, forwardedReflected.uniforms);
+        expectSameTable(reflected.uniformBlocks, forwardedReflected.uniformBlocks);
+        expectSameTable(reflected.attributes, forwardedReflected.attributes);
+    }
+
+    // Compiles and links the given source |testName|, and checks the
+    // reflection read from the SPIR-V made of it against the program's own:
+    // everything the program reflects must be found in the SPIR-V, the same.
+    // The SPIR-V also has what the program found inactive, so has more.
+    // Only shaders whose expected output says they fail to compile or link
+    // are skipped.
+    void loadFileCompileAndCheckSpirvReflection(const std::string& testDir,
+                                                const std::string& testName,
+                                                Source source,
+                                                Semantics semantics)
+    {
+        std::string input, expectedOutput;
+        tryLoadFile(testDir + "/" + testName, "input", &input);
+        tryLoadFile(testDir + "/baseResults/" + testName + ".out", "expected output", &expectedOutput);
+
+        const EShMessages controls = DeriveOptions(source, semantics, Target::Spv);
+        const EShLanguage kind = GetShaderStage(GetSuffix(testName));
+        glslang::TShader shader(kind);
+        shader.setAutoMapLocations(true);
+        glslang::TProgram program;
+        program.addShader(&shader);
+        const bool compiled = compile(&shader, input, "", controls) && program.link(controls);
+        ASSERT_EQ(expectedOutput.find("SPIR-V is not generated") == std::string::npos, compiled)
+            << "compiling and linking " << testName << " does not fail or succeed as its expected output says";
+        if (!compiled)
+            return;
+        ASSERT_TRUE(program.buildReflection());
+
+        std::vector<uint32_t> spirv;
+        spv::SpvBuildLogger logger;
+        glslang::SpvOptions options;
+        options.disableOptimizer = true;
+        glslang::GlslangToSpv(*program.getIntermediate(kind), spirv, &logger, &options);
+
+        std::vector<unsigned char> binary;
+        glslang::TReflectionRecords expected, reflected;
+        ASSERT_TRUE(program.serializeReflection(binary));
+        ASSERT_TRUE(glslang::ReadReflectionRecords(binary.data(), binary.size(), expected));
+        std::string error;
+        ASSERT_TRUE(spv::ReflectSpirv(spirv, reflected, error)) << error;
+
+        const auto find = [](const std::vector<glslang::TReflectionRecord>& table,
+                             const std::string& name) -> const glslang::TReflectionRecord* {
+            for (const auto& record : table) {
+                if (record.name == name)
+                    return &record;
+            }
+            return nullptr;
+        };
+        const auto blockName = [](const glslang::TReflectionRecords& records, int index) {
+            return index >= 0 ? records.uniformBlocks[index].name : std::string();
+        };
+        // Booleans in blocks are held as unsigned integers in SPIR-V.
+        const auto asHeld = [](int glType) {
+            if (glType == GL_BOOL)
+                return GL_UNSIGNED_INT;
+            if (glType >= GL_BOOL_VEC2 && glType <= GL_BOOL_VEC4)
+                return GL_UNSIGNED_INT_VEC2 + (glType - GL_BOOL_VEC2);
+            return glType;
+        };
+
+        for (const auto& uniform : expected.uniforms) {
+            const glslang::TReflectionRecord* found = find(reflected.uniforms, uniform.name);
+            ASSERT_NE(nullptr, found) << "uniform " << uniform.name;
+            // The program only offsets by the members and elements the shader
+            // names, so only a block's own members are sure to agree.
+            std::string member = uniform.name;
+            const std::string block = blockName(expected, uniform.index);
+            const std::string prefix = block.substr(0, block.find('[')) + ".";
+            if (member.compare(0, prefix.size(), prefix) == 0)
+                member = member.substr(prefix.size());
+            if (member.find_first_of(".[") == std::string::npos) {
+                EXPECT_EQ(uniform.offset, found->offset) << uniform.name;
+            }
+            EXPECT_EQ(asHeld(uniform.glDefineType), found->glDefineType) << uniform.name;
+            // The program only counts an array up to the last element the
+            // shader indexes, so only arrayness is compared.
+            if (uniform.size > 1) {
+                EXPECT_NE(1, found->size) << uniform.name;
+            }
+            EXPECT_EQ(blockName(expected, uniform.index), blockName(reflected, found->index)) << uniform.name;
+            EXPECT_EQ(uniform.binding, found->binding) << uniform.name;
+            if (uniform.set != -1) {
+                EXPECT_EQ(uniform.set, found->set) << uniform.name;
+            }
+        }
+        for (const auto& block : expected.uniformBlocks) {
+            const glslang::TReflectionRecord* found = find(reflected.uniformBlocks, block.name);
+            ASSERT_NE(nullptr, found) << "block " << block.name;
+            EXPECT_EQ(block.size, found->size) << block.name;
+            EXPECT_EQ(blockName(expected, block.counterIndex), blockName(reflected, found->counterIndex))
+                << block.name;
+            EXPECT_EQ(block.binding, found->binding) << block.name;
+            if (block.set != -1) {
+                EXPECT_EQ(block.set, found->set) << block.name;
+            }
+        }
+        for (const auto& attribute : expected.attributes) {
+            const glslang::TReflectionRecord* found = find(reflected.attributes, attribute.name);
+            ASSERT_NE(nullptr, found) << "attribute " << attribute.name;
+            EXPECT_EQ(attribute.glDefineType, found->glDefineType) << attribute.name;
+        }
+        for (int dim = 0; dim < 3; ++dim)
+            EXPECT_EQ(expected.localSize[dim], reflected.localSize[dim]);
+    }
+
 private:
     const int defaultVersion;
     const EProfile defaultProfile;
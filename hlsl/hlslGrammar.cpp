@@ -2586,9 +2586,9 @@ bool HlslGrammar::acceptInitializer(TIntermTyped*& node)
         // EvqConst.  Otherwise, it becomes EvqTemporary. That doesn't happen with e.g.
         // EvqIn or EvqPosition, since the collection isn't EvqPosition if all the members are.
         if (firstNode && expr->getQualifier().storage == EvqConst)
-            node->getQualifier().storage = EvqConst;
+            node->getWritableType().getQualifier().storage = EvqConst;
         else if (expr->getQualifier().storage != EvqConst)
-            node->getQualifier().storage = EvqTemporary;
+            node->getWritableType().getQualifier().storage = EvqTemporary;
 
         // COMMA
         if (acceptTokenClass(EHTokComma)) {
@@ -1823,7 +1823,7 @@ void HlslParseContext::transferTypeAttributes(const TAttributeMap& attributes, T
         const TIntermAggregate* attrAgg = attributes[attr];
         if (attrAgg == nullptr)
             return false;
-        if (argNum >= attrAgg->getSequence().size())
+        if (argNum >= (int)attrAgg->getSequence().size())
             return false;
         const TConstUnion& intConst = attrAgg->getSequence()[argNum]->getAsConstantUnion()->getConstArray()[0];
         if (intConst.getType() != EbtInt)
@@ -6930,15 +6930,15 @@ const TFunction* HlslParseContext::findFunction(const TSourceLoc& loc, TFunction
 
     // first, look for an exact match
     bool dummyScope;
-    TSymbol* symbol = symbolTable.find(call.getMangledName(), &builtIn, &dummyScope, &thisDepth);
-    if (symbol)
-        return symbol->getAsFunction();
+    const TFunction* exact = symbolTable.findFunction(call, &builtIn, &dummyScope, &thisDepth);
+    if (exact)
+        return exact;
 
     // no exact match, use the generic selector, parameterized by the GLSL rules
 
     // create list of candidates to send
     TVector<const TFunction*> candidateList;
-    symbolTable.findFunctionNameList(call.getMangledName(), candidateList, builtIn);
+    symbolTable.findFunctionNameList(call.getName(), candidateList, builtIn);
 
     // These built-in ops can accept any type, so we bypass the argument selection
     if (candidateList.size() == 1 && builtIn &&
@@ -7125,7 +7125,7 @@ const TFunction* HlslParseContext::findFunction(const TSourceLoc& loc, TFunction
     // Step 3:  Re-select after type promotion is applied, to find proper candidate.
     if (builtIn) {
         // Step 1: If there's an exact match, use it.
-        if (call.getMangledName() == bestMatch->getMangledName())
+        if (call.getName() == bestMatch->getName() && call.sameSignature(*bestMatch))
             return bestMatch;
 
         // Step 2a: Otherwise, get the operator from the best match and promote arguments as if we